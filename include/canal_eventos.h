@@ -0,0 +1,40 @@
+/*
+  Canal de Server-Sent Events sobre o WebServer síncrono do ESP32.
+  ---------------------------------------------------------------
+  aceitar() assume a conexão da requisição atual, responde com os cabeçalhos
+  de text/event-stream e guarda o cliente; a partir daí publicar() envia o
+  mesmo evento a todos. As escritas vão direto ao socket, que espera no
+  máximo ESPERA_MAXIMA_ENVIO_MS por espaço no buffer de envio: o cliente que
+  não leva o evento inteiro nesse prazo (navegador lento, rede ruim, conexão
+  morta sem aviso) é descartado, em vez de segurar o loop() pelos segundos
+  de espera do WiFiClient::write(). Cada endereço ocupa no máximo
+  MAX_POR_ENDERECO das MAX_CLIENTES vagas.
+*/
+#pragma once
+
+#include <Arduino.h>
+#include <WebServer.h>
+
+class CanalEventos {
+public:
+  static const int MAX_CLIENTES = 4;
+  static const int MAX_POR_ENDERECO = 2;
+  static const unsigned long ESPERA_MAXIMA_ENVIO_MS = 100UL;
+  static const unsigned long INTERVALO_KEEPALIVE_MS = 15000UL;
+
+  // Envia `dadosIniciais` só ao novo cliente. Responde 503 se não houver vaga.
+  bool aceitar(WebServer& server, const char* dadosIniciais, size_t tamanho);
+  void publicar(const char* dados, size_t tamanho);
+  // Comentário periódico: mantém proxies abertos e detecta clientes mortos.
+  void manter(unsigned long agora);
+  int clientes();
+  unsigned long recusados() const { return _recusados; }
+  unsigned long descartados() const { return _descartados; }
+
+private:
+  bool enviar(WiFiClient& cliente, const char* dados, size_t tamanho);
+  WiFiClient _clientes[MAX_CLIENTES];
+  unsigned long _ultimoKeepalive = 0;
+  unsigned long _recusados = 0;
+  unsigned long _descartados = 0;
+};
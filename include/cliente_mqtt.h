@@ -0,0 +1,96 @@
+/*
+  Cliente MQTT (PubSubClient) para a central de monitoramento.
+  -----------------------------------------------------------
+  Tópicos, todos sob um prefixo configurável (padrão "compressor/<mac>"):
+
+    <prefixo>/online              "1"/"0", retido (o "0" é a última vontade)
+    <prefixo>/estado              o JSON do /status, retido, a cada mudança
+    <prefixo>/telemetria          lotes binários (ver publicador_mqtt.h)
+    <prefixo>/comando/<ação>      ligar, desligar, automatico, zerarciclos, config
+    <prefixo>/resposta/<ação>     o texto que a rota HTTP equivalente responderia
+
+  O corpo de um comando tem os argumentos da rota HTTP em formato de
+  formulário ("canal=1", "tempoligado=10&tempodescanso=5"); as regras são as
+  mesmas (comandos.h). Tudo em QoS 0: quem garante a ordem e a retomada da
+  telemetria depois de uma queda é a fila do PublicadorMqtt.
+
+  A conexão é refeita com espera crescente (ESPERA_MINIMA_MS dobrando até
+  ESPERA_MAXIMA_MS), e cada tentativa segura o loop() por pouco tempo: o
+  nome do servidor vai ao DNS do lwIP pela tarefa tcpip, sem esperar (a
+  resposta chega por callback e a tentativa sai numa passada seguinte), o
+  TCP é aberto aqui com prazo de PRAZO_CONEXAO_MS e o CONNACK do broker
+  espera no máximo PRAZO_RESPOSTA_S; o PubSubClient aproveita o socket já
+  conectado. O controle roda na sua própria tarefa e não é afetado.
+  Sem servidor configurado (/configmqtt) o cliente fica desligado.
+*/
+#pragma once
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <PubSubClient.h>
+#include <WiFi.h>
+#include <atomic>
+
+// Nome do servidor resolvido pela tarefa tcpip do lwIP; o loop() só consulta o estado.
+struct ConsultaDns {
+  enum Estado : uint8_t { OCIOSA, PENDENTE, RESOLVIDA, FALHOU };
+  std::atomic<uint8_t> estado{OCIOSA};
+  std::atomic<uint32_t> endereco{0};
+  char nome[64];
+};
+
+class ClienteMqtt {
+public:
+  static const unsigned long ESPERA_MINIMA_MS = 2000UL;
+  static const unsigned long ESPERA_MAXIMA_MS = 60000UL;
+  static const uint16_t PORTA_PADRAO = 1883;
+  static const int32_t PRAZO_CONEXAO_MS = 1000;
+  static const uint16_t PRAZO_RESPOSTA_S = 1;
+
+  // `identificador`: client id no broker; `tamanhoMensagem`: maior mensagem publicada (o JSON do estado).
+  void iniciar(Preferences& preferences, const char* identificador, uint16_t tamanhoMensagem);
+  // Grava a configuração no NVS e reconecta; servidor vazio desliga o MQTT.
+  void configurar(const String& servidor, uint16_t porta, const String& usuario, const String& senha, const String& prefixo);
+  // Mantém a conexão e trata os comandos recebidos; retorna true ao conectar.
+  bool atualizar(unsigned long agora, bool redeConectada);
+
+  bool publicarEstado(const char* json, size_t tamanho);
+  // No formato de PublicarLoteMqtt; `contexto` é o ClienteMqtt.
+  static bool publicarLote(const uint8_t* dados, size_t tamanho, void* contexto);
+
+  bool configurado() const { return _servidor.length() > 0; }
+  bool conectado() { return _mqtt.connected(); }
+  const String& servidor() const { return _servidor; }
+  const String& prefixo() const { return _prefixo; }
+  unsigned long conexoes() const { return _conexoes; }
+  unsigned long mensagensEnviadas() const { return _mensagensEnviadas; }
+  unsigned long bytesEnviados() const { return _bytesEnviados; }
+  unsigned long comandosRecebidos() const { return _comandosRecebidos; }
+
+private:
+  void carregar();
+  // true com o endereço do servidor em `ip`; false enquanto o DNS não responde ou se falhou.
+  bool resolver(IPAddress& ip, bool& falhou);
+  bool conectar(const IPAddress& ip);
+  void adiarTentativa();
+  bool publicar(const String& topico, const uint8_t* dados, size_t tamanho, bool reter);
+  void tratarMensagem(char* topico, uint8_t* dados, unsigned int tamanho);
+
+  Preferences* _preferences = nullptr;
+  WiFiClient _rede;
+  PubSubClient _mqtt;
+  ConsultaDns _dns;
+  String _servidor;
+  uint16_t _porta = PORTA_PADRAO;
+  String _usuario;
+  String _senha;
+  String _prefixo;
+  String _identificador;
+
+  unsigned long _ultimaTentativa = 0;
+  unsigned long _espera = 0;
+  unsigned long _conexoes = 0;
+  unsigned long _mensagensEnviadas = 0;
+  unsigned long _bytesEnviados = 0;
+  unsigned long _comandosRecebidos = 0;
+};
@@ -0,0 +1,31 @@
+/*
+  Comandos externos, com as mesmas regras para HTTP e MQTT.
+  --------------------------------------------------------
+  As rotas /ligar, /desligar, /automatico, /zerarciclos e /config e os
+  tópicos <prefixo>/comando/<ação> do MQTT passam por aqui: a validação dos
+  argumentos e as recusas (caixa cheia, temperatura) são uma só, e o
+  resultado é um Comando pronto para enviarComando().
+
+  No MQTT os argumentos vêm no corpo da mensagem no formato de formulário
+  ("canal=2", "tempoligado=10&tempodescanso=5").
+*/
+#pragma once
+
+#include <Arduino.h>
+#include "controle.h"
+
+// Canal de um argumento "canal"; -1 se não for um número de canal válido.
+int interpretarCanal(const char* valor);
+
+// Motivo da recusa de um /ligar no canal, ou nullptr se pode ligar.
+const char* bloqueioLigar(const EstadoCanal& estado, const ParametrosOperacao& p);
+
+// Aplica um argumento do /config; retorna false se o nome for desconhecido ou o valor inválido.
+bool aplicarParametro(ParametrosOperacao& p, const char* nome, const char* valor);
+
+// Monta o comando de uma ação ("ligar", "desligar", "automatico", "zerarciclos"
+// ou "config") com os argumentos em formato de formulário. Retorna true se o
+// comando deve ser enviado; `resposta` recebe o texto que a rota HTTP
+// equivalente responderia (sucesso ou recusa).
+bool montarComando(const char* acao, const char* argumentos, const EstadoControle& estado, Comando& comando,
+                   const char*& resposta);
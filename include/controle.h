@@ -0,0 +1,189 @@
+/*
+  Lógica de controle dos compressores (relé, boia e proteção térmica).
+  -------------------------------------------------------------------
+  Todo o estado abaixo pertence à tarefa de controle. A camada web nunca o
+  altera diretamente: lê o retrato publicado com lerEstadoControle() e pede
+  mudanças com enviarComando().
+
+  Um controlador atende NUM_CANAIS poços: cada canal tem seu relé, sua boia e
+  seu DS18B20, todos os sensores no mesmo barramento OneWire. Os parâmetros
+  de operação são comuns a todos os canais; estado, contadores, histórico e
+  modelo adaptativo são por canal.
+*/
+#pragma once
+
+#include <Arduino.h>
+#include "controle_adaptativo.h"
+#include "entrada_boia.h"
+#include "estimador_termico.h"
+#include "maquina_compressor.h"
+#include "medidor_corrente.h"
+
+// ==================== CANAIS ====================
+// Compressores atendidos por este controlador; o build escolhe (-DNUM_CANAIS=N).
+#ifndef NUM_CANAIS
+#define NUM_CANAIS 1
+#endif
+const int MAX_CANAIS = 8;
+static_assert(NUM_CANAIS >= 1 && NUM_CANAIS <= MAX_CANAIS, "NUM_CANAIS deve estar entre 1 e MAX_CANAIS");
+
+// ==================== PINOS ====================
+// ESP32-S3-DevKitM-1. Ficam de fora: 0, 45 e 46 (strapping), 19 e 20 (USB),
+// 22 a 25 (não existem), 26 a 37 (flash e PSRAM do módulo) e 43 e 44 (UART0,
+// o Serial). O 48 é o LED RGB da placa, inofensivo como entrada com pull-up.
+constexpr uint8_t PINOS_RELE_COMPRESSOR[MAX_CANAIS] = { 11, 12, 13, 14, 15, 16, 17, 18 };   // LOW liga o compressor
+constexpr uint8_t ENTRADAS_CAIXA_CHEIA[MAX_CANAIS] = { 21, 38, 39, 40, 41, 42, 47, 48 };    // LOW com a boia fechada (caixa cheia)
+constexpr uint8_t PINO_SENSOR_TEMPERATURA = 10;    // barramento OneWire de todos os canais
+constexpr uint8_t PINOS_CORRENTE[MAX_CANAIS] = { 1, 2, 4, 5, 6, 7, 8, 9 };   // TC de cada canal, no ADC1 (GPIO 1 a 10; opcional)
+
+constexpr bool pinoReservado(uint8_t pino) {
+  return pino == 0 || pino == 19 || pino == 20 || (pino >= 22 && pino <= 37) || pino == 43 || pino == 44 ||
+         pino == 45 || pino == 46 || pino > 48;
+}
+
+constexpr bool pinosValidos() {
+  uint8_t pinos[3 * MAX_CANAIS + 1] = {};
+  int n = 0;
+  for (int i = 0; i < MAX_CANAIS; i++) {
+    pinos[n++] = PINOS_RELE_COMPRESSOR[i];
+    pinos[n++] = ENTRADAS_CAIXA_CHEIA[i];
+    pinos[n++] = PINOS_CORRENTE[i];
+    if (PINOS_CORRENTE[i] < 1 || PINOS_CORRENTE[i] > 10) return false;
+  }
+  pinos[n++] = PINO_SENSOR_TEMPERATURA;
+  for (int i = 0; i < n; i++) {
+    if (pinoReservado(pinos[i])) return false;
+    for (int j = i + 1; j < n; j++) {
+      if (pinos[i] == pinos[j]) return false;
+    }
+  }
+  return true;
+}
+static_assert(pinosValidos(), "pino repetido, reservado no ESP32-S3 ou TC fora do ADC1");
+
+const int TAMANHO_HISTORICO_ENCHIMENTO = 5;
+
+// Limites fixos do modo adaptativo; os outros dois vêm de ParametrosOperacao.
+const unsigned long TEMPO_LIGADO_MINIMO_MS = 60000UL;
+const unsigned long TEMPO_DESCANSO_MAXIMO_MS = 1800000UL;
+
+// Proteção térmica. Sem estimativa (ou com a previsão desligada) vale a histerese fixa.
+// A antecipação da parada preditiva fica em maquina_compressor.h.
+const float HISTERESE_TERMICA = 5.0f;
+const float PARTIDA_MINIMA_TERMICA_S = 420.0f; // religa quando uma partida consegue durar isso (ver --comparar-preditiva)
+
+struct EnchimentoInfo {
+  unsigned long tempo;
+  unsigned int ciclosParciais;
+};
+
+struct ParametrosOperacao {
+  unsigned long tempoLigado;
+  unsigned long tempoDescanso;
+  float temperaturaMaxima;
+  uint8_t resolucaoSensor;
+  unsigned long intervaloLeitura;
+  // Modo adaptativo: tempoLigado e tempoDescanso viram o ponto de partida do
+  // modelo, que os ajusta entre os limites abaixo e os fixos acima.
+  unsigned long tempoLigadoMaximo;
+  unsigned long tempoDescansoMinimo;
+  bool adaptativo;
+  bool protecaoPreditiva;   // para antes do limite e religa pela previsão, não pela histerese
+  // Filtro da boia (ver entrada_boia.h).
+  unsigned long debounceBoiaMs;
+  unsigned long glitchBoiaMs;
+  // Medição de corrente (ver medidor_corrente.h); 0 A = sem TC instalado.
+  float correnteNominalA;
+  float tensaoNominalV;
+};
+
+// Contadores, histórico e modelo de um canal.
+struct DadosCanal {
+  unsigned long ciclosParciaisOperacao;
+  unsigned long ciclosEnchimentoCompletos;
+  EnchimentoInfo historicoEnchimento[TAMANHO_HISTORICO_ENCHIMENTO];
+  int indiceHistoricoEnchimento;
+  ModeloEnchimento modelo;
+};
+
+// Tudo o que sobrevive a um reinício (gravado no NVS pela tarefa do loop()).
+struct DadosPersistentes {
+  ParametrosOperacao parametros;
+  DadosCanal canais[NUM_CANAIS];
+};
+
+struct EstadoCanal {
+  // Modo, temporizador e falha de corrente: só a máquina de estados os muda.
+  MaquinaCompressor maquina;
+  bool caixaCheia;
+  bool enchendo;                  // enchimento em andamento, desde inicioCicloEnchimentoMillis
+  float temperaturaAtual;
+  unsigned long inicioCicloMillis;
+  unsigned long inicioCicloEnchimentoMillis;
+  unsigned int ciclosParciaisNesteEnchimento;
+  uint64_t tempoLigadoTotalMs;   // tempo de relé fechado desde o boot
+  // Tempos em uso no ciclo automático (os configurados ou os do modelo adaptativo).
+  unsigned long tempoLigadoAtual;
+  unsigned long tempoDescansoAtual;
+  // Acumulados do enchimento em andamento, para o modelo adaptativo.
+  uint64_t ligadoNoInicioEnchimentoMs;
+  unsigned int paradasTermicasNesteEnchimento;
+  unsigned long ligadoAteLimiteMs;
+  EstimadorTermico termico;
+  float temperaturaReligamento;   // abaixo dela o compressor pode religar após uma parada térmica
+  unsigned long paradasTermicasPreditivas;
+  unsigned long desligamentosEmergencia;
+  bool sensorPresente;            // encontrado no barramento no boot
+  uint8_t enderecoSensor[8];      // ROM do DS18B20 deste canal
+  EstatisticasBoia boia;
+  // Medição de corrente (zerada sem TC).
+  float correnteA;                // valor eficaz da última janela
+  float potenciaW;
+  double energiaTotalWh;          // desde o boot
+  float energiaEnchimentoWh;      // enchimento em andamento
+  float energiaUltimoEnchimentoWh;
+  DetectorFalhaCorrente detectorCorrente;
+  unsigned long desligamentosCorrente;
+  bool correnteSemRele;           // corrente com o relé aberto (contator colado?)
+
+  bool compressorLigado() const { return releLigado(maquina.modo); }
+  bool modoManual() const { return ::modoManual(maquina.modo); }
+  bool desligadoPorTemperaturaAlta() const {
+    return maquina.modo == MODO_PARADA_TERMICA || maquina.modo == MODO_MANUAL_PARADA_TERMICA;
+  }
+  bool pausaTermica() const { return maquina.modo == MODO_PAUSA_PREDITIVA; }  // parada preditiva antes do limite
+  FalhaCorrente falhaCorrente() const { return maquina.falha; }  // a que desligou o compressor, até ser liberada
+};
+
+struct EstadoControle {
+  EstadoCanal canais[NUM_CANAIS];
+  unsigned long ultimoCicloExecutadoMillis;
+  DadosPersistentes dados;
+  // Incrementado sempre que `dados` muda de forma que mereça ser gravado.
+  unsigned long versaoDados;
+};
+
+enum TipoComando : uint8_t {
+  COMANDO_LIGAR,
+  COMANDO_DESLIGAR,
+  COMANDO_AUTOMATICO,
+  COMANDO_CONFIGURAR,
+  COMANDO_ZERAR_CICLOS
+};
+
+struct Comando {
+  TipoComando tipo;
+  uint8_t canal;                  // LIGAR, DESLIGAR, AUTOMATICO e ZERAR_CICLOS; CONFIGURAR vale para todos
+  ParametrosOperacao parametros;  // usado apenas por COMANDO_CONFIGURAR
+};
+
+// Chamado uma vez no setup(), antes de a tarefa de controle começar.
+void iniciarControle(const DadosPersistentes& dados, unsigned long agora);
+// Um ciclo completo: comandos pendentes, sensores, proteções e temporizadores.
+void executarCicloControle(unsigned long agora);
+
+// Seguros para chamar de outra tarefa.
+bool enviarComando(const Comando& comando);
+// O retrato tem uns 3,5 KB com 8 canais: o leitor passa um destino estático,
+// nunca uma variável local na pilha de 8 KB da tarefa do loop().
+void lerEstadoControle(EstadoControle& destino);
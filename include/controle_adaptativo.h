@@ -0,0 +1,64 @@
+/*
+  Ciclo liga/descanso adaptativo.
+  ------------------------------
+  Aprende com cada enchimento completo (os mesmos dados do
+  historicoEnchimento, mais o tempo ligado e as paradas térmicas) e ajusta
+  os tempos de ligado e de descanso dentro dos limites configurados:
+
+  - Tempo ligado: quanto bombeamento a caixa precisa por enchimento, com
+    folga, para que ela encha numa partida só (mais litros por partida),
+    sem passar do tempo que o compressor aguenta até a proteção térmica.
+  - Descanso: perturba e observa. Os enchimentos com mais de uma partida
+    alternam um descanso um pouco mais curto e um pouco mais longo que a
+    base; a base anda para o lado que encheu a caixa mais depressa. A
+    diferença de tempo ligado entre os dois lados estima a recuperação do
+    poço (segundos de bombeamento poupados por segundo a mais de descanso).
+
+  Memória constante: médias móveis exponenciais num struct de 48 bytes,
+  persistido junto com os contadores.
+*/
+#pragma once
+
+#include <stdint.h>
+
+// Resumo de um enchimento completo, montado pela tarefa de controle.
+struct ResumoEnchimento {
+  uint32_t duracaoS;          // da caixa vazia até a boia fechar
+  uint32_t ligadoS;           // tempo de compressor ligado dentro do enchimento
+  uint32_t ligadoAteLimiteS;  // a primeira partida parou na proteção térmica após este tempo (0 = não parou)
+  uint16_t partidas;
+  uint16_t paradasTermicas;
+};
+
+struct LimitesAdaptativos {
+  uint32_t ligadoMinimoMs;
+  uint32_t ligadoMaximoMs;
+  uint32_t descansoMinimoMs;
+  uint32_t descansoMaximoMs;
+};
+
+// Só tipos de largura fixa e sem preenchimento implícito: vai direto para o NVS.
+struct ModeloEnchimento {
+  float ligadoPorEnchimentoS;    // bombeamento necessário para encher a caixa (inverso da vazão)
+  float partidasPorEnchimento;
+  float ligadoAteLimiteS;        // tempo ligado, partindo frio, até a proteção térmica (0 = nunca observado)
+  float recuperacaoPoco;         // s de bombeamento poupados por s a mais de descanso
+  float duracaoLado[2];          // duração do enchimento com descanso curto [0] e longo [1]
+  float ligadoLado[2];           // tempo ligado, idem
+  uint32_t tempoLigadoMs;        // tempo ligado em uso (0 = modelo ainda não iniciado)
+  uint32_t tempoDescansoMs;      // base do descanso; a perturbação é aplicada em volta
+  uint16_t enchimentos;          // enchimentos incorporados
+  uint8_t amostrasLado[2];       // enchimentos em cada lado desde o último passo da base
+  uint8_t lado;                  // lado da perturbação no enchimento atual
+  uint8_t reservado[3];
+};
+
+void iniciarModelo(ModeloEnchimento& modelo, uint32_t tempoLigadoMs, uint32_t tempoDescansoMs);
+// Incorpora um enchimento completo. Com `ajustarDescanso` false (modo fixo) só as
+// estimativas são atualizadas: o descanso aplicado não variou, não há o que comparar.
+void incorporarEnchimento(ModeloEnchimento& modelo, const ResumoEnchimento& resumo,
+                          const LimitesAdaptativos& limites, bool ajustarDescanso);
+
+// Tempos a aplicar no próximo ciclo, já dentro dos limites.
+uint32_t tempoLigadoAdaptativo(const ModeloEnchimento& modelo, const LimitesAdaptativos& limites);
+uint32_t tempoDescansoAdaptativo(const ModeloEnchimento& modelo, const LimitesAdaptativos& limites);
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// CRC-8 Dallas/Maxim (polinômio 0x31 refletido), o mesmo do OneWire.
+uint8_t crc8(const void* dados, size_t tamanho);
+// CRC-32 IEEE 802.3 (polinômio 0xEDB88320 refletido); encadeável passando o resultado anterior em crc.
+uint32_t crc32(const void* dados, size_t tamanho, uint32_t crc = 0);
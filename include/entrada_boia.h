@@ -0,0 +1,81 @@
+/*
+  Boia da caixa d'água por interrupção, com filtro de trepidação.
+  ---------------------------------------------------------------
+  Cada borda do pino dispara uma interrupção que só anota o instante
+  (micros()) e o nível numa FilaSpsc; a tarefa de controle esvazia a fila a
+  cada ciclo e aplica o filtro:
+
+  - um pulso mais curto que `glitchMs` contra o nível estável é ruído
+    elétrico: é descartado e não conta como começo de transição;
+  - o nível novo só é aceito depois de passar `debounceMs` sem nenhuma borda
+    (a boia trepida ao chegar no nível), e o instante da mudança é o da
+    primeira borda da sequência, não o do ciclo que a confirmou.
+
+  Bordas perdidas (fila cheia, ou duas bordas tão próximas que a interrupção
+  leu o mesmo nível) são corrigidas pelo nível lido em atualizar(), que
+  ressincroniza o filtro com o instante do ciclo.
+
+  O filtro não consulta o relógio por conta própria: o instante atual é
+  passado em atualizar(), e no host as bordas vêm da tabela de pinos
+  simulada (sim::agendarPino), o que permite injetar sequências de bordas
+  com precisão de microssegundos.
+*/
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include "estado_compartilhado.h"
+
+struct EstatisticasBoia {
+  uint32_t bordas;        // bordas recebidas da interrupção
+  uint32_t glitches;      // pulsos curtos descartados
+  uint32_t trepidacoes;   // sequências de bordas que voltaram ao nível estável
+  uint32_t mudancas;      // mudanças de nível aceitas
+  uint32_t perdidas;      // bordas descartadas com a fila cheia e ressincronizações pelo nível lido
+};
+
+class EntradaBoia {
+public:
+  static const size_t CAPACIDADE_FILA = 16;
+
+  // Configura o pino com pull-up e a interrupção; o nível atual vira o estável.
+  void iniciar(uint8_t pino, unsigned long debounceMs, unsigned long glitchMs, uint32_t agoraUs);
+  // O glitch nunca passa do debounce.
+  void configurar(unsigned long debounceMs, unsigned long glitchMs);
+
+  // Produtor: chamado pela interrupção (ou pelo host) a cada borda.
+  void registrarBorda(uint32_t instanteUs, uint8_t nivel);
+
+  // Consumidor (tarefa de controle): aplica as bordas pendentes e retorna
+  // true se o nível estável mudou nesta chamada.
+  bool atualizar(uint32_t agoraUs);
+
+  uint8_t nivel() const { return _estavel; }
+  // Instante (micros()) da primeira borda da última mudança aceita.
+  uint32_t instanteMudancaUs() const { return _instanteMudancaUs; }
+  EstatisticasBoia estatisticas() const;
+
+private:
+  struct Borda {
+    uint32_t instanteUs;
+    uint8_t nivel;
+  };
+
+  static void interrupcao(void* argumento);
+  void processar(uint32_t instanteUs, uint8_t nivel);
+
+  uint8_t _pino = 0;
+  uint32_t _debounceUs = 50000UL;
+  uint32_t _glitchUs = 5000UL;
+  FilaSpsc<Borda, CAPACIDADE_FILA> _fila;
+  std::atomic<uint32_t> _estouros{0};   // escrito pela interrupção
+
+  // Só a tarefa de controle mexe daqui para baixo.
+  uint8_t _estavel = HIGH;
+  uint8_t _bruto = HIGH;              // último nível visto, antes do debounce
+  bool _pendente = false;             // há uma sequência de bordas ainda não confirmada
+  uint32_t _inicioPendenteUs = 0;
+  uint32_t _ultimaBordaUs = 0;
+  uint32_t _instanteMudancaUs = 0;
+  EstatisticasBoia _estatisticas = {};
+};
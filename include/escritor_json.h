@@ -0,0 +1,80 @@
+/*
+  Serializador JSON sobre um buffer fixo, sem nenhuma alocação no heap.
+  --------------------------------------------------------------------
+  As vírgulas entre elementos são inseridas automaticamente. Números são
+  formatados à mão (o printf de ponto flutuante da newlib aloca memória).
+  Se o buffer acabar, a escrita para e estourou() passa a retornar true;
+  o conteúdo nunca ultrapassa a capacidade e sempre termina em '\0'.
+  Com uma função de esvaziar, o buffer cheio é entregue a ela e reaproveitado:
+  a resposta pode ser maior que o buffer (envio em pedaços) e esvaziar()
+  entrega o resto no fim.
+
+    char buffer[256];
+    EscritorJson json(buffer, sizeof(buffer));
+    json.abrirObjeto();
+    json.campo("ligado", true);
+    json.campo("temperatura", 25.04f, 1);
+    json.abrirLista("historico");
+    json.valor(12UL);
+    json.fecharLista();
+    json.fecharObjeto();
+    // buffer == {"ligado":true,"temperatura":25.0,"historico":[12]}
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef void (*FuncaoEsvaziarJson)(const char* dados, size_t tamanho, void* contexto);
+
+class EscritorJson {
+public:
+  EscritorJson(char* buffer, size_t capacidade);
+  EscritorJson(char* buffer, size_t capacidade, FuncaoEsvaziarJson esvaziar, void* contexto);
+
+  void abrirObjeto(const char* nome = nullptr);
+  void fecharObjeto();
+  void abrirLista(const char* nome = nullptr);
+  void fecharLista();
+
+  // Elementos de lista
+  void valor(bool v);
+  void valor(long v);
+  void valor(unsigned long v);
+  void valor(int v) { valor((long)v); }
+  void valor(unsigned int v) { valor((unsigned long)v); }
+  void valor(float v, uint8_t casas);
+  void valor(const char* texto);
+  void valorNulo();
+
+  // Campos de objeto
+  template <typename T> void campo(const char* nome, T v) { chave(nome); valor(v); }
+  void campo(const char* nome, float v, uint8_t casas) { chave(nome); valor(v, casas); }
+  void campoNulo(const char* nome) { chave(nome); valorNulo(); }
+
+  const char* texto() const { return _buffer; }
+  size_t tamanho() const { return _tamanho; }
+  bool estourou() const { return _estourou; }
+  void esvaziar();
+
+private:
+  void chave(const char* nome);
+  void separar();
+  void abrir(const char* nome, char c);
+  void fechar(char c);
+  void escrever(char c);
+  void escrever(const char* s);
+  void escreverTextoEscapado(const char* s);
+  void escreverInteiro(unsigned long v);
+
+  char* _buffer;
+  size_t _capacidade;
+  FuncaoEsvaziarJson _esvaziar = nullptr;
+  void* _contexto = nullptr;
+  size_t _tamanho = 0;
+  bool _estourou = false;
+  bool _aposChave = false;
+  // Um bit por nível de aninhamento: 1 se o nível ainda não tem elementos.
+  uint32_t _niveisVazios = 0;
+  uint8_t _profundidade = 0;
+};
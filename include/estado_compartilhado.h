@@ -0,0 +1,136 @@
+/*
+  Primitivas sem trava para troca de dados entre a tarefa de controle e a
+  camada web.
+
+  EstadoCompartilhado<T>: seqlock de um único escritor. O escritor (tarefa de
+  controle) nunca espera; os leitores repetem a cópia caso ela tenha sido
+  feita durante uma publicação.
+
+  FilaSpsc<T, N>: fila circular de um produtor e um consumidor. Os handlers
+  HTTP (todos executados na tarefa do loop()) produzem comandos e a tarefa de
+  controle os consome no início de cada ciclo.
+
+  FilaMpsc<T, N>: fila circular de vários produtores e um consumidor, para
+  quem escreve de mais de uma tarefa (o registro de eventos). Cada posição
+  tem seu número de sequência; um produtor reserva a posição com um
+  compare-and-swap na cauda e a libera ao consumidor publicando a sequência.
+  Cheia, enviar() retorna false sem esperar.
+*/
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+template <typename T>
+class EstadoCompartilhado {
+  static_assert(std::is_trivially_copyable<T>::value, "EstadoCompartilhado exige tipo trivialmente copiável");
+
+public:
+  void publicar(const T& valor) {
+    uint32_t seq = _sequencia.load(std::memory_order_relaxed);
+    _sequencia.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(&_valor, &valor, sizeof(T));
+    _sequencia.store(seq + 2, std::memory_order_release);
+  }
+
+  // Copia para um destino do chamador: com T grande, quem lê decide onde a
+  // cópia mora (um buffer estático em vez da pilha da tarefa).
+  void ler(T& destino) const {
+    for (;;) {
+      uint32_t antes = _sequencia.load(std::memory_order_acquire);
+      if (antes & 1) continue;
+      memcpy(&destino, &_valor, sizeof(T));
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (_sequencia.load(std::memory_order_relaxed) == antes) return;
+    }
+  }
+
+  T ler() const {
+    T copia;
+    ler(copia);
+    return copia;
+  }
+
+private:
+  std::atomic<uint32_t> _sequencia{0};
+  T _valor{};
+};
+
+template <typename T, size_t N>
+class FilaSpsc {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "A capacidade da FilaSpsc deve ser potência de 2");
+
+public:
+  bool enviar(const T& item) {
+    size_t cauda = _cauda.load(std::memory_order_relaxed);
+    if (cauda - _cabeca.load(std::memory_order_acquire) >= N) return false;
+    _itens[cauda & (N - 1)] = item;
+    _cauda.store(cauda + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool receber(T& item) {
+    size_t cabeca = _cabeca.load(std::memory_order_relaxed);
+    if (cabeca == _cauda.load(std::memory_order_acquire)) return false;
+    item = _itens[cabeca & (N - 1)];
+    _cabeca.store(cabeca + 1, std::memory_order_release);
+    return true;
+  }
+
+private:
+  std::atomic<size_t> _cabeca{0};
+  std::atomic<size_t> _cauda{0};
+  T _itens[N];
+};
+
+template <typename T, size_t N>
+class FilaMpsc {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "A capacidade da FilaMpsc deve ser potência de 2");
+
+public:
+  FilaMpsc() {
+    for (size_t i = 0; i < N; i++) _posicoes[i].sequencia.store(i, std::memory_order_relaxed);
+  }
+
+  bool enviar(const T& item) {
+    size_t cauda = _cauda.load(std::memory_order_relaxed);
+    for (;;) {
+      Posicao& posicao = _posicoes[cauda & (N - 1)];
+      size_t sequencia = posicao.sequencia.load(std::memory_order_acquire);
+      intptr_t diferenca = (intptr_t)sequencia - (intptr_t)cauda;
+      if (diferenca == 0) {
+        if (_cauda.compare_exchange_weak(cauda, cauda + 1, std::memory_order_relaxed)) {
+          posicao.item = item;
+          posicao.sequencia.store(cauda + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diferenca < 0) {
+        return false;  // cheia: o consumidor ainda não liberou esta posição
+      } else {
+        cauda = _cauda.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  bool receber(T& item) {
+    Posicao& posicao = _posicoes[_cabeca & (N - 1)];
+    if (posicao.sequencia.load(std::memory_order_acquire) != _cabeca + 1) return false;
+    item = posicao.item;
+    posicao.sequencia.store(_cabeca + N, std::memory_order_release);
+    _cabeca++;
+    return true;
+  }
+
+private:
+  struct Posicao {
+    std::atomic<size_t> sequencia;
+    T item;
+  };
+  Posicao _posicoes[N];
+  std::atomic<size_t> _cauda{0};
+  size_t _cabeca = 0;  // só o consumidor usa
+};
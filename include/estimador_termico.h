@@ -0,0 +1,54 @@
+/*
+  Estimador térmico do compressor.
+  -------------------------------
+  Mede a inclinação da temperatura (°C/s) em janelas de 10 s, separadamente
+  com o compressor ligado (aquecimento) e desligado (resfriamento), e prevê:
+
+  - quanto falta, ligado, para chegar a um limite;
+  - abaixo de que temperatura uma partida consegue ficar ligada por um
+    tempo mínimo antes de chegar ao limite, e quanto falta para esfriar
+    até lá.
+
+  O aquecimento segue um modelo de primeira ordem, dT/dt = (Teq - T) / tau,
+  ajustado por mínimos quadrados (com esquecimento) sobre os pares
+  (temperatura, inclinação) de cada janela. Enquanto o ajuste não é
+  confiável, e para o resfriamento, vale a extrapolação linear com a
+  inclinação filtrada. A proteção por limiar continua ativa por cima de tudo.
+
+  Só campos simples: o estimador viaja dentro do EstadoControle publicado.
+*/
+#pragma once
+
+#include <stdint.h>
+
+struct EstimadorTermico {
+  static const unsigned long JANELA_MS = 10000UL;
+  static const uint8_t JANELAS_MINIMAS = 3;  // por modo, antes de as previsões valerem
+
+  float inclinacaoAquecimento;   // °C/s com o compressor ligado (média móvel)
+  // Somas ponderadas da regressão inclinação = a + b·temperatura, só no aquecimento.
+  float peso, somaT, somaI, somaTT, somaTI;
+  float inclinacaoResfriamento;  // °C/s desligado (negativa)
+  uint8_t janelasAquecimento;
+  uint8_t janelasResfriamento;
+  bool ligadoNaJanela;
+  bool janelaAberta;
+  float temperaturaInicioJanela;
+  unsigned long inicioJanelaMs;
+
+  void reiniciar();
+  // Chamado a cada leitura nova do sensor.
+  void atualizar(float temperatura, bool ligado, unsigned long agora);
+
+  bool aquecimentoValido() const { return janelasAquecimento >= JANELAS_MINIMAS && inclinacaoAquecimento > 0.0f; }
+  bool resfriamentoValido() const { return janelasResfriamento >= JANELAS_MINIMAS && inclinacaoResfriamento < 0.0f; }
+  // Modelo de primeira ordem do aquecimento; false enquanto o ajuste não é confiável.
+  bool modeloAquecimento(float& temperaturaEquilibrio, float& constanteTempoS) const;
+
+  // Segundos, ligado, de `temperatura` até `limite` (negativo se não há estimativa).
+  float segundosAteLimite(float temperatura, float limite) const;
+  // Temperatura a partir da qual uma partida dura `duracaoS` antes de atingir `limite`.
+  float temperaturaReligamento(float limite, float duracaoS) const;
+  // Segundos, desligado, até esfriar para `alvo` (0 se já está abaixo, negativo sem estimativa).
+  float segundosAteEsfriar(float temperatura, float alvo) const;
+};
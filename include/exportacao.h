@@ -0,0 +1,29 @@
+/*
+  Exportação binária do histórico (formato em formato_exportacao.h).
+  -----------------------------------------------------------------
+  Gera a exportação em fluxo, em pedaços pequenos entregues à função de
+  saída: nada do tamanho do histórico é montado em RAM. O /exportar do
+  firmware manda cada pedaço pelo chunked encoding; o simulador grava num
+  arquivo para o analisador de frota.
+*/
+#pragma once
+
+#include <Arduino.h>
+#include "controle.h"
+#include "formato_exportacao.h"
+#include "registro_telemetria.h"
+#include "serie_temporal.h"
+
+// Recebe cada pedaço; retorna false para interromper (cliente desconectou).
+typedef bool (*SaidaExportacao)(const uint8_t* dados, size_t tamanho, void* contexto);
+
+struct InfoExportacao {
+  const char* identificador;
+  uint32_t instante;
+  bool relogioSincronizado;
+  uint32_t uptimeS;
+};
+
+// Retorna o total de bytes entregues (menor que o completo se a saída interrompeu).
+size_t exportarHistorico(const InfoExportacao& info, const EstadoControle& estado, RegistroTelemetria& telemetria,
+                         const SerieTemporal& serie, SaidaExportacao saida, void* contexto);
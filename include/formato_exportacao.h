@@ -0,0 +1,129 @@
+/*
+  Formato da exportação binária do histórico (GET /exportar), versão 1.
+  --------------------------------------------------------------------
+  Lido pelo firmware (ao gerar) e por tools/analisador_frota.cpp (ao ler),
+  por isso este arquivo não depende do Arduino. Tudo little-endian, sem
+  preenchimento entre os campos:
+
+    CabecalhoExportacao                         32 bytes
+    seção*                                      CabecalhoSecao (8 bytes) + `tamanho` bytes
+    seção FIM                                   CRC-32 de tudo o que veio antes
+
+  Seções:
+    PARAMETROS   uma ParametrosExportados
+    CANAL        uma CanalExportado por canal (contadores, últimos enchimentos, modelo)
+    TELEMETRIA   N x AmostraExportada do registro de telemetria (canal 0), em
+                 ordem de instante; várias seções seguidas formam a série inteira
+    TEMPERATURA  uint32_t resolucaoS + N x BaldeExportado de um nível do
+                 gráfico, do mais antigo para o mais novo; seções seguidas com a
+                 mesma resolução continuam a anterior
+    FIM          uint32_t crc32 (IEEE 802.3, o de crc.h) de todos os bytes
+                 antes desta seção, a partir do CabecalhoExportacao
+
+  O firmware gera em fluxo, sem conhecer o total de antemão: por isso as
+  séries longas vêm em várias seções pequenas. Quem lê deve pular as seções
+  de tipo desconhecido (pelo tamanho); a versão só muda quando um leitor da
+  versão anterior interpretaria algo errado.
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+const uint16_t VERSAO_EXPORTACAO = 1;
+const char MAGICO_EXPORTACAO[4] = { 'C', 'P', 'E', 'X' };
+
+enum TipoSecaoExportacao : uint16_t {
+  SECAO_PARAMETROS = 1,
+  SECAO_CANAL = 2,
+  SECAO_TELEMETRIA = 3,
+  SECAO_TEMPERATURA = 4,
+  SECAO_FIM = 0xFFFF
+};
+
+struct CabecalhoExportacao {
+  char magico[4];
+  uint16_t versao;
+  uint8_t numCanais;
+  uint8_t flags;                // FLAG_RELOGIO_SINCRONIZADO
+  uint32_t instante;            // epoch (s) se sincronizado, senão segundos desde o boot
+  uint32_t uptimeS;
+  char identificador[16];       // terminado em '\0' se menor
+
+  static const uint8_t FLAG_RELOGIO_SINCRONIZADO = 1 << 0;
+};
+static_assert(sizeof(CabecalhoExportacao) == 32, "CabecalhoExportacao deve ter 32 bytes");
+
+struct CabecalhoSecao {
+  uint16_t tipo;
+  uint16_t reservado;
+  uint32_t tamanho;             // bytes de dados depois deste cabeçalho
+};
+static_assert(sizeof(CabecalhoSecao) == 8, "CabecalhoSecao deve ter 8 bytes");
+
+struct ParametrosExportados {
+  uint32_t tempoLigadoS;
+  uint32_t tempoDescansoS;
+  uint32_t intervaloLeituraMs;
+  uint32_t tempoLigadoMaximoS;
+  uint32_t tempoDescansoMinimoS;
+  int16_t temperaturaMaximaCentesimos;
+  uint8_t resolucaoSensor;
+  uint8_t flags;                // FLAG_ADAPTATIVO, FLAG_PROTECAO_PREDITIVA
+  uint16_t debounceBoiaMs;
+  uint16_t glitchBoiaMs;
+
+  static const uint8_t FLAG_ADAPTATIVO = 1 << 0;
+  static const uint8_t FLAG_PROTECAO_PREDITIVA = 1 << 1;
+};
+static_assert(sizeof(ParametrosExportados) == 28, "ParametrosExportados deve ter 28 bytes");
+
+struct EnchimentoExportado {
+  uint32_t tempoS;
+  uint32_t ciclosParciais;
+};
+
+struct CanalExportado {
+  static const int MAX_ENCHIMENTOS = 5;
+
+  uint8_t canal;
+  uint8_t flags;                // as mesmas de AmostraExportada, no instante da exportação
+  int16_t temperaturaCentesimos;
+  uint32_t ciclosParciaisOperacao;
+  uint32_t ciclosEnchimentoCompletos;
+  uint32_t tempoLigadoTotalS;   // desde o boot
+  uint32_t paradasTermicasPreditivas;
+  uint32_t desligamentosEmergencia;
+  uint8_t numEnchimentos;       // válidos em `enchimentos`, do mais antigo para o mais novo
+  uint8_t reservado[3];
+  EnchimentoExportado enchimentos[MAX_ENCHIMENTOS];
+  float ligadoPorEnchimentoS;   // modelo adaptativo
+  float partidasPorEnchimento;
+};
+static_assert(sizeof(CanalExportado) == 76, "CanalExportado deve ter 76 bytes");
+
+// Mesmo leiaute de AmostraTelemetria (registro_telemetria.h).
+struct AmostraExportada {
+  uint32_t instante;
+  int16_t temperaturaCentesimos;
+  uint8_t flags;
+  uint8_t crc;
+  uint32_t ciclosParciaisOperacao;
+  uint32_t ciclosEnchimentoCompletos;
+
+  static const uint8_t FLAG_COMPRESSOR = 1 << 0;
+  static const uint8_t FLAG_CAIXA_CHEIA = 1 << 1;
+  static const uint8_t FLAG_MODO_MANUAL = 1 << 2;
+  static const uint8_t FLAG_DESLIGADO_TEMPERATURA = 1 << 3;
+  static const uint8_t FLAG_RELOGIO_SINCRONIZADO = 1 << 4;
+};
+static_assert(sizeof(AmostraExportada) == 16, "AmostraExportada deve ter 16 bytes");
+
+struct BaldeExportado {
+  uint32_t idadeS;              // do início do balde até a exportação
+  int16_t minimoCentesimos;
+  int16_t maximoCentesimos;
+  int16_t mediaCentesimos;
+  int16_t reservado;
+};
+static_assert(sizeof(BaldeExportado) == 12, "BaldeExportado deve ter 12 bytes");
@@ -0,0 +1,71 @@
+/*
+  Conexão WiFi sem bloqueio.
+  -------------------------
+  Máquina de estados chamada a cada passada do loop(): nada aqui espera a
+  rede, então o controle e o servidor HTTP seguem rodando enquanto a conexão
+  é feita, refeita ou abandonada.
+
+  - O canal e o BSSID do último ponto de acesso são guardados no NVS; a
+    primeira tentativa os usa e pula a varredura de canais. Se falhar, a
+    seguinte faz a varredura completa.
+  - Depois de FALHAS_ANTES_AP tentativas sem sucesso (ou sem rede
+    configurada), sobe o ponto de acesso de configuração sem reiniciar e
+    continua tentando a rede do cliente em segundo plano; quando ela volta,
+    o ponto de acesso é desligado.
+*/
+#pragma once
+
+#include <Arduino.h>
+#include <DNSServer.h>
+#include <Preferences.h>
+#include <WiFi.h>
+
+class GerenciadorWiFi {
+public:
+  enum Estado { SEM_REDE, CONECTANDO, CONECTADO, AGUARDANDO };
+  enum Evento { NENHUM, CONECTOU, DESCONECTOU, AP_INICIADO };
+
+  static const unsigned long TEMPO_TENTATIVA_MS = 10000UL;
+  static const unsigned long ESPERA_RECONEXAO_MS = 5000UL;
+  static const unsigned long ESPERA_RECONEXAO_AP_MS = 60000UL;  // com o AP no ar, tenta com menos frequência
+  static const int FALHAS_ANTES_AP = 3;
+
+  GerenciadorWiFi(const char* apSsid, const char* apSenha) : _apSsid(apSsid), _apSenha(apSenha) {}
+
+  void iniciar(Preferences& preferences, unsigned long agora);
+  // Avança a máquina de estados; retorna o que mudou nesta chamada.
+  Evento atualizar(unsigned long agora);
+  // Credenciais novas gravadas no NVS: tenta conectar já, sem reiniciar.
+  void reconfigurar(unsigned long agora);
+
+  Estado estado() const { return _estado; }
+  bool conectado() const { return _estado == CONECTADO; }
+  bool apAtivo() const { return _apAtivo; }
+  IPAddress ipAp() const { return IPAddress(192, 168, 4, 1); }
+  unsigned long duracaoUltimaConexaoMs() const { return _duracaoUltimaConexao; }
+  unsigned long reconexoes() const { return _reconexoes; }
+
+private:
+  void carregarCredenciais();
+  void comecarTentativa(unsigned long agora);
+  void guardarCanal();
+  void iniciarAp();
+  void encerrarAp();
+
+  const char* _apSsid;
+  const char* _apSenha;
+  Preferences* _preferences = nullptr;
+  DNSServer _dns;
+  String _ssid;
+  String _senha;
+  uint8_t _canal = 0;
+  uint8_t _bssid[6] = {};
+  bool _usarCache = false;
+
+  Estado _estado = SEM_REDE;
+  bool _apAtivo = false;
+  int _falhas = 0;
+  unsigned long _inicioEstado = 0;
+  unsigned long _duracaoUltimaConexao = 0;
+  unsigned long _reconexoes = 0;
+};
@@ -0,0 +1,75 @@
+/*
+  Leitura não bloqueante dos DS18B20 de um barramento OneWire.
+  -----------------------------------------------------------
+  Em vez de chamar requestTemperatures() e esperar até 750 ms pela conversão,
+  o leitor dispara a conversão, retorna imediatamente e só coleta os valores
+  em passadas posteriores do loop(), depois de decorrido o tempo de conversão
+  da resolução configurada.
+
+  Os sensores são procurados uma vez só, em iniciar(), e guardados pelo
+  endereço ROM: getTempCByIndex() refaria a busca no barramento a cada
+  chamada. A conversão é um único comando para todos os sensores (broadcast)
+  e a coleta lê um sensor por passada, pelo endereço, de modo que o tempo de
+  barramento de cada passada não cresce com o número de sensores.
+
+  O leitor não consulta millis() por conta própria: o instante atual é
+  passado em atualizar(), o que permite exercitá-lo no host com sensores
+  simulados que tenham atraso de conversão configurável.
+
+  O DS18B20 liga com 85 °C no scratchpad: um sensor que reiniciou (mau
+  contato, queda na alimentação) ou uma leitura antes do fim da conversão
+  devolvem exatamente esse valor. Um 85,0 só é aceito quando a conversão
+  seguinte do mesmo sensor o repete; até lá a leitura é descartada, para não
+  disparar a proteção de temperatura por um valor que o sensor nem mediu.
+*/
+#pragma once
+
+#include <Arduino.h>
+#include <DallasTemperature.h>
+
+class LeitorTemperatura {
+public:
+  static const uint8_t MAX_SENSORES = 8;
+  static constexpr float VALOR_AO_LIGAR = 85.0f;  // scratchpad do DS18B20 antes da primeira conversão
+
+  enum Resultado {
+    SEM_NOVIDADE,   // nada a fazer nesta passada (aguardando período ou conversão, ou um 85 °C a confirmar)
+    LEITURA_NOVA,   // uma nova temperatura do sensor sensorLido() está em ultimaLeitura()
+    ERRO_SENSOR     // a conversão terminou mas o sensor sensorLido() não respondeu (ou não existe)
+  };
+
+  explicit LeitorTemperatura(DallasTemperature& sensores);
+
+  // Deve ser chamado após sensors.begin(). Procura os sensores no barramento e
+  // usa os `esperados` primeiros, na ordem da busca por ROM.
+  void iniciar(uint8_t esperados, uint8_t resolucao, unsigned long intervaloMs);
+  // Pode ser chamado a qualquer momento; uma conversão em andamento é descartada.
+  void configurar(uint8_t resolucao, unsigned long intervaloMs);
+
+  Resultado atualizar(unsigned long agora);
+
+  uint8_t sensorLido() const { return _sensorLido; }
+  float ultimaLeitura(uint8_t sensor = 0) const { return sensor < MAX_SENSORES ? _ultimasLeituras[sensor] : DEVICE_DISCONNECTED_C; }
+  uint8_t sensoresEncontrados() const { return _encontrados; }
+  // Endereço ROM do sensor, ou nullptr se ele não foi encontrado no boot.
+  const uint8_t* endereco(uint8_t sensor) const { return sensor < _encontrados ? _enderecos[sensor] : nullptr; }
+  uint8_t resolucao() const { return _resolucao; }
+  unsigned long intervalo() const { return _intervaloMs; }
+  unsigned long tempoConversao() const { return _tempoConversaoMs; }
+
+private:
+  DallasTemperature& _sensores;
+  DeviceAddress _enderecos[MAX_SENSORES];
+  uint8_t _esperados = 1;
+  uint8_t _encontrados = 0;
+  uint8_t _resolucao = 12;
+  unsigned long _intervaloMs = 1000UL;
+  unsigned long _tempoConversaoMs = 750UL;
+  bool _convertendo = false;
+  bool _primeiraConversao = true;
+  uint8_t _proximoColetado = 0;
+  uint8_t _sensorLido = 0;
+  unsigned long _inicioConversao = 0;
+  float _ultimasLeituras[MAX_SENSORES];
+  bool _ultimaFoiAoLigar[MAX_SENSORES] = {};  // a última conversão do sensor devolveu VALOR_AO_LIGAR
+};
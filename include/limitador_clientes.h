@@ -0,0 +1,60 @@
+/*
+  Limite de requisições por cliente do servidor web.
+  -------------------------------------------------
+  O WebServer do ESP32 atende uma conexão por vez, dentro do loop(): um
+  cliente que dispara requisições sem parar (um script em laço, um painel
+  com defeito, alguém tentando senhas) ocupa o loop() e atrasa todos os
+  outros. Cada endereço IP tem um balde de fichas: taxaPorS() fichas por
+  segundo, até rajada() acumuladas (o carregamento do painel pede uma dezena
+  de arquivos de uma vez), e cada requisição gasta o seu custo; o login, que
+  deriva a senha, gasta custoLogin(). Sem fichas a requisição é recusada com
+  429 e Retry-After antes de qualquer trabalho, inclusive a autenticação.
+  Os três valores partem dos padrões abaixo e podem ser trocados com
+  configurar() (POST /configlimite, guardado no NVS).
+
+  São acompanhados até MAX_CLIENTES endereços. Um endereço novo com a
+  tabela cheia toma o lugar do que está parado há mais tempo, que parado
+  já teria o balde cheio de novo. Sem alocação: um laço curto por requisição.
+*/
+#pragma once
+
+#include <stdint.h>
+
+class LimitadorClientes {
+public:
+  static const int MAX_CLIENTES = 16;
+  static const uint32_t TAXA_PADRAO_POR_S = 5;
+  static const uint32_t RAJADA_PADRAO = 30;
+  static const uint32_t CUSTO_LOGIN_PADRAO = 10;
+  static const uint32_t TAXA_MAXIMA_POR_S = 1000;
+  static const uint32_t RAJADA_MAXIMA = 1000;
+
+  // Recusa (e mantém os valores atuais) taxa ou rajada fora de 1..máxima e
+  // login que custe mais que a rajada, que nunca seria atendido.
+  bool configurar(uint32_t taxaPorS, uint32_t rajada, uint32_t custoLogin);
+  // true se a requisição de `ip` pode ser atendida agora; senão `esperaS` diz quando tentar de novo.
+  bool admitir(uint32_t ip, unsigned long agora, uint32_t custo, uint32_t& esperaS);
+
+  uint32_t taxaPorS() const { return _taxaPorS; }
+  uint32_t rajada() const { return _rajada; }
+  uint32_t custoLogin() const { return _custoLogin; }
+  unsigned long aceitas() const { return _aceitas; }
+  unsigned long recusadas() const { return _recusadas; }
+  int acompanhados() const;
+
+private:
+  // Fichas em milésimos: com taxaPorS() por segundo, cada ms rende taxaPorS() milésimos.
+  struct Cliente {
+    uint32_t ip;
+    uint32_t milesimos;
+    uint32_t ultimo;              // millis() da última requisição
+    bool ocupado;
+  };
+
+  Cliente _clientes[MAX_CLIENTES] = {};
+  uint32_t _taxaPorS = TAXA_PADRAO_POR_S;
+  uint32_t _rajada = RAJADA_PADRAO;
+  uint32_t _custoLogin = CUSTO_LOGIN_PADRAO;
+  unsigned long _aceitas = 0;
+  unsigned long _recusadas = 0;
+};
@@ -0,0 +1,128 @@
+/*
+  Máquina de estados do compressor de um canal.
+  --------------------------------------------
+  Quem decide o relé é uma tabela de transições (origem, sinal, guarda,
+  destino, efeitos) fixa em tempo de compilação, no lugar das combinações de
+  flags de antes (modo manual, desligado por temperatura, pausa térmica,
+  falha de corrente). despachar() procura as linhas de (modo, sinal) por um
+  índice também montado na compilação e aplica a primeira cuja guarda passa,
+  sem alocar nada. As regras de segurança da tabela (só liga com guarda, o
+  relé acompanha o modo, só o automático sai do manual) são conferidas por
+  static_assert.
+
+  A máquina é pura: a decisão depende só do modo, do contexto abaixo e do
+  evento, que traz tudo o que as guardas leem (instante, temperatura, boia,
+  limites e tempos em uso). Quem executa os efeitos (relé, contadores, log)
+  é o controle; a máquina só devolve a transição escolhida. Por isso um
+  SINAL_CICLO que não casa nenhuma linha não muda nada e não precisa ser
+  gravado: a sequência das transições basta para reproduzir um incidente
+  (ver rastro_compressor.h).
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "medidor_corrente.h"
+
+// Parada preditiva: acontece esse tempo antes do limite.
+const float ANTECIPACAO_TERMICA_S = 30.0f;
+// Depois de um desligamento por funcionamento a seco, o poço tem esse tempo para se recuperar;
+// a espera dobra a cada desarme seguido e no MAX_DESARMES_SECO o canal para até voltarem ao automático.
+const unsigned long ESPERA_APOS_SECO_MS = 1800000UL;
+const uint8_t MAX_DESARMES_SECO = 3;
+
+enum ModoCompressor : uint8_t {
+  MODO_DESCANSO,               // automático, relé aberto até vencer o descanso
+  MODO_LIGADO,                 // automático, relé fechado até vencer o tempo ligado
+  MODO_PAUSA_PREDITIVA,        // automático, parado antes do limite até esfriar
+  MODO_PARADA_TERMICA,         // automático, desligamento de emergência até esfriar
+  MODO_FALHA_CORRENTE,         // automático, parado até liberarem (ou o poço seco se recuperar, antes do bloqueio)
+  MODO_MANUAL_LIGADO,
+  MODO_MANUAL_DESLIGADO,
+  MODO_MANUAL_PARADA_TERMICA,  // manual, desligado no limite: só religa abaixo da temperatura de religamento
+  NUM_MODOS_COMPRESSOR
+};
+
+enum SinalCompressor : uint8_t {
+  SINAL_CICLO,                 // um ciclo de controle: temporizadores e liberações
+  SINAL_CAIXA_CHEIA,           // borda da boia
+  SINAL_TEMPERATURA_ALTA,      // leitura no limite com o relé fechado
+  SINAL_ERRO_SENSOR,
+  SINAL_FALHA_CORRENTE,
+  SINAL_MEDICAO_DESLIGADA,     // corrente nominal zerada: a falha registrada deixa de valer
+  SINAL_LIGAR,                 // comandos (HTTP ou MQTT)
+  SINAL_DESLIGAR,
+  SINAL_AUTOMATICO,
+  NUM_SINAIS_COMPRESSOR
+};
+
+// O que a transição pede a quem executa; o temporizador e a falha a máquina já aplicou.
+enum EfeitoCompressor : uint16_t {
+  EFEITO_LIGAR_RELE           = 1 << 0,
+  EFEITO_DESLIGAR_RELE        = 1 << 1,
+  EFEITO_REINICIAR_TEMPO      = 1 << 2,   // o tempo ligado (ou o descanso) conta a partir do evento
+  EFEITO_EMERGENCIA           = 1 << 3,
+  EFEITO_PARADA_PREDITIVA     = 1 << 4,
+  EFEITO_TEMPERATURA_LIBERADA = 1 << 5,
+  EFEITO_REGISTRAR_FALHA      = 1 << 6,
+  EFEITO_LIBERAR_FALHA        = 1 << 7,
+  EFEITO_DESCANSO_FORCADO     = 1 << 8,
+  EFEITO_FIM_CICLO            = 1 << 9,   // fim do tempo ligado: vale gravar os contadores
+  EFEITO_ZERAR_DESARMES       = 1 << 10   // o poço respondeu (ou alguém liberou): recomeça a contagem a seco
+};
+
+// Tamanho e campos fixos: o mesmo registro vale no ESP32 e no host (rastro).
+struct EventoCompressor {
+  SinalCompressor sinal;
+  FalhaCorrente falha;            // de SINAL_FALHA_CORRENTE
+  bool caixaCheia;
+  uint8_t reservado;
+  uint32_t instante;              // millis()
+  float temperatura;
+  float temperaturaMaxima;
+  float temperaturaReligamento;
+  float segundosAteLimite;        // previsão térmica com o relé fechado; negativo sem previsão
+  uint32_t tempoLigadoMs;         // tempos do ciclo automático em uso
+  uint32_t tempoDescansoMs;
+};
+static_assert(sizeof(EventoCompressor) == 32, "EventoCompressor faz parte do formato do rastro");
+
+struct MaquinaCompressor {
+  ModoCompressor modo;
+  FalhaCorrente falha;            // a que parou o compressor, até ser liberada
+  uint8_t desarmesSeco;           // desarmes a seco seguidos, sem um ciclo completo no meio
+  uint8_t reservado;
+  uint32_t inicioTemporizador;    // de onde contam o tempo ligado e o descanso
+  uint32_t instanteFalha;
+};
+static_assert(sizeof(MaquinaCompressor) == 12, "MaquinaCompressor faz parte do formato do rastro");
+
+typedef bool (*GuardaCompressor)(const MaquinaCompressor& maquina, const EventoCompressor& evento);
+
+struct TransicaoCompressor {
+  ModoCompressor origem;
+  SinalCompressor sinal;
+  GuardaCompressor guarda;        // nullptr: sempre
+  ModoCompressor destino;
+  uint16_t efeitos;
+};
+
+constexpr bool releLigado(ModoCompressor modo) { return modo == MODO_LIGADO || modo == MODO_MANUAL_LIGADO; }
+constexpr bool modoManual(ModoCompressor modo) { return modo >= MODO_MANUAL_LIGADO; }
+
+// Quanto o poço espera depois do desarme a seco de número `desarmes` (30 min, 60 min, ...).
+constexpr unsigned long esperaAposSeco(uint8_t desarmes) {
+  return desarmes <= 1 ? ESPERA_APOS_SECO_MS : ESPERA_APOS_SECO_MS << (desarmes - 1);
+}
+constexpr bool secoBloqueado(const MaquinaCompressor& m) {
+  return m.falha == FALHA_FUNCIONAMENTO_SECO && m.desarmesSeco >= MAX_DESARMES_SECO;
+}
+
+// Aplica o evento: a transição escolhida, ou nullptr se nenhuma linha casou (nada muda).
+const TransicaoCompressor* despachar(MaquinaCompressor& maquina, const EventoCompressor& evento);
+
+// A tabela inteira, para as conferências e a cobertura no host.
+const TransicaoCompressor* tabelaTransicoes(size_t& quantidade);
+
+const char* nomeModoCompressor(ModoCompressor modo);
+const char* nomeSinalCompressor(SinalCompressor sinal);
@@ -0,0 +1,117 @@
+/*
+  Corrente do compressor por transformador de corrente (opcional).
+  ---------------------------------------------------------------
+  Um TC de núcleo aberto (SCT-013-030: 30 A -> 1 V) por canal, com o resistor
+  de carga e a polarização no meio da escala, num pino do ADC1. O ADC roda em
+  modo contínuo com DMA a FREQUENCIA_CORRENTE_HZ por canal: o hardware enche
+  o buffer do driver sozinho e a tarefa de controle só recolhe, a cada ciclo,
+  o que já foi convertido (leitura com espera zero), sem esperar conversão.
+
+  O núcleo (processar) separa as conversões por canal e acumula, em inteiros
+  de 32 bits, a soma e a soma dos quadrados das amostras centradas no meio da
+  escala. A cada AMOSTRAS_POR_JANELA amostras de um canal (JANELA_CORRENTE_MS,
+  um número inteiro de ciclos em 50 e em 60 Hz) sai o valor eficaz, sem o
+  resto de nível DC da polarização: Irms² = E[x²] - E[x]², uma raiz por
+  janela. A potência é estimada com a tensão nominal e FATOR_POTENCIA (não há
+  medição de tensão).
+
+  DetectorFalhaCorrente compara cada janela com a corrente nominal do motor:
+  - relé fechado sem corrente: contator que não fechou, disjuntor ou motor aberto;
+  - corrente de partida que não cai: rotor bloqueado;
+  - corrente bem abaixo da nominal em regime: o compressor sopra sem coluna
+    d'água para empurrar (poço seco);
+  - corrente com o relé aberto: contator colado (só alarme; o relé já está aberto).
+  Como o EstimadorTermico, só campos simples: viaja dentro do EstadoControle.
+*/
+#pragma once
+
+#include <Arduino.h>
+#include <driver/adc.h>
+
+const uint32_t FREQUENCIA_CORRENTE_HZ = 2000;   // por canal; 8 canais = 16 kHz no ADC
+const unsigned long JANELA_CORRENTE_MS = 100;   // 5 ciclos de 50 Hz, 6 de 60 Hz
+const uint32_t AMOSTRAS_POR_JANELA = FREQUENCIA_CORRENTE_HZ * JANELA_CORRENTE_MS / 1000UL;
+const int32_t MEIO_ESCALA_ADC = 2048;
+// 1 V eficaz no TC a 30 A; ~3,1 V de fundo de escala em 12 bits com atenuação de 11 dB.
+const float AMPERES_POR_CONTAGEM = 30.0f * 3.1f / 4095.0f;
+const float FATOR_POTENCIA = 0.8f;
+// Abaixo disso é ruído do ADC, não corrente: contaria como energia com o compressor parado.
+const float CORRENTE_MINIMA_A = 0.15f;
+
+// Centradas, as amostras cabem em ±2048: 1024 quadrados ainda somam menos que 2^32.
+static_assert(AMOSTRAS_POR_JANELA <= 1024, "a soma dos quadrados de uma janela deve caber em 32 bits");
+
+// Janelas fechadas de um canal desde a última leitura.
+struct LeituraCorrente {
+  uint16_t janelas;
+  float correnteA;        // valor eficaz da mais recente
+  float somaCorrentesA;   // soma dos valores eficazes de todas (para a energia)
+};
+
+class MedidorCorrente {
+public:
+  static const size_t CONVERSOES_POR_LEITURA = 256;
+  static const uint32_t BUFFER_DRIVER_BYTES = 4096;   // ~64 ms a 16 kHz antes de transbordar
+
+  // Liga o ADC contínuo nos `pinos` (um por canal, GPIO1..10 do ESP32-S3 = ADC1_CHANNEL_0..9).
+  bool iniciar(const uint8_t* pinos, uint8_t canais);
+  void parar();
+  bool ativo() const { return _ativo; }
+
+  // Recolhe o que o DMA já converteu, sem esperar; chamado a cada ciclo de controle.
+  void atualizar();
+  // Núcleo: separa as conversões por canal e fecha as janelas completas.
+  void processar(const adc_digi_output_data_t* conversoes, size_t quantidade);
+  // O que fechou no canal desde a última chamada (e zera).
+  LeituraCorrente ler(uint8_t canal);
+
+  unsigned long conversoes() const { return _conversoes; }
+
+private:
+  struct Janela {
+    int32_t soma;
+    uint32_t somaQuadrados;
+    uint32_t amostras;
+  };
+
+  void fecharJanela(uint8_t canal);
+
+  bool _ativo = false;
+  uint8_t _canais = 0;
+  int8_t _canalDoAdc[16];
+  Janela _janelas[8] = {};
+  LeituraCorrente _leituras[8] = {};
+  unsigned long _conversoes = 0;
+  adc_digi_output_data_t _buffer[CONVERSOES_POR_LEITURA];
+};
+
+enum FalhaCorrente : uint8_t {
+  FALHA_NENHUMA,
+  FALHA_SEM_CORRENTE,
+  FALHA_ROTOR_BLOQUEADO,
+  FALHA_FUNCIONAMENTO_SECO,
+  FALHA_CORRENTE_SEM_RELE
+};
+
+// Nome curto da falha, para o /status e o /metrics.
+const char* nomeFalhaCorrente(FalhaCorrente falha);
+
+struct DetectorFalhaCorrente {
+  static constexpr float FRACAO_SEM_CORRENTE = 0.2f;      // da nominal
+  static constexpr float FRACAO_ROTOR_BLOQUEADO = 2.5f;
+  static constexpr float FRACAO_SECO = 0.7f;
+  static const unsigned long ATRASO_CONTATOR_MS = 500UL;  // fechamento do contator e janela misturada
+  static const unsigned long CONFIRMACAO_MS = 2000UL;     // sem corrente, com o relé aberto
+  static const unsigned long PARTIDA_MAXIMA_MS = 2000UL;  // uma partida normal cai bem antes
+  static const unsigned long ESTABILIZACAO_MS = 10000UL;  // antes disso o regime não vale para o seco
+  static const unsigned long CONFIRMACAO_SECO_MS = 30000UL;
+
+  unsigned long semCorrenteMs;
+  unsigned long acimaPartidaMs;
+  unsigned long abaixoRegimeMs;
+  unsigned long comReleAbertoMs;
+
+  void reiniciar();
+  // Uma ou mais janelas (`duracaoMs`) com o valor eficaz mais recente; `ligadoHaMs` desde o fechamento do relé.
+  FalhaCorrente avaliar(float correnteA, bool ligado, unsigned long ligadoHaMs, unsigned long duracaoMs, float nominalA);
+};
@@ -0,0 +1,86 @@
+/*
+  Perfil de tempo das etapas do loop() e da tarefa de controle.
+  ------------------------------------------------------------
+  Cada etapa tem um histograma de faixas fixas (LIMITES_US), a soma, a
+  contagem e o pior caso desde o boot, tudo em ciclos de CPU. Registrar uma
+  amostra é ler o contador de ciclos, subtrair, achar a faixa e somar: bem
+  abaixo de 1 µs a 240 MHz. A conversão para segundos só acontece ao
+  exportar (/metrics).
+
+  Uso encadeado, uma linha por etapa:
+    uint32_t marca = lerCiclos();
+    server.handleClient();
+    marca = perfilador.registrar(ETAPA_HTTP, marca);
+
+  Cada etapa tem um único escritor (o loop() ou a tarefa de controle). Quem
+  exporta lê sem trava e pode ver soma e contagem de instantes ligeiramente
+  diferentes, o que é aceitável para métricas.
+*/
+#pragma once
+
+#include <Arduino.h>
+
+#ifdef ARDUINO
+static inline uint32_t lerCiclos() { return ESP.getCycleCount(); }
+#else
+#include <chrono>
+// No host, "ciclos" são nanossegundos do relógio monotônico.
+static inline uint32_t lerCiclos() {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#endif
+
+enum EtapaPerfil : uint8_t {
+  ETAPA_WIFI,          // gerenciador de WiFi (inclui o DNS do portal cativo)
+  ETAPA_HTTP,          // server.handleClient()
+  ETAPA_PERSISTENCIA,  // salvarConfiguracoesOperacao()
+  ETAPA_GRAFICO,       // registrarTemperatura()
+  ETAPA_TELEMETRIA,    // registrarTelemetria()
+  ETAPA_EVENTOS,       // publicarEventos()
+  ETAPA_MQTT,          // publicarMqtt()
+  ETAPA_LOG,           // registroEventos.descarregar()
+  ETAPA_AUTENTICACAO,  // autenticar(), dentro do server.handleClient()
+  ETAPA_LOOP,          // o loop() inteiro
+  ETAPA_SENSORES,      // atualizarSensores() na tarefa de controle
+  ETAPA_CONTROLE,      // despacho da máquina de estados na tarefa de controle
+  NUM_ETAPAS
+};
+
+class Perfilador {
+public:
+  static const int NUM_FAIXAS = 9;
+  static const uint32_t LIMITES_US[NUM_FAIXAS];
+  static const char* const NOMES_ETAPAS[NUM_ETAPAS];
+
+  struct Histograma {
+    uint32_t contagem[NUM_FAIXAS + 1];  // a última faixa é "acima do maior limite"
+    uint64_t somaCiclos;
+    uint32_t maximoCiclos;
+  };
+
+  // ciclosPorUs: frequência da CPU em MHz (no host, 1000).
+  void iniciar(uint32_t ciclosPorUs);
+  // Registra o tempo desde `inicio` na etapa e retorna o contador atual, para encadear.
+  uint32_t registrar(EtapaPerfil etapa, uint32_t inicio) {
+    uint32_t agora = lerCiclos();
+    uint32_t duracao = agora - inicio;
+    Histograma& h = _etapas[etapa];
+    int faixa = 0;
+    while (faixa < NUM_FAIXAS && duracao > _limitesCiclos[faixa]) faixa++;
+    h.contagem[faixa]++;
+    h.somaCiclos += duracao;
+    if (duracao > h.maximoCiclos) h.maximoCiclos = duracao;
+    return agora;
+  }
+
+  const Histograma& histograma(EtapaPerfil etapa) const { return _etapas[etapa]; }
+  uint32_t ciclosPorUs() const { return _ciclosPorUs; }
+
+private:
+  Histograma _etapas[NUM_ETAPAS] = {};
+  uint32_t _limitesCiclos[NUM_FAIXAS] = {};
+  uint32_t _ciclosPorUs = 1;
+};
+
+extern Perfilador perfilador;
@@ -0,0 +1,31 @@
+/*
+  Gravação e leitura dos dados de operação no NVS (Preferences).
+  -------------------------------------------------------------
+  Todos os dados vão num único blob versionado com CRC-32, gravado
+  alternadamente em duas chaves: ao carregar, vale a cópia válida de maior
+  sequência, então uma queda de energia no meio da gravação não perde nada
+  além da própria gravação. As chaves avulsas das versões anteriores são
+  migradas e apagadas no primeiro boot.
+*/
+#pragma once
+
+#include <Preferences.h>
+#include "controle.h"
+
+extern const ParametrosOperacao PARAMETROS_PADRAO;
+
+struct EstatisticasPersistencia {
+  unsigned long gravacoes;
+  unsigned long bytesGravados;
+  unsigned long gravacoesEvitadas;  // versão marcada, mas nenhum campo mudou
+  unsigned long falhas;
+  unsigned long latenciaUltimaUs;
+  unsigned long latenciaMaximaUs;
+  unsigned long sequencia;          // número de sequência do retrato atual no NVS
+};
+
+void carregarConfiguracoesOperacao(Preferences& preferences, DadosPersistentes& dados);
+// Grava o retrato publicado pela tarefa de controle se ele mudou desde a última
+// gravação e se já passou o intervalo mínimo entre gravações. Retorna true se gravou.
+bool salvarConfiguracoesOperacao(Preferences& preferences, const EstadoControle& estado, unsigned long agora);
+EstatisticasPersistencia lerEstatisticasPersistencia();
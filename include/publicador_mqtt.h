@@ -0,0 +1,105 @@
+/*
+  Telemetria por MQTT: amostras em lotes binários, com fila para quedas.
+  ---------------------------------------------------------------------
+  Cada canal gera uma AmostraMqtt (16 bytes) a cada INTERVALO_AMOSTRAGEM_MS,
+  ou antes se o relé, a boia ou o modo mudarem. As amostras de todos os
+  canais vão para um lote, fechado quando enche ou, com a fila vazia,
+  quando a amostra mais antiga completa INTERVALO_LOTE_MS. Cada lote é uma
+  mensagem em
+  <prefixo>/telemetria:
+
+    CabecalhoLoteMqtt (8 bytes) + N x AmostraMqtt, little-endian
+
+  Os lotes fechados esperam numa fila de CAPACIDADE_FILA lotes e saem em
+  ordem quando há conexão; enquanto há lotes esperando, o atual só fecha
+  cheio, e a fila guarda CAPACIDADE_FILA x AMOSTRAS_POR_LOTE amostras (64 min
+  com um canal). Com o broker ou o WiFi fora por mais tempo do que isso, o lote mais antigo é descartado para dar lugar ao
+  novo; o número de sequência do cabeçalho deixa o buraco visível para quem
+  recebe (o canal 0 continua inteiro no /telemetria).
+
+  Esta classe não sabe nada de rede: descarregar() recebe a função que
+  publica um lote e para no primeiro que ela recusar. A conexão, o estado
+  retido e os comandos ficam em ClienteMqtt (cliente_mqtt.h).
+*/
+#pragma once
+
+#include <Arduino.h>
+#include "controle.h"
+
+struct AmostraMqtt {
+  uint32_t instante;               // como em AmostraTelemetria
+  int16_t temperaturaCentesimos;
+  uint8_t canal;
+  uint8_t flags;                   // AmostraTelemetria::FLAG_*
+  uint32_t ciclosParciaisOperacao;
+  uint32_t ciclosEnchimentoCompletos;
+};
+static_assert(sizeof(AmostraMqtt) == 16, "AmostraMqtt deve ter 16 bytes");
+
+struct CabecalhoLoteMqtt {
+  uint8_t versao;
+  uint8_t amostras;
+  uint16_t reservado;
+  uint32_t sequencia;              // +1 a cada lote fechado, inclusive os descartados
+};
+static_assert(sizeof(CabecalhoLoteMqtt) == 8, "CabecalhoLoteMqtt deve ter 8 bytes");
+
+// Bytes de um PUBLISH QoS 0 na conexão (cabeçalho fixo, tópico e dados), sem TCP/IP.
+inline size_t tamanhoPublishMqtt(size_t tamanhoTopico, size_t tamanhoDados) {
+  size_t restante = 2 + tamanhoTopico + tamanhoDados;
+  size_t bytesTamanho = restante < 128 ? 1 : restante < 16384 ? 2 : restante < 2097152 ? 3 : 4;
+  return 1 + bytesTamanho + restante;
+}
+
+// Publica um lote; retorna false se não foi possível (o lote fica na fila).
+typedef bool (*PublicarLoteMqtt)(const uint8_t* dados, size_t tamanho, void* contexto);
+
+class PublicadorMqtt {
+public:
+  static const uint8_t VERSAO_LOTE = 1;
+  static const int AMOSTRAS_POR_LOTE = 32;
+  static const int CAPACIDADE_FILA = 24;                        // ~12 KB de RAM
+  static const unsigned long INTERVALO_AMOSTRAGEM_MS = 5000UL;
+  static const unsigned long INTERVALO_MINIMO_MS = 1000UL;      // entre amostras disparadas por mudança
+  static const unsigned long INTERVALO_LOTE_MS = 60000UL;
+  static const int LOTES_POR_DESCARGA = 4;                      // por chamada, para não segurar o loop()
+
+  void amostrar(const EstadoControle& estado, unsigned long agoraMs, uint32_t instante, bool relogioSincronizado);
+  // Fecha o lote vencido (ou o atual, se forcar) e publica a fila em ordem.
+  // Retorna quantos lotes saíram.
+  int descarregar(PublicarLoteMqtt publicar, void* contexto, unsigned long agoraMs, bool forcar = false);
+
+  unsigned long amostras() const { return _amostras; }
+  unsigned long lotesPublicados() const { return _lotesPublicados; }
+  unsigned long amostrasPublicadas() const { return _amostrasPublicadas; }
+  unsigned long bytesPublicados() const { return _bytesPublicados; }
+  unsigned long lotesDescartados() const { return _lotesDescartados; }
+  unsigned long amostrasDescartadas() const { return _amostrasDescartadas; }
+  int lotesNaFila() const { return _naFila; }
+
+private:
+  struct Lote {
+    CabecalhoLoteMqtt cabecalho;
+    AmostraMqtt amostras[AMOSTRAS_POR_LOTE];
+  };
+
+  void fecharLote();
+
+  Lote _atual = {};
+  unsigned long _inicioLote = 0;
+  uint32_t _sequencia = 0;
+  Lote _fila[CAPACIDADE_FILA];
+  int _primeiro = 0;
+  int _naFila = 0;
+
+  unsigned long _ultimaAmostra[NUM_CANAIS] = {};
+  uint8_t _ultimasFlags[NUM_CANAIS] = {};
+  bool _temAmostra = false;
+
+  unsigned long _amostras = 0;
+  unsigned long _lotesPublicados = 0;
+  unsigned long _amostrasPublicadas = 0;
+  unsigned long _bytesPublicados = 0;
+  unsigned long _lotesDescartados = 0;
+  unsigned long _amostrasDescartadas = 0;
+};
@@ -0,0 +1,103 @@
+/*
+  Rastro da máquina de estados do compressor.
+  ------------------------------------------
+  Cada evento despachado à máquina de um canal (menos os SINAL_CICLO que
+  não mudaram nada) vira um RegistroRastro: o evento inteiro, a máquina
+  antes dele, o modo depois e os efeitos. A tarefa de controle só copia o
+  registro para uma FilaSpsc, sem esperar; o loop() recolhe em
+  descarregar() e guarda os últimos TAMANHO_HISTORICO, que saem em
+  GET /rastro num arquivo binário (CabecalhoRastro + registros).
+
+  Como a máquina é pura, o ReprodutorRastro refaz cada transição no host a
+  partir do `antes` do primeiro registro de cada canal e confere modo,
+  efeitos e contexto registro a registro: um incidente de campo se repete
+  exatamente no simulador (.pio/build/native/program --reproduzir ARQUIVO).
+  Registros perdidos com a fila cheia aparecem como buraco na sequência; o
+  reprodutor recomeça do `antes` do registro seguinte.
+*/
+#pragma once
+
+#include <Arduino.h>
+#include "controle.h"
+#include "estado_compartilhado.h"
+#include "exportacao.h"
+
+const uint32_t MAGICA_RASTRO = 0x504D4352UL;   // "RCMP" em little-endian
+const uint16_t VERSAO_RASTRO = 2;   // v2: MaquinaCompressor conta os desarmes a seco
+
+struct CabecalhoRastro {
+  uint32_t magica;
+  uint16_t versao;
+  uint16_t tamanhoRegistro;
+  uint8_t canais;
+  uint8_t reservado[3];
+  uint32_t registros;
+  uint32_t descartados;       // perdidos com a fila cheia desde o boot
+};
+static_assert(sizeof(CabecalhoRastro) == 20, "CabecalhoRastro é formato de arquivo");
+
+struct RegistroRastro {
+  uint32_t sequencia;         // conta também os perdidos
+  uint8_t canal;
+  ModoCompressor destino;
+  uint16_t efeitos;           // da transição; 0 se nenhuma linha casou
+  MaquinaCompressor antes;
+  EventoCompressor evento;
+};
+static_assert(sizeof(RegistroRastro) == 52, "RegistroRastro é formato de arquivo");
+
+class RastroCompressor {
+public:
+  static const size_t CAPACIDADE_FILA = 32;
+  static const size_t TAMANHO_HISTORICO = 128;
+
+  // Só da tarefa de controle; nunca bloqueia.
+  void registrar(uint8_t canal, const MaquinaCompressor& antes, const EventoCompressor& evento,
+                 const TransicaoCompressor* transicao);
+
+  // Só do loop(): move o que chegou para o histórico. Retorna quantos registros.
+  size_t descarregar();
+
+  // Os `ultimos` registros do histórico, do mais antigo ao mais novo (também só do loop()).
+  template <typename Funcao>
+  void percorrerHistorico(Funcao funcao, size_t ultimos = TAMANHO_HISTORICO) const {
+    size_t total = _noHistorico < TAMANHO_HISTORICO ? _noHistorico : TAMANHO_HISTORICO;
+    if (ultimos < total) total = ultimos;
+    for (size_t i = 0; i < total; i++) funcao(_historico[(_noHistorico - total + i) % TAMANHO_HISTORICO]);
+  }
+
+  // Cabeçalho e histórico, do mais antigo ao mais novo; retorna os bytes entregues.
+  size_t exportar(SaidaExportacao saida, void* contexto) const;
+
+  uint32_t registrados() const { return _sequencia.load(std::memory_order_relaxed) - descartados(); }
+  uint32_t descartados() const { return _descartados.load(std::memory_order_relaxed); }
+
+private:
+  FilaSpsc<RegistroRastro, CAPACIDADE_FILA> _fila;
+  std::atomic<uint32_t> _sequencia{0};
+  std::atomic<uint32_t> _descartados{0};
+  RegistroRastro _historico[TAMANHO_HISTORICO];
+  size_t _noHistorico = 0;
+};
+
+extern RastroCompressor rastroCompressor;
+
+class ReprodutorRastro {
+public:
+  // Refaz o registro na máquina do canal; false se o resultado não bate com o gravado.
+  bool reproduzir(const RegistroRastro& registro);
+
+  const MaquinaCompressor& maquina(uint8_t canal) const { return _maquinas[canal]; }
+  uint32_t reproduzidos() const { return _reproduzidos; }
+  uint32_t lacunas() const { return _lacunas; }
+  uint32_t divergencias() const { return _divergencias; }
+
+private:
+  MaquinaCompressor _maquinas[MAX_CANAIS] = {};
+  bool _sincronizada[MAX_CANAIS] = {};
+  bool _iniciado = false;
+  uint32_t _proximaSequencia = 0;
+  uint32_t _reproduzidos = 0;
+  uint32_t _lacunas = 0;
+  uint32_t _divergencias = 0;
+};
@@ -0,0 +1,151 @@
+/*
+  Registro de eventos diferido (log binário).
+  ------------------------------------------
+  Quem registra (a tarefa de controle, a persistência) não formata nem
+  escreve nada: grava só o identificador do evento, o canal, o instante e
+  até três argumentos de 32 bits numa FilaMpsc, sem esperar. A formatação
+  das mensagens (os textos com emoji de antes) acontece depois, no loop(),
+  em descarregar(): cada registro vai para a Serial só quando cabe no buffer
+  de transmissão, e os últimos ficam guardados para o endpoint /log.
+
+  Os eventos e seus níveis ficam na lista EVENTOS_LOG abaixo. O nível de
+  compilação (-DNIVEL_LOG=N, padrão NIVEL_LOG_INFO) descarta em tempo de
+  compilação as chamadas de nível acima dele: LOG_EVENTO de um evento
+  descartado não gera código nem avalia os argumentos.
+
+  Com a fila cheia o registro é perdido e contado; descarregar() avisa
+  quantos se perderam.
+*/
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include "estado_compartilhado.h"
+
+#define NIVEL_LOG_NENHUM 0
+#define NIVEL_LOG_ERRO 1
+#define NIVEL_LOG_AVISO 2
+#define NIVEL_LOG_INFO 3
+#define NIVEL_LOG_DEPURACAO 4
+
+#ifndef NIVEL_LOG
+#define NIVEL_LOG NIVEL_LOG_INFO
+#endif
+
+// X(nome, nível, texto): cada {} do texto recebe um argumento, na ordem.
+#define EVENTOS_LOG(X) \
+  X(LOG_DESCARTADOS, AVISO, "⚠️ {} mensagens de log descartadas (fila cheia).") \
+  X(ENCHIMENTO_PELO_COMPRESSOR, INFO, "💧 Iniciando novo ciclo de enchimento (disparo por compressor).") \
+  X(CICLO_PARCIAL, INFO, "⚡️ Ciclo parcial #{} iniciado. Total de ciclos: {}") \
+  X(COMPRESSOR_LIGADO, INFO, "🟢 COMPRESSOR LIGADO") \
+  X(COMPRESSOR_DESLIGADO, INFO, "🔴 COMPRESSOR DESLIGADO") \
+  X(CONTADORES_ZERADOS, AVISO, "🔄 Contadores e histórico de enchimento zerados pelo usuário.") \
+  X(ERRO_SENSOR, ERRO, "⚠️ ERRO DE SENSOR! Compressor desligado por segurança.") \
+  X(CAIXA_VAZIA, INFO, "💧 Caixa vazia detectada. Cronômetro de enchimento INICIADO.") \
+  X(CAIXA_CHEIA, INFO, "✅ Caixa Cheia! Tempo total: {} s, em {} ciclos parciais.") \
+  X(MODELO_ATUALIZADO, INFO, "🧠 Modelo: {} s ligado por enchimento; próximo ciclo {} s ligado, descanso base {} s.") \
+  X(CRONOMETRO_PARADO, DEPURACAO, "⏰ Cronômetro de enchimento PARADO.") \
+  X(DESCANSO_FORCADO, INFO, "⏰ Forçando ciclo de descanso completo.") \
+  X(DESLIGAMENTO_EMERGENCIA, ERRO, "‼️ DESLIGAMENTO DE EMERGÊNCIA! Temp ({}C) >= Limite ({}C).") \
+  X(TEMPERATURA_LIBERADA, INFO, "🌡️ Temperatura baixou o suficiente. Sistema liberado para religar.") \
+  X(PARADA_PREDITIVA, AVISO, "🌡️ Parada térmica preditiva: {}C, limite previsto em {} s.") \
+  X(CORRENTE_AUSENTE, ERRO, "⚡️ Relé fechado sem corrente ({} A): contator, disjuntor ou motor aberto. Compressor desligado.") \
+  X(ROTOR_BLOQUEADO, ERRO, "‼️ ROTOR BLOQUEADO! Corrente de partida ({} A) não caiu. Compressor desligado.") \
+  X(FUNCIONAMENTO_SECO, ERRO, "💧 Funcionamento a seco: {} A, abaixo de {} A em regime. Compressor desligado.") \
+  X(CORRENTE_SEM_RELE, ERRO, "⚠️ Corrente ({} A) com o relé aberto: contator colado?") \
+  X(FALHA_CORRENTE_LIBERADA, INFO, "⚡️ Falha de corrente liberada. Sistema liberado para religar.") \
+  X(MEDICAO_CORRENTE, INFO, "⚡️ Medição de corrente ativa em {} canais (nominal {} A).") \
+  X(ERRO_MEDICAO_CORRENTE, ERRO, "❌ Falha ao iniciar o ADC da medição de corrente.") \
+  X(SENSORES_ENCONTRADOS, INFO, "🌡️ {} de {} sensores de temperatura encontrados no barramento.") \
+  X(CONFIGURACOES_SALVAS, DEPURACAO, "💾 Configurações de operação salvas.") \
+  X(ERRO_GRAVACAO_NVS, ERRO, "❌ Erro ao gravar as configurações no NVS.") \
+  X(LIMITE_CLIENTES_ALTERADO, INFO, "🚦 Limite por cliente: {} requisições/s, rajada de {}, login custa {}.") \
+  X(CREDENCIAIS_ALTERADAS, AVISO, "🔐 Credenciais de acesso alteradas; as outras sessões foram encerradas.") \
+  X(MQTT_CONECTADO, INFO, "✅ MQTT conectado (porta {}).") \
+  X(MQTT_FALHA_CONEXAO, AVISO, "⚠️ MQTT: falha ao conectar (estado {}); nova tentativa em {} s.") \
+  X(MQTT_SEM_DNS, AVISO, "⚠️ MQTT: servidor não encontrado no DNS; nova tentativa em {} s.") \
+  X(SECO_NOVA_TENTATIVA, AVISO, "💧 Poço seco: nova tentativa em {} min.") \
+  X(SECO_BLOQUEADO, ERRO, "🔒 {} desarmes a seco seguidos: compressor parado até voltarem ao automático.")
+
+#define EVENTO_LOG_ENUM(nome, nivel, texto) EVENTO_##nome,
+enum EventoLog : uint16_t { EVENTOS_LOG(EVENTO_LOG_ENUM) NUM_EVENTOS_LOG };
+#undef EVENTO_LOG_ENUM
+
+#define EVENTO_LOG_NIVEL(nome, nivel, texto) NIVEL_LOG_##nivel,
+constexpr uint8_t NIVEIS_EVENTOS_LOG[NUM_EVENTOS_LOG] = { EVENTOS_LOG(EVENTO_LOG_NIVEL) };
+#undef EVENTO_LOG_NIVEL
+
+const uint8_t SEM_CANAL = 0xFF;
+
+// Um argumento de 32 bits com o tipo, para a formatação saber como mostrá-lo.
+struct ArgumentoLog {
+  enum Tipo : uint8_t { NENHUM, SEM_SINAL, COM_SINAL, REAL };
+  uint32_t palavra;
+  Tipo tipo;
+
+  ArgumentoLog() : palavra(0), tipo(NENHUM) {}
+  ArgumentoLog(unsigned long v) : palavra((uint32_t)v), tipo(SEM_SINAL) {}
+  ArgumentoLog(unsigned int v) : palavra(v), tipo(SEM_SINAL) {}
+  ArgumentoLog(long v) : palavra((uint32_t)v), tipo(COM_SINAL) {}
+  ArgumentoLog(int v) : palavra((uint32_t)v), tipo(COM_SINAL) {}
+  ArgumentoLog(float v) : tipo(REAL) { memcpy(&palavra, &v, sizeof(palavra)); }
+  ArgumentoLog(double v) : ArgumentoLog((float)v) {}
+};
+
+struct RegistroLog {
+  uint32_t instanteMs;
+  uint16_t evento;
+  uint8_t canal;
+  uint8_t tipos;              // 2 bits por argumento (ArgumentoLog::Tipo)
+  uint32_t argumentos[3];
+};
+
+class RegistroEventos {
+public:
+  static const size_t CAPACIDADE_FILA = 64;
+  static const size_t TAMANHO_HISTORICO = 64;   // os últimos, para o /log
+
+  // Seguro de qualquer tarefa; nunca bloqueia.
+  void registrar(EventoLog evento, uint8_t canal, ArgumentoLog a = ArgumentoLog(), ArgumentoLog b = ArgumentoLog(),
+                 ArgumentoLog c = ArgumentoLog());
+
+  // Só do loop(): formata o que couber no buffer da Serial sem bloquear e
+  // guarda no histórico. Retorna quantos registros foram escritos.
+  size_t descarregar();
+
+  // Texto de um registro (com "[canal N] " quando há mais de um canal), sem quebra de linha.
+  static size_t formatar(const RegistroLog& registro, char* destino, size_t tamanho);
+
+  // Percorre o histórico do mais antigo ao mais novo (também só do loop()).
+  template <typename Funcao>
+  void percorrerHistorico(Funcao funcao) const {
+    size_t total = _noHistorico < TAMANHO_HISTORICO ? _noHistorico : TAMANHO_HISTORICO;
+    for (size_t i = 0; i < total; i++) funcao(_historico[(_noHistorico - total + i) % TAMANHO_HISTORICO]);
+  }
+
+  uint32_t registrados() const { return _registrados.load(std::memory_order_relaxed); }
+  uint32_t descartados() const { return _descartados.load(std::memory_order_relaxed); }
+
+private:
+  FilaMpsc<RegistroLog, CAPACIDADE_FILA> _fila;
+  std::atomic<uint32_t> _registrados{0};
+  std::atomic<uint32_t> _descartados{0};
+  uint32_t _descartadosAvisados = 0;
+  bool _temPendente = false;       // um registro que não coube na Serial na passada anterior
+  RegistroLog _pendente;
+  unsigned long _pendenteDesdeMs = 0;
+  bool _serialTravada = false;
+  RegistroLog _historico[TAMANHO_HISTORICO];
+  size_t _noHistorico = 0;
+};
+
+extern RegistroEventos registroEventos;
+
+// LOG_EVENTO(CAIXA_CHEIA, canal, segundos, ciclos): some na compilação se o
+// nível do evento estiver acima de NIVEL_LOG.
+#define LOG_EVENTO(nome, canal, ...)                                                 \
+  do {                                                                              \
+    if constexpr (NIVEIS_EVENTOS_LOG[EVENTO_##nome] <= NIVEL_LOG) {                 \
+      registroEventos.registrar(EVENTO_##nome, (uint8_t)(canal), ##__VA_ARGS__);    \
+    }                                                                               \
+  } while (0)
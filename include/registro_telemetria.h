@@ -0,0 +1,104 @@
+/*
+  Registro binário de telemetria no SPIFFS.
+  ----------------------------------------
+  Cada amostra ocupa 16 bytes com CRC-8 próprio.
+
+  Só o canal 0 é gravado: com 8 canais o anel de 384 KB cobriria umas 4 h em
+  vez de ~34 h. Os demais canais saem amostra a amostra pelo MQTT
+  (publicador_mqtt.h), que traz o número do canal. As amostras são acumuladas em
+  RAM e gravadas em lote (no máximo uma vez por INTERVALO_DESCARGA_MS, ou
+  antes se o lote encher), sempre por acréscimo ao fim do segmento atual.
+
+  O log é um anel de NUM_SEGMENTOS arquivos (/tlm_00.bin ...). Cada segmento
+  começa com um cabeçalho que traz um número de geração crescente; ao
+  iniciar, o segmento de maior geração é o atual, e não existe nenhum
+  arquivo de índice que possa se corromper. Quando o segmento enche, o mais
+  antigo é apagado e reaproveitado com a geração seguinte, o que deixa o
+  nivelamento de desgaste por conta do SPIFFS.
+
+  Queda de energia: perde-se no máximo o lote em RAM. Um segmento com
+  gravação incompleta (tamanho quebrado) é abandonado no próximo boot, as
+  amostras inteiras dele continuam legíveis, e amostras com CRC inválido são
+  ignoradas na leitura. Um cabeçalho truncado ou corrompido (CRC-32) tira o
+  segmento do anel. test/test_registro_telemetria confere os três casos.
+*/
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+#include "controle.h"
+
+struct AmostraTelemetria {
+  uint32_t instante;             // epoch (s) se FLAG_RELOGIO_SINCRONIZADO, senão segundos desde o boot
+  int16_t temperaturaCentesimos;
+  uint8_t flags;
+  uint8_t crc;
+  uint32_t ciclosParciaisOperacao;
+  uint32_t ciclosEnchimentoCompletos;
+
+  static const uint8_t FLAG_COMPRESSOR = 1 << 0;
+  static const uint8_t FLAG_CAIXA_CHEIA = 1 << 1;
+  static const uint8_t FLAG_MODO_MANUAL = 1 << 2;
+  static const uint8_t FLAG_DESLIGADO_TEMPERATURA = 1 << 3;
+  static const uint8_t FLAG_RELOGIO_SINCRONIZADO = 1 << 4;
+};
+static_assert(sizeof(AmostraTelemetria) == 16, "AmostraTelemetria deve ter 16 bytes");
+
+// Chamado para cada amostra de um intervalo; retorna false para interromper a leitura.
+typedef bool (*VisitanteTelemetria)(const AmostraTelemetria& amostra, void* contexto);
+
+class RegistroTelemetria {
+public:
+  static const int NUM_SEGMENTOS = 12;
+  static const uint32_t AMOSTRAS_POR_SEGMENTO = 2048;       // 32 KB por segmento
+  static const int AMOSTRAS_POR_LOTE = 32;
+  static const unsigned long INTERVALO_AMOSTRAGEM_MS = 5000UL;
+  static const unsigned long INTERVALO_MINIMO_MS = 1000UL;   // entre amostras disparadas por mudança
+  static const unsigned long INTERVALO_DESCARGA_MS = 60000UL;
+
+  bool iniciar(fs::FS& fs);
+
+  // Registra uma amostra (do canal 0) se o intervalo venceu ou se o relé/caixa/modo mudou.
+  void amostrar(const EstadoControle& estado, unsigned long agoraMs, uint32_t instante, bool relogioSincronizado);
+  // Grava o lote em RAM se já passou o intervalo de descarga (ou se forcar).
+  void descarregar(unsigned long agoraMs, bool forcar = false);
+
+  // Percorre, da mais antiga para a mais nova, as amostras com instante em [de, ate],
+  // lendo um bloco pequeno por vez (inclui o lote ainda não gravado).
+  void percorrer(uint32_t de, uint32_t ate, VisitanteTelemetria visitante, void* contexto);
+
+  unsigned long amostrasGravadas() const { return _amostrasGravadas; }
+  unsigned long bytesGravados() const { return _bytesGravados; }
+  unsigned long falhasGravacao() const { return _falhasGravacao; }
+
+private:
+  struct Cabecalho {
+    uint32_t magico;
+    uint32_t geracao;
+    uint16_t versao;
+    uint16_t tamanhoAmostra;
+    uint32_t crc;
+  };
+  static_assert(sizeof(Cabecalho) == 16, "Cabecalho deve ter 16 bytes");
+
+  static void nomeSegmento(int indice, char* nome, size_t tamanho);
+  bool lerCabecalho(int indice, Cabecalho& cabecalho);
+  bool abrirNovoSegmento();
+  void anexar(const AmostraTelemetria& amostra);
+
+  fs::FS* _fs = nullptr;
+  int _segmentoAtual = -1;
+  uint32_t _geracaoAtual = 0;
+  uint32_t _amostrasNoSegmento = 0;
+
+  AmostraTelemetria _lote[AMOSTRAS_POR_LOTE];
+  int _noLote = 0;
+  unsigned long _ultimaDescarga = 0;
+  unsigned long _ultimaAmostra = 0;
+  bool _temAmostra = false;
+  uint8_t _ultimasFlags = 0;
+
+  unsigned long _amostrasGravadas = 0;
+  unsigned long _bytesGravados = 0;
+  unsigned long _falhasGravacao = 0;
+};
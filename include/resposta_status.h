@@ -0,0 +1,54 @@
+/*
+  Corpo JSON do /status, dos eventos e do /tempdata.
+  -------------------------------------------------
+  Só a serialização: quem chama cuida do WebServer e do envio. Fica fora do
+  main.cpp para o simulador (e os testes no host) montarem exatamente as
+  mesmas respostas que o firmware manda. escreverStatus() escreve só os
+  grupos de campos pedidos (CampoStatus); camposAlterados() diz quais
+  mudaram entre dois retratos, na resolução exibida.
+*/
+#pragma once
+
+#include <Arduino.h>
+#include "controle.h"
+#include "escritor_json.h"
+#include "serie_temporal.h"
+
+// Cada canal acrescenta uma entrada à lista "canais" do /status.
+const size_t TAMANHO_BUFFER_JSON = 1792 + 512 * NUM_CANAIS;
+
+// Grupos de campos do /status; os eventos levam só os grupos que mudaram.
+enum CampoStatus : uint32_t {
+  CAMPO_COMPRESSOR   = 1UL << 0,  // compressorLigado
+  CAMPO_TEMPERATURA  = 1UL << 1,  // temperatura, alertaTemperatura
+  CAMPO_CAIXA        = 1UL << 2,  // caixaCheia, alertaCaixaCheia
+  CAMPO_MODO         = 1UL << 3,  // modoManual, estadoControle
+  CAMPO_CONTADORES   = 1UL << 4,  // ciclosParciaisOperacao, ciclosEnchimentoCompletos
+  CAMPO_PARAMETROS   = 1UL << 5,  // tempoLigado, tempoDescanso, temperaturaMaxima, sensor
+  CAMPO_TEMPORIZADOR = 1UL << 6,  // tempoRestante, proximoEstado
+  CAMPO_HISTORICO    = 1UL << 7,  // historicoEnchimento, mediaEnchimento
+  CAMPO_DIAGNOSTICO  = 1UL << 8,  // latências do loop() e jitter da tarefa de controle
+  CAMPO_MODELO       = 1UL << 9,  // modelo, tempoLigadoAtual, tempoDescansoAtual
+  CAMPO_CANAIS       = 1UL << 10, // canais: resumo de cada canal (os campos avulsos são do canal 0)
+  CAMPO_CORRENTE     = 1UL << 11, // corrente, potencia, energia, falhaCorrente, desarmesSeco
+  CAMPOS_TODOS       = 0xFFFUL
+};
+
+// O que só o loop() sabe (CAMPO_DIAGNOSTICO); a tarefa de controle e o NVS são lidos aqui.
+struct DiagnosticoLoop {
+  unsigned long latenciaLoopUs;
+  unsigned long latenciaMaximaLoopUs;
+  unsigned long pilhaLoopLivreMinima;
+  unsigned long wifiConexaoMs;
+  unsigned long wifiReconexoes;
+};
+
+void escreverStatus(EscritorJson& json, const EstadoControle& retrato, uint32_t campos, const DiagnosticoLoop& diagnostico);
+uint32_t camposAlterados(const EstadoControle& anterior, const EstadoControle& atual);
+
+// Segundos até o próximo passo do ciclo automático e qual é ele.
+void calcularTemporizador(const EstadoCanal& estado, unsigned long& tempoRestante, const char*& proximoEstado);
+unsigned long mediaEnchimento(const DadosCanal& dados);
+
+// {"resolucao":..,"labels":[..],"dados":[..],"minimos":[..],"maximos":[..]} dos baldes do `nivel` dentro do intervalo.
+void escreverSerieTemperatura(EscritorJson& json, const SerieTemporal& serie, int nivel, uint32_t intervaloS);
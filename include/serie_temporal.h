@@ -0,0 +1,69 @@
+/*
+  Série temporal em RAM com agregação em cascata.
+  ----------------------------------------------
+  Cada nível guarda, num anel de tamanho fixo, o mínimo, o máximo e a média
+  de cada intervalo da sua resolução. Uma amostra entra só no acumulador do
+  nível mais fino; quando um intervalo fecha, o balde é gravado e repassado
+  ao acumulador do nível seguinte (mínimo dos mínimos, máximo dos máximos,
+  média ponderada pelo número de amostras). Assim cada amostra custa O(1)
+  e um pico de poucos segundos continua visível no máximo do nível de 1 h.
+
+  Memória: NUM_BALDES × 6 bytes, fixa em tempo de compilação.
+*/
+#pragma once
+
+#include <Arduino.h>
+
+// Chamado do balde mais antigo para o mais novo; idadeS é o tempo desde o início do balde.
+typedef void (*VisitanteSerie)(uint32_t idadeS, float minimo, float maximo, float media, void* contexto);
+
+class SerieTemporal {
+public:
+  struct Nivel {
+    uint32_t resolucaoS;
+    uint16_t capacidade;
+  };
+  static const int NUM_NIVEIS = 3;
+  static const Nivel NIVEIS[NUM_NIVEIS];  // 10 s × 1 h, 1 min × 24 h, 1 h × 30 dias
+  static const int NUM_BALDES = 360 + 1440 + 720;
+
+  SerieTemporal();
+
+  void registrar(float valor, unsigned long agoraMs);
+
+  // Primeiro nível com resolução >= resolucaoS; com resolucaoS == 0, o mais fino
+  // que cobre o intervalo pedido com no máximo maxPontos baldes.
+  static int escolherNivel(uint32_t resolucaoS, uint32_t intervaloS, uint32_t maxPontos);
+  // Percorre os baldes do nível nos últimos intervaloS segundos (0 = o anel inteiro),
+  // incluindo o balde ainda aberto.
+  void percorrer(int nivel, uint32_t intervaloS, VisitanteSerie visitante, void* contexto) const;
+
+  static size_t memoriaUsada() { return sizeof(SerieTemporal); }
+
+private:
+  struct Balde {
+    int16_t minimo;   // centésimos de grau; VAZIO marca balde sem amostras
+    int16_t maximo;
+    int16_t media;
+  };
+  struct Acumulador {
+    float minimo;
+    float maximo;
+    float soma;
+    uint32_t amostras;
+    uint32_t indice;  // início do balde / resolução do nível
+  };
+  static const int16_t VAZIO = INT16_MIN;
+
+  void agregar(int nivel, uint32_t indice, float minimo, float maximo, float soma, uint32_t amostras);
+  void fechar(int nivel);
+  static int deslocamento(int nivel);
+
+  Balde _baldes[NUM_BALDES];
+  Acumulador _acumuladores[NUM_NIVEIS] = {};
+  uint32_t _ultimoFechado[NUM_NIVEIS] = {};
+  bool _temFechado[NUM_NIVEIS] = {};
+  uint64_t _relogioMs = 0;
+  unsigned long _ultimoMs = 0;
+  bool _iniciada = false;
+};
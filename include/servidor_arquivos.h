@@ -0,0 +1,56 @@
+/*
+  Arquivos estáticos pré-comprimidos do painel.
+  --------------------------------------------
+  tools/gerar_assets.py grava no SPIFFS cada arquivo de data/ já comprimido
+  com gzip e o manifesto /assets.txt. Aqui o manifesto é lido no boot e:
+  - toda resposta sai com Content-Encoding: gzip e ETag forte (o hash do
+    conteúdo), e um If-None-Match igual responde 304 sem ler nada;
+  - os arquivos pequenos ficam em RAM (até ORCAMENTO_CACHE no total), os
+    demais são lidos do SPIFFS a cada envio;
+  - as URLs com impressão digital são marcadas como imutáveis, então o
+    navegador nem chega a revalidá-las.
+  Sem manifesto (SPIFFS gravado por uma versão antiga), servir() retorna
+  false e quem chamou usa o caminho antigo.
+*/
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+#include <WebServer.h>
+
+class ServidorArquivos {
+public:
+  static const int MAX_ARQUIVOS = 8;
+  static const size_t ORCAMENTO_CACHE = 16384;  // bytes de RAM para arquivos em cache
+  static const size_t MAX_ARQUIVO_CACHE = 8192;
+
+  // Lê o manifesto e carrega em RAM os arquivos pequenos. Retorna false sem manifesto.
+  bool iniciar(fs::FS& fs);
+  // Responde a requisição se a URL for um arquivo do manifesto; senão retorna false.
+  bool servir(WebServer& server, const String& url);
+
+  int arquivos() const { return _numArquivos; }
+  size_t bytesEmCache() const { return _bytesEmCache; }
+  unsigned long respostasNaoModificado() const { return _respostas304; }
+  unsigned long respostasRam() const { return _respostasRam; }
+  unsigned long respostasFlash() const { return _respostasFlash; }
+
+private:
+  struct Arquivo {
+    char url[48];
+    char nome[24];
+    char etag[20];        // já entre aspas, como vai no cabeçalho
+    char tipo[32];
+    bool imutavel;
+    uint8_t* cache;
+    size_t tamanho;
+  };
+
+  fs::FS* _fs = nullptr;
+  Arquivo _arquivos[MAX_ARQUIVOS];
+  int _numArquivos = 0;
+  size_t _bytesEmCache = 0;
+  unsigned long _respostas304 = 0;
+  unsigned long _respostasRam = 0;
+  unsigned long _respostasFlash = 0;
+};
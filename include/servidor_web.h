@@ -0,0 +1,26 @@
+/*
+  WebServer do ESP32 com a triagem das conexões (triagem_http.h).
+  --------------------------------------------------------------
+  handleClient() aceita todas as conexões que chegaram, guarda cada uma
+  numa vaga da triagem e só passa ao WebServer a que já tem a requisição
+  inteira no buffer; enquanto nenhuma estiver pronta, o WebServer nem é
+  chamado, para não aceitar por conta própria uma conexão sem triagem. Daí
+  em diante vale o WebServer de sempre: uma requisição por vez, no loop().
+*/
+#pragma once
+
+#include <Arduino.h>
+#include <WebServer.h>
+#include "triagem_http.h"
+
+class ServidorWeb : public WebServer {
+public:
+  explicit ServidorWeb(int porta) : WebServer(porta) {}
+
+  void handleClient() override;
+  const TriagemHttp& triagem() const { return _triagem; }
+
+private:
+  TriagemHttp _triagem;
+  WiFiClient _pendentes[TriagemHttp::MAX_PENDENTES];
+};
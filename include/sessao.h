@@ -0,0 +1,95 @@
+/*
+  Sessões do servidor web.
+  -----------------------
+  POST /login confere usuário e senha uma vez e devolve o cookie "sessao",
+  assinado e com validade. As requisições seguintes (o painel consulta
+  /status e /tempdata o tempo todo) só conferem o cookie: decodificar
+  TAMANHO_TOKEN dígitos hexadecimais, um HMAC-SHA256 de 8 bytes e uma
+  comparação em tempo constante, sem alocar nada e sem ler o NVS. Os últimos
+  tokens conferidos ficam num cache pequeno: o mesmo cookie de novo (o
+  painel manda sempre o mesmo) dispensa até o HMAC.
+
+  Token: hex(carga[8] || HMAC(chave, carga)[0..15]), com a carga feita do
+  fim da validade (segundos desde o boot) e um número de série. A chave é
+  sorteada no boot e de novo a cada troca de credenciais: reiniciar ou
+  trocar a senha derruba todas as sessões. O relógio é o esp_timer de 64
+  bits, que não dá a volta como o millis().
+
+  As credenciais ficam no NVS (chave "acesso") como usuário, sal e
+  PBKDF2-HMAC-SHA256 da senha com ITERACOES_SENHA iterações: dezenas de ms
+  no ESP32, pagos só no login, na troca de senha e na primeira vez que um
+  cabeçalho Basic aparece. Sem nada gravado valem as de fábrica (admin/1234).
+
+  O Basic continua aceito para scripts e para o Prometheus: o cabeçalho já
+  conferido fica, como veio, num cache pequeno só em RAM (esvaziado na troca
+  de credenciais), e as próximas requisições com o mesmo cabeçalho custam
+  uma comparação em tempo constante, menos que um cookie.
+*/
+#pragma once
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "sha256.h"
+
+class GerenciadorSessoes {
+public:
+  static const uint32_t VALIDADE_S = 12UL * 3600UL;
+  static const uint32_t ITERACOES_SENHA = 4096;
+  static const size_t TAMANHO_TOKEN = 48;     // dígitos, sem o '\0'
+  static const size_t TAMANHO_USUARIO = 32;   // com o '\0'
+  static const size_t TAMANHO_SENHA = 64;     // com o '\0'
+  static const size_t TAMANHO_CHAVE = 32;
+  static const size_t TAMANHO_SAL = 16;
+  static const int CACHE_BASIC = 4;
+  // "Basic " e o base64 do maior "usuário:senha" que cabe nas credenciais.
+  static const size_t TAMANHO_BASIC = 6 + 4 * ((TAMANHO_USUARIO + TAMANHO_SENHA - 1 + 2) / 3);
+  static const int CACHE_TOKENS = 4;
+
+  // `aleatorio`: TAMANHO_CHAVE bytes sorteados (esp_fill_random no ESP32).
+  void iniciar(Preferences& preferences, const uint8_t* aleatorio);
+
+  // Lenta (PBKDF2); usuário e resumo comparados em tempo constante.
+  bool conferirSenha(const char* usuario, const char* senha);
+  // O valor inteiro do cabeçalho Authorization ("Basic ..."); rápido se já conferido.
+  bool conferirBasic(const char* cabecalho);
+  // O valor inteiro do cabeçalho Cookie; procura "sessao=".
+  bool conferirCookie(const char* cabecalho, uint64_t agoraMs);
+  bool conferirToken(const char* token, size_t tamanho, uint64_t agoraMs);
+  // Escreve TAMANHO_TOKEN dígitos e o '\0'.
+  void emitir(uint64_t agoraMs, char* token);
+
+  // Grava as novas credenciais e troca a chave; false se o usuário ou a senha não servem.
+  // `aleatorio`: TAMANHO_CHAVE + TAMANHO_SAL bytes sorteados.
+  bool alterarCredenciais(const char* usuario, const char* senha, const uint8_t* aleatorio);
+
+  const char* usuario() const { return _credenciais.usuario; }
+  bool credenciaisDeFabrica() const { return _credenciais.iteracoes == 0; }
+  unsigned long sessoesEmitidas() const { return _emitidas; }
+  unsigned long senhasRecusadas() const { return _recusadas; }
+  unsigned long conferenciasLentas() const { return _lentas; }
+
+private:
+  // Formato gravado no NVS; iteracoes == 0 quer dizer credenciais de fábrica, sem resumo.
+  struct Credenciais {
+    char usuario[TAMANHO_USUARIO];
+    uint8_t sal[TAMANHO_SAL];
+    uint8_t resumo[Sha256::TAMANHO_RESUMO];
+    uint32_t iteracoes;
+  };
+
+  void assinar(const uint8_t carga[8], uint8_t assinatura[16]) const;
+
+  Preferences* _preferences = nullptr;
+  Credenciais _credenciais = {};
+  HmacSha256 _hmac;
+  char _cacheBasic[CACHE_BASIC][TAMANHO_BASIC] = {};
+  uint8_t _tamanhoBasic[CACHE_BASIC] = {};   // 0: vaga livre
+  int _proximoCache = 0;
+  uint8_t _cacheTokens[CACHE_TOKENS][24] = {};
+  bool _tokenOcupado[CACHE_TOKENS] = {};
+  int _proximoToken = 0;
+  uint32_t _serie = 0;
+  unsigned long _emitidas = 0;
+  unsigned long _recusadas = 0;
+  unsigned long _lentas = 0;
+};
@@ -0,0 +1,50 @@
+/*
+  SHA-256, HMAC-SHA256 e PBKDF2-HMAC-SHA256 (FIPS 180-4, RFC 2104, RFC 8018).
+  --------------------------------------------------------------------------
+  Implementação portátil, sem alocação, para as sessões do servidor web
+  (sessao.h): o mesmo código roda no ESP32 e no simulador, onde o custo de
+  cada verificação é medido. As mensagens aqui são de poucas dezenas de
+  bytes, faixa em que o acelerador de SHA do ESP32 não compensa a trava
+  e a cópia para os registradores dele.
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+class Sha256 {
+public:
+  static const size_t TAMANHO_RESUMO = 32;
+  static const size_t TAMANHO_BLOCO = 64;
+
+  Sha256() { reiniciar(); }
+  void reiniciar();
+  void atualizar(const void* dados, size_t tamanho);
+  void finalizar(uint8_t resumo[TAMANHO_RESUMO]);
+
+private:
+  void comprimir(const uint8_t bloco[TAMANHO_BLOCO]);
+
+  uint32_t _estado[8];
+  uint64_t _bytes;
+  uint8_t _bloco[TAMANHO_BLOCO];
+};
+
+// A chave é processada uma vez (blocos ipad/opad já comprimidos); cada
+// mensagem depois custa só os blocos dela mais um, copiando o contexto.
+class HmacSha256 {
+public:
+  void definirChave(const void* chave, size_t tamanho);
+  void calcular(const void* dados, size_t tamanho, uint8_t resumo[Sha256::TAMANHO_RESUMO]) const;
+
+private:
+  Sha256 _interno;
+  Sha256 _externo;
+};
+
+// Um bloco de 32 bytes de PBKDF2 (o tamanho do resumo basta para guardar senhas).
+void pbkdf2Sha256(const void* senha, size_t tamanhoSenha, const void* sal, size_t tamanhoSal, uint32_t iteracoes,
+                  uint8_t saida[Sha256::TAMANHO_RESUMO]);
+
+// Compara sem desviar pelo conteúdo: o tempo não revela quantos bytes bateram.
+bool iguaisTempoConstante(const void* a, const void* b, size_t tamanho);
@@ -0,0 +1,32 @@
+/*
+  Tarefa periódica de alta prioridade que executa o ciclo de controle.
+  ------------------------------------------------------------------
+  No ESP32 é uma tarefa FreeRTOS fixada em um núcleo e acordada por
+  vTaskDelayUntil(); no host (sem ARDUINO definido) é uma std::thread com
+  sleep_until(). Em ambos os casos o atraso de cada despertar em relação ao
+  instante ideal (jitter) e a duração de cada ciclo são medidos.
+*/
+#pragma once
+
+#include <stdint.h>
+
+typedef void (*FuncaoCicloControle)(unsigned long agoraMs);
+
+struct EstatisticasTarefa {
+  unsigned long periodoUs;
+  unsigned long amostras;
+  unsigned long jitterMaximoUs;
+  unsigned long jitterMedioUs;
+  unsigned long duracaoMaximaUs;
+  unsigned long ciclosAtrasados;   // ciclos que duraram mais que um período
+  unsigned long primeiroCicloUs;   // do boot até o primeiro ciclo (primeira verificação de segurança)
+  unsigned long pilhaLivreMinimaBytes;  // marca d'água da pilha da tarefa (0 no host)
+};
+
+bool iniciarTarefaControle(FuncaoCicloControle ciclo, unsigned long periodoMs, int prioridade, int nucleo);
+EstatisticasTarefa lerEstatisticasTarefa();
+
+#ifndef ARDUINO
+// Só no host: encerra a thread depois do ciclo em curso (o simulador, antes de sair).
+void pararTarefaControle();
+#endif
@@ -0,0 +1,64 @@
+/*
+  Triagem das conexões do servidor web.
+  ------------------------------------
+  O WebServer do ESP32 atende uma conexão por vez e lê o cabeçalho com
+  readStringUntil(): cada byte que chega dentro do timeout do Stream renova
+  a espera, então um cliente que manda um byte por segundo (ou que abre a
+  conexão e não manda nada) segura o loop() pelo tempo que quiser, e o
+  limite por cliente nem chega a ver a requisição.
+
+  A triagem fica entre o accept() e o WebServer. A conexão nova espera numa
+  das MAX_PENDENTES vagas e só é entregue quando a requisição inteira, o
+  cabeçalho e o corpo do Content-Length, já está no buffer do socket,
+  conferido com recv(MSG_PEEK | MSG_DONTWAIT), sem consumir nada: a leitura
+  do WebServer então não espera. É descartada a conexão que não completa a
+  requisição em PRAZO_CABECALHO_MS, que passa de LIMITE_ESPIADA bytes sem
+  completar ou que fecha antes; com as vagas cheias, a mais antiga dá lugar
+  à nova. A triagem só lê descritores e nunca os fecha: quem guarda a
+  conexão (o WiFiClient, no ESP32) fecha quando ela é descartada.
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+class TriagemHttp {
+public:
+  static const int MAX_PENDENTES = 4;
+  static const unsigned long PRAZO_CABECALHO_MS = 2000UL;
+  static const size_t LIMITE_ESPIADA = 2048;
+
+  enum Situacao {
+    TRIAGEM_LIVRE,        // vaga sem conexão
+    TRIAGEM_AGUARDANDO,   // requisição incompleta, dentro do prazo
+    TRIAGEM_PRONTA,       // requisição inteira no buffer: entregar ao servidor
+    TRIAGEM_DESCARTAR     // venceu, passou do limite ou fechou: fechar a conexão
+  };
+
+  // Guarda a conexão recém-aceita e devolve a vaga. Com todas ocupadas, reaproveita
+  // a da mais antiga e marca `despejou`: o chamador fecha a conexão que estava nela.
+  int guardar(int fd, unsigned long agora, bool& despejou);
+  // Espia o socket da vaga; em TRIAGEM_PRONTA e TRIAGEM_DESCARTAR o chamador libera a vaga.
+  Situacao examinar(int vaga, unsigned long agora);
+  void liberar(int vaga);
+  int pendentes() const;
+
+  unsigned long entregues() const { return _entregues; }
+  unsigned long vencidas() const { return _vencidas; }
+  unsigned long despejadas() const { return _despejadas; }
+
+  // true se `dados` já traz o cabeçalho inteiro e todo o corpo que o Content-Length anuncia.
+  static bool requisicaoCompleta(const char* dados, size_t tamanho);
+
+private:
+  struct Pendente {
+    int fd;
+    uint32_t chegada;   // millis() do accept()
+    bool ocupada;
+  };
+
+  Pendente _pendentes[MAX_PENDENTES] = {};
+  unsigned long _entregues = 0;
+  unsigned long _vencidas = 0;
+  unsigned long _despejadas = 0;
+};
@@ -0,0 +1,80 @@
+/*
+  Camada de abstração de hardware para o ambiente [env:native].
+  ------------------------------------------------------------
+  Os módulos de controle (src/, exceto main.cpp) só falam com o hardware por
+  meio da API do Arduino: millis()/micros(), pinMode/digitalRead/digitalWrite,
+  Serial, Preferences, SPIFFS e DallasTemperature, e do ADC do ESP-IDF. No
+  ESP32 essas chamadas vão para o framework; no host, os cabeçalhos desta
+  pasta as substituem por:
+
+  - um relógio virtual de 32 bits (inclusive o estouro do millis() aos 49,7
+    dias), avançado explicitamente pelo simulador;
+  - uma tabela de pinos que a planta simulada lê e escreve, com interrupções
+    de borda e mudanças agendadas com precisão de microssegundos;
+  - Preferences em memória e SPIFFS sobre um diretório do host;
+  - um DS18B20 simulado com atraso de conversão configurável;
+  - o ADC contínuo do ESP-IDF (driver/adc.h), com a corrente de cada TC.
+
+  ARDUINO não é definido aqui, de modo que os módulos que dependem do
+  FreeRTOS escolhem sua variante de host.
+*/
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define CHANGE 0x03
+
+#define IRAM_ATTR
+#define digitalPinToInterrupt(p) (p)
+
+#define F(s) (s)
+
+typedef uint8_t byte;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void pinMode(uint8_t pino, uint8_t modo);
+void digitalWrite(uint8_t pino, uint8_t nivel);
+int digitalRead(uint8_t pino);
+void attachInterruptArg(uint8_t pino, void (*rotina)(void*), void* argumento, int modo);
+void detachInterrupt(uint8_t pino);
+
+class SerialSimulado {
+public:
+  void begin(unsigned long) {}
+  size_t print(const char* s);
+  size_t println(const char* s = "");
+  size_t printf(const char* formato, ...) __attribute__((format(printf, 2, 3)));
+  int availableForWrite() { return 4096; }
+
+  // Por padrão a saída é descartada (é o que permite milhões de ciclos por segundo).
+  bool ecoar = false;
+  unsigned long bytesEscritos = 0;
+};
+extern SerialSimulado Serial;
+
+// ==================== CONTROLE DO SIMULADOR ====================
+namespace sim {
+  const int NUM_PINOS = 64;
+  void definirRelogio(uint64_t ms);       // pode começar perto do estouro de 32 bits
+  void avancarRelogio(unsigned long ms);  // aplica, em ordem, as mudanças agendadas no intervalo
+  uint64_t relogioTotalMs();              // sem estouro, para relatórios
+  uint64_t relogioTotalUs();
+  int nivelPino(uint8_t pino);            // o que o firmware escreveu
+  // O que o firmware vai ler; dispara a interrupção do pino se o nível mudar e
+  // descarta as mudanças ainda agendadas para ele.
+  void forcarPino(uint8_t pino, int nivel);
+  // Muda o pino no instante absoluto `instanteUs` (relógio sem estouro), dentro de um avancarRelogio().
+  void agendarPino(uint8_t pino, int nivel, uint64_t instanteUs);
+}
@@ -0,0 +1,55 @@
+/*
+  DS18B20 simulados para o ambiente [env:native].
+  Um barramento com sim::sensoresNoBarramento sensores; a temperatura de cada
+  um vem de sim::temperaturaSensores (escrita pela planta do canal). Como no
+  DS18B20 real, uma leitura feita antes de terminar a conversão devolve o
+  valor anterior do scratchpad (85 °C logo após ligar).
+
+  Cada transação soma em sim::tempoBarramentoUs o tempo que ocuparia o
+  barramento real (velocidade padrão, ~70 us por bit), para conferir quanto
+  barramento cada ciclo de controle gasta.
+*/
+#pragma once
+
+#include <OneWire.h>
+
+#define DEVICE_DISCONNECTED_C -127
+
+typedef uint8_t DeviceAddress[8];
+
+class DallasTemperature {
+public:
+  explicit DallasTemperature(OneWire*) {}
+  void begin();
+  uint8_t getDeviceCount();
+  bool getAddress(uint8_t* endereco, uint8_t indice);
+  void setWaitForConversion(bool esperar) { _esperar = esperar; }
+  void setResolution(uint8_t bits) { _resolucao = bits; }
+  uint8_t getResolution() { return _resolucao; }
+  int16_t millisToWaitForConversion(uint8_t bits);
+  void requestTemperatures();
+  float getTempC(const uint8_t* endereco);
+  // Refaz a busca por ROM até o sensor `indice` a cada chamada, como a biblioteca real.
+  float getTempCByIndex(uint8_t indice);
+
+private:
+  float lerScratchpad(uint8_t sensor);
+
+  static const uint8_t MAX_SENSORES = 8;
+  bool _esperar = true;
+  uint8_t _resolucao = 12;
+  bool _convertida[MAX_SENSORES] = {};
+  unsigned long _inicioConversao = 0;
+  float _valorConvertido[MAX_SENSORES] = { 85.0f, 85.0f, 85.0f, 85.0f, 85.0f, 85.0f, 85.0f, 85.0f };
+};
+
+namespace sim {
+  extern float temperaturaSensores[8];
+  extern uint8_t sensoresNoBarramento;
+  extern bool sensorConectado;
+  // Atraso real da conversão; 0 usa o tempo nominal da resolução.
+  extern unsigned long atrasoConversaoMs;
+  extern uint64_t tempoBarramentoUs;
+  // Uma leitura endereçada: reset, MATCH ROM com o endereço, READ SCRATCHPAD e 9 bytes.
+  const unsigned long CUSTO_LEITURA_ENDERECADA_US = 960 + 19 * 8 * 70;
+}
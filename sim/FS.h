@@ -0,0 +1,48 @@
+/*
+  Sistema de arquivos do host para o ambiente [env:native].
+  Os caminhos do SPIFFS são mapeados para sim::diretorioSpiffs.
+*/
+#pragma once
+
+#include <Arduino.h>
+
+namespace fs {
+
+class File {
+public:
+  File() {}
+  explicit File(FILE* arquivo) : _arquivo(arquivo) {}
+  operator bool() const { return _arquivo != nullptr; }
+  size_t write(const uint8_t* dados, size_t tamanho);
+  size_t read(uint8_t* destino, size_t tamanho);
+  int read();
+  int available();
+  bool seek(uint32_t posicao);
+  size_t position() const;
+  size_t size() const;
+  void flush();
+  void close();
+
+private:
+  FILE* _arquivo = nullptr;
+};
+
+class FS {
+public:
+  File open(const char* caminho, const char* modo = "r");
+  bool exists(const char* caminho);
+  bool remove(const char* caminho);
+  bool rename(const char* de, const char* para);
+};
+
+}  // namespace fs
+
+using fs::File;
+using fs::FS;
+
+namespace sim {
+  extern const char* diretorioSpiffs;
+  // Queda de energia: com valor >= 0, as gravações param depois de tantos
+  // bytes (a que estiver em curso fica pela metade). -1 desliga.
+  extern long bytesAteQueda;
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <Arduino.h>
+
+class OneWire {
+public:
+  explicit OneWire(uint8_t pino) : _pino(pino) {}
+
+private:
+  uint8_t _pino;
+};
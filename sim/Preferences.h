@@ -0,0 +1,48 @@
+/*
+  Preferences em memória para o ambiente [env:native].
+  Os dados de cada namespace sobrevivem a end()/begin() (simulando um
+  reinício) e toda gravação é contabilizada para medir o desgaste do NVS.
+*/
+#pragma once
+
+#include <Arduino.h>
+#include <map>
+#include <string>
+#include <vector>
+
+class Preferences {
+public:
+  bool begin(const char* nome, bool somenteLeitura = false);
+  void end();
+  bool clear();
+  bool remove(const char* chave);
+  bool isKey(const char* chave);
+
+  size_t putUChar(const char* chave, uint8_t valor) { return gravar(chave, &valor, sizeof(valor)); }
+  size_t putInt(const char* chave, int32_t valor) { return gravar(chave, &valor, sizeof(valor)); }
+  size_t putULong(const char* chave, uint32_t valor) { return gravar(chave, &valor, sizeof(valor)); }
+  size_t putFloat(const char* chave, float valor) { return gravar(chave, &valor, sizeof(valor)); }
+  size_t putBytes(const char* chave, const void* valor, size_t tamanho) { return gravar(chave, valor, tamanho); }
+
+  uint8_t getUChar(const char* chave, uint8_t padrao = 0) { return lerValor(chave, padrao); }
+  int32_t getInt(const char* chave, int32_t padrao = 0) { return lerValor(chave, padrao); }
+  uint32_t getULong(const char* chave, uint32_t padrao = 0) { return lerValor(chave, padrao); }
+  float getFloat(const char* chave, float padrao = NAN) { return lerValor(chave, padrao); }
+  size_t getBytesLength(const char* chave);
+  size_t getBytes(const char* chave, void* destino, size_t tamanho);
+
+  // Estatísticas de desgaste, acumuladas desde o início do processo.
+  static unsigned long gravacoes;
+  static unsigned long bytesGravados;
+  static unsigned long bytesFlash;     // em entradas de 32 bytes, como o NVS grava de fato
+
+private:
+  typedef std::map<std::string, std::vector<uint8_t>> Namespace;
+  size_t gravar(const char* chave, const void* valor, size_t tamanho);
+  template <typename T> T lerValor(const char* chave, T padrao) {
+    T valor;
+    return (getBytesLength(chave) == sizeof(T) && getBytes(chave, &valor, sizeof(T)) == sizeof(T)) ? valor : padrao;
+  }
+  Namespace* _ns = nullptr;
+  bool _somenteLeitura = false;
+};
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "FS.h"
+
+class SPIFFSFS : public fs::FS {
+public:
+  bool begin(bool formatarSeFalhar = false);
+  size_t totalBytes() { return 1441792; }
+};
+extern SPIFFSFS SPIFFS;
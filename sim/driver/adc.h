@@ -0,0 +1,80 @@
+/*
+  ADC contínuo (DMA) do ESP32-S3 simulado para o ambiente [env:native].
+  Só o pedaço da API do ESP-IDF 4.4 que o medidor de corrente usa, com o
+  mesmo formato de saída (TYPE2: valor, canal e unidade numa palavra de 32
+  bits por conversão).
+
+  Cada canal do ADC1 vê um transformador de corrente com sim::correnteAdc[c]
+  ampères eficazes senoidais a sim::frequenciaRedeHz, somados ao nível DC da
+  polarização e a um pouco de ruído, e saturando nos extremos da escala. As
+  conversões acontecem no relógio virtual, na taxa configurada, alternando os
+  canais do padrão; o que não for lido a tempo transborda o buffer do driver
+  (max_store_buf_size) e é descartado do mais antigo, como no DMA real.
+*/
+#pragma once
+
+#include <stdint.h>
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_INVALID_STATE 0x103
+#define ESP_ERR_TIMEOUT 0x107
+
+#define SOC_ADC_DIGI_MAX_BITWIDTH 12
+#define SOC_ADC_DIGI_RESULT_BYTES 4
+
+typedef enum { ADC_ATTEN_DB_0 = 0, ADC_ATTEN_DB_2_5 = 1, ADC_ATTEN_DB_6 = 2, ADC_ATTEN_DB_11 = 3 } adc_atten_t;
+typedef enum { ADC_CONV_SINGLE_UNIT_1 = 1, ADC_CONV_SINGLE_UNIT_2 = 2 } adc_digi_convert_mode_t;
+typedef enum { ADC_DIGI_OUTPUT_FORMAT_TYPE1, ADC_DIGI_OUTPUT_FORMAT_TYPE2 } adc_digi_output_format_t;
+
+typedef struct {
+  uint32_t max_store_buf_size;
+  uint32_t conv_num_each_intr;
+  uint32_t adc1_chan_mask;
+  uint32_t adc2_chan_mask;
+} adc_digi_init_config_t;
+
+typedef struct {
+  uint8_t atten;
+  uint8_t channel;
+  uint8_t unit;
+  uint8_t bit_width;
+} adc_digi_pattern_config_t;
+
+typedef struct {
+  bool conv_limit_en;
+  uint32_t conv_limit_num;
+  uint32_t pattern_num;
+  adc_digi_pattern_config_t* adc_pattern;
+  uint32_t sample_freq_hz;
+  adc_digi_convert_mode_t conv_mode;
+  adc_digi_output_format_t format;
+} adc_digi_configuration_t;
+
+typedef struct {
+  union {
+    struct {
+      uint32_t data : 13;
+      uint32_t channel : 4;
+      uint32_t unit : 1;
+      uint32_t reserved17_31 : 14;
+    } type2;
+    uint32_t val;
+  };
+} adc_digi_output_data_t;
+
+esp_err_t adc_digi_initialize(const adc_digi_init_config_t* init_config);
+esp_err_t adc_digi_deinitialize(void);
+esp_err_t adc_digi_controller_configure(const adc_digi_configuration_t* config);
+esp_err_t adc_digi_start(void);
+esp_err_t adc_digi_stop(void);
+esp_err_t adc_digi_read_bytes(uint8_t* buf, uint32_t length_max, uint32_t* out_length, uint32_t timeout_ms);
+
+namespace sim {
+  const int CANAIS_ADC = 10;
+  extern float correnteAdc[CANAIS_ADC];      // A eficazes no primário do TC de cada canal do ADC1
+  extern float frequenciaRedeHz;
+  extern uint64_t conversoesAdc;             // geradas desde o início
+  extern uint64_t conversoesAdcDescartadas;  // transbordaram o buffer do driver
+}
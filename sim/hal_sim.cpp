@@ -0,0 +1,393 @@
+// Implementação da camada de abstração de hardware do ambiente [env:native].
+#include <Arduino.h>
+#include <DallasTemperature.h>
+#include <Preferences.h>
+#include <SPIFFS.h>
+#include <driver/adc.h>
+#include <algorithm>
+#include <map>
+#include <stdarg.h>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+// ==================== RELÓGIO VIRTUAL ====================
+static uint64_t relogioUs = 0;
+static int pinosEscritos[sim::NUM_PINOS];
+static int pinosLidos[sim::NUM_PINOS];
+
+struct MudancaAgendada {
+  uint8_t pino;
+  int nivel;
+};
+static std::multimap<uint64_t, MudancaAgendada> agenda;
+
+static void mudarPino(uint8_t pino, int nivel);
+
+void sim::definirRelogio(uint64_t ms) { relogioUs = ms * 1000ULL; }
+void sim::avancarRelogio(unsigned long ms) {
+  uint64_t alvo = relogioUs + ms * 1000ULL;
+  // A interrupção de cada mudança vê micros() no instante exato dela.
+  while (!agenda.empty() && agenda.begin()->first <= alvo) {
+    std::multimap<uint64_t, MudancaAgendada>::iterator proxima = agenda.begin();
+    MudancaAgendada mudanca = proxima->second;
+    if (proxima->first > relogioUs) relogioUs = proxima->first;
+    agenda.erase(proxima);
+    mudarPino(mudanca.pino, mudanca.nivel);
+  }
+  relogioUs = alvo;
+}
+uint64_t sim::relogioTotalMs() { return relogioUs / 1000ULL; }
+uint64_t sim::relogioTotalUs() { return relogioUs; }
+
+unsigned long millis() { return (uint32_t)(relogioUs / 1000ULL); }
+unsigned long micros() { return (uint32_t)relogioUs; }
+void delay(unsigned long ms) { sim::avancarRelogio(ms); }
+
+// ==================== GPIO ====================
+struct Interrupcao {
+  void (*rotina)(void*);
+  void* argumento;
+};
+static Interrupcao interrupcoes[sim::NUM_PINOS];
+
+void pinMode(uint8_t pino, uint8_t modo) {
+  if (pino < sim::NUM_PINOS && modo == INPUT_PULLUP) pinosLidos[pino] = HIGH;
+}
+void digitalWrite(uint8_t pino, uint8_t nivel) { if (pino < sim::NUM_PINOS) pinosEscritos[pino] = nivel; }
+int digitalRead(uint8_t pino) { return pino < sim::NUM_PINOS ? pinosLidos[pino] : LOW; }
+void attachInterruptArg(uint8_t pino, void (*rotina)(void*), void* argumento, int) {
+  if (pino < sim::NUM_PINOS) interrupcoes[pino] = { rotina, argumento };
+}
+void detachInterrupt(uint8_t pino) { if (pino < sim::NUM_PINOS) interrupcoes[pino] = { nullptr, nullptr }; }
+
+// Só o modo CHANGE existe aqui: qualquer mudança de nível interrompe.
+static void mudarPino(uint8_t pino, int nivel) {
+  if (pino >= sim::NUM_PINOS || pinosLidos[pino] == nivel) return;
+  pinosLidos[pino] = nivel;
+  if (interrupcoes[pino].rotina) interrupcoes[pino].rotina(interrupcoes[pino].argumento);
+}
+
+int sim::nivelPino(uint8_t pino) { return pino < NUM_PINOS ? pinosEscritos[pino] : LOW; }
+void sim::forcarPino(uint8_t pino, int nivel) {
+  for (std::multimap<uint64_t, MudancaAgendada>::iterator it = agenda.begin(); it != agenda.end();) {
+    if (it->second.pino == pino) it = agenda.erase(it);
+    else ++it;
+  }
+  mudarPino(pino, nivel);
+}
+void sim::agendarPino(uint8_t pino, int nivel, uint64_t instanteUs) { agenda.insert({ instanteUs, { pino, nivel } }); }
+
+// ==================== SERIAL ====================
+SerialSimulado Serial;
+
+size_t SerialSimulado::print(const char* s) {
+  size_t n = strlen(s);
+  bytesEscritos += n;
+  if (ecoar) fputs(s, stdout);
+  return n;
+}
+size_t SerialSimulado::println(const char* s) { return print(s) + print("\n"); }
+size_t SerialSimulado::printf(const char* formato, ...) {
+  char buffer[256];
+  va_list args;
+  va_start(args, formato);
+  int n = vsnprintf(buffer, sizeof(buffer), formato, args);
+  va_end(args);
+  if (n < 0) return 0;
+  return print(buffer);
+}
+
+// ==================== PREFERENCES ====================
+static std::map<std::string, std::map<std::string, std::vector<uint8_t>>> armazenamentoNvs;
+unsigned long Preferences::gravacoes = 0;
+unsigned long Preferences::bytesGravados = 0;
+unsigned long Preferences::bytesFlash = 0;
+
+bool Preferences::begin(const char* nome, bool somenteLeitura) {
+  _ns = &armazenamentoNvs[nome];
+  _somenteLeitura = somenteLeitura;
+  return true;
+}
+void Preferences::end() { _ns = nullptr; }
+bool Preferences::clear() {
+  if (!_ns || _somenteLeitura) return false;
+  _ns->clear();
+  return true;
+}
+bool Preferences::remove(const char* chave) { return _ns && !_somenteLeitura && _ns->erase(chave) > 0; }
+bool Preferences::isKey(const char* chave) { return _ns && _ns->count(chave) > 0; }
+size_t Preferences::getBytesLength(const char* chave) {
+  if (!_ns) return 0;
+  Namespace::const_iterator it = _ns->find(chave);
+  return it == _ns->end() ? 0 : it->second.size();
+}
+size_t Preferences::getBytes(const char* chave, void* destino, size_t tamanho) {
+  size_t disponivel = getBytesLength(chave);
+  if (disponivel == 0 || disponivel > tamanho) return 0;
+  memcpy(destino, (*_ns)[chave].data(), disponivel);
+  return disponivel;
+}
+size_t Preferences::gravar(const char* chave, const void* valor, size_t tamanho) {
+  if (!_ns || _somenteLeitura) return 0;
+  const uint8_t* bytes = static_cast<const uint8_t*>(valor);
+  (*_ns)[chave].assign(bytes, bytes + tamanho);
+  gravacoes++;
+  bytesGravados += tamanho;
+  // No NVS do ESP-IDF cada chave ocupa uma entrada de 32 bytes; valores de até
+  // 8 bytes cabem nela, blobs e strings ocupam mais entradas com os dados.
+  unsigned long entradas = tamanho <= 8 ? 1 : 1 + (tamanho + 31) / 32;
+  bytesFlash += entradas * 32;
+  return tamanho;
+}
+
+// ==================== DS18B20 ====================
+float sim::temperaturaSensores[8] = { 25.0f, 25.0f, 25.0f, 25.0f, 25.0f, 25.0f, 25.0f, 25.0f };
+uint8_t sim::sensoresNoBarramento = 1;
+bool sim::sensorConectado = true;
+unsigned long sim::atrasoConversaoMs = 0;
+uint64_t sim::tempoBarramentoUs = 0;
+
+// Tempos de barramento na velocidade padrão: reset com presença ~960 us, ~70 us por bit.
+static const unsigned long US_RESET = 960;
+static const unsigned long US_BYTE = 8 * 70;
+// SEARCH ROM por sensor: comando e 64 bits de 3 slots cada (bit, complemento, escolha).
+static const unsigned long US_BUSCA_SENSOR = US_RESET + US_BYTE + 64 * 3 * 70;
+
+// ROM sintético: família 0x28 (DS18B20), série = índice; o último byte faria as vezes do CRC.
+static void enderecoSimulado(uint8_t indice, uint8_t* endereco) {
+  const uint8_t rom[8] = { 0x28, (uint8_t)(0x10 + indice), 0x5A, 0x01, 0x00, 0x00, 0x00, (uint8_t)(0xA0 + indice) };
+  memcpy(endereco, rom, 8);
+}
+
+void DallasTemperature::begin() { sim::tempoBarramentoUs += (uint64_t)sim::sensoresNoBarramento * US_BUSCA_SENSOR; }
+uint8_t DallasTemperature::getDeviceCount() { return sim::sensoresNoBarramento; }
+bool DallasTemperature::getAddress(uint8_t* endereco, uint8_t indice) {
+  if (indice >= sim::sensoresNoBarramento) return false;
+  sim::tempoBarramentoUs += (uint64_t)(indice + 1) * US_BUSCA_SENSOR;
+  enderecoSimulado(indice, endereco);
+  return true;
+}
+int16_t DallasTemperature::millisToWaitForConversion(uint8_t bits) {
+  switch (bits) {
+    case 9: return 94;
+    case 10: return 188;
+    case 11: return 375;
+    default: return 750;
+  }
+}
+void DallasTemperature::requestTemperatures() {
+  // SKIP ROM + CONVERT T: todos os sensores convertem juntos.
+  sim::tempoBarramentoUs += US_RESET + 2 * US_BYTE;
+  _inicioConversao = millis();
+  memset(_convertida, 0, sizeof(_convertida));
+  // Com espera habilitada a biblioteca real bloqueia; aqui o tempo virtual avança.
+  if (_esperar) delay(sim::atrasoConversaoMs ? sim::atrasoConversaoMs : millisToWaitForConversion(_resolucao));
+}
+float DallasTemperature::lerScratchpad(uint8_t sensor) {
+  if (!sim::sensorConectado || sensor >= sim::sensoresNoBarramento) return DEVICE_DISCONNECTED_C;
+  unsigned long atraso = sim::atrasoConversaoMs ? sim::atrasoConversaoMs : millisToWaitForConversion(_resolucao);
+  if (!_convertida[sensor] && millis() - _inicioConversao >= atraso) {
+    float passo = 0.5f / (1 << (_resolucao - 9));
+    _valorConvertido[sensor] = roundf(sim::temperaturaSensores[sensor] / passo) * passo;
+    _convertida[sensor] = true;
+  }
+  return _valorConvertido[sensor];
+}
+float DallasTemperature::getTempC(const uint8_t* endereco) {
+  sim::tempoBarramentoUs += sim::CUSTO_LEITURA_ENDERECADA_US;
+  for (uint8_t i = 0; i < sim::sensoresNoBarramento; i++) {
+    uint8_t rom[8];
+    enderecoSimulado(i, rom);
+    if (memcmp(rom, endereco, sizeof(rom)) == 0) return lerScratchpad(i);
+  }
+  return DEVICE_DISCONNECTED_C;
+}
+float DallasTemperature::getTempCByIndex(uint8_t indice) {
+  uint8_t rom[8];
+  if (!getAddress(rom, indice)) return DEVICE_DISCONNECTED_C;
+  return getTempC(rom);
+}
+
+// ==================== ADC CONTÍNUO ====================
+float sim::correnteAdc[sim::CANAIS_ADC] = {};
+float sim::frequenciaRedeHz = 60.0f;
+uint64_t sim::conversoesAdc = 0;
+uint64_t sim::conversoesAdcDescartadas = 0;
+
+// SCT-013-030 (30 A -> 1 V eficaz) polarizado no meio da escala; 12 bits em ~3,1 V com 11 dB.
+static const float CONTAGENS_POR_AMPERE = (1.0f / 30.0f) * 4095.0f / 3.1f;
+static const int TAMANHO_TABELA_SENO = 1024;
+
+struct AdcSimulado {
+  bool inicializado;
+  bool rodando;
+  bool transbordou;
+  uint32_t maximoConversoes;
+  uint32_t frequenciaHz;
+  uint32_t padroes;
+  uint8_t canais[16];
+  uint64_t inicioUs;
+  uint64_t geradas;         // desde adc_digi_start()
+  uint32_t fase;            // acumulador de fase da rede (2^32 = um ciclo)
+  uint32_t ruido;
+  std::vector<uint32_t> anel;  // buffer do driver: maximoConversoes palavras
+  uint32_t inicioAnel;
+  uint32_t noAnel;
+};
+static AdcSimulado adc;
+static float tabelaSeno[TAMANHO_TABELA_SENO];
+
+// Cada canal com um resto de nível DC diferente, como resistores de polarização reais.
+static float nivelDcAdc(uint8_t canal) { return 2048.0f - 60.0f + 17.0f * canal; }
+
+// Gera as conversões que o DMA teria feito até o instante atual do relógio virtual.
+static void gerarConversoesAdc() {
+  if (!adc.rodando || adc.padroes == 0) return;
+  uint64_t devidas = (relogioUs - adc.inicioUs) * adc.frequenciaHz / 1000000ULL;
+  uint32_t passoFase = (uint32_t)(sim::frequenciaRedeHz / adc.frequenciaHz * 4294967296.0);
+  uint64_t primeira = adc.geradas;
+  // Sem divisões no laço: são milhões de conversões por segundo simulado com 8 canais.
+  uint32_t padrao = (uint32_t)(adc.geradas % adc.padroes);
+  uint32_t fim = adc.inicioAnel + adc.noAnel;
+  if (fim >= adc.maximoConversoes) fim -= adc.maximoConversoes;
+  for (; adc.geradas < devidas; adc.geradas++) {
+    uint8_t canal = adc.canais[padrao];
+    if (++padrao == adc.padroes) padrao = 0;
+    adc.ruido ^= adc.ruido << 13;
+    adc.ruido ^= adc.ruido >> 17;
+    adc.ruido ^= adc.ruido << 5;
+    float pico = sim::correnteAdc[canal] * 1.41421356f * CONTAGENS_POR_AMPERE;
+    float valor = nivelDcAdc(canal) + pico * tabelaSeno[adc.fase >> 22] + (float)(adc.ruido % 7) - 3.0f;
+    adc.fase += passoFase;
+    int32_t contagem = valor <= 0.0f ? 0 : valor >= 4095.0f ? 4095 : (int32_t)(valor + 0.5f);
+    adc_digi_output_data_t saida;
+    saida.val = 0;
+    saida.type2.data = (uint32_t)contagem;
+    saida.type2.channel = canal;
+    saida.type2.unit = 0;
+    if (adc.noAnel == adc.maximoConversoes) {
+      // Cheio: a nova ocupa o lugar da mais antiga.
+      if (++adc.inicioAnel == adc.maximoConversoes) adc.inicioAnel = 0;
+      adc.noAnel--;
+      adc.transbordou = true;
+      sim::conversoesAdcDescartadas++;
+    }
+    adc.anel[fim] = saida.val;
+    if (++fim == adc.maximoConversoes) fim = 0;
+    adc.noAnel++;
+  }
+  sim::conversoesAdc += devidas - primeira;
+}
+
+esp_err_t adc_digi_initialize(const adc_digi_init_config_t* inicializacao) {
+  if (adc.inicializado) return ESP_ERR_INVALID_STATE;
+  if (tabelaSeno[TAMANHO_TABELA_SENO / 4] == 0.0f) {
+    for (int i = 0; i < TAMANHO_TABELA_SENO; i++) tabelaSeno[i] = sinf(2.0f * (float)M_PI * i / TAMANHO_TABELA_SENO);
+  }
+  adc = AdcSimulado();
+  adc.inicializado = true;
+  adc.maximoConversoes = inicializacao->max_store_buf_size / SOC_ADC_DIGI_RESULT_BYTES;
+  if (adc.maximoConversoes == 0) return ESP_FAIL;
+  adc.anel.assign(adc.maximoConversoes, 0);
+  adc.ruido = 0x2545F491u;
+  return ESP_OK;
+}
+esp_err_t adc_digi_deinitialize(void) {
+  adc = AdcSimulado();
+  return ESP_OK;
+}
+esp_err_t adc_digi_controller_configure(const adc_digi_configuration_t* configuracao) {
+  if (!adc.inicializado || adc.rodando || configuracao->pattern_num == 0 || configuracao->pattern_num > 16) return ESP_ERR_INVALID_STATE;
+  adc.padroes = configuracao->pattern_num;
+  for (uint32_t i = 0; i < adc.padroes; i++) {
+    if (configuracao->adc_pattern[i].channel >= sim::CANAIS_ADC) return ESP_FAIL;
+    adc.canais[i] = configuracao->adc_pattern[i].channel;
+  }
+  adc.frequenciaHz = configuracao->sample_freq_hz;
+  return ESP_OK;
+}
+esp_err_t adc_digi_start(void) {
+  if (!adc.inicializado || adc.frequenciaHz == 0) return ESP_ERR_INVALID_STATE;
+  adc.rodando = true;
+  adc.inicioUs = relogioUs;
+  adc.geradas = 0;
+  return ESP_OK;
+}
+esp_err_t adc_digi_stop(void) {
+  gerarConversoesAdc();
+  adc.rodando = false;
+  return ESP_OK;
+}
+// A espera nunca acontece: as conversões só avançam com o relógio virtual.
+esp_err_t adc_digi_read_bytes(uint8_t* destino, uint32_t tamanhoMaximo, uint32_t* lidos, uint32_t) {
+  *lidos = 0;
+  if (!adc.inicializado) return ESP_ERR_INVALID_STATE;
+  gerarConversoesAdc();
+  uint32_t n = std::min(tamanhoMaximo / SOC_ADC_DIGI_RESULT_BYTES, adc.noAnel);
+  // No máximo dois pedaços: até o fim do anel e do começo dele.
+  uint32_t ateFim = std::min(n, adc.maximoConversoes - adc.inicioAnel);
+  memcpy(destino, &adc.anel[adc.inicioAnel], ateFim * SOC_ADC_DIGI_RESULT_BYTES);
+  memcpy(destino + ateFim * SOC_ADC_DIGI_RESULT_BYTES, &adc.anel[0], (n - ateFim) * SOC_ADC_DIGI_RESULT_BYTES);
+  adc.inicioAnel = (adc.inicioAnel + n) % adc.maximoConversoes;
+  adc.noAnel -= n;
+  *lidos = n * SOC_ADC_DIGI_RESULT_BYTES;
+  if (adc.transbordou) {
+    adc.transbordou = false;
+    return ESP_ERR_INVALID_STATE;
+  }
+  return n > 0 ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+// ==================== SPIFFS ====================
+const char* sim::diretorioSpiffs = "sim_spiffs";
+long sim::bytesAteQueda = -1;
+SPIFFSFS SPIFFS;
+
+static std::string caminhoHost(const char* caminho) { return std::string(sim::diretorioSpiffs) + caminho; }
+
+bool SPIFFSFS::begin(bool) {
+  mkdir(sim::diretorioSpiffs, 0755);
+  return true;
+}
+File fs::FS::open(const char* caminho, const char* modo) {
+  const char* modoHost = modo;
+  if (strcmp(modo, "r") == 0) modoHost = "rb";
+  else if (strcmp(modo, "w") == 0) modoHost = "wb";
+  else if (strcmp(modo, "a") == 0) modoHost = "ab";
+  else if (strcmp(modo, "r+") == 0) modoHost = "r+b";
+  return File(fopen(caminhoHost(caminho).c_str(), modoHost));
+}
+bool fs::FS::exists(const char* caminho) {
+  struct stat info;
+  return stat(caminhoHost(caminho).c_str(), &info) == 0;
+}
+bool fs::FS::remove(const char* caminho) { return ::remove(caminhoHost(caminho).c_str()) == 0; }
+bool fs::FS::rename(const char* de, const char* para) { return ::rename(caminhoHost(de).c_str(), caminhoHost(para).c_str()) == 0; }
+
+size_t fs::File::write(const uint8_t* dados, size_t tamanho) {
+  if (!_arquivo) return 0;
+  if (sim::bytesAteQueda >= 0) {
+    if ((long)tamanho > sim::bytesAteQueda) tamanho = (size_t)sim::bytesAteQueda;
+    sim::bytesAteQueda -= (long)tamanho;
+  }
+  return fwrite(dados, 1, tamanho, _arquivo);
+}
+size_t fs::File::read(uint8_t* destino, size_t tamanho) { return _arquivo ? fread(destino, 1, tamanho, _arquivo) : 0; }
+int fs::File::read() {
+  uint8_t c;
+  return read(&c, 1) == 1 ? c : -1;
+}
+int fs::File::available() { return _arquivo ? (int)(size() - position()) : 0; }
+bool fs::File::seek(uint32_t posicao) { return _arquivo && fseek(_arquivo, posicao, SEEK_SET) == 0; }
+size_t fs::File::position() const { return _arquivo ? (size_t)ftell(_arquivo) : 0; }
+size_t fs::File::size() const {
+  if (!_arquivo) return 0;
+  struct stat info;
+  return fstat(fileno(_arquivo), &info) == 0 ? (size_t)info.st_size : 0;
+}
+void fs::File::flush() { if (_arquivo) fflush(_arquivo); }
+void fs::File::close() {
+  if (_arquivo) fclose(_arquivo);
+  _arquivo = nullptr;
+}
@@ -0,0 +1,129 @@
+#include "planta.h"
+#include <Arduino.h>
+#include <DallasTemperature.h>
+#include <driver/adc.h>
+#include "controle.h"
+
+static const double PI_2 = 6.283185307179586;
+
+// Trepidação da boia, em microssegundos depois da primeira borda: alterna
+// nível antigo e novo e termina no novo. O primeiro contato dura mais que o
+// filtro de glitch (5 ms), como numa boia real: senão seria ruído.
+static const uint32_t TREPIDACAO_US[] = { 6000, 7000, 15000, TREPIDACAO_BOIA_MS * 1000 };
+static const unsigned long INTERVALO_RUIDO_MS = 7UL * 60000UL;
+static const double MARGEM_RUIDO_L = 5.0;   // ruído só longe dos níveis em que a boia muda
+static const double FATOR_PARTIDA = 5.0;
+static const unsigned long PARTIDA_MS = 300;
+static const unsigned long QUEDA_PARTIDA_MS = 200;
+
+Planta::Planta(const ParametrosPlanta& parametros, int canal)
+    : _p(parametros), _canal(canal), _caixaL(parametros.nivelInicialL), _pocoL(parametros.volumePocoL),
+      _temperaturaC(parametros.temperaturaAmbienteC), _temperaturaMaximaC(parametros.temperaturaAmbienteC),
+      _msAteRuido(INTERVALO_RUIDO_MS) {
+  _boiaFechada = _caixaL >= _p.nivelBoiaFechaL;
+  sim::forcarPino(ENTRADAS_CAIXA_CHEIA[_canal], _boiaFechada ? LOW : HIGH);
+  sim::temperaturaSensores[_canal] = (float)_temperaturaC;
+}
+
+void Planta::avancar(unsigned long passoMs, uint64_t tempoAbsolutoMs) {
+  const double dtH = passoMs / 3600000.0;
+  const double dtS = passoMs / 1000.0;
+  const double faseDia = (double)(tempoAbsolutoMs % 86400000ULL) / 86400000.0;
+
+  bool ligado = sim::nivelPino(PINOS_RELE_COMPRESSOR[_canal]) == LOW;
+  if (ligado && !_ligado) {
+    _partidas++;
+    _msDesdePartida = 0;
+  }
+  _ligado = ligado;
+  bool motorAlimentado = ligado && _falha != FALHA_CONTATOR;
+  bool bombeando = motorAlimentado && _falha != FALHA_ROTOR;
+
+  // Corrente, antes de o poço andar: o regime depende da coluna d'água.
+  _correnteA = 0.0;
+  if (motorAlimentado && _p.correnteNominalA > 0.0) {
+    double submergencia = _pocoL / (0.5 * _p.volumePocoL);
+    double regime = _p.correnteNominalA * (0.55 + 0.45 * (submergencia < 1.0 ? submergencia : 1.0));
+    double partida = FATOR_PARTIDA * _p.correnteNominalA;
+    if (_falha == FALHA_ROTOR || _msDesdePartida < PARTIDA_MS) _correnteA = partida;
+    else if (_msDesdePartida < PARTIDA_MS + QUEDA_PARTIDA_MS) {
+      _correnteA = partida + (regime - partida) * (_msDesdePartida - PARTIDA_MS) / (double)QUEDA_PARTIDA_MS;
+    } else _correnteA = regime;
+  }
+  _msDesdePartida += passoMs;
+  sim::correnteAdc[PINOS_CORRENTE[_canal] - 1] = (float)_correnteA;
+  double energiaPassoWh = _correnteA * _p.tensaoV * FATOR_POTENCIA * dtH;
+
+  // Poço e caixa
+  double vazaoLh = bombeando ? _p.vazaoMaximaLh * (_pocoL / _p.volumePocoL) : 0.0;
+  double recuperacaoLh = _falha == FALHA_POCO_SECO ? 0.0 : _p.recuperacaoPocoPorH * (_p.volumePocoL - _pocoL);
+  double consumoLh = _p.consumoMedioLh * (1.0 + 0.8 * sin(PI_2 * (faseDia - 0.30)));
+  _pocoL += (recuperacaoLh - vazaoLh) * dtH;
+  if (_pocoL < 0.0) _pocoL = 0.0;
+  _caixaL += (vazaoLh - consumoLh) * dtH;
+  if (_caixaL > _p.capacidadeCaixaL) _caixaL = _p.capacidadeCaixaL;
+  if (_caixaL < 0.0) _caixaL = 0.0;
+  _litrosBombeados += vazaoLh * dtH;
+
+  // Boia com diferencial; o pino só muda nas bordas, para a interrupção do firmware.
+  const uint8_t pinoBoia = ENTRADAS_CAIXA_CHEIA[_canal];
+  const bool boiaEstavaFechada = _boiaFechada;
+  _msDesdeInicioEnchimento += passoMs;
+  if (!_boiaFechada) _energiaEnchimentoWh += energiaPassoWh;
+  if (!_boiaFechada && _caixaL >= _p.nivelBoiaFechaL) {
+    _boiaFechada = true;
+    _energiaUltimoEnchimentoWh = _energiaEnchimentoWh;
+    for (int i = HISTORICO - 1; i > 0; i--) _duracoes[i] = _duracoes[i - 1];
+    _duracoes[0] = (unsigned long)(_msDesdeInicioEnchimento / 1000ULL);
+    _somaDuracoesS += _msDesdeInicioEnchimento / 1000.0;
+    _enchimentos++;
+  } else if (_boiaFechada && _caixaL < _p.nivelBoiaAbreL) {
+    _boiaFechada = false;
+    _msDesdeInicioEnchimento = 0;
+    _energiaEnchimentoWh = 0.0;
+  }
+  const int nivel = _boiaFechada ? LOW : HIGH;
+  const uint64_t agoraUs = tempoAbsolutoMs * 1000ULL;
+  if (_boiaFechada != boiaEstavaFechada) {
+    sim::forcarPino(pinoBoia, nivel);
+    _msAteRuido = INTERVALO_RUIDO_MS;  // o ruído não se mistura com a trepidação
+    if (_p.trepidacao) {
+      for (size_t i = 0; i < sizeof(TREPIDACAO_US) / sizeof(TREPIDACAO_US[0]); i++) {
+        sim::agendarPino(pinoBoia, i % 2 == 0 ? !nivel : nivel, agoraUs + TREPIDACAO_US[i]);
+      }
+    }
+  } else if (_p.trepidacao) {
+    _msAteRuido = _msAteRuido > passoMs ? _msAteRuido - passoMs : 0;
+    bool longeDaMudanca = _boiaFechada ? _caixaL > _p.nivelBoiaAbreL + MARGEM_RUIDO_L
+                                       : _caixaL < _p.nivelBoiaFechaL - MARGEM_RUIDO_L;
+    if (_msAteRuido == 0 && longeDaMudanca) {
+      bool glitch = (_glitchesInjetados + _pulsosInjetados) % 2 == 0;
+      uint64_t inicio = agoraUs + 2000ULL;
+      sim::agendarPino(pinoBoia, !nivel, inicio);
+      sim::agendarPino(pinoBoia, nivel, inicio + (glitch ? 1000ULL : 20000ULL));
+      if (glitch) _glitchesInjetados++;
+      else _pulsosInjetados++;
+      _msAteRuido = INTERVALO_RUIDO_MS;
+    }
+  }
+
+  // Temperatura do compressor (primeira ordem, ambiente com ciclo diário)
+  double ambiente = _p.temperaturaAmbienteC + _p.variacaoDiariaC * sin(PI_2 * (faseDia - 0.375));
+  if (ligado) _msLigado += passoMs;
+  if (motorAlimentado) {
+    _temperaturaC += (ambiente + _p.elevacaoRegimeC - _temperaturaC) * dtS / _p.constanteAquecimentoS;
+  } else {
+    _temperaturaC += (ambiente - _temperaturaC) * dtS / _p.constanteResfriamentoS;
+  }
+  if (_temperaturaC > _temperaturaMaximaC) _temperaturaMaximaC = _temperaturaC;
+  sim::temperaturaSensores[_canal] = (float)_temperaturaC;
+}
+
+void Planta::injetarFalha(FalhaPlanta falha) {
+  _falha = falha;
+  if (falha == FALHA_POCO_SECO) _pocoL = 0.0;
+}
+
+unsigned long Planta::duracaoEnchimento(int n) const {
+  return (n >= 0 && n < HISTORICO) ? _duracoes[n] : 0;
+}
@@ -0,0 +1,105 @@
+/*
+  Planta simulada: poço com air-lift, caixa d'água com boia e aquecimento do
+  compressor. A cada passo lê o relé que o firmware escreveu e atualiza a boia,
+  o sensor de temperatura e a corrente no TC que o firmware vai ler.
+
+  Corrente: 5x a nominal por 300 ms na partida, caindo ao regime em 200 ms;
+  em regime, a nominal com coluna d'água no poço, caindo até 55% dela com o
+  poço seco (o air-lift sopra sem ter o que empurrar). Falhas injetáveis:
+  contator que não fecha (sem corrente, sem bombear nem aquecer), rotor
+  bloqueado (a corrente de partida não cai, não bombeia) e poço seco.
+*/
+#pragma once
+
+#include <stdint.h>
+
+struct ParametrosPlanta {
+  // Caixa d'água
+  double capacidadeCaixaL = 1000.0;
+  double nivelInicialL = 500.0;
+  double nivelBoiaFechaL = 980.0;    // a boia fecha (caixa cheia) acima deste volume
+  double nivelBoiaAbreL = 850.0;     // e só reabre abaixo deste (diferencial mecânico)
+  double consumoMedioLh = 60.0;      // consumo da casa, modulado ao longo do dia
+  // Boia com trepidação a cada mudança e, longe dos níveis de mudança, ruído de
+  // tempos em tempos (alternando um glitch de 1 ms e um pulso de 20 ms).
+  bool trepidacao = false;
+  // Poço
+  double volumePocoL = 500.0;        // coluna d'água acima da sucção em repouso
+  double vazaoMaximaLh = 600.0;      // vazão com o poço em repouso; cai com a submergência
+  double recuperacaoPocoPorH = 2.0;  // fração do déficit do poço reposta por hora
+  // Compressor
+  double temperaturaAmbienteC = 25.0;
+  double variacaoDiariaC = 6.0;      // amplitude da variação do ambiente ao longo do dia
+  double elevacaoRegimeC = 50.0;     // acima do ambiente, ligado continuamente
+  double constanteAquecimentoS = 1200.0;
+  double constanteResfriamentoS = 1800.0;
+  // Corrente (0 = sem TC)
+  double correnteNominalA = 0.0;
+  double tensaoV = 220.0;
+};
+
+enum FalhaPlanta { SEM_FALHA_PLANTA, FALHA_CONTATOR, FALHA_ROTOR, FALHA_POCO_SECO };
+
+class Planta {
+public:
+  // `canal` escolhe o relé, a boia e o sensor do firmware ligados a esta planta.
+  explicit Planta(const ParametrosPlanta& parametros, int canal = 0);
+
+  // Avança a simulação; `tempoAbsolutoMs` é o relógio sem estouro (para o ciclo diário).
+  void avancar(unsigned long passoMs, uint64_t tempoAbsolutoMs);
+
+  // A falha vale até ser reparada; o poço seco esvazia na hora e para de se recuperar.
+  void injetarFalha(FalhaPlanta falha);
+  void repararFalha() { _falha = SEM_FALHA_PLANTA; }
+  FalhaPlanta falha() const { return _falha; }
+
+  bool caixaCheia() const { return _boiaFechada; }
+  bool compressorLigado() const { return _ligado; }
+  double nivelCaixaL() const { return _caixaL; }
+  double nivelPocoL() const { return _pocoL; }
+  double temperaturaC() const { return _temperaturaC; }
+  double correnteA() const { return _correnteA; }
+
+  // Estatísticas medidas pela própria planta, para conferir o firmware.
+  unsigned long enchimentos() const { return _enchimentos; }
+  unsigned long partidas() const { return _partidas; }
+  double litrosBombeados() const { return _litrosBombeados; }
+  double horasLigado() const { return _msLigado / 3600000.0; }
+  double temperaturaMaximaC() const { return _temperaturaMaximaC; }
+  unsigned long glitchesInjetados() const { return _glitchesInjetados; }
+  unsigned long pulsosInjetados() const { return _pulsosInjetados; }
+  // Duração (s) do n-ésimo enchimento mais recente (0 = o último).
+  unsigned long duracaoEnchimento(int n) const;
+  double duracaoMediaEnchimentoS() const { return _enchimentos ? _somaDuracoesS / _enchimentos : 0.0; }
+  // Com a tensão e o fator de potência que o firmware supõe: confere só a medição de corrente.
+  double energiaUltimoEnchimentoWh() const { return _energiaUltimoEnchimentoWh; }
+
+private:
+  ParametrosPlanta _p;
+  int _canal;
+  double _caixaL;
+  double _pocoL;
+  double _temperaturaC;
+  bool _boiaFechada = false;
+  bool _ligado = false;
+  FalhaPlanta _falha = SEM_FALHA_PLANTA;
+  unsigned long _msDesdePartida = 0;
+  double _correnteA = 0.0;
+  double _energiaEnchimentoWh = 0.0;
+  double _energiaUltimoEnchimentoWh = 0.0;
+  uint64_t _msDesdeInicioEnchimento = 0;
+  uint64_t _msLigado = 0;
+  unsigned long _enchimentos = 0;
+  unsigned long _partidas = 0;
+  double _litrosBombeados = 0.0;
+  double _temperaturaMaximaC;
+  static const int HISTORICO = 8;
+  unsigned long _duracoes[HISTORICO] = {0};
+  double _somaDuracoesS = 0.0;
+  unsigned long _msAteRuido;
+  unsigned long _glitchesInjetados = 0;
+  unsigned long _pulsosInjetados = 0;
+};
+
+// Duração da trepidação de uma mudança da boia (do primeiro ao último contato).
+const unsigned long TREPIDACAO_BOIA_MS = 18;
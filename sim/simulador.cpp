@@ -0,0 +1,1641 @@
+/*
+  Simulador de longa duração do controlador ([env:native]).
+  --------------------------------------------------------
+  Executa o mesmo executarCicloControle() do firmware contra a planta
+  simulada, com relógio virtual: meses de enchimentos em segundos.
+
+    .pio/build/native/program [--dias N] [--passo-ms N] [--inicio-ms N] [--estouro] [--adaptativo] [--preditiva] [--trepidacao] [--corrente] [--exportar ARQUIVO] [--rastro ARQUIVO] [--verbose]
+    .pio/build/native/program --reproduzir ARQUIVO | --fuzz N | --tarefa S | --servir PORTA [--segundos S] [--sem-triagem] | --comparar-preditiva [--dias N]
+
+  --estouro começa o relógio 12 horas antes do estouro de 32 bits do millis()
+  (49,7 dias), de modo que temporizadores e enchimentos atravessem o estouro.
+  Ao final confere o firmware contra a planta (enchimentos, histórico, relé
+  ligado com caixa cheia além do filtro da boia) e informa quantos ciclos de controle por segundo
+  foram simulados. Retorna 1 se alguma conferência falhar.
+
+  --adaptativo liga o ciclo adaptativo; compare litros por partida e duração
+  média dos enchimentos com uma execução sem a opção. --preditiva liga a
+  proteção térmica preditiva, que o firmware traz desligada.
+  --comparar-preditiva simula só o controle contra as plantas duas vezes,
+  com a proteção por limiar e com a preditiva, e falha se a preditiva render
+  menos litros por partida ou tiver mais desligamentos de emergência.
+
+  --trepidacao faz a boia trepidar a cada mudança e injeta ruído (glitches de
+  1 ms e pulsos de 20 ms) enquanto ela está parada; as bordas chegam à
+  interrupção do firmware com o instante exato. Confere que o filtro descarta
+  exatamente o ruído injetado, que os enchimentos continuam batendo com a
+  planta ao segundo e que o relé corta dentro do debounce.
+
+  --corrente liga a medição de corrente (TC de 8 A nominais em cada canal) e
+  injeta, em cada canal, um contator que não fecha (6ª hora), um rotor
+  bloqueado (20ª) e o poço seco (40ª), meia hora mais tarde a cada canal. Um
+  "técnico" repara o contator e o rotor 10 min depois do desligamento e
+  volta ao automático; o poço só volta a encher quando o canal bloqueia a
+  seco, e o técnico volta ao automático uma hora depois. Confere que cada
+  falha desliga o compressor com o motivo certo e a tempo (3 s; 45 s a
+  seco), que o poço seco desarma no máximo MAX_DESARMES_SECO vezes antes de
+  bloquear o canal, que não há desligamento sem falha e que a energia do
+  último enchimento bate com a da planta. Em qualquer caso confere o núcleo
+  do valor eficaz contra senoides sintéticas (50 e 60 Hz, com nível DC,
+  harmônica e ruído) e mede seu custo por amostra contra a conta direta em
+  ponto flutuante.
+
+  --tarefa S roda o ciclo de controle na variante std::thread da tarefa de
+  controle por S segundos de tempo real, com esta thread fazendo o loop()
+  inundado (handlers de 50 ms seguidos, lendo o retrato e mandando comandos),
+  e falha se o jitter passar de meio período, se algum ciclo atrasar ou se um
+  retrato chegar fora de ordem.
+
+  --servir PORTA atende por --segundos S (60) em 127.0.0.1:PORTA como o
+  loop() do firmware, uma requisição por passada, passando as conexões pela
+  triagem (triagem_http.h), com respostas fixas para o tools/carga_http.cpp;
+  --sem-triagem lê como o WebServer, para comparar com --lentos.
+
+  --exportar grava ao final o mesmo arquivo do GET /exportar, para testar o
+  tools/analisador_frota.cpp.
+
+  O rastro das transições da máquina de estados é refeito à medida que o
+  firmware o registra e tem de se reproduzir. --rastro grava ao final o
+  mesmo arquivo do GET /rastro; --reproduzir ARQUIVO refaz e lista um rastro
+  (de campo ou do --rastro) e sai; --fuzz N sorteia N sequências de eventos
+  contra as invariantes (sim/verificacao_maquina.h) e sai.
+
+  As regras de cada módulo (filas, série temporal, persistência, registro
+  de telemetria, boia, máquina de estados, sessões, limite por cliente,
+  triagem das conexões, JSON) são testes de unidade em test/ (pio test -e native); aqui ficam os
+  cenários longos contra a planta e as medições de custo: por requisição, o
+  cookie, o Basic já conferido e o Basic como o WebServer::authenticate()
+  fazia antes, um login, e uma requisição admitida pelo limite por cliente. O /status e o /tempdata
+  montados como antes, com a String do Arduino, contra os serializadores do
+  firmware (src/resposta_status.cpp): alocações, bytes pedidos ao heap e µs
+  por resposta; falha se a serialização alocar, estourar o buffer, perder um
+  campo que o /status mandava ou mudar o número de pontos do gráfico.
+
+  Com NUM_CANAIS > 1 ([env:native8] usa 8) cada canal tem sua planta, com
+  consumo e nível inicial diferentes, e as conferências valem por canal. Em
+  qualquer caso confere que nenhum ciclo de controle ocupa o barramento
+  OneWire por mais que uma leitura endereçada, com 1 ou com 8 sensores, que
+  o log diferido não descartou nenhum evento e que a telemetria MQTT chega em
+  ordem a um broker simulado que cai periodicamente. Mede quanto custa um
+  LOG_EVENTO contra formatar e transmitir a mesma linha, e a vazão e os bytes
+  por amostra do publicador MQTT. Com um canal, grava também como a v5.1
+  (as nove chaves avulsas a cada versão marcada) num namespace à parte e
+  imprime o desgaste do NVS antes e agora.
+*/
+#include <Arduino.h>
+#include <DallasTemperature.h>
+#include <Preferences.h>
+#include <SPIFFS.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+#include "comandos.h"
+#include "controle.h"
+#include "escritor_json.h"
+#include "resposta_status.h"
+#include "exportacao.h"
+#include "limitador_clientes.h"
+#include "perfilador.h"
+#include "persistencia.h"
+#include "planta.h"
+#include "publicador_mqtt.h"
+#include "rastro_compressor.h"
+#include "registro_eventos.h"
+#include "registro_telemetria.h"
+#include "serie_temporal.h"
+#include "sessao.h"
+#include "tarefa_controle.h"
+#include "triagem_http.h"
+#include "verificacao_maquina.h"
+
+// Os testes de test/ (pio test -e native) compilam sim/ junto e trazem o próprio main().
+#ifndef PIO_UNIT_TESTING
+
+struct OpcoesSimulacao {
+  double dias = 90.0;
+  unsigned long passoMs = 10;
+  uint64_t inicioMs = 0;
+  bool adaptativo = false;
+  bool protecaoPreditiva = false;   // o padrão do firmware
+  bool compararPreditiva = false;
+  bool trepidacao = false;
+  bool corrente = false;
+  const char* exportar = nullptr;
+  const char* rastro = nullptr;
+  const char* reproduzir = nullptr;
+  uint64_t sequenciasFuzz = 0;
+  double segundosTarefa = 0.0;
+  int portaServidor = 0;
+  double segundosServidor = 60.0;
+  bool semTriagem = false;
+};
+
+// ==================== CORRENTE ====================
+// Conversões TYPE2 de uma senoide com harmônica, nível DC e ruído, como o DMA as entregaria.
+struct SinalSintetico {
+  float frequenciaHz;
+  float correnteA;      // eficaz da fundamental
+  float nivelDc;        // contagens
+  float harmonica;      // terceira, em fração da fundamental
+  float eficazA() const { return correnteA * sqrtf(1.0f + harmonica * harmonica); }
+};
+
+static uint32_t ruidoSintetico = 0x9E3779B9u;
+
+static uint16_t amostrarSinal(const SinalSintetico& s, double t) {
+  ruidoSintetico ^= ruidoSintetico << 13;
+  ruidoSintetico ^= ruidoSintetico >> 17;
+  ruidoSintetico ^= ruidoSintetico << 5;
+  double w = 6.283185307179586 * s.frequenciaHz * t;
+  double amperes = s.correnteA * 1.4142135623730951 * (sin(w) + s.harmonica * sin(3.0 * w + 0.7));
+  double valor = s.nivelDc + amperes / AMPERES_POR_CONTAGEM + (double)(ruidoSintetico % 7) - 3.0;
+  return (uint16_t)(valor < 0.0 ? 0.0 : valor > 4095.0 ? 4095.0 : lround(valor));
+}
+
+// Intercala os canais como o padrão do ADC: canal 0, 1, ..., N-1, 0, 1, ...
+static void gerarConversoes(const SinalSintetico* sinais, int canais, size_t porCanal, std::vector<adc_digi_output_data_t>& saida) {
+  saida.resize(porCanal * canais);
+  for (size_t n = 0; n < porCanal; n++) {
+    double t = (double)n / FREQUENCIA_CORRENTE_HZ;
+    for (int c = 0; c < canais; c++) {
+      adc_digi_output_data_t& d = saida[n * canais + c];
+      d.val = 0;
+      d.type2.data = amostrarSinal(sinais[c], t + (double)c / (FREQUENCIA_CORRENTE_HZ * canais));
+      d.type2.channel = PINOS_CORRENTE[c] - 1;
+    }
+  }
+}
+
+struct ResultadoNucleoCorrente {
+  int casos = 0;
+  int fora = 0;
+  float piorErroA = 0.0f;
+  double nsNucleo = 0.0;
+  double nsReferencia = 0.0;
+};
+
+// Conta direta: separa os canais em float e faz média e desvio em duas passadas por janela.
+static float referenciaEficaz(const std::vector<adc_digi_output_data_t>& conversoes, int canais, std::vector<float>* porCanal) {
+  for (int c = 0; c < canais; c++) porCanal[c].clear();
+  for (size_t i = 0; i < conversoes.size(); i++) porCanal[i % canais].push_back((float)conversoes[i].type2.data);
+  float soma = 0.0f;
+  for (int c = 0; c < canais; c++) {
+    const std::vector<float>& x = porCanal[c];
+    for (size_t inicio = 0; inicio + AMOSTRAS_POR_JANELA <= x.size(); inicio += AMOSTRAS_POR_JANELA) {
+      float media = 0.0f;
+      for (size_t k = 0; k < AMOSTRAS_POR_JANELA; k++) media += x[inicio + k];
+      media /= AMOSTRAS_POR_JANELA;
+      float variancia = 0.0f;
+      for (size_t k = 0; k < AMOSTRAS_POR_JANELA; k++) variancia += (x[inicio + k] - media) * (x[inicio + k] - media);
+      soma += sqrtf(variancia / AMOSTRAS_POR_JANELA) * AMPERES_POR_CONTAGEM;
+    }
+  }
+  return soma;
+}
+
+// Antes de o firmware ligar o ADC: usa o mesmo MedidorCorrente, alimentado direto pelo núcleo.
+static ResultadoNucleoCorrente testarNucleoCorrente() {
+  ResultadoNucleoCorrente r;
+  std::vector<SinalSintetico> casos;
+  const float frequencias[] = { 50.0f, 60.0f };
+  const float correntes[] = { 0.5f, 8.0f, 25.0f };
+  const float niveis[] = { 1900.0f, 2050.0f, 2200.0f };
+  const float harmonicas[] = { 0.0f, 0.2f };
+  for (float f : frequencias)
+    for (float a : correntes)
+      for (float dc : niveis)
+        for (float h : harmonicas) casos.push_back({ f, a, dc, h });
+
+  MedidorCorrente medidor;
+  if (!medidor.iniciar(PINOS_CORRENTE, MAX_CANAIS)) return r;
+  const size_t JANELAS = 10;
+  std::vector<adc_digi_output_data_t> conversoes;
+  for (size_t grupo = 0; grupo < casos.size(); grupo += MAX_CANAIS) {
+    SinalSintetico sinais[MAX_CANAIS];
+    for (int c = 0; c < MAX_CANAIS; c++) {
+      sinais[c] = grupo + c < casos.size() ? casos[grupo + c] : SinalSintetico{ 60.0f, 0.0f, 2048.0f, 0.0f };
+    }
+    gerarConversoes(sinais, MAX_CANAIS, JANELAS * AMOSTRAS_POR_JANELA, conversoes);
+    // Em pedaços do tamanho de uma leitura do driver, como em atualizar().
+    for (size_t i = 0; i < conversoes.size(); i += MedidorCorrente::CONVERSOES_POR_LEITURA) {
+      size_t n = std::min(conversoes.size() - i, MedidorCorrente::CONVERSOES_POR_LEITURA);
+      medidor.processar(&conversoes[i], n);
+    }
+    for (int c = 0; c < MAX_CANAIS && grupo + c < casos.size(); c++) {
+      LeituraCorrente leitura = medidor.ler(c);
+      float esperado = sinais[c].eficazA();
+      float erro = fabsf(leitura.correnteA - esperado);
+      r.casos++;
+      if (leitura.janelas != JANELAS || erro > 0.01f * esperado + 0.05f) {
+        r.fora++;
+        printf("  corrente: %.0f Hz, %.1f A, DC %.0f, harmônica %.0f%%: medido %.3f A em %u janelas\n", sinais[c].frequenciaHz,
+               esperado, sinais[c].nivelDc, sinais[c].harmonica * 100.0f, leitura.correnteA, leitura.janelas);
+      }
+      if (erro > r.piorErroA) r.piorErroA = erro;
+    }
+  }
+
+  // Custo por amostra: 8 canais a 8 A, 1000 janelas por canal.
+  SinalSintetico sinais[MAX_CANAIS];
+  for (int c = 0; c < MAX_CANAIS; c++) sinais[c] = { 60.0f, 8.0f, 2048.0f, 0.1f };
+  gerarConversoes(sinais, MAX_CANAIS, 1000 * AMOSTRAS_POR_JANELA, conversoes);
+  std::chrono::steady_clock::time_point inicio = std::chrono::steady_clock::now();
+  float soma = 0.0f;
+  const int REPETICOES = 5;
+  for (int k = 0; k < REPETICOES; k++) {
+    for (size_t i = 0; i < conversoes.size(); i += MedidorCorrente::CONVERSOES_POR_LEITURA) {
+      medidor.processar(&conversoes[i], std::min(conversoes.size() - i, MedidorCorrente::CONVERSOES_POR_LEITURA));
+    }
+    for (int c = 0; c < MAX_CANAIS; c++) soma += medidor.ler(c).somaCorrentesA;
+  }
+  r.nsNucleo = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - inicio).count() /
+               (REPETICOES * conversoes.size());
+  std::vector<float> porCanal[MAX_CANAIS];
+  inicio = std::chrono::steady_clock::now();
+  float somaReferencia = 0.0f;
+  for (int k = 0; k < REPETICOES; k++) somaReferencia += referenciaEficaz(conversoes, MAX_CANAIS, porCanal);
+  r.nsReferencia = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - inicio).count() /
+                   (REPETICOES * conversoes.size());
+  if (fabsf(soma - somaReferencia) > 0.001f * somaReferencia) {
+    printf("  corrente: núcleo soma %.1f A, referência %.1f A\n", soma, somaReferencia);
+    r.fora++;
+  }
+  medidor.parar();
+  return r;
+}
+
+// Falhas injetadas num canal pelo --corrente e o que o simulador viu do firmware.
+struct RoteiroFalhasCanal {
+  static const int NUM_FALHAS = 3;
+  uint64_t injecaoMs[NUM_FALHAS];    // relativo ao início; 0 = já injetada
+  FalhaPlanta tipos[NUM_FALHAS];
+  uint64_t exposicaoMs = 0;          // relé fechado sobre a falha desde
+  uint64_t reparoMs = 0;             // técnico chega
+  FalhaCorrente anterior = FALHA_NENHUMA;
+  bool bloqueado = false;            // o poço seco já bloqueou o canal nesta injeção
+  unsigned long bloqueiosSeco = 0;
+  unsigned long desligamentos[5] = {};
+  unsigned long esperados[5] = {};
+  unsigned long falsos = 0;
+  unsigned long alarmesSemRele = 0;
+  unsigned long piorLatenciaMs[5] = {};
+};
+
+static FalhaCorrente falhaEsperada(FalhaPlanta falha) {
+  switch (falha) {
+    case FALHA_CONTATOR: return FALHA_SEM_CORRENTE;
+    case FALHA_ROTOR: return FALHA_ROTOR_BLOQUEADO;
+    case FALHA_POCO_SECO: return FALHA_FUNCIONAMENTO_SECO;
+    default: return FALHA_NENHUMA;
+  }
+}
+
+// Broker MQTT em processo: fora do ar 20 min a cada 6 h e 3 h seguidas a partir
+// da 30ª hora (mais do que a fila do publicador aguenta). Confere a ordem dos
+// lotes e soma os bytes que cada PUBLISH ocuparia na conexão.
+struct BrokerSimulado {
+  static constexpr const char* TOPICO = "compressor/a1b2c3/telemetria";
+  bool noAr = true;
+  uint32_t proximaSequencia = 0;
+  unsigned long lotes = 0;
+  unsigned long lotesFaltando = 0;
+  unsigned long foraDeOrdem = 0;
+  unsigned long amostras = 0;
+  uint64_t bytesMqtt = 0;
+  uint32_t ultimoInstante[NUM_CANAIS] = {};
+  AmostraMqtt ultima[NUM_CANAIS] = {};
+
+  static bool noArEm(uint64_t decorridoMs) {
+    const uint64_t HORA = 3600000ULL;
+    if (decorridoMs >= 30 * HORA && decorridoMs < 33 * HORA) return false;
+    return decorridoMs % (6 * HORA) >= 20 * 60000ULL;
+  }
+
+  static bool receber(const uint8_t* dados, size_t tamanho, void* contexto) {
+    BrokerSimulado& b = *static_cast<BrokerSimulado*>(contexto);
+    if (!b.noAr) return false;
+    CabecalhoLoteMqtt cabecalho;
+    memcpy(&cabecalho, dados, sizeof(cabecalho));
+    // A sequência começa em 0: lotes descartados antes do primeiro recebido também contam.
+    if (cabecalho.sequencia < b.proximaSequencia) b.foraDeOrdem++;
+    else b.lotesFaltando += cabecalho.sequencia - b.proximaSequencia;
+    b.proximaSequencia = cabecalho.sequencia + 1;
+    if (tamanho != sizeof(cabecalho) + cabecalho.amostras * sizeof(AmostraMqtt)) b.foraDeOrdem++;
+    for (int i = 0; i < cabecalho.amostras; i++) {
+      AmostraMqtt a;
+      memcpy(&a, dados + sizeof(cabecalho) + i * sizeof(AmostraMqtt), sizeof(a));
+      if (a.canal >= NUM_CANAIS || a.instante < b.ultimoInstante[a.canal]) { b.foraDeOrdem++; continue; }
+      b.ultimoInstante[a.canal] = a.instante;
+      b.ultima[a.canal] = a;
+    }
+    b.lotes++;
+    b.amostras += cabecalho.amostras;
+    b.bytesMqtt += tamanhoPublishMqtt(strlen(TOPICO), tamanho);
+    return true;
+  }
+};
+
+static bool lerOpcoes(int argc, char** argv, OpcoesSimulacao& opcoes) {
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--dias") == 0 && i + 1 < argc) opcoes.dias = atof(argv[++i]);
+    else if (strcmp(argv[i], "--passo-ms") == 0 && i + 1 < argc) opcoes.passoMs = strtoul(argv[++i], nullptr, 10);
+    else if (strcmp(argv[i], "--inicio-ms") == 0 && i + 1 < argc) opcoes.inicioMs = strtoull(argv[++i], nullptr, 10);
+    else if (strcmp(argv[i], "--estouro") == 0) opcoes.inicioMs = 0x100000000ULL - 12ULL * 3600000ULL;
+    else if (strcmp(argv[i], "--adaptativo") == 0) opcoes.adaptativo = true;
+    else if (strcmp(argv[i], "--preditiva") == 0) opcoes.protecaoPreditiva = true;
+    else if (strcmp(argv[i], "--comparar-preditiva") == 0) opcoes.compararPreditiva = true;
+    else if (strcmp(argv[i], "--trepidacao") == 0) opcoes.trepidacao = true;
+    else if (strcmp(argv[i], "--corrente") == 0) opcoes.corrente = true;
+    else if (strcmp(argv[i], "--exportar") == 0 && i + 1 < argc) opcoes.exportar = argv[++i];
+    else if (strcmp(argv[i], "--rastro") == 0 && i + 1 < argc) opcoes.rastro = argv[++i];
+    else if (strcmp(argv[i], "--reproduzir") == 0 && i + 1 < argc) opcoes.reproduzir = argv[++i];
+    else if (strcmp(argv[i], "--fuzz") == 0 && i + 1 < argc) opcoes.sequenciasFuzz = strtoull(argv[++i], nullptr, 10);
+    else if (strcmp(argv[i], "--tarefa") == 0 && i + 1 < argc) opcoes.segundosTarefa = atof(argv[++i]);
+    else if (strcmp(argv[i], "--servir") == 0 && i + 1 < argc) opcoes.portaServidor = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--segundos") == 0 && i + 1 < argc) opcoes.segundosServidor = atof(argv[++i]);
+    else if (strcmp(argv[i], "--sem-triagem") == 0) opcoes.semTriagem = true;
+    else if (strcmp(argv[i], "--verbose") == 0) Serial.ecoar = true;
+    else {
+      fprintf(stderr, "uso: %s [--dias N] [--passo-ms N] [--inicio-ms N] [--estouro] [--adaptativo] [--preditiva] [--trepidacao] [--corrente] [--exportar ARQUIVO] [--rastro ARQUIVO] [--reproduzir ARQUIVO] [--fuzz N] [--tarefa SEGUNDOS] [--servir PORTA [--segundos S] [--sem-triagem]] [--comparar-preditiva] [--verbose]\n", argv[0]);
+      return false;
+    }
+  }
+  return opcoes.passoMs > 0 && opcoes.dias > 0.0;
+}
+
+// ==================== PERSISTÊNCIA ANTIGA ====================
+// Réplica da gravação até a v5.1, para comparar o desgaste do NVS na mesma
+// execução: a cada versão marcada, passado o intervalo mínimo, as nove chaves
+// avulsas eram regravadas, mudasse algum valor ou não. Só conhecia um canal.
+struct GravacaoLegada {
+  static const unsigned long INTERVALO_MS = 60000UL;
+  unsigned long ultimaGravacao = 0;
+  uint32_t versaoGravada = 0;
+  unsigned long gravacoes = 0;
+  unsigned long bytesGravados = 0;
+  unsigned long bytesFlash = 0;
+
+  void salvar(Preferences& preferences, const EstadoControle& estado, unsigned long agora) {
+    if (estado.versaoDados == versaoGravada) return;
+    if (agora - ultimaGravacao < INTERVALO_MS && ultimaGravacao != 0) return;
+    // Os contadores do Preferences simulado são globais: conta só a diferença.
+    unsigned long gravacoesAntes = Preferences::gravacoes;
+    unsigned long bytesAntes = Preferences::bytesGravados;
+    unsigned long flashAntes = Preferences::bytesFlash;
+    const ParametrosOperacao& p = estado.dados.parametros;
+    const DadosCanal& canal0 = estado.dados.canais[0];
+    preferences.putULong("tempoLigado", p.tempoLigado);
+    preferences.putULong("tempoDescanso", p.tempoDescanso);
+    preferences.putFloat("tempMaxima", p.temperaturaMaxima);
+    preferences.putUChar("resSensor", p.resolucaoSensor);
+    preferences.putULong("intLeitura", p.intervaloLeitura);
+    preferences.putULong("ciclosParc", canal0.ciclosParciaisOperacao);
+    preferences.putULong("ciclosEnch", canal0.ciclosEnchimentoCompletos);
+    preferences.putInt("idxHEnch", canal0.indiceHistoricoEnchimento);
+    // O array de EnchimentoInfo do ESP32: dois campos de 32 bits por entrada.
+    uint32_t historico[TAMANHO_HISTORICO_ENCHIMENTO * 2];
+    for (int i = 0; i < TAMANHO_HISTORICO_ENCHIMENTO; i++) {
+      historico[2 * i] = canal0.historicoEnchimento[i].tempo;
+      historico[2 * i + 1] = canal0.historicoEnchimento[i].ciclosParciais;
+    }
+    preferences.putBytes("hEnchimento", historico, sizeof(historico));
+    gravacoes += Preferences::gravacoes - gravacoesAntes;
+    bytesGravados += Preferences::bytesGravados - bytesAntes;
+    bytesFlash += Preferences::bytesFlash - flashAntes;
+    Preferences::gravacoes = gravacoesAntes;
+    Preferences::bytesGravados = bytesAntes;
+    Preferences::bytesFlash = flashAntes;
+    ultimaGravacao = agora;
+    versaoGravada = estado.versaoDados;
+  }
+};
+
+// ==================== SESSÕES ====================
+static void codificarBase64(const char* texto, std::string& saida) {
+  static const char ALFABETO[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  size_t n = strlen(texto);
+  saida.clear();
+  for (size_t i = 0; i < n; i += 3) {
+    uint32_t v = (uint8_t)texto[i] << 16 | (i + 1 < n ? (uint8_t)texto[i + 1] << 8 : 0) | (i + 2 < n ? (uint8_t)texto[i + 2] : 0);
+    saida += ALFABETO[v >> 18];
+    saida += ALFABETO[(v >> 12) & 63];
+    saida += i + 1 < n ? ALFABETO[(v >> 6) & 63] : '=';
+    saida += i + 2 < n ? ALFABETO[v & 63] : '=';
+  }
+}
+
+// O que o WebServer::authenticate() fazia em toda requisição: copiar o
+// cabeçalho, cortar o "Basic ", codificar "usuário:senha" num buffer alocado e comparar.
+static bool autenticarComoAntes(const char* cabecalho, const char* usuario, const char* senha) {
+  std::string recebido(cabecalho);
+  if (recebido.compare(0, 5, "Basic") != 0) return false;
+  recebido = recebido.substr(6);
+  std::string credenciais = std::string(usuario) + ":" + senha;
+  std::string* esperado = new std::string;
+  codificarBase64(credenciais.c_str(), *esperado);
+  bool confere = recebido == *esperado;
+  delete esperado;
+  return confere;
+}
+
+struct ResultadoSessoes {
+  bool aceitouTodas = false;
+  double nsAntes = 0.0;
+  double nsCookie = 0.0;
+  double nsCookieNovo = 0.0;
+  double nsBasicCache = 0.0;
+  double msLogin = 0.0;
+};
+
+// Custo de autenticar uma requisição antes e depois (as regras ficam em test/test_sessoes).
+static ResultadoSessoes testarSessoes() {
+  ResultadoSessoes r;
+  Preferences preferences;
+  preferences.begin("sessao-sim", false);
+  uint8_t aleatorio[GerenciadorSessoes::TAMANHO_CHAVE + GerenciadorSessoes::TAMANHO_SAL];
+  for (size_t i = 0; i < sizeof(aleatorio); i++) aleatorio[i] = (uint8_t)(i * 37 + 11);
+  GerenciadorSessoes sessoes;
+  sessoes.iniciar(preferences, aleatorio);
+  sessoes.alterarCredenciais("operador", "poco-fundo", aleatorio);
+  std::string basicNovo = "Basic ", codificado;
+  codificarBase64("operador:poco-fundo", codificado);
+  basicNovo += codificado;
+
+  const uint64_t agoraMs = 5000;
+  char token[GerenciadorSessoes::TAMANHO_TOKEN + 1];
+  sessoes.emitir(agoraMs, token);
+  char cookie[128];
+  snprintf(cookie, sizeof(cookie), "tema=escuro; sessao=%s; idioma=pt", token);
+
+  const int REQUISICOES = 200000;
+  int aceitas = 0;
+  std::chrono::steady_clock::time_point inicio = std::chrono::steady_clock::now();
+  for (int i = 0; i < REQUISICOES; i++) aceitas += autenticarComoAntes(basicNovo.c_str(), "operador", "poco-fundo");
+  r.nsAntes = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - inicio).count() / REQUISICOES;
+  inicio = std::chrono::steady_clock::now();
+  for (int i = 0; i < REQUISICOES; i++) aceitas += sessoes.conferirCookie(cookie, agoraMs + i);
+  r.nsCookie = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - inicio).count() / REQUISICOES;
+  // Sempre um cookie que o cache ainda não viu: o HMAC inteiro a cada requisição.
+  const int NOVOS = GerenciadorSessoes::CACHE_TOKENS + 1;
+  char cookies[NOVOS][80];
+  for (int i = 0; i < NOVOS; i++) {
+    sessoes.emitir(agoraMs, token);
+    snprintf(cookies[i], sizeof(cookies[i]), "sessao=%s", token);
+  }
+  inicio = std::chrono::steady_clock::now();
+  for (int i = 0; i < REQUISICOES; i++) aceitas += sessoes.conferirCookie(cookies[i % NOVOS], agoraMs);
+  r.nsCookieNovo = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - inicio).count() / REQUISICOES;
+  inicio = std::chrono::steady_clock::now();
+  for (int i = 0; i < REQUISICOES; i++) aceitas += sessoes.conferirBasic(basicNovo.c_str());
+  r.nsBasicCache = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - inicio).count() / REQUISICOES;
+  const int LOGINS = 20;
+  inicio = std::chrono::steady_clock::now();
+  for (int i = 0; i < LOGINS; i++) aceitas += sessoes.conferirSenha("operador", "poco-fundo");
+  r.msLogin = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - inicio).count() / LOGINS;
+  r.aceitouTodas = aceitas == 4 * REQUISICOES + LOGINS;
+  preferences.clear();
+  return r;
+}
+
+// ==================== LIMITE POR CLIENTE ====================
+// Custo de admitir uma requisição (as regras ficam em test/test_limitador).
+static double nsPorRequisicaoLimitador() {
+  static LimitadorClientes limitador;
+  uint32_t espera = 0;
+  const int REQUISICOES = 1000000;
+  std::chrono::steady_clock::time_point inicio = std::chrono::steady_clock::now();
+  for (int i = 0; i < REQUISICOES; i++) limitador.admitir(0x0100000A + (i % 24), (unsigned long)i, 1, espera);
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - inicio).count() / REQUISICOES;
+}
+
+// ==================== SERVIDOR HTTP LOCAL ====================
+// Uma conexão por vez e uma requisição por passada do loop(), como o
+// WebServer do firmware, numa porta local e com respostas fixas: o
+// tools/carga_http.cpp mede aqui a triagem das conexões (--lentos) sem um
+// ESP32. Com --sem-triagem lê como o WebServer lia: até 5 s pelo primeiro
+// byte e então byte a byte, com a espera de 1 s do Stream renovada a cada um.
+static const int ESPERA_PRIMEIRO_BYTE_MS = 5000;   // HTTP_MAX_DATA_WAIT
+static const int ESPERA_STREAM_MS = 1000;          // timeout padrão do Stream
+static const int PASSADA_LOOP_MS = 10;             // o vTaskDelay() do fim do loop()
+
+static unsigned long msDesde(std::chrono::steady_clock::time_point inicio) {
+  return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - inicio).count();
+}
+
+static bool esperarLeitura(int fd, int prazoMs) {
+  pollfd p = { fd, POLLIN, 0 };
+  return poll(&p, 1, prazoMs) == 1;
+}
+
+static bool lerComoWebServer(int fd, std::string& pedido) {
+  if (!esperarLeitura(fd, ESPERA_PRIMEIRO_BYTE_MS)) return false;
+  char byte;
+  while (!TriagemHttp::requisicaoCompleta(pedido.data(), pedido.size())) {
+    if (!esperarLeitura(fd, ESPERA_STREAM_MS) || recv(fd, &byte, 1, 0) != 1) return false;
+    pedido += byte;
+  }
+  return true;
+}
+
+// A requisição já está inteira no buffer (a triagem conferiu): lê sem esperar.
+static void lerTriado(int fd, std::string& pedido) {
+  char bloco[512];
+  for (int n; (n = (int)recv(fd, bloco, sizeof(bloco), MSG_DONTWAIT)) > 0;) pedido.append(bloco, (size_t)n);
+}
+
+static void responderLocal(int fd, const std::string& pedido) {
+  std::string linha = pedido.substr(0, pedido.find('\r'));
+  const char* status = "404 Not Found";
+  const char* tipo = "text/plain";
+  const char* extras = "";
+  std::string corpo = "nao encontrado";
+  if (linha.compare(0, 12, "POST /login ") == 0) {
+    status = "200 OK";
+    extras = "Set-Cookie: sessao=local; Path=/; HttpOnly\r\n";
+    corpo = "sessao iniciada";
+  } else if (linha.compare(0, 12, "GET /status ") == 0) {
+    status = "200 OK";
+    tipo = "application/json";
+    corpo = "{\"compressorLigado\":false,\"jitterControleMaxUs\":0,\"jitterControleMedioUs\":0,\"ciclosControleAtrasados\":0}";
+  } else if (linha.compare(0, 14, "GET /tempdata ") == 0) {
+    status = "200 OK";
+    tipo = "application/json";
+    corpo = "{\"labels\":[],\"data\":[]}";
+  } else if (linha.compare(0, 13, "GET /metrics ") == 0) {
+    status = "200 OK";
+    corpo = "compressor_http_aceitas_total 0\n";
+  }
+  std::string resposta = std::string("HTTP/1.1 ") + status + "\r\nContent-Type: " + tipo + "\r\n" + extras +
+                         "Content-Length: " + std::to_string(corpo.size()) + "\r\nConnection: close\r\n\r\n" + corpo;
+  send(fd, resposta.data(), resposta.size(), MSG_NOSIGNAL);
+  close(fd);
+}
+
+static bool servirLocal(const OpcoesSimulacao& opcoes) {
+  int escuta = socket(AF_INET, SOCK_STREAM, 0);
+  int um = 1;
+  setsockopt(escuta, SOL_SOCKET, SO_REUSEADDR, &um, sizeof(um));
+  sockaddr_in endereco = {};
+  endereco.sin_family = AF_INET;
+  endereco.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  endereco.sin_port = htons((uint16_t)opcoes.portaServidor);
+  if (bind(escuta, (sockaddr*)&endereco, sizeof(endereco)) != 0 || listen(escuta, 16) != 0) {
+    fprintf(stderr, "não consegui escutar em 127.0.0.1:%d\n", opcoes.portaServidor);
+    return false;
+  }
+  fcntl(escuta, F_SETFL, fcntl(escuta, F_GETFL) | O_NONBLOCK);
+  printf("Servindo em 127.0.0.1:%d por %.0f s, %s\n", opcoes.portaServidor, opcoes.segundosServidor,
+         opcoes.semTriagem ? "sem triagem (lendo como o WebServer)" : "com a triagem das conexões");
+  fflush(stdout);
+
+  std::chrono::steady_clock::time_point inicio = std::chrono::steady_clock::now();
+  const unsigned long duracaoMs = (unsigned long)(opcoes.segundosServidor * 1000.0);
+  TriagemHttp triagem;
+  int pendentes[TriagemHttp::MAX_PENDENTES];
+  for (int& fd : pendentes) fd = -1;
+  unsigned long atendidas = 0, abandonadas = 0, maiorPassadaMs = 0;
+  for (unsigned long agora = 0; agora < duracaoMs; agora = msDesde(inicio)) {
+    if (opcoes.semTriagem) {
+      int fd = accept(escuta, nullptr, nullptr);
+      if (fd >= 0) {
+        std::string pedido;
+        if (lerComoWebServer(fd, pedido)) {
+          responderLocal(fd, pedido);
+          atendidas++;
+        } else {
+          close(fd);
+          abandonadas++;
+        }
+      }
+    } else {
+      for (int fd; (fd = accept(escuta, nullptr, nullptr)) >= 0;) {
+        bool despejou = false;
+        int vaga = triagem.guardar(fd, agora, despejou);
+        if (despejou) {
+          close(pendentes[vaga]);
+          abandonadas++;
+        }
+        pendentes[vaga] = fd;
+      }
+      bool atendeu = false;
+      for (int vaga = 0; vaga < TriagemHttp::MAX_PENDENTES; vaga++) {
+        TriagemHttp::Situacao situacao = triagem.examinar(vaga, agora);
+        if (situacao == TriagemHttp::TRIAGEM_PRONTA && !atendeu) {
+          std::string pedido;
+          lerTriado(pendentes[vaga], pedido);
+          responderLocal(pendentes[vaga], pedido);
+          pendentes[vaga] = -1;
+          triagem.liberar(vaga);
+          atendidas++;
+          atendeu = true;
+        } else if (situacao == TriagemHttp::TRIAGEM_DESCARTAR) {
+          close(pendentes[vaga]);
+          pendentes[vaga] = -1;
+          triagem.liberar(vaga);
+          abandonadas++;
+        }
+      }
+    }
+    unsigned long passadaMs = msDesde(inicio) - agora;
+    if (passadaMs > maiorPassadaMs) maiorPassadaMs = passadaMs;
+    std::this_thread::sleep_for(std::chrono::milliseconds(PASSADA_LOOP_MS));
+  }
+  for (int fd : pendentes) {
+    if (fd >= 0) close(fd);
+  }
+  close(escuta);
+  printf("Servidor: %lu requisições atendidas, %lu conexões fechadas sem requisição; passada do loop() mais longa %lu ms\n",
+         atendidas, abandonadas, maiorPassadaMs);
+  if (!opcoes.semTriagem) {
+    printf("Triagem: %lu entregues, %lu vencidas, %lu despejadas\n", triagem.entregues(), triagem.vencidas(),
+           triagem.despejadas());
+  }
+  return true;
+}
+
+// ==================== TAREFA DE CONTROLE ====================
+// O executarCicloControle() roda na variante std::thread da tarefa de
+// controle, em tempo real de verdade, enquanto esta thread faz o papel do
+// loop() inundado: lê o retrato, manda comandos e prende cada "requisição"
+// por ATRASO_HANDLER_MS, como um handler que bloqueia. No loop() único de
+// antes, o controle esperava cada uma delas inteira.
+const unsigned long PERIODO_TAREFA_SIM_MS = 10;
+const unsigned long ATRASO_HANDLER_MS = 50;
+// Meio período. Com SCHED_FIFO (root) o jitter fica em centenas de us; sem
+// privilégio, no escalonador comum, chega a uns 4 ms num host carregado.
+const unsigned long LIMITE_JITTER_TAREFA_US = PERIODO_TAREFA_SIM_MS * 1000UL / 2;
+
+// Esta thread vai para o núcleo 0 com a menor prioridade do escalonador, como
+// o loop() (prioridade 1) diante da tarefa de controle (10) no ESP32. SCHED_IDLE
+// não exige privilégios, ao contrário do SCHED_FIFO que a tarefa tenta.
+static void rebaixarComoLoop() {
+#ifdef __linux__
+  cpu_set_t nucleos;
+  CPU_ZERO(&nucleos);
+  CPU_SET(0, &nucleos);
+  pthread_setaffinity_np(pthread_self(), sizeof(nucleos), &nucleos);
+  sched_param parametro = {};
+  pthread_setschedparam(pthread_self(), SCHED_IDLE, &parametro);
+#endif
+}
+
+static bool testarTarefaControle(double segundos) {
+  using namespace std::chrono;
+  Preferences preferences;
+  preferences.begin("tarefa", false);
+  preferences.clear();
+  DadosPersistentes dados;
+  carregarConfiguracoesOperacao(preferences, dados);
+  sim::sensoresNoBarramento = NUM_CANAIS;
+  iniciarControle(dados, 0);
+  // As duas threads no mesmo núcleo, como o loop() e a tarefa de controle no
+  // núcleo 1 do ESP32: quem segura a latência é a prioridade, não um núcleo livre.
+  // Depois de criar a tarefa: ela herdaria a política desta thread.
+  iniciarTarefaControle(executarCicloControle, PERIODO_TAREFA_SIM_MS, 10, 0);
+  rebaixarComoLoop();
+
+  static EstadoControle retrato;
+  unsigned long requisicoes = 0, comandos = 0, recusados = 0, retrocessos = 0, ultimoCiclo = 0;
+  const steady_clock::time_point fim = steady_clock::now() + duration_cast<steady_clock::duration>(duration<double>(segundos));
+  while (steady_clock::now() < fim) {
+    lerEstadoControle(retrato);
+    if (retrato.ultimoCicloExecutadoMillis < ultimoCiclo) retrocessos++;
+    ultimoCiclo = retrato.ultimoCicloExecutadoMillis;
+    Comando comando;
+    const char* resposta = nullptr;
+    if (montarComando(requisicoes % 2 ? "automatico" : "desligar", "canal=0", retrato, comando, resposta)) {
+      if (enviarComando(comando)) comandos++; else recusados++;
+    }
+    registroEventos.descarregar();
+    const steady_clock::time_point liberar = steady_clock::now() + milliseconds(ATRASO_HANDLER_MS);
+    while (steady_clock::now() < liberar) {}
+    requisicoes++;
+  }
+  pararTarefaControle();
+  registroEventos.descarregar();
+
+  EstatisticasTarefa t = lerEstatisticasTarefa();
+  unsigned long esperadas = (unsigned long)(segundos * 1000.0 / PERIODO_TAREFA_SIM_MS);
+  bool ok = t.jitterMaximoUs <= LIMITE_JITTER_TAREFA_US && t.ciclosAtrasados == 0 && retrocessos == 0 &&
+            t.amostras + t.amostras / 10 >= esperadas;
+  printf("Tarefa de controle (std::thread, %lu ms, %u núcleo(s)) com o loop() inundado por %.0f s:\n",
+         PERIODO_TAREFA_SIM_MS, std::thread::hardware_concurrency(), segundos);
+  printf("  %lu requisições de %lu ms, %lu comandos (%lu recusados com a fila cheia), %lu retratos fora de ordem\n",
+         requisicoes, ATRASO_HANDLER_MS, comandos, recusados, retrocessos);
+  printf("  %lu ciclos de %lu esperados; jitter máx %lu us, médio %lu us (limite %lu us); duração máx %lu us; %lu atrasados\n",
+         t.amostras, esperadas, t.jitterMaximoUs, t.jitterMedioUs, LIMITE_JITTER_TAREFA_US, t.duracaoMaximaUs, t.ciclosAtrasados);
+  printf("  no loop() único, cada ciclo de controle esperaria até %lu ms\n", ATRASO_HANDLER_MS);
+  printf("%s\n", ok ? "OK" : "FALHOU: a tarefa de controle não manteve o período com o loop() inundado");
+  return ok;
+}
+
+// ==================== RESPOSTAS JSON ====================
+// /status e /tempdata como eram, com a String do Arduino, contra o
+// EscritorJson. Tudo o que o programa pede ao heap com new passa pelos
+// contadores abaixo; a réplica da String conta o malloc/realloc dela.
+static std::atomic<unsigned long> alocacoesNew{0};
+static std::atomic<unsigned long> bytesNew{0};
+
+void* operator new(size_t tamanho) {
+  alocacoesNew.fetch_add(1, std::memory_order_relaxed);
+  bytesNew.fetch_add(tamanho, std::memory_order_relaxed);
+  if (void* p = malloc(tamanho ? tamanho : 1)) return p;
+  throw std::bad_alloc();
+}
+// Fora de linha: embutido, o GCC vê um free() casado com new e avisa.
+__attribute__((noinline)) void operator delete(void* p) noexcept { free(p); }
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept { free(p); }
+
+// Política de memória da String do arduino-esp32 (WString): até 14
+// caracteres no próprio objeto; acima disso malloc/realloc em múltiplos de
+// 16. String(float, casas) pede casas + 42 bytes ao heap para o dtostrf.
+class StringArduino {
+public:
+  static unsigned long alocacoes;
+  static unsigned long bytesAlocados;
+
+  StringArduino(const char* s = "") { concatenar(s, strlen(s)); }
+  explicit StringArduino(unsigned long v) { char b[12]; concatenar(b, snprintf(b, sizeof(b), "%lu", v)); }
+  explicit StringArduino(unsigned int v) : StringArduino((unsigned long)v) {}
+  explicit StringArduino(int v) { char b[12]; concatenar(b, snprintf(b, sizeof(b), "%d", v)); }
+  StringArduino(float v, unsigned casas) {
+    char* b = (char*)pedir(nullptr, casas + 42);
+    concatenar(b, snprintf(b, casas + 42, "%*.*f", (int)casas + 2, (int)casas, v));
+    free(b);
+  }
+  StringArduino(const StringArduino& o) { concatenar(o.c_str(), o._tamanho); }
+  StringArduino(StringArduino&& o) noexcept : _heap(o._heap), _tamanho(o._tamanho), _capacidade(o._capacidade) {
+    memcpy(_sso, o._sso, sizeof(_sso));
+    o._heap = nullptr;
+  }
+  ~StringArduino() { free(_heap); }
+
+  StringArduino& operator+=(const char* s) { concatenar(s, strlen(s)); return *this; }
+  StringArduino& operator+=(const StringArduino& s) { concatenar(s.c_str(), s._tamanho); return *this; }
+  friend StringArduino operator+(StringArduino a, const StringArduino& b) { a += b; return a; }
+  const char* c_str() const { return _heap ? _heap : _sso; }
+  size_t length() const { return _tamanho; }
+
+private:
+  static void* pedir(void* antigo, size_t bytes) {
+    alocacoes++;
+    bytesAlocados += bytes;
+    return realloc(antigo, bytes);
+  }
+  void concatenar(const char* s, size_t n) {
+    if (_tamanho + n > _capacidade) {
+      size_t bloco = (_tamanho + n + 16) & ~(size_t)15;
+      char* novo = (char*)pedir(_heap, bloco);
+      if (!_heap) memcpy(novo, _sso, _tamanho + 1);
+      _heap = novo;
+      _capacidade = bloco - 1;
+    }
+    char* destino = _heap ? _heap : _sso;
+    memcpy(destino + _tamanho, s, n);
+    _tamanho += n;
+    destino[_tamanho] = '\0';
+  }
+
+  char _sso[15] = {};
+  char* _heap = nullptr;
+  size_t _tamanho = 0;
+  size_t _capacidade = sizeof(_sso) - 1;
+};
+unsigned long StringArduino::alocacoes = 0;
+unsigned long StringArduino::bytesAlocados = 0;
+
+// O /status daquela versão, de um canal, com os mesmos valores que o escreverStatus() lê.
+static StringArduino statusComString(const EstadoControle& retrato, const DiagnosticoLoop& diagnostico) {
+  const EstadoCanal& estado = retrato.canais[0];
+  const DadosCanal& dados = retrato.dados.canais[0];
+  const ParametrosOperacao& p = retrato.dados.parametros;
+  EstatisticasTarefa tarefa = lerEstatisticasTarefa();
+  unsigned long tempoRestante;
+  const char* proximo;
+  calcularTemporizador(estado, tempoRestante, proximo);
+  typedef StringArduino String;
+  String proximoEstado = proximo;
+  String json = "{";
+  json += "\"compressorLigado\":" + String(estado.compressorLigado() ? "true" : "false") + ",";
+  json += "\"temperatura\":" + String(estado.temperaturaAtual, 1) + ",";
+  json += "\"caixaCheia\":" + String(estado.caixaCheia ? "true" : "false") + ",";
+  json += "\"modoManual\":" + String(estado.modoManual() ? "true" : "false") + ",";
+  json += "\"alertaTemperatura\":" + String((estado.temperaturaAtual >= p.temperaturaMaxima) ? "true" : "false") + ",";
+  json += "\"alertaCaixaCheia\":" + String(estado.caixaCheia ? "true" : "false") + ",";
+  json += "\"ciclosParciaisOperacao\":" + String(dados.ciclosParciaisOperacao) + ",";
+  json += "\"ciclosEnchimentoCompletos\":" + String(dados.ciclosEnchimentoCompletos) + ",";
+  json += "\"tempoLigado\":" + String(p.tempoLigado / 60000UL) + ",";
+  json += "\"tempoDescanso\":" + String(p.tempoDescanso / 60000UL) + ",";
+  json += "\"temperaturaMaxima\":" + String(p.temperaturaMaxima, 1) + ",";
+  json += "\"tempoRestante\":" + String(tempoRestante) + ",";
+  json += "\"proximoEstado\":\"" + proximoEstado + "\",";
+  json += "\"historicoEnchimento\":[";
+  for (int i = 0; i < TAMANHO_HISTORICO_ENCHIMENTO; i++) {
+    int index = (dados.indiceHistoricoEnchimento - 1 - i + TAMANHO_HISTORICO_ENCHIMENTO) % TAMANHO_HISTORICO_ENCHIMENTO;
+    json += "{";
+    json += "\"tempo\":" + String(dados.historicoEnchimento[index].tempo) + ",";
+    json += "\"ciclos\":" + String(dados.historicoEnchimento[index].ciclosParciais);
+    json += "}";
+    if (i < TAMANHO_HISTORICO_ENCHIMENTO - 1) json += ",";
+  }
+  json += "],";
+  json += "\"mediaEnchimento\":" + String(mediaEnchimento(dados)) + ",";
+  json += "\"resolucaoSensor\":" + String((int)p.resolucaoSensor) + ",";
+  json += "\"intervaloLeitura\":" + String(p.intervaloLeitura) + ",";
+  json += "\"latenciaLoopUs\":" + String(diagnostico.latenciaLoopUs) + ",";
+  json += "\"latenciaMaximaLoopUs\":" + String(diagnostico.latenciaMaximaLoopUs) + ",";
+  json += "\"jitterControleMaxUs\":" + String(tarefa.jitterMaximoUs) + ",";
+  json += "\"jitterControleMedioUs\":" + String(tarefa.jitterMedioUs) + ",";
+  json += "\"duracaoControleMaxUs\":" + String(tarefa.duracaoMaximaUs) + ",";
+  json += "\"ciclosControleAtrasados\":" + String(tarefa.ciclosAtrasados);
+  json += "}";
+  return json;
+}
+
+// O gráfico de 24 leituras horárias daquela versão.
+static StringArduino tempDataComString(const float* historicoTemp, int indiceHistorico) {
+  typedef StringArduino String;
+  String labels = "[";
+  String dados = "[";
+  int leiturasValidas = 0;
+  for (int i = 0; i < 24; i++) {
+    int index = (indiceHistorico + i) % 24;
+    if (historicoTemp[index] > -999) {
+      if (leiturasValidas > 0) { labels += ","; dados += ","; }
+      labels += "\"-" + String(23 - i) + "h\"";
+      dados += String(historicoTemp[index], 1);
+      leiturasValidas++;
+    }
+  }
+  labels += "]";
+  dados += "]";
+  String json = "{\"labels\":" + labels + ",\"dados\":" + dados + "}";
+  return json;
+}
+
+// Fim do valor que começa em `v` (número, texto, objeto ou lista), no nível em que ele está.
+static const char* fimValorJson(const char* v) {
+  int nivel = 0;
+  bool texto = false;
+  for (; *v; v++) {
+    if (texto) {
+      if (*v == '\\' && v[1]) v++;
+      else if (*v == '"') texto = false;
+    } else if (*v == '"') {
+      texto = true;
+    } else if (*v == '{' || *v == '[') {
+      nivel++;
+    } else if (*v == '}' || *v == ']') {
+      if (nivel-- == 0) return v;
+    } else if (*v == ',' && nivel == 0) {
+      return v;
+    }
+  }
+  return v;
+}
+
+// Todo campo de primeiro nível de `antigo` está em `novo`, com o mesmo texto: o painel antigo lê o mesmo.
+static bool camposPreservados(const char* antigo, const char* novo) {
+  const char* c = antigo + 1;
+  char chave[512];
+  while (*c == '"') {
+    const char* fimChave = strchr(c + 1, '"');
+    const char* fim = fimValorJson(fimChave + 2);
+    size_t n = (size_t)(fim - c);
+    if (n >= sizeof(chave)) return false;
+    memcpy(chave, c, n);
+    chave[n] = '\0';
+    const char* achado = strstr(novo, chave);
+    // Mesmo texto e terminado ali (não o começo de um número maior).
+    if (!achado || (achado[n] != ',' && achado[n] != '}')) return false;
+    c = *fim == ',' ? fim + 1 : fim;
+  }
+  return *c == '}';
+}
+
+// Elementos da lista `nome` de primeiro nível (números ou textos sem vírgula).
+static int elementosLista(const char* json, const char* nome) {
+  char chave[32];
+  snprintf(chave, sizeof(chave), "\"%s\":[", nome);
+  const char* c = strstr(json, chave);
+  if (!c) return -1;
+  c += strlen(chave);
+  if (*c == ']') return 0;
+  int n = 1;
+  for (; *c && *c != ']'; c++) n += *c == ',' ? 1 : 0;
+  return n;
+}
+
+struct CustoResposta {
+  double alocacoes;     // por resposta
+  double bytes;         // pedidos ao heap por resposta
+  double us;            // por resposta, no host
+  size_t tamanho;       // do corpo
+};
+
+struct ComparacaoResposta {
+  CustoResposta string;
+  CustoResposta escritor;
+  bool cabe;            // os dois corpos couberam aqui e o do EscritorJson, em pedaços, não estourou
+};
+
+// Corpos do último par de respostas, para as conferências de cada rota.
+static char corpoString[8192];
+static char corpoEscritor[32768];
+
+struct CorpoMontado {
+  size_t tamanho;
+  bool cheio;
+};
+
+// Os pedaços do EscritorJson, como o firmware manda pelo chunked encoding.
+static void juntarPedaco(const char* dados, size_t tamanho, void* contexto) {
+  CorpoMontado& corpo = *static_cast<CorpoMontado*>(contexto);
+  if (corpo.tamanho + tamanho >= sizeof(corpoEscritor)) {
+    corpo.cheio = true;
+    return;
+  }
+  memcpy(corpoEscritor + corpo.tamanho, dados, tamanho);
+  corpo.tamanho += tamanho;
+  corpoEscritor[corpo.tamanho] = '\0';
+}
+
+// `comEscritor` é o serializador do firmware, num buffer do tamanho do bufferJson do main.cpp.
+template <typename ComString, typename ComEscritor>
+static ComparacaoResposta compararResposta(ComString comString, ComEscritor comEscritor) {
+  using namespace std::chrono;
+  const int RESPOSTAS = 20000;
+  ComparacaoResposta c = {};
+  StringArduino::alocacoes = StringArduino::bytesAlocados = 0;
+  unsigned long novasAntes = alocacoesNew.load(), bytesNovosAntes = bytesNew.load();
+  steady_clock::time_point inicio = steady_clock::now();
+  for (int i = 0; i < RESPOSTAS; i++) {
+    StringArduino json = comString();
+    c.string.tamanho = json.length();
+    if (i == 0) {
+      c.cabe = json.length() < sizeof(corpoString);
+      if (c.cabe) memcpy(corpoString, json.c_str(), json.length() + 1);
+    }
+  }
+  c.string.us = duration<double, std::micro>(steady_clock::now() - inicio).count() / RESPOSTAS;
+  c.string.alocacoes = (double)(StringArduino::alocacoes + alocacoesNew.load() - novasAntes) / RESPOSTAS;
+  c.string.bytes = (double)(StringArduino::bytesAlocados + bytesNew.load() - bytesNovosAntes) / RESPOSTAS;
+
+  static char buffer[TAMANHO_BUFFER_JSON];
+  bool estourou = false;
+  CorpoMontado corpo = {};
+  novasAntes = alocacoesNew.load();
+  bytesNovosAntes = bytesNew.load();
+  inicio = steady_clock::now();
+  for (int i = 0; i < RESPOSTAS; i++) {
+    corpo = {};
+    EscritorJson json(buffer, sizeof(buffer), juntarPedaco, &corpo);
+    comEscritor(json);
+    json.esvaziar();
+    estourou = estourou || json.estourou();
+  }
+  c.escritor.us = duration<double, std::micro>(steady_clock::now() - inicio).count() / RESPOSTAS;
+  c.escritor.alocacoes = (double)(alocacoesNew.load() - novasAntes) / RESPOSTAS;
+  c.escritor.bytes = (double)(bytesNew.load() - bytesNovosAntes) / RESPOSTAS;
+  c.escritor.tamanho = corpo.tamanho;
+  c.cabe = c.cabe && !corpo.cheio && !estourou;
+  return c;
+}
+
+static bool relatarResposta(const char* rota, const ComparacaoResposta& c, bool confere, const char* conferencia) {
+  printf("Resposta %s: String %.0f alocações, %.0f bytes, %.2f us (%zu bytes); EscritorJson %.0f alocações, %.0f bytes, "
+         "%.2f us (%zu bytes); %s%s\n",
+         rota, c.string.alocacoes, c.string.bytes, c.string.us, c.string.tamanho, c.escritor.alocacoes, c.escritor.bytes,
+         c.escritor.us, c.escritor.tamanho, conferencia, confere ? "" : ": NÃO");
+  if (c.escritor.alocacoes == 0.0 && c.cabe && confere) return true;
+  printf("FALHA: a serialização do %s alocou memória, estourou o buffer ou mudou o que a versão com String mandava.\n", rota);
+  return false;
+}
+
+// ==================== PROTEÇÃO TÉRMICA ====================
+struct ResultadoTermico {
+  unsigned long partidas = 0;
+  unsigned long enchimentos = 0;
+  unsigned long emergencias = 0;
+  double litros = 0.0;
+  double somaEnchimentosS = 0.0;
+  double temperaturaMaximaC = 0.0;
+
+  double litrosPorPartida() const { return partidas ? litros / partidas : 0.0; }
+  double enchimentoMedioS() const { return enchimentos ? somaEnchimentosS / enchimentos : 0.0; }
+};
+
+// Só o controle contra as plantas, partindo dos parâmetros padrão: as duas
+// proteções veem exatamente o mesmo consumo e o mesmo ambiente.
+static ResultadoTermico simularProtecaoTermica(const OpcoesSimulacao& opcoes, bool preditiva) {
+  sim::definirRelogio(opcoes.inicioMs);
+  static DadosPersistentes dados;
+  memset(&dados, 0, sizeof(dados));
+  dados.parametros = PARAMETROS_PADRAO;
+  dados.parametros.adaptativo = opcoes.adaptativo;
+  dados.parametros.protecaoPreditiva = preditiva;
+  sim::sensoresNoBarramento = NUM_CANAIS;
+  iniciarControle(dados, millis());
+  std::vector<Planta> plantas;
+  for (int i = 0; i < NUM_CANAIS; i++) {
+    ParametrosPlanta parametrosPlanta;
+    parametrosPlanta.consumoMedioLh *= 1.0 + 0.15 * i;
+    parametrosPlanta.nivelInicialL += 40.0 * i;
+    plantas.emplace_back(parametrosPlanta, i);
+  }
+  const uint64_t totalCiclos = (uint64_t)(opcoes.dias * 86400000.0 / opcoes.passoMs);
+  for (uint64_t ciclo = 0; ciclo < totalCiclos; ciclo++) {
+    sim::avancarRelogio(opcoes.passoMs);
+    for (Planta& p : plantas) p.avancar(opcoes.passoMs, sim::relogioTotalMs());
+    executarCicloControle(millis());
+    rastroCompressor.descarregar();
+    if (ciclo % 1000 == 0) registroEventos.descarregar();
+  }
+  ResultadoTermico r;
+  EstadoControle estado;
+  lerEstadoControle(estado);
+  for (int i = 0; i < NUM_CANAIS; i++) {
+    const Planta& p = plantas[i];
+    r.partidas += p.partidas();
+    r.enchimentos += p.enchimentos();
+    r.litros += p.litrosBombeados();
+    r.somaEnchimentosS += p.duracaoMediaEnchimentoS() * p.enchimentos();
+    r.temperaturaMaximaC = std::max(r.temperaturaMaximaC, p.temperaturaMaximaC());
+    r.emergencias += estado.canais[i].desligamentosEmergencia;
+  }
+  return r;
+}
+
+// A preditiva tem de render ao menos tantos litros por partida quanto o limiar,
+// sem nenhum desligamento de emergência a mais.
+static bool compararProtecaoTermica(const OpcoesSimulacao& opcoes) {
+  ResultadoTermico limiar = simularProtecaoTermica(opcoes, false);
+  ResultadoTermico preditiva = simularProtecaoTermica(opcoes, true);
+  const ResultadoTermico* resultados[2] = { &limiar, &preditiva };
+  const char* nomes[2] = { "por limiar", "preditiva " };
+  printf("=== Proteção térmica: %.1f dias, %d canal(is) ===\n", opcoes.dias, NUM_CANAIS);
+  for (int i = 0; i < 2; i++) {
+    const ResultadoTermico& r = *resultados[i];
+    printf("%s: %.1f L por partida (%lu partidas, %.0f L), enchimento médio %.0f s, %lu desligamentos de emergência, Tmax %.1f °C\n",
+           nomes[i], r.litrosPorPartida(), r.partidas, r.litros, r.enchimentoMedioS(), r.emergencias, r.temperaturaMaximaC);
+  }
+  bool vence = preditiva.litrosPorPartida() >= limiar.litrosPorPartida() && preditiva.emergencias <= limiar.emergencias;
+  if (!vence) printf("FALHA: a proteção preditiva rende menos por partida que a por limiar (ou desliga mais em emergência).\n");
+  printf("%s\n", vence ? "OK" : "FALHOU");
+  return vence;
+}
+
+// ==================== MÁQUINA DE ESTADOS ====================
+static bool relatarVerificacaoMaquina(const ResultadoVerificacaoMaquina& r) {
+  printf("Máquina:  %llu sequências, %llu eventos, %llu transições em %.2f s (%.2e sequências/min); "
+         "%zu de %zu linhas da tabela exercitadas; %llu violações, %llu divergências na reprodução\n",
+         (unsigned long long)r.sequencias, (unsigned long long)r.eventos, (unsigned long long)r.transicoes, r.segundos,
+         r.segundos > 0.0 ? r.sequencias * 60.0 / r.segundos : 0.0, r.linhasExercitadas, r.linhasTabela,
+         (unsigned long long)r.violacoes, (unsigned long long)r.divergenciasReproducao);
+  if (r.violacoes != 0) printf("  primeira: %s\n", r.primeiraViolacao);
+  bool confere = r.violacoes == 0 && r.divergenciasReproducao == 0 && r.linhasExercitadas == r.linhasTabela;
+  if (!confere) printf("FALHA: máquina de estados violou uma invariante, divergiu na reprodução ou tem linha inalcançável.\n");
+  return confere;
+}
+
+int main(int argc, char** argv) {
+  OpcoesSimulacao opcoes;
+  if (!lerOpcoes(argc, argv, opcoes)) return 2;
+  if (opcoes.reproduzir) {
+    long divergencias = reproduzirArquivoRastro(opcoes.reproduzir, true);
+    if (divergencias < 0) fprintf(stderr, "%s não é um rastro completo desta versão\n", opcoes.reproduzir);
+    return divergencias == 0 ? 0 : 1;
+  }
+  if (opcoes.sequenciasFuzz > 0) return relatarVerificacaoMaquina(verificarMaquina(opcoes.sequenciasFuzz, 1)) ? 0 : 1;
+  if (opcoes.compararPreditiva) return compararProtecaoTermica(opcoes) ? 0 : 1;
+  if (opcoes.segundosTarefa > 0.0) return testarTarefaControle(opcoes.segundosTarefa) ? 0 : 1;
+  if (opcoes.portaServidor > 0) return servirLocal(opcoes) ? 0 : 1;
+
+  sim::definirRelogio(opcoes.inicioMs);
+  Preferences preferences;
+  preferences.begin("compressor", false);
+  Preferences preferencesLegado;
+  preferencesLegado.begin("compressor-v51", false);
+  GravacaoLegada gravacaoLegada;
+  DadosPersistentes dados;
+  carregarConfiguracoesOperacao(preferences, dados);
+  dados.parametros.adaptativo = opcoes.adaptativo;
+  dados.parametros.protecaoPreditiva = opcoes.protecaoPreditiva;
+  if (opcoes.corrente) dados.parametros.correnteNominalA = 8.0f;
+  ResultadoNucleoCorrente nucleoCorrente = testarNucleoCorrente();
+  perfilador.iniciar(1000);  // no host os "ciclos" do perfilador são nanossegundos
+  sim::sensoresNoBarramento = NUM_CANAIS;
+  iniciarControle(dados, millis());
+  static SerieTemporal serieTemperatura;
+  float maiorTemperatura = -1000.0f;
+  RegistroTelemetria registroTelemetria;
+  static PublicadorMqtt publicadorMqtt;
+  BrokerSimulado broker;
+  if (!SPIFFS.begin(true) || !registroTelemetria.iniciar(SPIFFS)) {
+    fprintf(stderr, "não foi possível abrir o registro de telemetria em %s\n", sim::diretorioSpiffs);
+    return 2;
+  }
+
+  // Canais com consumo e nível inicial diferentes, para não andarem em fase.
+  std::vector<Planta> plantas;
+  for (int i = 0; i < NUM_CANAIS; i++) {
+    ParametrosPlanta parametrosPlanta;
+    parametrosPlanta.consumoMedioLh *= 1.0 + 0.15 * i;
+    parametrosPlanta.nivelInicialL += 40.0 * i;
+    parametrosPlanta.trepidacao = opcoes.trepidacao;
+    if (opcoes.corrente) parametrosPlanta.correnteNominalA = 8.0;
+    plantas.emplace_back(parametrosPlanta, i);
+  }
+  const uint64_t HORA_MS = 3600000ULL;
+  const uint64_t duracaoMs = (uint64_t)(opcoes.dias * 86400000.0);
+  std::vector<RoteiroFalhasCanal> roteiros(NUM_CANAIS);
+  for (int i = 0; i < NUM_CANAIS; i++) {
+    const uint64_t horas[RoteiroFalhasCanal::NUM_FALHAS] = { 6, 20, 40 };
+    const FalhaPlanta tipos[RoteiroFalhasCanal::NUM_FALHAS] = { FALHA_CONTATOR, FALHA_ROTOR, FALHA_POCO_SECO };
+    for (int f = 0; f < RoteiroFalhasCanal::NUM_FALHAS; f++) {
+      uint64_t instante = horas[f] * HORA_MS + i * HORA_MS / 2;
+      // Só o que ainda dá tempo de disparar (e, a seco, de o poço voltar).
+      bool cabe = opcoes.corrente && instante + (tipos[f] == FALHA_POCO_SECO ? 3 : 1) * HORA_MS < duracaoMs;
+      roteiros[i].injecaoMs[f] = cabe ? instante : 0;
+      roteiros[i].tipos[f] = tipos[f];
+    }
+  }
+
+  const uint64_t totalCiclos = (uint64_t)(opcoes.dias * 86400000.0 / opcoes.passoMs);
+  // Tempo seguido de relé fechado com a boia já fechada: o corte espera o debounce.
+  unsigned long releComCaixaCheiaMs[NUM_CANAIS] = {};
+  unsigned long maiorCorteMs[NUM_CANAIS] = {};
+  uint64_t maiorBarramentoCicloUs = 0;
+  uint64_t inicioBarramentoUs = sim::tempoBarramentoUs;
+  // O rastro é refeito à medida que chega, como o --reproduzir faria com o arquivo.
+  ReprodutorRastro reprodutor;
+
+  std::chrono::steady_clock::time_point inicio = std::chrono::steady_clock::now();
+  for (uint64_t ciclo = 0; ciclo < totalCiclos; ciclo++) {
+    sim::avancarRelogio(opcoes.passoMs);
+    for (Planta& p : plantas) p.avancar(opcoes.passoMs, sim::relogioTotalMs());
+    uint64_t barramentoAntes = sim::tempoBarramentoUs;
+    executarCicloControle(millis());
+    uint64_t barramentoCiclo = sim::tempoBarramentoUs - barramentoAntes;
+    if (barramentoCiclo > maiorBarramentoCicloUs) maiorBarramentoCicloUs = barramentoCiclo;
+    size_t novosRastro = rastroCompressor.descarregar();
+    if (novosRastro > 0) {
+      rastroCompressor.percorrerHistorico([&](const RegistroRastro& r) { reprodutor.reproduzir(r); }, novosRastro);
+    }
+    if (opcoes.corrente) {
+      uint64_t decorridoMs = sim::relogioTotalMs() - opcoes.inicioMs;
+      bool lerEstado = ciclo % 10 == 0;
+      EstadoControle atual;
+      if (lerEstado) lerEstadoControle(atual);
+      for (int i = 0; i < NUM_CANAIS; i++) {
+        RoteiroFalhasCanal& r = roteiros[i];
+        Planta& planta = plantas[i];
+        bool releFechado = sim::nivelPino(PINOS_RELE_COMPRESSOR[i]) == LOW;
+        for (int f = 0; f < RoteiroFalhasCanal::NUM_FALHAS; f++) {
+          if (r.injecaoMs[f] == 0 || decorridoMs < r.injecaoMs[f] || planta.falha() != SEM_FALHA_PLANTA) continue;
+          planta.injetarFalha(r.tipos[f]);
+          r.esperados[falhaEsperada(r.tipos[f])]++;
+          r.injecaoMs[f] = 0;
+          r.exposicaoMs = releFechado ? decorridoMs : 0;
+        }
+        // A latência conta do fechamento do relé sobre a falha (ou da injeção, com ele fechado).
+        if (releFechado && !planta.compressorLigado() && planta.falha() != SEM_FALHA_PLANTA) r.exposicaoMs = decorridoMs;
+        if (r.reparoMs != 0 && decorridoMs >= r.reparoMs) {
+          planta.repararFalha();
+          Comando comando;
+          comando.tipo = COMANDO_AUTOMATICO;
+          comando.canal = (uint8_t)i;
+          enviarComando(comando);
+          r.reparoMs = 0;
+        }
+        if (!lerEstado) continue;
+        const EstadoCanal& c = atual.canais[i];
+        if (c.correnteSemRele) r.alarmesSemRele++;
+        if (c.falhaCorrente() != r.anterior && c.falhaCorrente() != FALHA_NENHUMA) {
+          r.desligamentos[c.falhaCorrente()]++;
+          if (c.falhaCorrente() != falhaEsperada(planta.falha())) r.falsos++;
+          else {
+            unsigned long latenciaMs = (unsigned long)(decorridoMs - r.exposicaoMs);
+            if (latenciaMs > r.piorLatenciaMs[c.falhaCorrente()]) r.piorLatenciaMs[c.falhaCorrente()] = latenciaMs;
+          }
+          if (planta.falha() == FALHA_CONTATOR || planta.falha() == FALHA_ROTOR) r.reparoMs = decorridoMs + 10 * 60000ULL;
+        }
+        // O poço só volta a encher depois do bloqueio, e o técnico dá uma hora para ele se refazer antes de
+        // voltar ao automático: as novas tentativas do firmware, até ali, todas o encontram seco.
+        if (secoBloqueado(c.maquina) && !r.bloqueado) {
+          r.bloqueiosSeco++;
+          planta.repararFalha();
+          r.reparoMs = decorridoMs + HORA_MS;
+        }
+        r.bloqueado = secoBloqueado(c.maquina);
+        r.anterior = c.falhaCorrente();
+      }
+    }
+    for (int i = 0; i < NUM_CANAIS; i++) {
+      if (plantas[i].caixaCheia() && sim::nivelPino(PINOS_RELE_COMPRESSOR[i]) == LOW) {
+        releComCaixaCheiaMs[i] += opcoes.passoMs;
+        if (releComCaixaCheiaMs[i] > maiorCorteMs[i]) maiorCorteMs[i] = releComCaixaCheiaMs[i];
+      } else {
+        releComCaixaCheiaMs[i] = 0;
+      }
+    }
+    // O loop() do firmware tenta gravar a cada passada; aqui basta a cada segundo simulado.
+    if (ciclo % (1000 / opcoes.passoMs + 1) == 0) {
+      EstadoControle atual;
+      lerEstadoControle(atual);
+      salvarConfiguracoesOperacao(preferences, atual, millis());
+      if (NUM_CANAIS == 1) gravacaoLegada.salvar(preferencesLegado, atual, millis());
+      registroTelemetria.amostrar(atual, millis(), (uint32_t)(sim::relogioTotalMs() / 1000ULL), false);
+      registroTelemetria.descarregar(millis());
+      registroEventos.descarregar();
+      broker.noAr = BrokerSimulado::noArEm(sim::relogioTotalMs() - opcoes.inicioMs);
+      publicadorMqtt.amostrar(atual, millis(), (uint32_t)(sim::relogioTotalMs() / 1000ULL), false);
+      publicadorMqtt.descarregar(BrokerSimulado::receber, &broker, millis());
+      serieTemperatura.registrar(atual.canais[0].temperaturaAtual, millis());
+      if (atual.canais[0].temperaturaAtual > maiorTemperatura) maiorTemperatura = atual.canais[0].temperaturaAtual;
+    }
+  }
+  registroTelemetria.descarregar(millis(), true);
+  broker.noAr = true;
+  publicadorMqtt.descarregar(BrokerSimulado::receber, &broker, millis(), true);
+  double segundos = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+
+  EstadoControle retrato;
+  lerEstadoControle(retrato);
+  const ParametrosOperacao& p = retrato.dados.parametros;
+  const DadosCanal& d = retrato.dados.canais[0];
+  int falhas = 0;
+
+  printf("=== Simulação: %.1f dias, passo %lu ms, relógio inicial %llu ms, %d canal(is) ===\n", opcoes.dias, opcoes.passoMs,
+         (unsigned long long)opcoes.inicioMs, NUM_CANAIS);
+  for (int i = 0; i < NUM_CANAIS; i++) {
+    const Planta& planta = plantas[i];
+    const EstadoCanal& estado = retrato.canais[i];
+    const DadosCanal& d = retrato.dados.canais[i];
+    if (NUM_CANAIS > 1) printf("--- Canal %d ---\n", i);
+    printf("Planta:   %lu enchimentos, %lu partidas, %.0f L bombeados, %.1f h ligado, Tmax %.1f °C\n",
+           planta.enchimentos(), planta.partidas(), planta.litrosBombeados(), planta.horasLigado(), planta.temperaturaMaximaC());
+    printf("Firmware: %lu enchimentos, %lu ciclos parciais\n", d.ciclosEnchimentoCompletos, d.ciclosParciaisOperacao);
+    printf("Ciclo %s: %.1f L por partida, enchimento médio %.0f s, em uso %lu s ligado / %lu s descanso\n",
+           p.adaptativo ? "adaptativo" : "fixo", planta.partidas() ? planta.litrosBombeados() / planta.partidas() : 0.0,
+           planta.duracaoMediaEnchimentoS(), estado.tempoLigadoAtual / 1000UL, estado.tempoDescansoAtual / 1000UL);
+    printf("Modelo:   %.0f s ligado por enchimento, %.2f partidas por enchimento, limite térmico %.0f s, recuperação %.2f\n",
+           d.modelo.ligadoPorEnchimentoS, d.modelo.partidasPorEnchimento, d.modelo.ligadoAteLimiteS, d.modelo.recuperacaoPoco);
+    printf("Térmica:  proteção %s, %lu paradas preditivas, %lu desligamentos de emergência, religa abaixo de %.1f °C\n",
+           p.protecaoPreditiva ? "preditiva" : "por limiar", estado.paradasTermicasPreditivas,
+           estado.desligamentosEmergencia, estado.temperaturaReligamento);
+    // O bombeamento por enchimento estimado tem de bater com o medido na planta.
+    double ligadoPorEnchimentoPlanta = planta.enchimentos() ? planta.horasLigado() * 3600.0 / planta.enchimentos() : 0.0;
+    // Com falhas injetadas (--corrente) o modelo aprende também os enchimentos anormais.
+    if (!opcoes.corrente && planta.enchimentos() >= 5 && fabs(d.modelo.ligadoPorEnchimentoS - ligadoPorEnchimentoPlanta) > 0.25 * ligadoPorEnchimentoPlanta) {
+      printf("FALHA: modelo estima %.0f s ligado por enchimento, planta mediu %.0f s.\n", d.modelo.ligadoPorEnchimentoS,
+             ligadoPorEnchimentoPlanta);
+      falhas++;
+    }
+
+    if (d.ciclosEnchimentoCompletos != planta.enchimentos()) {
+      printf("FALHA: contagem de enchimentos diverge da planta.\n");
+      falhas++;
+    }
+    if (d.ciclosParciaisOperacao != planta.partidas()) {
+      printf("FALHA: contagem de ciclos parciais diverge das partidas da planta.\n");
+      falhas++;
+    }
+    // O primeiro enchimento começa antes de a boia abrir, então só os seguintes são comparáveis.
+    unsigned long comparaveis = planta.enchimentos() > 0 ? planta.enchimentos() - 1 : 0;
+    for (int j = 0; j < TAMANHO_HISTORICO_ENCHIMENTO && (unsigned long)j < comparaveis; j++) {
+      int indice = (d.indiceHistoricoEnchimento - 1 - j + TAMANHO_HISTORICO_ENCHIMENTO) % TAMANHO_HISTORICO_ENCHIMENTO;
+      unsigned long firmware = d.historicoEnchimento[indice].tempo;
+      unsigned long referencia = planta.duracaoEnchimento(j);
+      printf("  Enchimento -%d: firmware %lu s, planta %lu s\n", j, firmware, referencia);
+      if (firmware != referencia) {
+        printf("FALHA: duração do enchimento -%d diverge da planta.\n", j);
+        falhas++;
+      }
+    }
+    // A borda confirma depois do debounce, contado da última borda da trepidação.
+    unsigned long limiteCorteMs = p.debounceBoiaMs + (opcoes.trepidacao ? TREPIDACAO_BOIA_MS : 0) + opcoes.passoMs;
+    printf("Boia:     %lu bordas, %lu glitches e %lu trepidações descartados (injetados %lu e %lu), %lu perdidas, "
+           "corte até %lu ms após fechar (limite %lu ms)\n",
+           (unsigned long)estado.boia.bordas, (unsigned long)estado.boia.glitches, (unsigned long)estado.boia.trepidacoes,
+           planta.glitchesInjetados(), planta.pulsosInjetados(), (unsigned long)estado.boia.perdidas, maiorCorteMs[i],
+           limiteCorteMs);
+    if (maiorCorteMs[i] > limiteCorteMs) {
+      printf("FALHA: relé ligado com a caixa cheia por %lu ms.\n", maiorCorteMs[i]);
+      falhas++;
+    }
+    if (estado.boia.glitches != planta.glitchesInjetados() || estado.boia.trepidacoes != planta.pulsosInjetados() ||
+        estado.boia.perdidas != 0) {
+      printf("FALHA: filtro da boia não confere com o ruído injetado.\n");
+      falhas++;
+    }
+    // A planta e o firmware somam o mesmo passo com o relé fechado; só o último passo fica de fora.
+    double msLigadoPlanta = planta.horasLigado() * 3600000.0;
+    printf("Relé:     %.1f h ligado segundo o firmware\n", estado.tempoLigadoTotalMs / 3600000.0);
+    if (fabs((double)estado.tempoLigadoTotalMs - msLigadoPlanta) > opcoes.passoMs) {
+      printf("FALHA: tempo de relé ligado diverge da planta.\n");
+      falhas++;
+    }
+    if (planta.temperaturaMaximaC() >= p.temperaturaMaxima + 1.0) {
+      printf("FALHA: temperatura passou do limite (%.1f °C).\n", planta.temperaturaMaximaC());
+      falhas++;
+    }
+    if (opcoes.corrente) {
+      const RoteiroFalhasCanal& r = roteiros[i];
+      printf("Corrente: %.2f A agora; desligamentos sem corrente %lu, rotor bloqueado %lu, a seco %lu com %lu bloqueios "
+             "(injetados %lu, %lu, %lu); pior latência %lu ms, %lu ms e %lu ms; %lu falsos\n",
+             estado.correnteA, r.desligamentos[FALHA_SEM_CORRENTE], r.desligamentos[FALHA_ROTOR_BLOQUEADO],
+             r.desligamentos[FALHA_FUNCIONAMENTO_SECO], r.bloqueiosSeco, r.esperados[FALHA_SEM_CORRENTE],
+             r.esperados[FALHA_ROTOR_BLOQUEADO], r.esperados[FALHA_FUNCIONAMENTO_SECO], r.piorLatenciaMs[FALHA_SEM_CORRENTE],
+             r.piorLatenciaMs[FALHA_ROTOR_BLOQUEADO], r.piorLatenciaMs[FALHA_FUNCIONAMENTO_SECO], r.falsos);
+      unsigned long vistos = r.desligamentos[FALHA_SEM_CORRENTE] + r.desligamentos[FALHA_ROTOR_BLOQUEADO] + r.desligamentos[FALHA_FUNCIONAMENTO_SECO];
+      // Cada poço seco desarma pelo menos uma vez e no máximo MAX_DESARMES_SECO, e termina bloqueando o canal.
+      unsigned long secos = r.esperados[FALHA_FUNCIONAMENTO_SECO];
+      bool secoConfere = r.desligamentos[FALHA_FUNCIONAMENTO_SECO] >= secos &&
+                         r.desligamentos[FALHA_FUNCIONAMENTO_SECO] <= secos * MAX_DESARMES_SECO && r.bloqueiosSeco == secos;
+      if (r.desligamentos[FALHA_SEM_CORRENTE] != r.esperados[FALHA_SEM_CORRENTE] ||
+          r.desligamentos[FALHA_ROTOR_BLOQUEADO] != r.esperados[FALHA_ROTOR_BLOQUEADO] || !secoConfere || r.falsos != 0 ||
+          r.alarmesSemRele != 0 || estado.desligamentosCorrente != vistos) {
+        printf("FALHA: desligamentos por corrente não conferem com as falhas injetadas (%lu no firmware, %lu alarmes de relé).\n",
+               estado.desligamentosCorrente, r.alarmesSemRele);
+        falhas++;
+      }
+      if (r.piorLatenciaMs[FALHA_SEM_CORRENTE] > 3000 || r.piorLatenciaMs[FALHA_ROTOR_BLOQUEADO] > 3000 ||
+          r.piorLatenciaMs[FALHA_FUNCIONAMENTO_SECO] > 45000) {
+        printf("FALHA: desligamento por corrente demorou demais.\n");
+        falhas++;
+      }
+      double energiaPlanta = planta.energiaUltimoEnchimentoWh();
+      printf("Energia:  último enchimento %.1f Wh segundo o firmware, %.1f Wh na planta; %.2f kWh desde o boot\n",
+             estado.energiaUltimoEnchimentoWh, energiaPlanta, estado.energiaTotalWh / 1000.0);
+      if (planta.enchimentos() >= 2 && fabs(estado.energiaUltimoEnchimentoWh - energiaPlanta) > 0.02 * energiaPlanta) {
+        printf("FALHA: energia do último enchimento diverge da planta em mais de 2%%.\n");
+        falhas++;
+      }
+    }
+  }
+  if (NUM_CANAIS > 1) printf("---\n");
+
+  // Um broadcast de conversão e uma leitura endereçada por ciclo, no máximo: não cresce com os canais.
+  printf("Barramento: %d sensor(es), máx %llu us por ciclo, média %.1f us por ciclo (limite %lu us)\n", NUM_CANAIS,
+         (unsigned long long)maiorBarramentoCicloUs, (double)(sim::tempoBarramentoUs - inicioBarramentoUs) / totalCiclos,
+         sim::CUSTO_LEITURA_ENDERECADA_US);
+  if (maiorBarramentoCicloUs > sim::CUSTO_LEITURA_ENDERECADA_US) {
+    printf("FALHA: um ciclo de controle ocupou o barramento por mais que uma leitura endereçada.\n");
+    falhas++;
+  }
+
+  // A última amostra lida de volta do log tem de bater com os contadores finais.
+  struct LeituraTelemetria { unsigned long amostras; AmostraTelemetria ultima; } leitura = { 0, {} };
+  registroTelemetria.percorrer((uint32_t)(opcoes.inicioMs / 1000ULL), UINT32_MAX,
+                               [](const AmostraTelemetria& a, void* contexto) {
+                                 LeituraTelemetria& l = *static_cast<LeituraTelemetria*>(contexto);
+                                 l.amostras++;
+                                 l.ultima = a;
+                                 return true;
+                               }, &leitura);
+  printf("Telemetria: %lu amostras gravadas (%lu bytes, %lu falhas), %lu lidas de volta\n",
+         registroTelemetria.amostrasGravadas(), registroTelemetria.bytesGravados(), registroTelemetria.falhasGravacao(),
+         leitura.amostras);
+  if (leitura.amostras == 0 || leitura.ultima.ciclosEnchimentoCompletos != d.ciclosEnchimentoCompletos ||
+      leitura.ultima.ciclosParciaisOperacao != d.ciclosParciaisOperacao) {
+    printf("FALHA: última amostra da telemetria não confere com os contadores.\n");
+    falhas++;
+  }
+
+  if (opcoes.exportar) {
+    FILE* arquivo = fopen(opcoes.exportar, "wb");
+    if (!arquivo) {
+      printf("FALHA: não foi possível criar %s.\n", opcoes.exportar);
+      falhas++;
+    } else {
+      InfoExportacao info = { "compressor-sim", (uint32_t)(sim::relogioTotalMs() / 1000ULL), false, (uint32_t)(millis() / 1000UL) };
+      size_t bytes = exportarHistorico(info, retrato, registroTelemetria, serieTemperatura,
+                                       [](const uint8_t* dados, size_t tamanho, void* contexto) {
+                                         return fwrite(dados, 1, tamanho, static_cast<FILE*>(contexto)) == tamanho;
+                                       }, arquivo);
+      fclose(arquivo);
+      printf("Exportação: %zu bytes em %s\n", bytes, opcoes.exportar);
+    }
+  }
+
+  printf("Rastro:   %lu transições registradas, %lu perdidas; %lu reproduzidas com %lu lacunas e %lu divergências\n",
+         (unsigned long)rastroCompressor.registrados(), (unsigned long)rastroCompressor.descartados(),
+         (unsigned long)reprodutor.reproduzidos(), (unsigned long)reprodutor.lacunas(), (unsigned long)reprodutor.divergencias());
+  if (rastroCompressor.descartados() != 0 || reprodutor.lacunas() != 0 || reprodutor.divergencias() != 0 ||
+      reprodutor.reproduzidos() != rastroCompressor.registrados()) {
+    printf("FALHA: o rastro da máquina de estados perdeu registros ou não se reproduz.\n");
+    falhas++;
+  }
+  if (opcoes.rastro) {
+    FILE* arquivo = fopen(opcoes.rastro, "wb");
+    if (!arquivo) {
+      printf("FALHA: não foi possível criar %s.\n", opcoes.rastro);
+      falhas++;
+    } else {
+      size_t bytes = rastroCompressor.exportar([](const uint8_t* dados, size_t tamanho, void* contexto) {
+                                                 return fwrite(dados, 1, tamanho, static_cast<FILE*>(contexto)) == tamanho;
+                                               }, arquivo);
+      fclose(arquivo);
+      printf("Rastro:   %zu bytes em %s\n", bytes, opcoes.rastro);
+      if (reproduzirArquivoRastro(opcoes.rastro, false) != 0) {
+        printf("FALHA: o arquivo do rastro não se reproduz.\n");
+        falhas++;
+      }
+    }
+  }
+
+  // O pico tem de sobreviver à agregação até o nível mais grosso (1 h) enquanto couber no anel.
+  float picoSerie = -1000.0f;
+  serieTemperatura.percorrer(SerieTemporal::NUM_NIVEIS - 1, 0,
+                             [](uint32_t, float, float maximo, float, void* contexto) {
+                               float& pico = *static_cast<float*>(contexto);
+                               if (maximo > pico) pico = maximo;
+                             }, &picoSerie);
+  printf("Série temporal: %u bytes, pico %.2f °C no nível de 1 h (amostrado %.2f °C)\n",
+         (unsigned)SerieTemporal::memoriaUsada(), picoSerie, maiorTemperatura);
+  if (opcoes.dias <= 30.0 && fabsf(picoSerie - maiorTemperatura) > 0.01f) {
+    printf("FALHA: pico de temperatura perdido na agregação da série.\n");
+    falhas++;
+  }
+
+  // Tudo o que não caiu por fila cheia chegou, em ordem, e o buraco aparece na sequência.
+  printf("MQTT:     %lu amostras em %lu lotes, %lu descartadas em %lu lotes durante as quedas; "
+         "%.1f bytes MQTT por amostra (%.1f com TCP/IP)\n",
+         broker.amostras, broker.lotes, publicadorMqtt.amostrasDescartadas(), publicadorMqtt.lotesDescartados(),
+         broker.amostras ? (double)broker.bytesMqtt / broker.amostras : 0.0,
+         broker.amostras ? (double)(broker.bytesMqtt + 40ULL * broker.lotes) / broker.amostras : 0.0);
+  bool ultimaConfere = true;
+  for (int i = 0; i < NUM_CANAIS; i++) {
+    ultimaConfere &= broker.ultima[i].ciclosEnchimentoCompletos == retrato.dados.canais[i].ciclosEnchimentoCompletos &&
+                     broker.ultima[i].ciclosParciaisOperacao == retrato.dados.canais[i].ciclosParciaisOperacao;
+  }
+  if (broker.amostras + publicadorMqtt.amostrasDescartadas() != publicadorMqtt.amostras() ||
+      broker.lotesFaltando != publicadorMqtt.lotesDescartados() || broker.foraDeOrdem != 0 || !ultimaConfere) {
+    printf("  (recebidas %lu + descartadas %lu de %lu; %lu lotes faltando; %lu fora de ordem; última %s)\n", broker.amostras,
+           publicadorMqtt.amostrasDescartadas(), publicadorMqtt.amostras(), broker.lotesFaltando, broker.foraDeOrdem,
+           ultimaConfere ? "confere" : "diverge");
+    printf("FALHA: telemetria MQTT perdeu amostras, saiu fora de ordem ou não confere com os contadores.\n");
+    falhas++;
+  }
+  // Comandos por MQTT seguem as regras das rotas HTTP.
+  Comando comando;
+  const char* resposta = nullptr;
+  bool configura = montarComando("config", "tempoligado=12&glitchboia=7&desconhecido=1", retrato, comando, resposta);
+  bool configuraCerto = configura && comando.tipo == COMANDO_CONFIGURAR && comando.parametros.tempoLigado == 720000UL &&
+                        comando.parametros.glitchBoiaMs == 7 && comando.parametros.tempoDescanso == p.tempoDescanso;
+  bool recusaCanal = !montarComando("desligar", "canal=99", retrato, comando, resposta) && strcmp(resposta, "❌ Canal inválido.") == 0;
+  bool recusaVazio = !montarComando("config", "tempoligado=abc", retrato, comando, resposta);
+  bool recusaAcao = !montarComando("reiniciar", "", retrato, comando, resposta);
+  bool aceitaCanal = montarComando("automatico", NUM_CANAIS > 1 ? "canal=1" : "canal=0", retrato, comando, resposta) &&
+                     comando.tipo == COMANDO_AUTOMATICO && comando.canal == (NUM_CANAIS > 1 ? 1 : 0);
+  if (!configuraCerto || !recusaCanal || !recusaVazio || !recusaAcao || !aceitaCanal) {
+    printf("FALHA: comandos por MQTT não seguem as regras das rotas HTTP.\n");
+    falhas++;
+  }
+
+  double ciclosPorSegundo = totalCiclos / (segundos > 0.0 ? segundos : 1e-9);
+  printf("Desempenho: %llu ciclos de controle em %.2f s = %.2e ciclos/s (meta 1e6)%s\n",
+         (unsigned long long)totalCiclos, segundos, ciclosPorSegundo, ciclosPorSegundo < 1e6 ? "  ABAIXO DA META" : "");
+  // Custo de uma marcação do perfilador: tem de ficar bem abaixo de 1 µs.
+  const int MARCACOES = 1000000;
+  std::chrono::steady_clock::time_point inicioMarcacoes = std::chrono::steady_clock::now();
+  uint32_t marca = lerCiclos();
+  for (int i = 0; i < MARCACOES; i++) marca = perfilador.registrar(ETAPA_LOOP, marca);
+  double nsPorMarcacao = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - inicioMarcacoes).count() / MARCACOES;
+  const Perfilador::Histograma& sensores = perfilador.histograma(ETAPA_SENSORES);
+  const Perfilador::Histograma& controle = perfilador.histograma(ETAPA_CONTROLE);
+  uint64_t amostrasSensores = 0, amostrasControle = 0;
+  for (int f = 0; f <= Perfilador::NUM_FAIXAS; f++) {
+    amostrasSensores += sensores.contagem[f];
+    amostrasControle += controle.contagem[f];
+  }
+  printf("Perfilador: %.0f ns por marcação; sensores média %.0f ns (máx %lu ns), controle média %.0f ns (máx %lu ns)\n",
+         nsPorMarcacao, amostrasSensores ? (double)sensores.somaCiclos / amostrasSensores : 0.0, (unsigned long)sensores.maximoCiclos,
+         amostrasControle ? (double)controle.somaCiclos / amostrasControle : 0.0, (unsigned long)controle.maximoCiclos);
+  if (amostrasSensores != totalCiclos || nsPorMarcacao >= 1000.0) {
+    printf("FALHA: perfilador perdeu amostras ou custa mais de 1 µs por marcação.\n");
+    falhas++;
+  }
+
+  // Custo de um LOG_EVENTO no caminho de controle, contra o Serial.printf síncrono que ele substituiu.
+  registroEventos.descarregar();
+  unsigned long eventosSimulacao = registroEventos.registrados();
+  unsigned long descartadosSimulacao = registroEventos.descartados();
+  bool ecoar = Serial.ecoar;
+  Serial.ecoar = false;
+  const int EVENTOS = 1000000;
+  const int LOTE = RegistroEventos::CAPACIDADE_FILA / 2;
+  double nsRegistrando = 0.0;
+  for (int i = 0; i < EVENTOS; i += LOTE) {
+    std::chrono::steady_clock::time_point inicioLote = std::chrono::steady_clock::now();
+    for (int j = 0; j < LOTE; j++) LOG_EVENTO(CICLO_PARCIAL, 0, (unsigned)j, (unsigned long)i);
+    nsRegistrando += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - inicioLote).count();
+    registroEventos.descarregar();
+  }
+  Serial.ecoar = ecoar;
+  double nsPorEvento = nsRegistrando / EVENTOS;
+  char linha[192];
+  const int FORMATACOES = 100000;
+  int bytesLinha = 0;
+  std::chrono::steady_clock::time_point inicioFormatacao = std::chrono::steady_clock::now();
+  for (int i = 0; i < FORMATACOES; i++) {
+    bytesLinha = snprintf(linha, sizeof(linha), "⚡️ Ciclo parcial #%u iniciado. Total de ciclos: %lu\n", (unsigned)i % 7, 100000UL + i);
+  }
+  double nsPorFormatacao = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - inicioFormatacao).count() / FORMATACOES;
+  double msSerial = bytesLinha * 10.0 / 115200.0 * 1000.0;  // 8N1: 10 bits por byte
+  printf("Log:      %.0f ns por evento registrado, contra %.0f ns para formatar e %.2f ms para transmitir a mesma linha a 115200 baud; "
+         "%lu eventos na simulação, %lu descartados\n",
+         nsPorEvento, nsPorFormatacao, msSerial, eventosSimulacao, descartadosSimulacao);
+  if (descartadosSimulacao != 0 || nsPorEvento >= 1000.0) {
+    printf("FALHA: log diferido perdeu eventos ou custa mais de 1 µs por registro.\n");
+    falhas++;
+  }
+  // Vazão do publicador: amostras de todos os canais a cada 5 s simulados, broker sempre no ar.
+  static PublicadorMqtt vazao;
+  BrokerSimulado brokerVazao;
+  const int RODADAS = 200000;
+  std::chrono::steady_clock::time_point inicioVazao = std::chrono::steady_clock::now();
+  for (int i = 0; i < RODADAS; i++) {
+    unsigned long agora = (unsigned long)i * PublicadorMqtt::INTERVALO_AMOSTRAGEM_MS;
+    vazao.amostrar(retrato, agora, agora / 1000UL, false);
+    vazao.descarregar(BrokerSimulado::receber, &brokerVazao, agora);
+  }
+  double segundosVazao = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicioVazao).count();
+  printf("MQTT:     vazão de %.2e amostras/s e %.2e mensagens/s no publicador, %.1f bytes MQTT por amostra\n",
+         brokerVazao.amostras / segundosVazao, brokerVazao.lotes / segundosVazao,
+         (double)brokerVazao.bytesMqtt / brokerVazao.amostras);
+  printf("Corrente: núcleo do valor eficaz com erro máx %.3f A em %d casos sintéticos (%d fora de 1%% + 0,05 A); "
+         "%.2f ns por amostra contra %.2f ns da conta direta em float (%.1fx)\n",
+         nucleoCorrente.piorErroA, nucleoCorrente.casos, nucleoCorrente.fora, nucleoCorrente.nsNucleo,
+         nucleoCorrente.nsReferencia, nucleoCorrente.nsNucleo > 0.0 ? nucleoCorrente.nsReferencia / nucleoCorrente.nsNucleo : 0.0);
+  if (nucleoCorrente.casos == 0 || nucleoCorrente.fora != 0) {
+    printf("FALHA: valor eficaz do núcleo fora da tolerância.\n");
+    falhas++;
+  }
+  ResultadoSessoes sessoes = testarSessoes();
+  printf("Sessões:  por requisição, Basic como antes %.0f ns, cookie %.0f ns (%.0f ns fora do cache), Basic já conferido %.0f ns; "
+         "login (PBKDF2, %lu iterações) %.2f ms\n",
+         sessoes.nsAntes, sessoes.nsCookie, sessoes.nsCookieNovo, sessoes.nsBasicCache,
+         (unsigned long)GerenciadorSessoes::ITERACOES_SENHA, sessoes.msLogin);
+  if (!sessoes.aceitouTodas) {
+    printf("FALHA: sessões recusaram uma credencial ou um token válido.\n");
+    falhas++;
+  }
+  printf("Limite:   %lu requisições/s por cliente, rajada de %lu, login custa %lu; %.0f ns por requisição admitida\n",
+         (unsigned long)LimitadorClientes::TAXA_PADRAO_POR_S, (unsigned long)LimitadorClientes::RAJADA_PADRAO,
+         (unsigned long)LimitadorClientes::CUSTO_LOGIN_PADRAO, nsPorRequisicaoLimitador());
+  {
+    const DiagnosticoLoop diagnostico = { 850, 4200, 0, 0, 0 };
+    ComparacaoResposta status = compararResposta([&]() { return statusComString(retrato, diagnostico); },
+                                                 [&](EscritorJson& json) { escreverStatus(json, retrato, CAMPOS_TODOS, diagnostico); });
+    falhas += !relatarResposta("/status", status, camposPreservados(corpoString, corpoEscritor), "campos antigos preservados");
+
+    // O gráfico de antes (24 leituras horárias) contra o /tempdata de hoje no mesmo nível de 1 h.
+    float historicoTemp[24];
+    static SerieTemporal serie;
+    for (int i = 0; i < 24; i++) historicoTemp[(7 + i) % 24] = 38.0f + 9.0f * sinf(i * 0.26f) + 0.07f * i;
+    for (uint32_t s = 0; s < 24 * 3600; s += 60) serie.registrar(historicoTemp[(7 + s / 3600) % 24], s * 1000UL);
+    const int nivel = SerieTemporal::escolherNivel(3600, 86400, 360);
+    ComparacaoResposta tempData = compararResposta([&]() { return tempDataComString(historicoTemp, 7); },
+                                                   [&](EscritorJson& json) { escreverSerieTemperatura(json, serie, nivel, 86400); });
+    int pontos = elementosLista(corpoEscritor, "dados");
+    bool listas = pontos == elementosLista(corpoString, "dados") && pontos == elementosLista(corpoEscritor, "labels") &&
+                  pontos == elementosLista(corpoEscritor, "minimos") && pontos == elementosLista(corpoEscritor, "maximos");
+    falhas += !relatarResposta("/tempdata", tempData, listas, "mesmos 24 pontos");
+  }
+  if (opcoes.corrente) {
+    printf("ADC:      %llu conversões, %llu descartadas por transbordar o buffer do driver\n",
+           (unsigned long long)sim::conversoesAdc, (unsigned long long)sim::conversoesAdcDescartadas);
+    if (sim::conversoesAdcDescartadas != 0) {
+      printf("FALHA: o ciclo de controle não recolheu o ADC a tempo.\n");
+      falhas++;
+    }
+  }
+  if (NUM_CANAIS == 1) {
+    printf("NVS antes (9 chaves): %lu gravações, %lu bytes de dados, %lu bytes na flash\n", gravacaoLegada.gravacoes,
+           gravacaoLegada.bytesGravados, gravacaoLegada.bytesFlash);
+  }
+  printf("NVS: %lu gravações, %lu bytes de dados, %lu bytes na flash\n", Preferences::gravacoes, Preferences::bytesGravados,
+         Preferences::bytesFlash);
+  // A latência da gravação só tem sentido no ESP32: aqui o micros() é o relógio virtual.
+  EstatisticasPersistencia nvs = lerEstatisticasPersistencia();
+  printf("Persistência: %lu retratos gravados, %lu evitados (sem mudança)\n", nvs.gravacoes, nvs.gravacoesEvitadas);
+  printf("%s\n", falhas == 0 ? "OK" : "FALHOU");
+  return falhas == 0 ? 0 : 1;
+}
+#endif
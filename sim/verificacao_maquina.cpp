@@ -0,0 +1,243 @@
+#include "verificacao_maquina.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "rastro_compressor.h"
+
+namespace {
+
+const int EVENTOS_POR_SEQUENCIA = 64;
+
+// xorshift64*: rápido e reproduzível a partir da semente.
+struct Sorteio {
+  uint64_t estado;
+  uint32_t proximo() {
+    estado ^= estado >> 12;
+    estado ^= estado << 25;
+    estado ^= estado >> 27;
+    return (uint32_t)((estado * 0x2545F4914F6CDD1DULL) >> 32);
+  }
+  uint32_t ate(uint32_t n) { return (uint32_t)(((uint64_t)proximo() * n) >> 32); }
+  bool chance(uint32_t porMil) { return ate(1000) < porMil; }
+  float real(float minimo, float maximo) { return minimo + (maximo - minimo) * (float)(proximo() >> 8) * (1.0f / 16777216.0f); }
+};
+
+// O que o controle leria no ciclo: uma boia, um sensor e os parâmetros em uso.
+struct Mundo {
+  uint32_t instante;
+  bool caixaCheia;
+  bool preditiva;
+  float temperatura;
+  float temperaturaMaxima;
+  float temperaturaReligamento;
+  uint32_t tempoLigadoMs;
+  uint32_t tempoDescansoMs;
+};
+
+EventoCompressor montarEvento(const Mundo& mundo, SinalCompressor sinal, bool releFechado, Sorteio& sorteio) {
+  EventoCompressor evento = {};
+  evento.sinal = sinal;
+  evento.falha = sinal == SINAL_FALHA_CORRENTE ? (FalhaCorrente)(FALHA_SEM_CORRENTE + sorteio.ate(3)) : FALHA_NENHUMA;
+  evento.caixaCheia = mundo.caixaCheia;
+  evento.instante = mundo.instante;
+  evento.temperatura = mundo.temperatura;
+  evento.temperaturaMaxima = mundo.temperaturaMaxima;
+  evento.temperaturaReligamento = mundo.temperaturaReligamento;
+  evento.segundosAteLimite = mundo.preditiva && releFechado ? sorteio.real(-5.0f, 120.0f) : -1.0f;
+  evento.tempoLigadoMs = mundo.tempoLigadoMs;
+  evento.tempoDescansoMs = mundo.tempoDescansoMs;
+  return evento;
+}
+
+bool emergencia(ModoCompressor modo) { return modo == MODO_PARADA_TERMICA || modo == MODO_MANUAL_PARADA_TERMICA; }
+
+// nullptr se o evento respeitou as invariantes; senão, qual quebrou.
+const char* violacao(const MaquinaCompressor& antes, const MaquinaCompressor& depois, const EventoCompressor& evento,
+                     const TransicaoCompressor* transicao) {
+  bool ligadoAntes = releLigado(antes.modo);
+  bool ligado = releLigado(depois.modo);
+  if (!transicao) return memcmp(&antes, &depois, sizeof(antes)) == 0 ? nullptr : "evento sem transição mudou a máquina";
+  if (transicao->origem != antes.modo || transicao->sinal != evento.sinal || transicao->destino != depois.modo) {
+    return "transição devolvida não é a aplicada";
+  }
+  if (ligado && evento.caixaCheia) return "relé fechado com a caixa cheia";
+  if (ligado && (evento.sinal == SINAL_TEMPERATURA_ALTA || evento.sinal == SINAL_CAIXA_CHEIA ||
+                 evento.sinal == SINAL_ERRO_SENSOR || evento.sinal == SINAL_FALHA_CORRENTE)) {
+    return "relé continua fechado depois de um evento de proteção";
+  }
+  if (!ligadoAntes && ligado) {
+    if (evento.sinal != SINAL_CICLO && evento.sinal != SINAL_LIGAR) return "relé fechado por evento que não é ciclo nem comando";
+    if (evento.temperatura >= evento.temperaturaMaxima) return "relé fechado no limite de temperatura";
+    bool esfriando = emergencia(antes.modo) || (evento.sinal == SINAL_CICLO && antes.modo == MODO_PAUSA_PREDITIVA);
+    if (esfriando && evento.temperatura >= evento.temperaturaReligamento) return "religou antes de esfriar";
+    if (evento.sinal == SINAL_CICLO) {
+      if (modoManual(antes.modo)) return "ciclo fechou o relé no manual";
+      if (evento.instante - antes.inicioTemporizador < evento.tempoDescansoMs) return "religou antes do descanso";
+      if (antes.modo == MODO_FALHA_CORRENTE &&
+          (antes.falha != FALHA_FUNCIONAMENTO_SECO || evento.instante - antes.instanteFalha < esperaAposSeco(antes.desarmesSeco))) {
+        return "religou com a falha de corrente ainda valendo";
+      }
+      if (secoBloqueado(antes)) return "religou sozinho com o poço seco bloqueado";
+    } else if (antes.falha == FALHA_ROTOR_BLOQUEADO) {
+      return "comando religou com o rotor bloqueado";
+    }
+  }
+  if (modoManual(antes.modo) && !modoManual(depois.modo) && evento.sinal != SINAL_AUTOMATICO) {
+    return "saiu do manual sem o comando de automático";
+  }
+  if (!modoManual(antes.modo) && modoManual(depois.modo) && evento.sinal != SINAL_LIGAR && evento.sinal != SINAL_DESLIGAR) {
+    return "entrou no manual sem comando";
+  }
+  if (!modoManual(depois.modo) && (depois.modo == MODO_FALHA_CORRENTE) != (depois.falha != FALHA_NENHUMA)) {
+    return "falha de corrente fora do modo de falha";
+  }
+  if (depois.desarmesSeco > MAX_DESARMES_SECO) return "desarmes a seco passaram do máximo";
+  if (secoBloqueado(antes) && !secoBloqueado(depois) && evento.sinal != SINAL_AUTOMATICO && evento.sinal != SINAL_MEDICAO_DESLIGADA) {
+    return "bloqueio a seco liberado sem ninguém";
+  }
+  if (depois.modo == MODO_LIGADO && evento.sinal == SINAL_CICLO &&
+      evento.instante - depois.inicioTemporizador >= evento.tempoLigadoMs) {
+    return "passou do tempo ligado";
+  }
+  return nullptr;
+}
+
+void descreverEfeitos(uint16_t efeitos, char* texto, size_t tamanho) {
+  static const char* const NOMES[] = { "liga", "desliga", "tempo", "emergencia", "preditiva",
+                                       "liberada", "falha", "sem-falha", "descanso", "fim-ciclo", "zera-seco" };
+  size_t usado = 0;
+  texto[0] = '\0';
+  for (size_t i = 0; i < sizeof(NOMES) / sizeof(NOMES[0]); i++) {
+    if (!(efeitos & (1u << i)) || usado >= tamanho) continue;
+    usado += snprintf(texto + usado, tamanho - usado, "%s%s", usado ? "," : "", NOMES[i]);
+  }
+}
+
+}  // namespace
+
+ResultadoVerificacaoMaquina verificarMaquina(uint64_t sequencias, uint32_t semente) {
+  ResultadoVerificacaoMaquina resultado = {};
+  size_t linhas = 0;
+  const TransicaoCompressor* tabela = tabelaTransicoes(linhas);
+  std::vector<bool> exercitadas(linhas, false);
+  Sorteio sorteio = { 0x9E3779B97F4A7C15ULL ^ semente };
+  // Sem CICLO ocioso o rastro de uma sequência cabe com folga (até 3 eventos por passo).
+  RegistroRastro rastro[3 * EVENTOS_POR_SEQUENCIA];
+  std::chrono::steady_clock::time_point inicio = std::chrono::steady_clock::now();
+
+  for (uint64_t s = 0; s < sequencias; s++) {
+    Mundo mundo;
+    // Um quarto das sequências começa a minutos do estouro do millis().
+    mundo.instante = sorteio.chance(250) ? 0u - sorteio.ate(3600000) : sorteio.proximo();
+    mundo.caixaCheia = sorteio.chance(200);
+    mundo.preditiva = sorteio.chance(700);
+    mundo.temperaturaMaxima = sorteio.real(50.0f, 70.0f);
+    mundo.temperaturaReligamento = mundo.temperaturaMaxima - sorteio.real(1.0f, 10.0f);
+    mundo.temperatura = sorteio.real(20.0f, mundo.temperaturaMaxima + 5.0f);
+    mundo.tempoLigadoMs = 60000 + sorteio.ate(30 * 60000);
+    mundo.tempoDescansoMs = 1000 + sorteio.ate(30 * 60000);
+
+    MaquinaCompressor maquina = {};
+    maquina.modo = MODO_DESCANSO;
+    maquina.inicioTemporizador = mundo.instante;
+    size_t noRastro = 0;
+
+    auto aplicar = [&](SinalCompressor sinal) {
+      MaquinaCompressor antes = maquina;
+      EventoCompressor evento = montarEvento(mundo, sinal, releLigado(maquina.modo), sorteio);
+      const TransicaoCompressor* transicao = despachar(maquina, evento);
+      resultado.eventos++;
+      if (transicao) {
+        resultado.transicoes++;
+        exercitadas[transicao - tabela] = true;
+      }
+      const char* motivo = violacao(antes, maquina, evento, transicao);
+      if (motivo && resultado.violacoes++ == 0) {
+        snprintf(resultado.primeiraViolacao, sizeof(resultado.primeiraViolacao), "%s (%s em %s, sequência %llu)", motivo,
+                 nomeSinalCompressor(sinal), nomeModoCompressor(antes.modo), (unsigned long long)s);
+      }
+      if (transicao || sinal != SINAL_CICLO) {
+        RegistroRastro& registro = rastro[noRastro];
+        registro.sequencia = (uint32_t)noRastro++;
+        registro.canal = 0;
+        registro.destino = maquina.modo;
+        registro.efeitos = transicao ? transicao->efeitos : 0;
+        registro.antes = antes;
+        registro.evento = evento;
+      }
+    };
+
+    for (int e = 0; e < EVENTOS_POR_SEQUENCIA; e++) {
+      // Passos curtos, de minutos e de horas, como entre os ciclos e os comandos reais.
+      uint32_t faixa = sorteio.ate(10);
+      mundo.instante += faixa < 6 ? sorteio.ate(2000) : faixa < 9 ? sorteio.ate(600000) : sorteio.ate(3 * 3600000);
+      mundo.temperatura += sorteio.real(-3.0f, 3.0f);
+      if (sorteio.chance(50)) mundo.temperatura = sorteio.real(20.0f, mundo.temperaturaMaxima + 5.0f);
+      if (sorteio.chance(30)) {
+        // O ciclo adaptativo e a configuração mudam os tempos no meio do caminho.
+        mundo.tempoLigadoMs = 60000 + sorteio.ate(30 * 60000);
+        mundo.tempoDescansoMs = 1000 + sorteio.ate(30 * 60000);
+      }
+
+      // O controle entrega a borda da boia e a leitura no limite antes do resto. Se a borda
+      // se perder, o ciclo seguinte ainda vê a caixa cheia e tem de abrir o relé.
+      if (sorteio.chance(150)) {
+        mundo.caixaCheia = !mundo.caixaCheia;
+        if (mundo.caixaCheia) aplicar(sorteio.chance(100) ? SINAL_CICLO : SINAL_CAIXA_CHEIA);
+      }
+      if (releLigado(maquina.modo) && mundo.temperatura >= mundo.temperaturaMaxima) aplicar(SINAL_TEMPERATURA_ALTA);
+
+      static const SinalCompressor AVULSOS[] = { SINAL_LIGAR, SINAL_DESLIGAR, SINAL_AUTOMATICO, SINAL_ERRO_SENSOR,
+                                                 SINAL_FALHA_CORRENTE, SINAL_MEDICAO_DESLIGADA };
+      aplicar(sorteio.chance(550) ? SINAL_CICLO : AVULSOS[sorteio.ate(sizeof(AVULSOS) / sizeof(AVULSOS[0]))]);
+    }
+
+    // O rastro da sequência tem de levar o reprodutor ao mesmo estado, registro a registro.
+    ReprodutorRastro reprodutor;
+    for (size_t r = 0; r < noRastro; r++) {
+      if (!reprodutor.reproduzir(rastro[r])) resultado.divergenciasReproducao++;
+    }
+    if (noRastro > 0 && memcmp(&reprodutor.maquina(0), &maquina, sizeof(maquina)) != 0) resultado.divergenciasReproducao++;
+  }
+
+  resultado.sequencias = sequencias;
+  resultado.linhasTabela = linhas;
+  for (size_t i = 0; i < linhas; i++) resultado.linhasExercitadas += exercitadas[i] ? 1 : 0;
+  resultado.segundos = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+  return resultado;
+}
+
+long reproduzirArquivoRastro(const char* caminho, bool listar) {
+  FILE* arquivo = fopen(caminho, "rb");
+  if (!arquivo) return -1;
+  CabecalhoRastro cabecalho;
+  if (fread(&cabecalho, sizeof(cabecalho), 1, arquivo) != 1 || cabecalho.magica != MAGICA_RASTRO ||
+      cabecalho.versao != VERSAO_RASTRO || cabecalho.tamanhoRegistro != sizeof(RegistroRastro)) {
+    fclose(arquivo);
+    return -1;
+  }
+  printf("Rastro: %lu registros de %u canal(is); %lu perdidos no firmware desde o boot\n",
+         (unsigned long)cabecalho.registros, (unsigned)cabecalho.canais, (unsigned long)cabecalho.descartados);
+
+  ReprodutorRastro reprodutor;
+  RegistroRastro registro;
+  uint32_t lidos = 0;
+  while (lidos < cabecalho.registros && fread(&registro, sizeof(registro), 1, arquivo) == 1) {
+    lidos++;
+    bool confere = reprodutor.reproduzir(registro);
+    if (!listar && confere) continue;
+    char efeitos[96];
+    descreverEfeitos(registro.efeitos, efeitos, sizeof(efeitos));
+    const EventoCompressor& e = registro.evento;
+    printf("#%-7lu canal %u %10lu ms  %-19s %-23s -> %-23s %-28s %5.1f/%4.1f °C%s%s\n", (unsigned long)registro.sequencia,
+           (unsigned)registro.canal, (unsigned long)e.instante, nomeSinalCompressor(e.sinal),
+           nomeModoCompressor(registro.antes.modo), nomeModoCompressor(registro.destino), efeitos, e.temperatura,
+           e.temperaturaMaxima, e.caixaCheia ? "  cheia" : "", confere ? "" : "  <- DIVERGE");
+  }
+  fclose(arquivo);
+  printf("Reproduzidos %lu de %lu registros: %lu lacunas na sequência, %lu divergências\n", (unsigned long)lidos,
+         (unsigned long)cabecalho.registros, (unsigned long)reprodutor.lacunas(), (unsigned long)reprodutor.divergencias());
+  return lidos == cabecalho.registros ? (long)reprodutor.divergencias() : -1;
+}
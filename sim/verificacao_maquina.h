@@ -0,0 +1,39 @@
+/*
+  Verificação da máquina de estados do compressor no host.
+  -------------------------------------------------------
+  verificarMaquina() sorteia sequências de eventos num mundo coerente
+  (relógio que avança de milissegundos a horas, atravessando o estouro de 32
+  bits; boia que enche e esvazia com a borda entregue como SINAL_CAIXA_CHEIA,
+  às vezes perdida, para o ciclo seguinte ter de perceber sozinho;
+  temperatura que sobe e desce em torno do limite; comandos, erros de sensor
+  e falhas de corrente a qualquer momento) e confere, depois de cada evento,
+  as invariantes de segurança: relé nunca fechado com a caixa cheia, só
+  liga por ciclo ou comando e só dentro das condições, temperatura alta e
+  caixa cheia sempre abrem o relé, só o automático sai do manual, e a falha
+  de corrente existe só onde deve. Cada sequência é gravada como um rastro e
+  reproduzida pelo ReprodutorRastro, que tem de chegar ao mesmo estado.
+
+  reproduzirArquivoRastro() lê um arquivo do GET /rastro, lista as
+  transições e confere cada uma.
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct ResultadoVerificacaoMaquina {
+  uint64_t sequencias;
+  uint64_t eventos;
+  uint64_t transicoes;
+  uint64_t violacoes;
+  uint64_t divergenciasReproducao;
+  size_t linhasExercitadas;
+  size_t linhasTabela;
+  double segundos;
+  char primeiraViolacao[192];
+};
+
+ResultadoVerificacaoMaquina verificarMaquina(uint64_t sequencias, uint32_t semente);
+
+// Retorna as divergências (0 = reproduziu tudo), ou -1 se o arquivo não é um rastro.
+long reproduzirArquivoRastro(const char* caminho, bool listar);
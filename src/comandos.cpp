@@ -0,0 +1,137 @@
+#include "comandos.h"
+
+int interpretarCanal(const char* valor) {
+  if (!valor || !*valor) return -1;
+  char* fim = nullptr;
+  long canal = strtol(valor, &fim, 10);
+  if (*fim != '\0' || canal < 0 || canal >= NUM_CANAIS) return -1;
+  return (int)canal;
+}
+
+const char* bloqueioLigar(const EstadoCanal& estado, const ParametrosOperacao& p) {
+  if (estado.caixaCheia) return "❌ Ação bloqueada: A caixa de água já está cheia.";
+  if (estado.falhaCorrente() == FALHA_ROTOR_BLOQUEADO) return "❌ Ação bloqueada: Rotor bloqueado. Verifique o compressor e volte ao automático.";
+  if (estado.desligadoPorTemperaturaAlta()) {
+    if (estado.temperaturaAtual >= estado.temperaturaReligamento) return "❌ Ação bloqueada: Aguardando temperatura baixar para religar (cooldown).";
+  } else if (estado.temperaturaAtual >= p.temperaturaMaxima) {
+    return "❌ Ação bloqueada: A temperatura está acima do limite permitido.";
+  }
+  return nullptr;
+}
+
+static bool igual(const char* a, const char* b) { return strcmp(a, b) == 0; }
+
+bool aplicarParametro(ParametrosOperacao& p, const char* nome, const char* valor) {
+  if (igual(nome, "tempoligado")) {
+    unsigned long v = atol(valor) * 60000UL;
+    if (v >= 60000UL) { p.tempoLigado = v; return true; }
+  } else if (igual(nome, "tempodescanso")) {
+    unsigned long v = atol(valor) * 60000UL;
+    if (v >= 1000UL) { p.tempoDescanso = v; return true; }
+  } else if (igual(nome, "temperaturamax")) {
+    float v = atof(valor);
+    if (v > 0.0) { p.temperaturaMaxima = v; return true; }
+  } else if (igual(nome, "resolucaosensor")) {
+    long v = atol(valor);
+    if (v >= 9 && v <= 12) { p.resolucaoSensor = (uint8_t)v; return true; }
+  } else if (igual(nome, "intervaloleitura")) {
+    long v = atol(valor);
+    if (v >= 100) { p.intervaloLeitura = (unsigned long)v; return true; }
+  } else if (igual(nome, "adaptativo")) {
+    p.adaptativo = igual(valor, "1") || igual(valor, "true");
+    return true;
+  } else if (igual(nome, "protecaopreditiva")) {
+    p.protecaoPreditiva = igual(valor, "1") || igual(valor, "true");
+    return true;
+  } else if (igual(nome, "debounceboia")) {
+    long v = atol(valor);
+    if (v >= 0 && v <= 1000) { p.debounceBoiaMs = (unsigned long)v; return true; }
+  } else if (igual(nome, "glitchboia")) {
+    long v = atol(valor);
+    if (v >= 0 && v <= 255) { p.glitchBoiaMs = (unsigned long)v; return true; }
+  } else if (igual(nome, "tempoligadomax")) {
+    unsigned long v = atol(valor) * 60000UL;
+    if (v >= TEMPO_LIGADO_MINIMO_MS) { p.tempoLigadoMaximo = v; return true; }
+  } else if (igual(nome, "tempodescansomin")) {
+    unsigned long v = atol(valor) * 1000UL;
+    if (v >= 1000UL && v <= TEMPO_DESCANSO_MAXIMO_MS) { p.tempoDescansoMinimo = v; return true; }
+  } else if (igual(nome, "correntenominal")) {
+    float v = atof(valor);
+    if (v >= 0.0f && v <= 30.0f) { p.correnteNominalA = v; return true; }
+  } else if (igual(nome, "tensaonominal")) {
+    float v = atof(valor);
+    if (v >= 90.0f && v <= 400.0f) { p.tensaoNominalV = v; return true; }
+  }
+  return false;
+}
+
+// Próximo par nome=valor de `texto` (separados por '&'); retorna o ponteiro depois dele.
+static const char* proximoArgumento(const char* texto, char* nome, size_t tamanhoNome, char* valor, size_t tamanhoValor) {
+  size_t n = 0;
+  while (*texto && *texto != '=' && *texto != '&') {
+    if (n + 1 < tamanhoNome) nome[n++] = *texto;
+    texto++;
+  }
+  nome[n] = '\0';
+  n = 0;
+  if (*texto == '=') {
+    texto++;
+    while (*texto && *texto != '&') {
+      if (n + 1 < tamanhoValor) valor[n++] = *texto;
+      texto++;
+    }
+  }
+  valor[n] = '\0';
+  return *texto == '&' ? texto + 1 : texto;
+}
+
+bool montarComando(const char* acao, const char* argumentos, const EstadoControle& estado, Comando& comando,
+                   const char*& resposta) {
+  bool configurar = igual(acao, "config");
+  if (configurar) {
+    comando.tipo = COMANDO_CONFIGURAR;
+    comando.parametros = estado.dados.parametros;
+  } else if (igual(acao, "ligar")) comando.tipo = COMANDO_LIGAR;
+  else if (igual(acao, "desligar")) comando.tipo = COMANDO_DESLIGAR;
+  else if (igual(acao, "automatico")) comando.tipo = COMANDO_AUTOMATICO;
+  else if (igual(acao, "zerarciclos")) comando.tipo = COMANDO_ZERAR_CICLOS;
+  else {
+    resposta = "❌ Comando desconhecido.";
+    return false;
+  }
+
+  comando.canal = 0;
+  bool alterado = false;
+  char nome[24];
+  char valor[32];
+  for (const char* p = argumentos ? argumentos : ""; *p;) {
+    p = proximoArgumento(p, nome, sizeof(nome), valor, sizeof(valor));
+    if (configurar) {
+      alterado |= aplicarParametro(comando.parametros, nome, valor);
+    } else if (igual(nome, "canal")) {
+      int canal = interpretarCanal(valor);
+      if (canal < 0) {
+        resposta = "❌ Canal inválido.";
+        return false;
+      }
+      comando.canal = (uint8_t)canal;
+    }
+  }
+
+  switch (comando.tipo) {
+    case COMANDO_CONFIGURAR:
+      resposta = alterado ? "✅ Configurações salvas!" : "ℹ️ Nenhuma alteração válida.";
+      return alterado;
+    case COMANDO_LIGAR:
+      resposta = bloqueioLigar(estado.canais[comando.canal], estado.dados.parametros);
+      if (resposta) return false;
+      resposta = "✅ Compressor ligado manualmente.";
+      return true;
+    case COMANDO_ZERAR_CICLOS:
+      resposta = "Todos os contadores e o histórico foram zerados!";
+      return true;
+    default:
+      resposta = "OK";
+      return true;
+  }
+}
@@ -0,0 +1,391 @@
+#include "controle.h"
+#include <OneWire.h>
+#include <DallasTemperature.h>
+#include "estado_compartilhado.h"
+#include "leitor_temperatura.h"
+#include "perfilador.h"
+#include "rastro_compressor.h"
+#include "registro_eventos.h"
+
+// ==================== SENSOR DE TEMPERATURA ====================
+bool sensorEnabled = true;
+OneWire oneWire(PINO_SENSOR_TEMPERATURA);
+DallasTemperature sensors(&oneWire);
+LeitorTemperatura leitorTemperatura(sensors);
+
+// ==================== BOIAS ====================
+static EntradaBoia boias[NUM_CANAIS];
+
+// ==================== CORRENTE ====================
+static MedidorCorrente medidorCorrente;
+
+// ==================== ESTADO ====================
+static EstadoControle estado;
+static EstadoCompartilhado<EstadoControle> estadoPublicado;
+static FilaSpsc<Comando, 8> filaComandos;
+
+static void marcarParaGravar() { estado.versaoDados++; }
+
+static LimitesAdaptativos limitesAdaptativos(const ParametrosOperacao& p) {
+  LimitesAdaptativos limites;
+  limites.ligadoMinimoMs = TEMPO_LIGADO_MINIMO_MS;
+  limites.ligadoMaximoMs = p.tempoLigadoMaximo > TEMPO_LIGADO_MINIMO_MS ? p.tempoLigadoMaximo : TEMPO_LIGADO_MINIMO_MS;
+  limites.descansoMinimoMs = p.tempoDescansoMinimo < TEMPO_DESCANSO_MAXIMO_MS ? p.tempoDescansoMinimo : TEMPO_DESCANSO_MAXIMO_MS;
+  limites.descansoMaximoMs = TEMPO_DESCANSO_MAXIMO_MS;
+  return limites;
+}
+
+static void comecarEnchimento(EstadoCanal& c, unsigned long agora) {
+  c.enchendo = true;
+  c.inicioCicloEnchimentoMillis = agora;
+  c.ciclosParciaisNesteEnchimento = 0;
+  c.ligadoNoInicioEnchimentoMs = c.tempoLigadoTotalMs;
+  c.paradasTermicasNesteEnchimento = 0;
+  c.ligadoAteLimiteMs = 0;
+  c.energiaEnchimentoWh = 0.0f;
+}
+
+// Parada por temperatura (preditiva ou de emergência), para o modelo adaptativo.
+// Só a primeira partida do enchimento sai do compressor frio; as seguintes partem quentes.
+static void registrarParadaTermica(EstadoCanal& c, unsigned long agora) {
+  if (c.ciclosParciaisNesteEnchimento == 1 && c.paradasTermicasNesteEnchimento == 0) {
+    c.ligadoAteLimiteMs = agora - c.inicioCicloMillis;
+  }
+  c.paradasTermicasNesteEnchimento++;
+}
+
+// Com a previsão, religa assim que uma partida consegue durar PARTIDA_MINIMA_TERMICA_S
+// (mais a antecipação) antes do limite; sem ela, a histerese fixa. Nunca a menos de
+// 1 °C do limite, nem mais que duas histereses abaixo dele se a estimativa for ruim.
+static float calcularTemperaturaReligamento(const EstadoCanal& c, const ParametrosOperacao& p) {
+  float histerese = p.temperaturaMaxima - HISTERESE_TERMICA;
+  if (!p.protecaoPreditiva || !c.termico.aquecimentoValido()) return histerese;
+  float prevista = c.termico.temperaturaReligamento(p.temperaturaMaxima, PARTIDA_MINIMA_TERMICA_S + ANTECIPACAO_TERMICA_S);
+  if (prevista > p.temperaturaMaxima - 1.0f) return p.temperaturaMaxima - 1.0f;
+  if (prevista < p.temperaturaMaxima - 2.0f * HISTERESE_TERMICA) return p.temperaturaMaxima - 2.0f * HISTERESE_TERMICA;
+  return prevista;
+}
+
+// Tempos do ciclo automático: os configurados, ou os do modelo no modo adaptativo.
+static void atualizarTemposCiclo(EstadoCanal& c, const DadosCanal& d) {
+  const ParametrosOperacao& p = estado.dados.parametros;
+  if (!p.adaptativo) {
+    c.tempoLigadoAtual = p.tempoLigado;
+    c.tempoDescansoAtual = p.tempoDescanso;
+    return;
+  }
+  LimitesAdaptativos limites = limitesAdaptativos(p);
+  c.tempoLigadoAtual = tempoLigadoAdaptativo(d.modelo, limites);
+  c.tempoDescansoAtual = tempoDescansoAdaptativo(d.modelo, limites);
+}
+
+// ==================== LÓGICA DE CONTROLE DO RELÉ ====================
+// Só a partir dos efeitos de uma transição: a tabela garante que o relé acompanha o modo.
+static void fecharRele(int canal, unsigned long agora) {
+  EstadoCanal& c = estado.canais[canal];
+  DadosCanal& d = estado.dados.canais[canal];
+  digitalWrite(PINOS_RELE_COMPRESSOR[canal], LOW);
+  c.inicioCicloMillis = agora;
+  if (!c.enchendo) {
+    comecarEnchimento(c, agora);
+    LOG_EVENTO(ENCHIMENTO_PELO_COMPRESSOR, canal);
+  }
+  c.ciclosParciaisNesteEnchimento++;
+  d.ciclosParciaisOperacao++;
+  LOG_EVENTO(CICLO_PARCIAL, canal, c.ciclosParciaisNesteEnchimento, d.ciclosParciaisOperacao);
+  LOG_EVENTO(COMPRESSOR_LIGADO, canal);
+}
+static void abrirRele(int canal) {
+  digitalWrite(PINOS_RELE_COMPRESSOR[canal], HIGH);
+  estado.canais[canal].inicioCicloMillis = 0;
+  LOG_EVENTO(COMPRESSOR_DESLIGADO, canal);
+}
+
+// ==================== MÁQUINA DE ESTADOS ====================
+// O evento leva tudo o que as guardas leem, para o rastro reproduzir a decisão.
+static EventoCompressor montarEvento(const EstadoCanal& c, SinalCompressor sinal, unsigned long agora) {
+  const ParametrosOperacao& p = estado.dados.parametros;
+  EventoCompressor e = {};
+  e.sinal = sinal;
+  e.caixaCheia = c.caixaCheia;
+  e.instante = (uint32_t)agora;
+  e.temperatura = c.temperaturaAtual;
+  e.temperaturaMaxima = p.temperaturaMaxima;
+  e.temperaturaReligamento = c.temperaturaReligamento;
+  e.segundosAteLimite = p.protecaoPreditiva && c.compressorLigado() ? c.termico.segundosAteLimite(c.temperaturaAtual, p.temperaturaMaxima)
+                                                                     : -1.0f;
+  e.tempoLigadoMs = (uint32_t)c.tempoLigadoAtual;
+  e.tempoDescansoMs = (uint32_t)c.tempoDescansoAtual;
+  return e;
+}
+
+// Efeitos na ordem das mensagens de antes: o motivo, o relé, e só então o que vem depois.
+static void executarEfeitos(int canal, uint16_t efeitos, const MaquinaCompressor& antes, const EventoCompressor& e,
+                            unsigned long agora) {
+  EstadoCanal& c = estado.canais[canal];
+  const ParametrosOperacao& p = estado.dados.parametros;
+  if (efeitos & EFEITO_EMERGENCIA) {
+    LOG_EVENTO(DESLIGAMENTO_EMERGENCIA, canal, e.temperatura, e.temperaturaMaxima);
+    c.desligamentosEmergencia++;
+    registrarParadaTermica(c, agora);
+  }
+  if (efeitos & EFEITO_PARADA_PREDITIVA) {
+    LOG_EVENTO(PARADA_PREDITIVA, canal, e.temperatura, e.segundosAteLimite);
+    c.paradasTermicasPreditivas++;
+    registrarParadaTermica(c, agora);
+  }
+  if (efeitos & EFEITO_REGISTRAR_FALHA) {
+    if (e.falha == FALHA_SEM_CORRENTE) LOG_EVENTO(CORRENTE_AUSENTE, canal, c.correnteA);
+    else if (e.falha == FALHA_ROTOR_BLOQUEADO) LOG_EVENTO(ROTOR_BLOQUEADO, canal, c.correnteA);
+    else LOG_EVENTO(FUNCIONAMENTO_SECO, canal, c.correnteA, p.correnteNominalA * DetectorFalhaCorrente::FRACAO_SECO);
+    // No automático o poço seco é tentado de novo sozinho, até o bloqueio.
+    if (e.falha == FALHA_FUNCIONAMENTO_SECO && c.maquina.modo == MODO_FALHA_CORRENTE) {
+      if (secoBloqueado(c.maquina)) LOG_EVENTO(SECO_BLOQUEADO, canal, (unsigned int)c.maquina.desarmesSeco);
+      else LOG_EVENTO(SECO_NOVA_TENTATIVA, canal, esperaAposSeco(c.maquina.desarmesSeco) / 60000UL);
+    }
+    c.desligamentosCorrente++;
+    c.detectorCorrente.reiniciar();
+  }
+  if (efeitos & EFEITO_DESLIGAR_RELE) abrirRele(canal);
+  if (efeitos & EFEITO_DESCANSO_FORCADO) LOG_EVENTO(DESCANSO_FORCADO, canal);
+  if (efeitos & EFEITO_TEMPERATURA_LIBERADA) LOG_EVENTO(TEMPERATURA_LIBERADA, canal);
+  if ((efeitos & EFEITO_LIBERAR_FALHA) && antes.falha != FALHA_NENHUMA) {
+    c.detectorCorrente.reiniciar();
+    LOG_EVENTO(FALHA_CORRENTE_LIBERADA, canal);
+  }
+  if (efeitos & EFEITO_LIGAR_RELE) fecharRele(canal, agora);
+  if (efeitos & EFEITO_FIM_CICLO) marcarParaGravar();
+}
+
+// Ciclos sem transição não vão para o rastro: não mudaram nada e a reprodução não precisa deles.
+static void despacharEvento(int canal, SinalCompressor sinal, unsigned long agora, FalhaCorrente falha = FALHA_NENHUMA) {
+  EstadoCanal& c = estado.canais[canal];
+  EventoCompressor e = montarEvento(c, sinal, agora);
+  e.falha = falha;
+  MaquinaCompressor antes = c.maquina;
+  const TransicaoCompressor* transicao = despachar(c.maquina, e);
+  if (transicao || sinal != SINAL_CICLO) rastroCompressor.registrar((uint8_t)canal, antes, e, transicao);
+  if (transicao) executarEfeitos(canal, transicao->efeitos, antes, e, agora);
+}
+
+// Liga o ADC só com um TC configurado (corrente nominal > 0); desligado, zera as leituras.
+static void configurarMedicaoCorrente(const ParametrosOperacao& p, unsigned long agora) {
+  if (p.correnteNominalA > 0.0f) {
+    if (medidorCorrente.ativo()) return;
+    if (medidorCorrente.iniciar(PINOS_CORRENTE, NUM_CANAIS)) LOG_EVENTO(MEDICAO_CORRENTE, SEM_CANAL, NUM_CANAIS, p.correnteNominalA);
+    else LOG_EVENTO(ERRO_MEDICAO_CORRENTE, SEM_CANAL);
+    return;
+  }
+  medidorCorrente.parar();
+  for (int i = 0; i < NUM_CANAIS; i++) {
+    EstadoCanal& c = estado.canais[i];
+    c.correnteA = c.potenciaW = 0.0f;
+    if (c.falhaCorrente() != FALHA_NENHUMA) despacharEvento(i, SINAL_MEDICAO_DESLIGADA, agora);
+    c.correnteSemRele = false;
+    c.detectorCorrente.reiniciar();
+  }
+}
+
+// ==================== COMANDOS DA CAMADA WEB ====================
+static void aplicarComando(const Comando& comando, unsigned long agora) {
+  if (comando.tipo == COMANDO_CONFIGURAR) {
+    const ParametrosOperacao& p = comando.parametros;
+    if (sensorEnabled && (p.resolucaoSensor != estado.dados.parametros.resolucaoSensor ||
+                          p.intervaloLeitura != estado.dados.parametros.intervaloLeitura)) {
+      leitorTemperatura.configurar(p.resolucaoSensor, p.intervaloLeitura);
+    }
+    if (p.debounceBoiaMs != estado.dados.parametros.debounceBoiaMs || p.glitchBoiaMs != estado.dados.parametros.glitchBoiaMs) {
+      for (int i = 0; i < NUM_CANAIS; i++) boias[i].configurar(p.debounceBoiaMs, p.glitchBoiaMs);
+    }
+    configurarMedicaoCorrente(p, agora);
+    for (int i = 0; i < NUM_CANAIS; i++) {
+      if (p.adaptativo && estado.dados.canais[i].modelo.tempoLigadoMs == 0) {
+        iniciarModelo(estado.dados.canais[i].modelo, p.tempoLigado, p.tempoDescanso);
+      }
+    }
+    estado.dados.parametros = p;
+    marcarParaGravar();
+    return;
+  }
+  if (comando.canal >= NUM_CANAIS) return;
+  DadosCanal& d = estado.dados.canais[comando.canal];
+  switch (comando.tipo) {
+    case COMANDO_LIGAR:
+      despacharEvento(comando.canal, SINAL_LIGAR, agora);
+      break;
+    case COMANDO_DESLIGAR:
+      despacharEvento(comando.canal, SINAL_DESLIGAR, agora);
+      break;
+    case COMANDO_AUTOMATICO:
+      despacharEvento(comando.canal, SINAL_AUTOMATICO, agora);
+      break;
+    case COMANDO_ZERAR_CICLOS:
+      d.ciclosParciaisOperacao = 0;
+      d.ciclosEnchimentoCompletos = 0;
+      memset(d.historicoEnchimento, 0, sizeof(d.historicoEnchimento));
+      d.indiceHistoricoEnchimento = 0;
+      iniciarModelo(d.modelo, estado.dados.parametros.tempoLigado, estado.dados.parametros.tempoDescanso);
+      marcarParaGravar();
+      LOG_EVENTO(CONTADORES_ZERADOS, comando.canal);
+      break;
+    case COMANDO_CONFIGURAR:
+      break;
+  }
+}
+
+// ==================== SENSORES E PROTEÇÕES ====================
+// Uma passada do leitor por ciclo: no máximo uma transação no barramento,
+// qualquer que seja o número de canais.
+static void atualizarTemperaturas(unsigned long agora) {
+  if (!sensorEnabled) return;
+  LeitorTemperatura::Resultado leitura = leitorTemperatura.atualizar(agora);
+  if (leitura == LeitorTemperatura::SEM_NOVIDADE) return;
+  int canal = leitorTemperatura.sensorLido();
+  if (canal >= NUM_CANAIS) return;
+  EstadoCanal& c = estado.canais[canal];
+  if (leitura == LeitorTemperatura::LEITURA_NOVA) {
+    c.temperaturaAtual = leitorTemperatura.ultimaLeitura(canal);
+    c.termico.atualizar(c.temperaturaAtual, c.compressorLigado(), agora);
+  }
+  else if (leitura == LeitorTemperatura::ERRO_SENSOR) {
+    despacharEvento(canal, SINAL_ERRO_SENSOR, agora);
+    LOG_EVENTO(ERRO_SENSOR, canal);
+  }
+}
+
+// Janelas de corrente fechadas desde o último ciclo: energia e detecção de falhas.
+// Falha com o relé fechado desliga o compressor e o segura até ser liberada (ver a tabela de transições).
+static void atualizarCorrente(int canal, unsigned long agora) {
+  EstadoCanal& c = estado.canais[canal];
+  const ParametrosOperacao& p = estado.dados.parametros;
+  LeituraCorrente leitura = medidorCorrente.ler(canal);
+  if (leitura.janelas == 0) return;
+  float wattsPorAmpere = p.tensaoNominalV * FATOR_POTENCIA;
+  c.correnteA = leitura.correnteA;
+  c.potenciaW = c.correnteA * wattsPorAmpere;
+  float energiaWh = leitura.somaCorrentesA * wattsPorAmpere * JANELA_CORRENTE_MS / 3600000.0f;
+  c.energiaTotalWh += energiaWh;
+  if (c.enchendo) c.energiaEnchimentoWh += energiaWh;
+
+  bool ligado = c.compressorLigado();
+  unsigned long ligadoHaMs = ligado ? agora - c.inicioCicloMillis : 0;
+  FalhaCorrente falha = c.detectorCorrente.avaliar(c.correnteA, ligado, ligadoHaMs,
+                                                   leitura.janelas * JANELA_CORRENTE_MS, p.correnteNominalA);
+  if (!ligado) {
+    // Só alarme: o relé já está aberto. Cai quando a corrente some.
+    if (falha == FALHA_CORRENTE_SEM_RELE && !c.correnteSemRele) LOG_EVENTO(CORRENTE_SEM_RELE, canal, c.correnteA);
+    if (falha == FALHA_CORRENTE_SEM_RELE) c.correnteSemRele = true;
+    else if (c.correnteA < p.correnteNominalA * DetectorFalhaCorrente::FRACAO_SEM_CORRENTE) c.correnteSemRele = false;
+    return;
+  }
+  if (falha != FALHA_NENHUMA) despacharEvento(canal, SINAL_FALHA_CORRENTE, agora, falha);
+}
+
+static void atualizarProtecoes(int canal, unsigned long agora, uint32_t agoraUs) {
+  EstadoCanal& c = estado.canais[canal];
+  DadosCanal& d = estado.dados.canais[canal];
+  const ParametrosOperacao& p = estado.dados.parametros;
+  EntradaBoia& boia = boias[canal];
+  boia.atualizar(agoraUs);
+  c.boia = boia.estatisticas();
+  bool caixaEstavaCheia = c.caixaCheia;
+  c.caixaCheia = boia.nivel() == LOW;
+  // O enchimento começa e termina na borda da boia, não no ciclo que confirmou o nível.
+  unsigned long instanteBorda = agora - (agoraUs - boia.instanteMudancaUs()) / 1000UL;
+  if (caixaEstavaCheia && !c.caixaCheia) {
+    comecarEnchimento(c, instanteBorda);
+    LOG_EVENTO(CAIXA_VAZIA, canal);
+  }
+  if (!caixaEstavaCheia && c.caixaCheia && c.enchendo) {
+    unsigned long tempoTotalSecs = (instanteBorda - c.inicioCicloEnchimentoMillis) / 1000UL;
+    d.historicoEnchimento[d.indiceHistoricoEnchimento].tempo = tempoTotalSecs;
+    d.historicoEnchimento[d.indiceHistoricoEnchimento].ciclosParciais = c.ciclosParciaisNesteEnchimento;
+    d.indiceHistoricoEnchimento = (d.indiceHistoricoEnchimento + 1) % TAMANHO_HISTORICO_ENCHIMENTO;
+    d.ciclosEnchimentoCompletos++;
+    LOG_EVENTO(CAIXA_CHEIA, canal, tempoTotalSecs, c.ciclosParciaisNesteEnchimento);
+    ResumoEnchimento resumo;
+    resumo.duracaoS = tempoTotalSecs;
+    resumo.ligadoS = (uint32_t)((c.tempoLigadoTotalMs - c.ligadoNoInicioEnchimentoMs) / 1000ULL);
+    resumo.ligadoAteLimiteS = c.ligadoAteLimiteMs / 1000UL;
+    resumo.partidas = (uint16_t)c.ciclosParciaisNesteEnchimento;
+    resumo.paradasTermicas = (uint16_t)c.paradasTermicasNesteEnchimento;
+    c.energiaUltimoEnchimentoWh = c.energiaEnchimentoWh;
+    incorporarEnchimento(d.modelo, resumo, limitesAdaptativos(p), p.adaptativo);
+    if (p.adaptativo) {
+      LOG_EVENTO(MODELO_ATUALIZADO, canal, (unsigned long)d.modelo.ligadoPorEnchimentoS,
+                 (unsigned long)(d.modelo.tempoLigadoMs / 1000UL), (unsigned long)(d.modelo.tempoDescansoMs / 1000UL));
+    }
+    LOG_EVENTO(CRONOMETRO_PARADO, canal);
+    marcarParaGravar();
+    c.enchendo = false;
+  }
+  if (!caixaEstavaCheia && c.caixaCheia) despacharEvento(canal, SINAL_CAIXA_CHEIA, agora);
+  if (c.temperaturaAtual >= p.temperaturaMaxima && c.compressorLigado()) despacharEvento(canal, SINAL_TEMPERATURA_ALTA, agora);
+}
+
+// ==================== INTERFACE PÚBLICA ====================
+void iniciarControle(const DadosPersistentes& dados, unsigned long agora) {
+  memset(&estado, 0, sizeof(estado));
+  estado.dados = dados;
+  estado.ultimoCicloExecutadoMillis = agora;
+  for (int i = 0; i < NUM_CANAIS; i++) {
+    EstadoCanal& c = estado.canais[i];
+    DadosCanal& d = estado.dados.canais[i];
+    c.temperaturaAtual = 25.0;
+    c.maquina.modo = MODO_DESCANSO;
+    c.maquina.inicioTemporizador = (uint32_t)agora;
+    if (d.modelo.tempoLigadoMs == 0) {
+      iniciarModelo(d.modelo, dados.parametros.tempoLigado, dados.parametros.tempoDescanso);
+    }
+    atualizarTemposCiclo(c, d);
+    c.temperaturaReligamento = calcularTemperaturaReligamento(c, dados.parametros);
+
+    pinMode(PINOS_RELE_COMPRESSOR[i], OUTPUT);
+    digitalWrite(PINOS_RELE_COMPRESSOR[i], HIGH);
+    boias[i].iniciar(ENTRADAS_CAIXA_CHEIA[i], dados.parametros.debounceBoiaMs, dados.parametros.glitchBoiaMs, micros());
+    // Caixa já cheia no boot não é borda: nada a encerrar nem descanso a forçar.
+    c.caixaCheia = boias[i].nivel() == LOW;
+  }
+  configurarMedicaoCorrente(dados.parametros, agora);
+
+  if (sensorEnabled) {
+    sensors.begin();
+    leitorTemperatura.iniciar(NUM_CANAIS, dados.parametros.resolucaoSensor, dados.parametros.intervaloLeitura);
+    LOG_EVENTO(SENSORES_ENCONTRADOS, SEM_CANAL, (unsigned)leitorTemperatura.sensoresEncontrados(), NUM_CANAIS);
+    for (int i = 0; i < NUM_CANAIS; i++) {
+      const uint8_t* endereco = leitorTemperatura.endereco(i);
+      estado.canais[i].sensorPresente = endereco != nullptr;
+      if (endereco) memcpy(estado.canais[i].enderecoSensor, endereco, sizeof(estado.canais[i].enderecoSensor));
+    }
+  }
+  estadoPublicado.publicar(estado);
+}
+
+void executarCicloControle(unsigned long agora) {
+  Comando comando;
+  // Os relés ficaram no estado anterior durante todo o intervalo desde o último ciclo.
+  uint32_t decorrido = (uint32_t)(agora - estado.ultimoCicloExecutadoMillis);
+  for (int i = 0; i < NUM_CANAIS; i++) {
+    if (estado.canais[i].compressorLigado()) estado.canais[i].tempoLigadoTotalMs += decorrido;
+  }
+  estado.ultimoCicloExecutadoMillis = agora;
+  while (filaComandos.receber(comando)) { aplicarComando(comando, agora); }
+  uint32_t marca = lerCiclos();
+  uint32_t agoraUs = micros();
+  atualizarTemperaturas(agora);
+  medidorCorrente.atualizar();
+  for (int i = 0; i < NUM_CANAIS; i++) {
+    atualizarCorrente(i, agora);
+    atualizarProtecoes(i, agora, agoraUs);
+    atualizarTemposCiclo(estado.canais[i], estado.dados.canais[i]);
+    estado.canais[i].temperaturaReligamento = calcularTemperaturaReligamento(estado.canais[i], estado.dados.parametros);
+  }
+  marca = perfilador.registrar(ETAPA_SENSORES, marca);
+  for (int i = 0; i < NUM_CANAIS; i++) despacharEvento(i, SINAL_CICLO, agora);
+  perfilador.registrar(ETAPA_CONTROLE, marca);
+  estadoPublicado.publicar(estado);
+}
+
+bool enviarComando(const Comando& comando) { return filaComandos.enviar(comando); }
+
+void lerEstadoControle(EstadoControle& destino) { estadoPublicado.ler(destino); }
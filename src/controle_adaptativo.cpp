@@ -0,0 +1,79 @@
+#include "controle_adaptativo.h"
+#include <string.h>
+
+static const float ALFA = 0.3f;                // peso de cada enchimento novo nas médias
+static const float FOLGA_LIGADO = 1.25f;       // tempo ligado acima do bombeamento médio por enchimento
+static const float MARGEM_TERMICA = 0.9f;      // fração do tempo até a proteção térmica que se usa
+static const float SONDAGEM_TERMICA = 1.05f;   // quanto o limite térmico aprendido sobe sem disparos
+static const float PERTURBACAO = 0.25f;        // descanso curto = base × 0,75, longo = base × 1,25
+static const float PASSO_DESCANSO = 1.2f;
+static const float DIFERENCA_MINIMA = 0.03f;   // abaixo de 3 % a base do descanso não anda
+static const uint8_t AMOSTRAS_POR_PASSO = 2;   // enchimentos de cada lado antes de comparar
+
+static void acumular(float& media, float amostra, bool primeira) {
+  media = primeira ? amostra : media + ALFA * (amostra - media);
+}
+
+static uint32_t limitar(float valor, uint32_t minimo, uint32_t maximo) {
+  if (valor < (float)minimo) return minimo;
+  if (valor > (float)maximo) return maximo;
+  return (uint32_t)valor;
+}
+
+void iniciarModelo(ModeloEnchimento& modelo, uint32_t tempoLigadoMs, uint32_t tempoDescansoMs) {
+  memset(&modelo, 0, sizeof(modelo));
+  modelo.tempoLigadoMs = tempoLigadoMs;
+  modelo.tempoDescansoMs = tempoDescansoMs;
+}
+
+void incorporarEnchimento(ModeloEnchimento& modelo, const ResumoEnchimento& resumo,
+                          const LimitesAdaptativos& limites, bool ajustarDescanso) {
+  bool primeiro = modelo.enchimentos == 0;
+  acumular(modelo.ligadoPorEnchimentoS, (float)resumo.ligadoS, primeiro);
+  acumular(modelo.partidasPorEnchimento, (float)resumo.partidas, primeiro);
+
+  float alvoMs = modelo.ligadoPorEnchimentoS * FOLGA_LIGADO * 1000.0f;
+  float limiteTermicoMs = modelo.ligadoAteLimiteS * MARGEM_TERMICA * 1000.0f;
+  if (resumo.ligadoAteLimiteS > 0) {
+    acumular(modelo.ligadoAteLimiteS, (float)resumo.ligadoAteLimiteS, modelo.ligadoAteLimiteS == 0.0f);
+  } else if (modelo.ligadoAteLimiteS > 0.0f && limiteTermicoMs < alvoMs && resumo.partidas > 1) {
+    // O limite térmico aprendido segurou o tempo ligado e não houve disparo: sonda
+    // um pouco acima, já que o ambiente muda ao longo do dia e das estações.
+    modelo.ligadoAteLimiteS *= SONDAGEM_TERMICA;
+  }
+  limiteTermicoMs = modelo.ligadoAteLimiteS * MARGEM_TERMICA * 1000.0f;
+  if (modelo.ligadoAteLimiteS > 0.0f && limiteTermicoMs < alvoMs) alvoMs = limiteTermicoMs;
+  modelo.tempoLigadoMs = limitar(alvoMs, limites.ligadoMinimoMs, limites.ligadoMaximoMs);
+
+  // Com uma partida só o descanso não entrou no enchimento: nada a aprender sobre ele.
+  if (ajustarDescanso && resumo.partidas > 1) {
+    uint8_t lado = modelo.lado;
+    bool primeiraDoLado = modelo.amostrasLado[lado] == 0;
+    acumular(modelo.duracaoLado[lado], (float)resumo.duracaoS, primeiraDoLado);
+    acumular(modelo.ligadoLado[lado], (float)resumo.ligadoS, primeiraDoLado);
+    modelo.amostrasLado[lado]++;
+    modelo.lado ^= 1;
+
+    if (modelo.amostrasLado[0] >= AMOSTRAS_POR_PASSO && modelo.amostrasLado[1] >= AMOSTRAS_POR_PASSO) {
+      float descansosPorEnchimento = modelo.partidasPorEnchimento - 1.0f;
+      float descansoExtraS = 2.0f * PERTURBACAO * modelo.tempoDescansoMs / 1000.0f * descansosPorEnchimento;
+      if (descansoExtraS > 0.0f) modelo.recuperacaoPoco = (modelo.ligadoLado[0] - modelo.ligadoLado[1]) / descansoExtraS;
+
+      float base = (float)modelo.tempoDescansoMs;
+      if (modelo.duracaoLado[1] < modelo.duracaoLado[0] * (1.0f - DIFERENCA_MINIMA)) base *= PASSO_DESCANSO;
+      else if (modelo.duracaoLado[0] < modelo.duracaoLado[1] * (1.0f - DIFERENCA_MINIMA)) base /= PASSO_DESCANSO;
+      modelo.tempoDescansoMs = limitar(base, limites.descansoMinimoMs, limites.descansoMaximoMs);
+      modelo.amostrasLado[0] = modelo.amostrasLado[1] = 0;
+    }
+  }
+  if (modelo.enchimentos < UINT16_MAX) modelo.enchimentos++;
+}
+
+uint32_t tempoLigadoAdaptativo(const ModeloEnchimento& modelo, const LimitesAdaptativos& limites) {
+  return limitar((float)modelo.tempoLigadoMs, limites.ligadoMinimoMs, limites.ligadoMaximoMs);
+}
+
+uint32_t tempoDescansoAdaptativo(const ModeloEnchimento& modelo, const LimitesAdaptativos& limites) {
+  float fator = modelo.lado ? 1.0f + PERTURBACAO : 1.0f - PERTURBACAO;
+  return limitar(modelo.tempoDescansoMs * fator, limites.descansoMinimoMs, limites.descansoMaximoMs);
+}
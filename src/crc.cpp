@@ -0,0 +1,26 @@
+#include "crc.h"
+
+uint8_t crc8(const void* dados, size_t tamanho) {
+  const uint8_t* p = static_cast<const uint8_t*>(dados);
+  uint8_t crc = 0;
+  while (tamanho--) {
+    uint8_t byte = *p++;
+    for (int i = 0; i < 8; i++) {
+      uint8_t misturado = (crc ^ byte) & 0x01;
+      crc >>= 1;
+      if (misturado) crc ^= 0x8C;
+      byte >>= 1;
+    }
+  }
+  return crc;
+}
+
+uint32_t crc32(const void* dados, size_t tamanho, uint32_t crc) {
+  const uint8_t* p = static_cast<const uint8_t*>(dados);
+  crc = ~crc;
+  while (tamanho--) {
+    crc ^= *p++;
+    for (int i = 0; i < 8; i++) crc = (crc >> 1) ^ (0xEDB88320UL & (0UL - (crc & 1)));
+  }
+  return ~crc;
+}
@@ -0,0 +1,77 @@
+#include "entrada_boia.h"
+
+void EntradaBoia::iniciar(uint8_t pino, unsigned long debounceMs, unsigned long glitchMs, uint32_t agoraUs) {
+  _pino = pino;
+  configurar(debounceMs, glitchMs);
+  pinMode(_pino, INPUT_PULLUP);
+  _estavel = _bruto = (uint8_t)digitalRead(_pino);
+  _instanteMudancaUs = agoraUs;
+  // Uma borda entre a leitura acima e a interrupção ficar ativa é recuperada em atualizar().
+  attachInterruptArg(digitalPinToInterrupt(_pino), interrupcao, this, CHANGE);
+}
+
+void EntradaBoia::configurar(unsigned long debounceMs, unsigned long glitchMs) {
+  if (glitchMs > debounceMs) glitchMs = debounceMs;
+  _debounceUs = debounceMs * 1000UL;
+  _glitchUs = glitchMs * 1000UL;
+}
+
+// Na interrupção só o mínimo: instante, nível e a fila (FilaSpsc::enviar é inline,
+// fica junto desta rotina na IRAM).
+void IRAM_ATTR EntradaBoia::interrupcao(void* argumento) {
+  EntradaBoia* entrada = static_cast<EntradaBoia*>(argumento);
+  entrada->registrarBorda(micros(), (uint8_t)digitalRead(entrada->_pino));
+}
+
+void IRAM_ATTR EntradaBoia::registrarBorda(uint32_t instanteUs, uint8_t nivel) {
+  Borda borda = { instanteUs, nivel };
+  if (!_fila.enviar(borda)) _estouros.fetch_add(1, std::memory_order_relaxed);
+}
+
+void EntradaBoia::processar(uint32_t instanteUs, uint8_t nivel) {
+  if (nivel == _bruto) return;  // duas interrupções leram o mesmo nível: a borda do meio se perdeu
+  _bruto = nivel;
+  _ultimaBordaUs = instanteUs;
+  if (!_pendente) {
+    if (nivel != _estavel) {
+      _pendente = true;
+      _inicioPendenteUs = instanteUs;
+    }
+  } else if (nivel == _estavel && instanteUs - _inicioPendenteUs < _glitchUs) {
+    // Voltou antes do filtro de glitch: nem chega a ser o começo de uma transição.
+    _pendente = false;
+    _estatisticas.glitches++;
+  }
+}
+
+bool EntradaBoia::atualizar(uint32_t agoraUs) {
+  Borda borda;
+  while (_fila.receber(borda)) {
+    _estatisticas.bordas++;
+    processar(borda.instanteUs, borda.nivel);
+  }
+  // O pino diverge do que as bordas contaram: a fila estourou ou a borda chegou
+  // depois de esvaziada. O instante do ciclo é o melhor que se tem.
+  uint8_t lido = (uint8_t)digitalRead(_pino);
+  if (lido != _bruto) {
+    _estatisticas.perdidas++;
+    processar(agoraUs, lido);
+  }
+  // Com sinal: uma borda registrada depois de `agoraUs` ser lido não pode parecer antiga.
+  if (!_pendente || (int32_t)(agoraUs - _ultimaBordaUs) < (int32_t)_debounceUs) return false;
+  _pendente = false;
+  if (_bruto == _estavel) {
+    _estatisticas.trepidacoes++;
+    return false;
+  }
+  _estavel = _bruto;
+  _instanteMudancaUs = _inicioPendenteUs;
+  _estatisticas.mudancas++;
+  return true;
+}
+
+EstatisticasBoia EntradaBoia::estatisticas() const {
+  EstatisticasBoia e = _estatisticas;
+  e.perdidas += _estouros.load(std::memory_order_relaxed);
+  return e;
+}
@@ -0,0 +1,155 @@
+#include "escritor_json.h"
+#include <math.h>
+
+EscritorJson::EscritorJson(char* buffer, size_t capacidade) : _buffer(buffer), _capacidade(capacidade) {
+  if (_capacidade > 0) _buffer[0] = '\0';
+  else _estourou = true;
+}
+
+EscritorJson::EscritorJson(char* buffer, size_t capacidade, FuncaoEsvaziarJson esvaziar, void* contexto)
+    : EscritorJson(buffer, capacidade) {
+  _esvaziar = esvaziar;
+  _contexto = contexto;
+}
+
+void EscritorJson::esvaziar() {
+  if (!_esvaziar || _tamanho == 0) return;
+  _esvaziar(_buffer, _tamanho, _contexto);
+  _tamanho = 0;
+  _buffer[0] = '\0';
+}
+
+void EscritorJson::escrever(char c) {
+  if (_tamanho + 1 >= _capacidade) esvaziar();
+  if (_tamanho + 1 >= _capacidade) {
+    _estourou = true;
+    return;
+  }
+  _buffer[_tamanho++] = c;
+  _buffer[_tamanho] = '\0';
+}
+
+void EscritorJson::escrever(const char* s) {
+  while (*s) escrever(*s++);
+}
+
+void EscritorJson::escreverTextoEscapado(const char* s) {
+  static const char HEX[] = "0123456789abcdef";
+  escrever('"');
+  for (; *s; s++) {
+    unsigned char c = (unsigned char)*s;
+    if (c == '"' || c == '\\') {
+      escrever('\\');
+      escrever((char)c);
+    } else if (c < 0x20) {
+      escrever("\\u00");
+      escrever(HEX[c >> 4]);
+      escrever(HEX[c & 0x0F]);
+    } else {
+      escrever((char)c);
+    }
+  }
+  escrever('"');
+}
+
+void EscritorJson::escreverInteiro(unsigned long v) {
+  char digitos[20];
+  int n = 0;
+  do {
+    digitos[n++] = (char)('0' + v % 10);
+    v /= 10;
+  } while (v > 0);
+  while (n > 0) escrever(digitos[--n]);
+}
+
+// Vírgula antes de todo elemento que não seja o primeiro do nível (ou o valor de uma chave).
+void EscritorJson::separar() {
+  if (_aposChave) {
+    _aposChave = false;
+    return;
+  }
+  if (_profundidade == 0) return;
+  uint32_t bit = 1UL << (_profundidade - 1);
+  if (_niveisVazios & bit) _niveisVazios &= ~bit;
+  else escrever(',');
+}
+
+void EscritorJson::chave(const char* nome) {
+  separar();
+  escreverTextoEscapado(nome);
+  escrever(':');
+  _aposChave = true;
+}
+
+void EscritorJson::abrir(const char* nome, char c) {
+  if (nome) chave(nome);
+  separar();
+  escrever(c);
+  if (_profundidade < 32) {
+    _niveisVazios |= 1UL << _profundidade;
+    _profundidade++;
+  } else {
+    _estourou = true;
+  }
+}
+
+void EscritorJson::fechar(char c) {
+  if (_profundidade > 0) _profundidade--;
+  escrever(c);
+}
+
+void EscritorJson::abrirObjeto(const char* nome) { abrir(nome, '{'); }
+void EscritorJson::fecharObjeto() { fechar('}'); }
+void EscritorJson::abrirLista(const char* nome) { abrir(nome, '['); }
+void EscritorJson::fecharLista() { fechar(']'); }
+
+void EscritorJson::valor(bool v) {
+  separar();
+  escrever(v ? "true" : "false");
+}
+
+void EscritorJson::valor(long v) {
+  separar();
+  if (v < 0) {
+    escrever('-');
+    escreverInteiro(0UL - (unsigned long)v);
+  } else {
+    escreverInteiro((unsigned long)v);
+  }
+}
+
+void EscritorJson::valor(unsigned long v) {
+  separar();
+  escreverInteiro(v);
+}
+
+void EscritorJson::valor(float v, uint8_t casas) {
+  if (isnan(v) || isinf(v)) {
+    valorNulo();
+    return;
+  }
+  separar();
+  if (casas > 6) casas = 6;
+  unsigned long escala = 1;
+  for (uint8_t i = 0; i < casas; i++) escala *= 10;
+  double absoluto = fabs((double)v);
+  unsigned long total = (unsigned long)(absoluto * escala + 0.5);
+  if (v < 0 && total > 0) escrever('-');
+  escreverInteiro(total / escala);
+  if (casas == 0) return;
+  escrever('.');
+  unsigned long fracao = total % escala;
+  for (unsigned long divisor = escala / 10; divisor > 0; divisor /= 10) {
+    escrever((char)('0' + (fracao / divisor) % 10));
+  }
+}
+
+void EscritorJson::valor(const char* texto) {
+  separar();
+  escreverTextoEscapado(texto);
+}
+
+void EscritorJson::valorNulo() {
+  separar();
+  escrever("null");
+}
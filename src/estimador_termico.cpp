@@ -0,0 +1,84 @@
+#include "estimador_termico.h"
+#include <math.h>
+#include <string.h>
+
+static const float ALFA_INCLINACAO = 0.3f;
+static const float ESQUECIMENTO = 0.99f;        // por janela: memória de ~100 janelas (~17 min ligado)
+static const float VARIANCIA_MINIMA = 4.0f;     // °C²: o ajuste precisa de uma faixa de temperaturas
+static const float PESO_MINIMO = 5.0f;
+static const float CONSTANTE_MINIMA_S = 60.0f;
+static const float CONSTANTE_MAXIMA_S = 36000.0f;
+static const float SEM_LIMITE_S = 86400.0f;     // o equilíbrio fica abaixo do limite
+static const float REFERENCIA_C = 40.0f;        // as somas usam T - 40 °C, para não perder precisão no float
+
+void EstimadorTermico::reiniciar() {
+  memset(this, 0, sizeof(*this));
+}
+
+void EstimadorTermico::atualizar(float temperatura, bool ligado, unsigned long agora) {
+  // Uma troca de estado do relé no meio da janela mistura as duas curvas: recomeça.
+  if (!janelaAberta || ligado != ligadoNaJanela) {
+    janelaAberta = true;
+    ligadoNaJanela = ligado;
+    temperaturaInicioJanela = temperatura;
+    inicioJanelaMs = agora;
+    return;
+  }
+  unsigned long decorrido = agora - inicioJanelaMs;
+  if (decorrido < JANELA_MS) return;
+  float inclinacao = (temperatura - temperaturaInicioJanela) * 1000.0f / (float)decorrido;
+  float& media = ligado ? inclinacaoAquecimento : inclinacaoResfriamento;
+  uint8_t& janelas = ligado ? janelasAquecimento : janelasResfriamento;
+  media = janelas == 0 ? inclinacao : media + ALFA_INCLINACAO * (inclinacao - media);
+  if (janelas < UINT8_MAX) janelas++;
+  if (ligado) {
+    float t = 0.5f * (temperatura + temperaturaInicioJanela) - REFERENCIA_C;
+    peso = ESQUECIMENTO * peso + 1.0f;
+    somaT = ESQUECIMENTO * somaT + t;
+    somaI = ESQUECIMENTO * somaI + inclinacao;
+    somaTT = ESQUECIMENTO * somaTT + t * t;
+    somaTI = ESQUECIMENTO * somaTI + t * inclinacao;
+  }
+  temperaturaInicioJanela = temperatura;
+  inicioJanelaMs = agora;
+}
+
+bool EstimadorTermico::modeloAquecimento(float& temperaturaEquilibrio, float& constanteTempoS) const {
+  if (peso < PESO_MINIMO) return false;
+  float mediaT = somaT / peso;
+  float variancia = somaTT / peso - mediaT * mediaT;
+  if (variancia < VARIANCIA_MINIMA) return false;
+  float b = (somaTI / peso - mediaT * (somaI / peso)) / variancia;
+  float a = somaI / peso - b * mediaT;
+  if (b >= 0.0f) return false;
+  constanteTempoS = -1.0f / b;
+  temperaturaEquilibrio = -a / b + REFERENCIA_C;
+  return constanteTempoS >= CONSTANTE_MINIMA_S && constanteTempoS <= CONSTANTE_MAXIMA_S;
+}
+
+float EstimadorTermico::segundosAteLimite(float temperatura, float limite) const {
+  if (temperatura >= limite) return 0.0f;
+  float equilibrio, constante;
+  if (modeloAquecimento(equilibrio, constante)) {
+    if (equilibrio <= limite) return SEM_LIMITE_S;
+    if (temperatura < equilibrio) return constante * logf((equilibrio - temperatura) / (equilibrio - limite));
+  }
+  if (!aquecimentoValido()) return -1.0f;
+  return (limite - temperatura) / inclinacaoAquecimento;
+}
+
+float EstimadorTermico::temperaturaReligamento(float limite, float duracaoS) const {
+  float equilibrio, constante;
+  if (modeloAquecimento(equilibrio, constante)) {
+    if (equilibrio <= limite) return limite;
+    return equilibrio - (equilibrio - limite) * expf(duracaoS / constante);
+  }
+  if (!aquecimentoValido()) return limite;
+  return limite - inclinacaoAquecimento * duracaoS;
+}
+
+float EstimadorTermico::segundosAteEsfriar(float temperatura, float alvo) const {
+  if (temperatura <= alvo) return 0.0f;
+  if (!resfriamentoValido()) return -1.0f;
+  return (temperatura - alvo) / -inclinacaoResfriamento;
+}
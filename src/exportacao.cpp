@@ -0,0 +1,171 @@
+#include "exportacao.h"
+#include <stddef.h>
+#include "crc.h"
+
+static_assert(sizeof(AmostraExportada) == sizeof(AmostraTelemetria) &&
+                  offsetof(AmostraExportada, flags) == offsetof(AmostraTelemetria, flags) &&
+                  offsetof(AmostraExportada, ciclosEnchimentoCompletos) == offsetof(AmostraTelemetria, ciclosEnchimentoCompletos),
+              "AmostraExportada deve ter o leiaute de AmostraTelemetria");
+
+// Itens por seção de série: 32 amostras são 512 bytes de pilha.
+static const int ITENS_POR_SECAO = 32;
+
+namespace {
+
+struct Escritor {
+  SaidaExportacao saida;
+  void* contexto;
+  uint32_t crc = 0;
+  size_t total = 0;
+  bool interrompido = false;
+
+  bool escrever(const void* dados, size_t tamanho) {
+    if (interrompido) return false;
+    crc = crc32(dados, tamanho, crc);
+    if (!saida(static_cast<const uint8_t*>(dados), tamanho, contexto)) {
+      interrompido = true;
+      return false;
+    }
+    total += tamanho;
+    return true;
+  }
+
+  bool secao(uint16_t tipo, const void* dados, size_t tamanho) {
+    CabecalhoSecao cabecalho = { tipo, 0, (uint32_t)tamanho };
+    return escrever(&cabecalho, sizeof(cabecalho)) && escrever(dados, tamanho);
+  }
+};
+
+struct BlocoTelemetria {
+  Escritor* escritor;
+  AmostraExportada amostras[ITENS_POR_SECAO];
+  int quantidade = 0;
+
+  void esvaziar() {
+    if (quantidade == 0) return;
+    escritor->secao(SECAO_TELEMETRIA, amostras, quantidade * sizeof(AmostraExportada));
+    quantidade = 0;
+  }
+};
+
+struct BlocoTemperatura {
+  Escritor* escritor;
+  struct {
+    uint32_t resolucaoS;
+    BaldeExportado baldes[ITENS_POR_SECAO];
+  } dados;
+  int quantidade = 0;
+
+  void esvaziar() {
+    if (quantidade == 0) return;
+    escritor->secao(SECAO_TEMPERATURA, &dados, sizeof(uint32_t) + quantidade * sizeof(BaldeExportado));
+    quantidade = 0;
+  }
+};
+
+}  // namespace
+
+static int16_t centesimos(float valor) {
+  float c = valor * 100.0f;
+  if (c > 32767.0f) c = 32767.0f;
+  if (c < -32768.0f) c = -32768.0f;
+  return (int16_t)lroundf(c);
+}
+
+static bool acumularAmostra(const AmostraTelemetria& amostra, void* contexto) {
+  BlocoTelemetria& bloco = *static_cast<BlocoTelemetria*>(contexto);
+  memcpy(&bloco.amostras[bloco.quantidade++], &amostra, sizeof(amostra));
+  if (bloco.quantidade == ITENS_POR_SECAO) bloco.esvaziar();
+  return !bloco.escritor->interrompido;
+}
+
+static void acumularBalde(uint32_t idadeS, float minimo, float maximo, float media, void* contexto) {
+  BlocoTemperatura& bloco = *static_cast<BlocoTemperatura*>(contexto);
+  if (bloco.escritor->interrompido) return;
+  BaldeExportado& balde = bloco.dados.baldes[bloco.quantidade++];
+  balde.idadeS = idadeS;
+  balde.minimoCentesimos = centesimos(minimo);
+  balde.maximoCentesimos = centesimos(maximo);
+  balde.mediaCentesimos = centesimos(media);
+  balde.reservado = 0;
+  if (bloco.quantidade == ITENS_POR_SECAO) bloco.esvaziar();
+}
+
+static void exportarCanal(Escritor& escritor, const EstadoControle& estado, int i) {
+  const EstadoCanal& c = estado.canais[i];
+  const DadosCanal& d = estado.dados.canais[i];
+  CanalExportado canal = {};
+  canal.canal = (uint8_t)i;
+  if (c.compressorLigado()) canal.flags |= AmostraExportada::FLAG_COMPRESSOR;
+  if (c.caixaCheia) canal.flags |= AmostraExportada::FLAG_CAIXA_CHEIA;
+  if (c.modoManual()) canal.flags |= AmostraExportada::FLAG_MODO_MANUAL;
+  if (c.desligadoPorTemperaturaAlta()) canal.flags |= AmostraExportada::FLAG_DESLIGADO_TEMPERATURA;
+  canal.temperaturaCentesimos = centesimos(c.temperaturaAtual);
+  canal.ciclosParciaisOperacao = d.ciclosParciaisOperacao;
+  canal.ciclosEnchimentoCompletos = d.ciclosEnchimentoCompletos;
+  canal.tempoLigadoTotalS = (uint32_t)(c.tempoLigadoTotalMs / 1000ULL);
+  canal.paradasTermicasPreditivas = c.paradasTermicasPreditivas;
+  canal.desligamentosEmergencia = c.desligamentosEmergencia;
+  // indiceHistoricoEnchimento aponta para a próxima posição, que é a mais antiga.
+  for (int j = 0; j < TAMANHO_HISTORICO_ENCHIMENTO && j < CanalExportado::MAX_ENCHIMENTOS; j++) {
+    const EnchimentoInfo& e = d.historicoEnchimento[(d.indiceHistoricoEnchimento + j) % TAMANHO_HISTORICO_ENCHIMENTO];
+    if (e.tempo == 0) continue;
+    canal.enchimentos[canal.numEnchimentos].tempoS = (uint32_t)e.tempo;
+    canal.enchimentos[canal.numEnchimentos].ciclosParciais = e.ciclosParciais;
+    canal.numEnchimentos++;
+  }
+  canal.ligadoPorEnchimentoS = d.modelo.ligadoPorEnchimentoS;
+  canal.partidasPorEnchimento = d.modelo.partidasPorEnchimento;
+  escritor.secao(SECAO_CANAL, &canal, sizeof(canal));
+}
+
+size_t exportarHistorico(const InfoExportacao& info, const EstadoControle& estado, RegistroTelemetria& telemetria,
+                         const SerieTemporal& serie, SaidaExportacao saida, void* contexto) {
+  Escritor escritor;
+  escritor.saida = saida;
+  escritor.contexto = contexto;
+
+  CabecalhoExportacao cabecalho = {};
+  memcpy(cabecalho.magico, MAGICO_EXPORTACAO, sizeof(cabecalho.magico));
+  cabecalho.versao = VERSAO_EXPORTACAO;
+  cabecalho.numCanais = NUM_CANAIS;
+  cabecalho.flags = info.relogioSincronizado ? CabecalhoExportacao::FLAG_RELOGIO_SINCRONIZADO : 0;
+  cabecalho.instante = info.instante;
+  cabecalho.uptimeS = info.uptimeS;
+  strncpy(cabecalho.identificador, info.identificador ? info.identificador : "", sizeof(cabecalho.identificador));
+  escritor.escrever(&cabecalho, sizeof(cabecalho));
+
+  const ParametrosOperacao& p = estado.dados.parametros;
+  ParametrosExportados parametros = {};
+  parametros.tempoLigadoS = (uint32_t)(p.tempoLigado / 1000UL);
+  parametros.tempoDescansoS = (uint32_t)(p.tempoDescanso / 1000UL);
+  parametros.intervaloLeituraMs = (uint32_t)p.intervaloLeitura;
+  parametros.tempoLigadoMaximoS = (uint32_t)(p.tempoLigadoMaximo / 1000UL);
+  parametros.tempoDescansoMinimoS = (uint32_t)(p.tempoDescansoMinimo / 1000UL);
+  parametros.temperaturaMaximaCentesimos = centesimos(p.temperaturaMaxima);
+  parametros.resolucaoSensor = p.resolucaoSensor;
+  if (p.adaptativo) parametros.flags |= ParametrosExportados::FLAG_ADAPTATIVO;
+  if (p.protecaoPreditiva) parametros.flags |= ParametrosExportados::FLAG_PROTECAO_PREDITIVA;
+  parametros.debounceBoiaMs = (uint16_t)p.debounceBoiaMs;
+  parametros.glitchBoiaMs = (uint16_t)p.glitchBoiaMs;
+  escritor.secao(SECAO_PARAMETROS, &parametros, sizeof(parametros));
+
+  for (int i = 0; i < NUM_CANAIS; i++) exportarCanal(escritor, estado, i);
+
+  BlocoTelemetria telemetriaBloco;
+  telemetriaBloco.escritor = &escritor;
+  telemetria.percorrer(0, UINT32_MAX, acumularAmostra, &telemetriaBloco);
+  telemetriaBloco.esvaziar();
+
+  for (int nivel = 0; nivel < SerieTemporal::NUM_NIVEIS; nivel++) {
+    BlocoTemperatura temperaturaBloco;
+    temperaturaBloco.escritor = &escritor;
+    temperaturaBloco.dados.resolucaoS = SerieTemporal::NIVEIS[nivel].resolucaoS;
+    serie.percorrer(nivel, 0, acumularBalde, &temperaturaBloco);
+    temperaturaBloco.esvaziar();
+  }
+
+  uint32_t crc = escritor.crc;
+  escritor.secao(SECAO_FIM, &crc, sizeof(crc));
+  return escritor.total;
+}
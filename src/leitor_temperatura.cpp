@@ -0,0 +1,55 @@
+#include "leitor_temperatura.h"
+
+LeitorTemperatura::LeitorTemperatura(DallasTemperature& sensores) : _sensores(sensores) {
+  for (uint8_t i = 0; i < MAX_SENSORES; i++) _ultimasLeituras[i] = DEVICE_DISCONNECTED_C;
+}
+
+void LeitorTemperatura::iniciar(uint8_t esperados, uint8_t resolucao, unsigned long intervaloMs) {
+  _esperados = esperados > MAX_SENSORES ? MAX_SENSORES : esperados;
+  // A única busca no barramento: daqui em diante cada sensor é lido pelo endereço.
+  _encontrados = 0;
+  uint8_t total = _sensores.getDeviceCount();
+  for (uint8_t i = 0; i < total && _encontrados < _esperados; i++) {
+    if (_sensores.getAddress(_enderecos[_encontrados], i)) _encontrados++;
+  }
+  _sensores.setWaitForConversion(false);
+  configurar(resolucao, intervaloMs);
+}
+
+void LeitorTemperatura::configurar(uint8_t resolucao, unsigned long intervaloMs) {
+  if (resolucao < 9) resolucao = 9;
+  if (resolucao > 12) resolucao = 12;
+  _resolucao = resolucao;
+  _sensores.setResolution(_resolucao);
+  _tempoConversaoMs = _sensores.millisToWaitForConversion(_resolucao);
+  // O intervalo nunca pode ser menor que o tempo de conversão.
+  _intervaloMs = (intervaloMs < _tempoConversaoMs) ? _tempoConversaoMs : intervaloMs;
+  _convertendo = false;
+  _primeiraConversao = true;
+}
+
+LeitorTemperatura::Resultado LeitorTemperatura::atualizar(unsigned long agora) {
+  if (!_convertendo) {
+    if (!_primeiraConversao && agora - _inicioConversao < _intervaloMs) return SEM_NOVIDADE;
+    _sensores.requestTemperatures();
+    _inicioConversao = agora;
+    _convertendo = true;
+    _primeiraConversao = false;
+    _proximoColetado = 0;
+    return SEM_NOVIDADE;
+  }
+  if (agora - _inicioConversao < _tempoConversaoMs) return SEM_NOVIDADE;
+
+  // Um sensor por passada; a conversão só termina depois de coletar todos.
+  _sensorLido = _proximoColetado++;
+  if (_proximoColetado >= _esperados) _convertendo = false;
+  if (_sensorLido >= _encontrados) return ERRO_SENSOR;
+  float t = _sensores.getTempC(_enderecos[_sensorLido]);
+  if (t == DEVICE_DISCONNECTED_C) return ERRO_SENSOR;
+  // 85 °C sozinho é o valor de quem acabou de ligar; dois seguidos, uma medida.
+  bool confirmado = _ultimaFoiAoLigar[_sensorLido];
+  _ultimaFoiAoLigar[_sensorLido] = t == VALOR_AO_LIGAR;
+  if (t == VALOR_AO_LIGAR && !confirmado) return SEM_NOVIDADE;
+  _ultimasLeituras[_sensorLido] = t;
+  return LEITURA_NOVA;
+}
@@ -0,0 +1,53 @@
+#include "limitador_clientes.h"
+
+bool LimitadorClientes::configurar(uint32_t taxaPorS, uint32_t rajada, uint32_t custoLogin) {
+  if (taxaPorS == 0 || taxaPorS > TAXA_MAXIMA_POR_S || rajada == 0 || rajada > RAJADA_MAXIMA) return false;
+  if (custoLogin == 0 || custoLogin > rajada) return false;
+  _taxaPorS = taxaPorS;
+  _rajada = rajada;
+  _custoLogin = custoLogin;
+  // Baldes acima da rajada nova são aparados na próxima requisição de cada endereço.
+  return true;
+}
+
+bool LimitadorClientes::admitir(uint32_t ip, unsigned long agora, uint32_t custo, uint32_t& esperaS) {
+  const uint32_t BALDE_CHEIO = _rajada * 1000UL;
+  Cliente* cliente = nullptr;
+  Cliente* maisParado = &_clientes[0];
+  for (int i = 0; i < MAX_CLIENTES && !cliente; i++) {
+    Cliente& c = _clientes[i];
+    if (c.ocupado && c.ip == ip) cliente = &c;
+    else if (!c.ocupado) maisParado = &c;
+    else if (maisParado->ocupado && (uint32_t)(agora - c.ultimo) > (uint32_t)(agora - maisParado->ultimo)) maisParado = &c;
+  }
+  if (!cliente) {
+    cliente = maisParado;
+    cliente->ip = ip;
+    cliente->milesimos = BALDE_CHEIO;
+    cliente->ocupado = true;
+  } else {
+    // Limita o intervalo antes de multiplicar: parado mais que isso, o balde já encheu.
+    uint32_t decorrido = (uint32_t)(agora - cliente->ultimo);
+    if (decorrido > BALDE_CHEIO / _taxaPorS) decorrido = BALDE_CHEIO / _taxaPorS;
+    cliente->milesimos += decorrido * _taxaPorS;
+    if (cliente->milesimos > BALDE_CHEIO) cliente->milesimos = BALDE_CHEIO;
+  }
+  cliente->ultimo = (uint32_t)agora;
+
+  uint32_t preco = custo * 1000UL;
+  if (cliente->milesimos >= preco) {
+    cliente->milesimos -= preco;
+    _aceitas++;
+    return true;
+  }
+  uint32_t faltam = preco - cliente->milesimos;
+  esperaS = (faltam + _taxaPorS * 1000UL - 1) / (_taxaPorS * 1000UL);
+  _recusadas++;
+  return false;
+}
+
+int LimitadorClientes::acompanhados() const {
+  int n = 0;
+  for (int i = 0; i < MAX_CLIENTES; i++) n += _clientes[i].ocupado ? 1 : 0;
+  return n;
+}
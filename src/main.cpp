@@ -15,402 +15,787 @@
 #include <Arduino.h>
 #include <WiFi.h>
 #include <WebServer.h>
-#include <DNSServer.h>
-#include <OneWire.h>
-#include <DallasTemperature.h>
 #include <Preferences.h>
 #include <ESPmDNS.h>
 #include <SPIFFS.h>
-
-// ==================== ESTRUTURAS DE DADOS ====================
-struct EnchimentoInfo {
-  unsigned long tempo;
-  unsigned int ciclosParciais;
-};
+#include "canal_eventos.h"
+#include "cliente_mqtt.h"
+#include "comandos.h"
+#include "controle.h"
+#include "escritor_json.h"
+#include "exportacao.h"
+#include "gerenciador_wifi.h"
+#include "limitador_clientes.h"
+#include "perfilador.h"
+#include "persistencia.h"
+#include "publicador_mqtt.h"
+#include "rastro_compressor.h"
+#include "registro_eventos.h"
+#include "registro_telemetria.h"
+#include "resposta_status.h"
+#include "serie_temporal.h"
+#include "servidor_arquivos.h"
+#include "servidor_web.h"
+#include "sessao.h"
+#include "tarefa_controle.h"
 
 // ==================== CONFIGURAÇÕES GERAIS ====================
-const char* httpUser = "admin";
-const char* httpPass = "1234";
 const char* apSsid = "EletroMatos_Compressor";
 const char* apPassword = "12345678";
 
-WebServer server(80);
-DNSServer dnsServer;
+ServidorWeb server(80);
+GerenciadorWiFi gerenciadorWiFi(apSsid, apPassword);
 Preferences preferences;
+CanalEventos canalEventos;
+RegistroTelemetria registroTelemetria;
+ServidorArquivos servidorArquivos;
+ClienteMqtt clienteMqtt;
+PublicadorMqtt publicadorMqtt;
+GerenciadorSessoes sessoes;
+LimitadorClientes limitadorClientes;
 
 // ==================== PINOS ====================
-const int PINO_RELE_COMPRESSOR = 26;
-const int ENTRADA_CAIXA_CHEIA = 25;
-const int PINO_SENSOR_TEMPERATURA = 4;
 const int LED_STATUS = 2;
 
-// ==================== SENSOR DE TEMPERATURA ====================
-bool sensorEnabled = true;
-OneWire oneWire(PINO_SENSOR_TEMPERATURA);
-DallasTemperature sensors(&oneWire);
-
-// ==================== PARÂMETROS DE OPERAÇÃO ====================
-unsigned long tempoLigado = 600000UL;
-unsigned long tempoDescanso = 100000UL;
-float temperaturaMaxima = 60.0;
+// ==================== TAREFA DE CONTROLE ====================
+const unsigned long PERIODO_CONTROLE_MS = 10UL;
+const int PRIORIDADE_TAREFA_CONTROLE = 10;
+const int NUCLEO_TAREFA_CONTROLE = 1;
 
 // ==================== VARIÁVEIS DE EXECUÇÃO ====================
-bool compressorLigado = false;
-bool modoManual = false;
-bool caixaCheia = false;
-float temperaturaAtual = 25.0;
-unsigned long ciclosParciaisOperacao = 0UL;
-unsigned long ultimoTempoControle = 0UL;
-unsigned long ultimoSaveMillis = 0UL;
-const unsigned long SAVE_INTERVAL = 60000UL;
-unsigned long inicioCicloMillis = 0;
-unsigned long ultimoCheckWiFi = 0;
-const long intervaloCheckWiFi = 30000;
-int tentativasReconexao = 0;
-const int maxTentativasReconexao = 5;
-
-unsigned long inicioCicloEnchimentoMillis = 0;
-bool desligadoPorTemperaturaAlta = false;
-const int TAMANHO_HISTORICO_ENCHIMENTO = 5;
-EnchimentoInfo historicoEnchimento[TAMANHO_HISTORICO_ENCHIMENTO];
-int indiceHistoricoEnchimento = 0;
-unsigned long ciclosEnchimentoCompletos = 0UL;
-unsigned int ciclosParciaisNesteEnchimento = 0;
-
-float historicoTemp[24];
-int indiceHistorico = 0;
+bool relogioConfigurado = false;
+// "compressor-" e os 3 últimos bytes do MAC: client id no MQTT e nome das exportações.
+char identificadorDispositivo[24];
+
+// Uma amostra por segundo alimenta os níveis de 10 s, 1 min e 1 h do gráfico.
+SerieTemporal serieTemperatura;
 unsigned long ultimaLeituraGrafico = 0;
-const long INTERVALO_GRAFICO = 3600000UL;
+const unsigned long INTERVALO_GRAFICO = 1000UL;
+// Sem resolução explícita, /tempdata escolhe um nível com até este número de pontos.
+const uint32_t MAX_PONTOS_GRAFICO = 360;
+
+// Buffer único das respostas JSON: os handlers rodam todos na tarefa do loop().
+char bufferJson[TAMANHO_BUFFER_JSON];
+
+// ==================== EVENTOS (SSE) ====================
+// Mudanças dentro desta janela são agrupadas num único evento.
+const unsigned long INTERVALO_MINIMO_EVENTOS = 250UL;
+EstadoControle ultimoEstadoPublicado;
+unsigned long ultimoEventoMillis = 0;
+
+// ==================== TELEMETRIA ====================
+// time() abaixo disso significa que o NTP ainda não sincronizou.
+const time_t EPOCH_MINIMO_VALIDO = 1700000000;
+const long FUSO_HORARIO_SEGUNDOS = -3 * 3600;
+
+unsigned long latenciaLoopUs = 0UL;
+unsigned long latenciaMaximaLoopUs = 0UL;
+
+// ==================== MQTT ====================
+// O estado retido é republicado quando relé, boia, modo, contadores ou
+// parâmetros mudam (a temperatura vai na telemetria), no máximo uma vez por
+// INTERVALO_MINIMO_ESTADO_MQTT, e sempre que o cliente reconecta.
+const unsigned long INTERVALO_MINIMO_ESTADO_MQTT = 1000UL;
+EstadoControle ultimoEstadoMqtt;
+unsigned long ultimoEstadoMqttMillis = 0;
+bool estadoMqttPendente = true;
+
+// ==================== RECURSOS (MÉTRICAS) ====================
+// Amostrados uma vez por segundo no loop(): as consultas ao heap e à pilha
+// percorrem estruturas internas e não cabem em toda passada.
+const unsigned long INTERVALO_RECURSOS = 1000UL;
+unsigned long ultimaAmostraRecursos = 0;
+uint32_t heapLivre = 0;
+uint32_t heapLivreMinimo = 0;
+uint32_t maiorBlocoLivre = 0;
+uint32_t maiorBlocoLivreMinimo = UINT32_MAX;
+uint32_t pilhaLoopLivreMinima = 0;
+
+// ==================== RETRATOS DO CONTROLE ====================
+// O EstadoControle passa de 3 KB com 8 canais; cópias locais no loop() e nos
+// handlers (chamados de dentro do server.handleClient(), um quadro acima)
+// somavam mais de 7 KB na pilha de 8 KB da tarefa do loop(). Os dois ficam
+// aqui: um para o loop(), outro para os handlers, que nunca se aninham.
+EstadoControle retratoLoop;
+EstadoControle retratoHttp;
 
 // ==================== PROTÓTIPOS DAS FUNÇÕES ====================
+bool barrarCliente(uint32_t custo = 1);
 bool autenticar();
+void enviarCookieSessao(uint64_t agoraMs);
+void handleLogin();
+void handleSair();
+void handleConfigAcesso();
+void carregarLimiteClientes();
+void handleConfigLimite();
 void handleRoot();
 void handleLigar();
 void handleDesligar();
 void handleAutomatico();
 void handleStatus();
+void handleEventos();
+DiagnosticoLoop diagnosticoLoop();
+void publicarEventos(const EstadoControle& estado);
 void handleConfig();
 void handleZerarCiclos();
 void handleTempData();
+void handleTelemetria();
+void handleLog();
+void handleRastro();
+void handleExportar();
+void registrarTelemetria(const EstadoControle& estado);
+void publicarMqtt(const EstadoControle& estado);
+void handleConfigMqtt();
 void handleConfigWiFi();
 void handleSalvarWiFi();
 String paginaConfigWiFi();
-void gerenciarConexaoWiFi();
-void registrarTemperatura();
-void configurarRotasWebNormais();
-void ligarCompressor();
-void desligarCompressor();
-void carregarConfiguracoesOperacao();
-void salvarConfiguracoesOperacao();
-void atualizarSensores();
-void controleAutomatico();
-bool conectarWiFi();
-void iniciarModoAutonomo();
+bool encaminharComando(TipoComando tipo, uint8_t canal);
+int canalRequisitado();
+void enviarJson(const EscritorJson& json);
+void tratarEventoWiFi(GerenciadorWiFi::Evento evento);
+void registrarTemperatura(float temperaturaAtual);
+void amostrarRecursos();
+void handleMetrics();
+void configurarRotas();
 
 // ==================== SETUP ====================
+// A ordem importa: o relé é colocado em estado seguro e a tarefa de controle
+// começa antes de qualquer coisa lenta (SPIFFS, WiFi), que segue em paralelo.
 void setup() {
   Serial.begin(115200);
-  delay(100);
   Serial.println(F("\n\n=== Iniciando EletroMatos Compressor v5.1 ==="));
-  
-  if(!SPIFFS.begin(true)){
-    Serial.println("Ocorreu um erro ao montar o SPIFFS");
-    return;
-  }
+  perfilador.iniciar(ESP.getCpuFreqMHz());
 
-  for (int i = 0; i < 24; i++) { historicoTemp[i] = -1000; }
-  memset(historicoEnchimento, 0, sizeof(historicoEnchimento));
+  preferences.begin("compressor", false);
+  DadosPersistentes dados;
+  carregarConfiguracoesOperacao(preferences, dados);
+  iniciarControle(dados, millis());
+  if (!iniciarTarefaControle(executarCicloControle, PERIODO_CONTROLE_MS, PRIORIDADE_TAREFA_CONTROLE, NUCLEO_TAREFA_CONTROLE)) {
+    Serial.println(F("‼️ Falha ao criar a tarefa de controle."));
+  }
 
-  pinMode(PINO_RELE_COMPRESSOR, OUTPUT);
-  digitalWrite(PINO_RELE_COMPRESSOR, HIGH);
-  pinMode(ENTRADA_CAIXA_CHEIA, INPUT_PULLUP);
   pinMode(LED_STATUS, OUTPUT);
   digitalWrite(LED_STATUS, LOW);
 
-  preferences.begin("compressor", false);
-  carregarConfiguracoesOperacao();
-
-  if (sensorEnabled) { sensors.begin(); }
-
-  if (!conectarWiFi()) {
-    iniciarModoAutonomo();
+  if (!SPIFFS.begin(true)) {
+    Serial.println("Ocorreu um erro ao montar o SPIFFS");
   } else {
-    configurarRotasWebNormais();
-    server.begin();
-    Serial.println(F("✅ Conectado à rede do cliente. Servidor HTTP iniciado."));
-    if (MDNS.begin("compressor")) {
-      Serial.println(F("✅ Servidor mDNS iniciado. Acesse em http://compressor.local"));
+    if (servidorArquivos.iniciar(SPIFFS)) {
+      Serial.printf("✅ %d arquivos do painel (%u bytes em RAM).\n", servidorArquivos.arquivos(), (unsigned)servidorArquivos.bytesEmCache());
     } else {
-      Serial.println(F("❌ Erro ao iniciar mDNS."));
+      Serial.println(F("⚠️ Manifesto /assets.txt ausente: servindo o index.html sem compressão."));
+    }
+    if (!registroTelemetria.iniciar(SPIFFS)) {
+      Serial.println(F("❌ Erro ao abrir o registro de telemetria."));
     }
   }
 
-  ultimoTempoControle = millis();
-  Serial.println(F("✅ Sistema pronto."));
+  gerenciadorWiFi.iniciar(preferences, millis());
+  snprintf(identificadorDispositivo, sizeof(identificadorDispositivo), "compressor-%06lx",
+           (unsigned long)(ESP.getEfuseMac() & 0xFFFFFFUL));
+  clienteMqtt.iniciar(preferences, identificadorDispositivo, sizeof(bufferJson));
+  // A chave das sessões é sorteada com o rádio já ligado: é ele que alimenta o esp_random.
+  uint8_t chaveSessoes[GerenciadorSessoes::TAMANHO_CHAVE];
+  esp_fill_random(chaveSessoes, sizeof(chaveSessoes));
+  sessoes.iniciar(preferences, chaveSessoes);
+  carregarLimiteClientes();
+  configurarRotas();
+  server.begin();
+
+  Serial.printf("✅ Sistema pronto. Controle ativo %lu us após o boot; setup em %lu ms.\n",
+                lerEstatisticasTarefa().primeiroCicloUs, millis());
 }
 
 // ==================== LOOP PRINCIPAL ====================
 void loop() {
-  if (WiFi.getMode() == WIFI_AP) { dnsServer.processNextRequest(); }
-  else { gerenciarConexaoWiFi(); }
+  unsigned long inicioLoop = micros();
+  uint32_t inicioCiclos = lerCiclos();
+  tratarEventoWiFi(gerenciadorWiFi.atualizar(millis()));
+  uint32_t marca = perfilador.registrar(ETAPA_WIFI, inicioCiclos);
   server.handleClient();
-  atualizarSensores();
-  registrarTemperatura();
-  if (!modoManual) { controleAutomatico(); }
-  if (WiFi.getMode() == WIFI_AP) { digitalWrite(LED_STATUS, (millis() / 500) % 2); }
+  marca = perfilador.registrar(ETAPA_HTTP, marca);
+  lerEstadoControle(retratoLoop);
+  const EstadoControle& estado = retratoLoop;
+  salvarConfiguracoesOperacao(preferences, estado, millis());
+  marca = perfilador.registrar(ETAPA_PERSISTENCIA, marca);
+  registrarTemperatura(estado.canais[0].temperaturaAtual);
+  marca = perfilador.registrar(ETAPA_GRAFICO, marca);
+  registrarTelemetria(estado);
+  marca = perfilador.registrar(ETAPA_TELEMETRIA, marca);
+  publicarEventos(estado);
+  marca = perfilador.registrar(ETAPA_EVENTOS, marca);
+  publicarMqtt(estado);
+  marca = perfilador.registrar(ETAPA_MQTT, marca);
+  registroEventos.descarregar();
+  rastroCompressor.descarregar();
+  perfilador.registrar(ETAPA_LOG, marca);
+  amostrarRecursos();
+  if (gerenciadorWiFi.apAtivo()) { digitalWrite(LED_STATUS, (millis() / 500) % 2); }
   else {
-    if (WiFi.status() != WL_CONNECTED) { digitalWrite(LED_STATUS, (millis() / 200) % 2); }
-    else { digitalWrite(LED_STATUS, compressorLigado ? HIGH : LOW); }
+    if (!gerenciadorWiFi.conectado()) { digitalWrite(LED_STATUS, (millis() / 200) % 2); }
+    else {
+      bool algumLigado = false;
+      for (int i = 0; i < NUM_CANAIS; i++) algumLigado |= estado.canais[i].compressorLigado();
+      digitalWrite(LED_STATUS, algumLigado ? HIGH : LOW);
+    }
   }
+  latenciaLoopUs = micros() - inicioLoop;
+  if (latenciaLoopUs > latenciaMaximaLoopUs) { latenciaMaximaLoopUs = latenciaLoopUs; }
+  perfilador.registrar(ETAPA_LOOP, inicioCiclos);
   vTaskDelay(10 / portTICK_PERIOD_MS);
 }
 
-// ==================== LÓGICA DE CONTROLE DO RELÉ ====================
-void ligarCompressor() {
-  if (!compressorLigado && !caixaCheia) {
-    digitalWrite(PINO_RELE_COMPRESSOR, LOW);
-    compressorLigado = true;
-    inicioCicloMillis = millis();
-    if (inicioCicloEnchimentoMillis == 0 && !caixaCheia) {
-      inicioCicloEnchimentoMillis = millis();
-      ciclosParciaisNesteEnchimento = 0;
-      Serial.println(F("💧 Iniciando novo ciclo de enchimento (disparo por compressor)."));
+// ==================== RESPOSTAS EM PEDAÇOS ====================
+// Acumula o texto da resposta e envia em pedaços pelo chunked encoding,
+// para respostas maiores que o bufferJson.
+struct SaidaFragmentada {
+  char buffer[512];
+  size_t usado = 0;
+};
+
+static void esvaziarSaida(SaidaFragmentada& saida) {
+  if (saida.usado == 0) return;
+  server.sendContent(saida.buffer, saida.usado);
+  saida.usado = 0;
+}
+
+static void escreverSaida(SaidaFragmentada& saida, const char* formato, ...) {
+  if (sizeof(saida.buffer) - saida.usado < 128) esvaziarSaida(saida);
+  va_list args;
+  va_start(args, formato);
+  int n = vsnprintf(saida.buffer + saida.usado, sizeof(saida.buffer) - saida.usado, formato, args);
+  va_end(args);
+  if (n > 0) saida.usado += min((size_t)n, sizeof(saida.buffer) - saida.usado - 1);
+}
+
+static void iniciarSaida(const char* tipo) {
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, tipo, "");
+}
+
+static void encerrarSaida(SaidaFragmentada& saida) {
+  esvaziarSaida(saida);
+  server.sendContent("");
+}
+
+// ==================== MÉTRICAS ====================
+void amostrarRecursos() {
+  unsigned long agora = millis();
+  if (agora - ultimaAmostraRecursos < INTERVALO_RECURSOS && ultimaAmostraRecursos != 0) return;
+  ultimaAmostraRecursos = agora;
+  heapLivre = ESP.getFreeHeap();
+  heapLivreMinimo = ESP.getMinFreeHeap();
+  maiorBlocoLivre = ESP.getMaxAllocHeap();
+  if (maiorBlocoLivre < maiorBlocoLivreMinimo) maiorBlocoLivreMinimo = maiorBlocoLivre;
+  pilhaLoopLivreMinima = uxTaskGetStackHighWaterMark(nullptr);
+}
+
+static void escreverMetrica(SaidaFragmentada& saida, const char* nome, const char* tipo, const char* ajuda) {
+  escreverSaida(saida, "# HELP %s %s\n# TYPE %s %s\n", nome, ajuda, nome, tipo);
+}
+
+// GET /metrics — formato de exposição de texto do Prometheus (0.0.4).
+// Durações em segundos; os histogramas usam as faixas fixas do Perfilador.
+void handleMetrics() {
+  SaidaFragmentada saida;
+  iniciarSaida("text/plain; version=0.0.4");
+  const double segundosPorCiclo = 1.0 / (perfilador.ciclosPorUs() * 1e6);
+
+  escreverMetrica(saida, "compressor_etapa_duracao_segundos", "histogram", "Duracao de cada etapa do loop e da tarefa de controle.");
+  for (int e = 0; e < NUM_ETAPAS; e++) {
+    const Perfilador::Histograma& h = perfilador.histograma((EtapaPerfil)e);
+    const char* nome = Perfilador::NOMES_ETAPAS[e];
+    unsigned long acumulado = 0;
+    for (int f = 0; f < Perfilador::NUM_FAIXAS; f++) {
+      acumulado += h.contagem[f];
+      escreverSaida(saida, "compressor_etapa_duracao_segundos_bucket{etapa=\"%s\",le=\"%g\"} %lu\n",
+                    nome, Perfilador::LIMITES_US[f] / 1e6, acumulado);
     }
-    ciclosParciaisNesteEnchimento++;
-    ciclosParciaisOperacao++;
-    Serial.printf("⚡️ Ciclo parcial #%u iniciado. Total de ciclos: %lu\n", ciclosParciaisNesteEnchimento, ciclosParciaisOperacao);
-    Serial.println(F("🟢 COMPRESSOR LIGADO"));
+    acumulado += h.contagem[Perfilador::NUM_FAIXAS];
+    escreverSaida(saida, "compressor_etapa_duracao_segundos_bucket{etapa=\"%s\",le=\"+Inf\"} %lu\n", nome, acumulado);
+    escreverSaida(saida, "compressor_etapa_duracao_segundos_sum{etapa=\"%s\"} %.6f\n", nome, h.somaCiclos * segundosPorCiclo);
+    escreverSaida(saida, "compressor_etapa_duracao_segundos_count{etapa=\"%s\"} %lu\n", nome, acumulado);
   }
-}
-void desligarCompressor() {
-  if (compressorLigado) {
-    digitalWrite(PINO_RELE_COMPRESSOR, HIGH);
-    compressorLigado = false;
-    inicioCicloMillis = 0;
-    Serial.println(F("🔴 COMPRESSOR DESLIGADO"));
+  escreverMetrica(saida, "compressor_etapa_duracao_maxima_segundos", "gauge", "Pior duracao de cada etapa desde o boot.");
+  for (int e = 0; e < NUM_ETAPAS; e++) {
+    escreverSaida(saida, "compressor_etapa_duracao_maxima_segundos{etapa=\"%s\"} %.6f\n",
+                  Perfilador::NOMES_ETAPAS[e], perfilador.histograma((EtapaPerfil)e).maximoCiclos * segundosPorCiclo);
+  }
+
+  EstatisticasTarefa tarefa = lerEstatisticasTarefa();
+  escreverMetrica(saida, "compressor_heap_livre_bytes", "gauge", "Heap livre agora.");
+  escreverSaida(saida, "compressor_heap_livre_bytes %lu\n", (unsigned long)heapLivre);
+  escreverMetrica(saida, "compressor_heap_livre_minimo_bytes", "gauge", "Menor heap livre desde o boot.");
+  escreverSaida(saida, "compressor_heap_livre_minimo_bytes %lu\n", (unsigned long)heapLivreMinimo);
+  escreverMetrica(saida, "compressor_heap_maior_bloco_bytes", "gauge", "Maior bloco livre agora (fragmentacao).");
+  escreverSaida(saida, "compressor_heap_maior_bloco_bytes %lu\n", (unsigned long)maiorBlocoLivre);
+  escreverMetrica(saida, "compressor_heap_maior_bloco_minimo_bytes", "gauge", "Menor valor do maior bloco livre desde o boot.");
+  escreverSaida(saida, "compressor_heap_maior_bloco_minimo_bytes %lu\n",
+                (unsigned long)(maiorBlocoLivreMinimo == UINT32_MAX ? 0 : maiorBlocoLivreMinimo));
+  escreverMetrica(saida, "compressor_pilha_livre_minima_bytes", "gauge", "Marca d'agua da pilha de cada tarefa.");
+  escreverSaida(saida, "compressor_pilha_livre_minima_bytes{tarefa=\"loop\"} %lu\n", (unsigned long)pilhaLoopLivreMinima);
+  escreverSaida(saida, "compressor_pilha_livre_minima_bytes{tarefa=\"controle\"} %lu\n", tarefa.pilhaLivreMinimaBytes);
+  escreverMetrica(saida, "compressor_controle_ciclos_atrasados_total", "counter", "Ciclos de controle mais longos que o periodo.");
+  escreverSaida(saida, "compressor_controle_ciclos_atrasados_total %lu\n", tarefa.ciclosAtrasados);
+
+  // Uma série por canal, com o rótulo canal="N".
+  lerEstadoControle(retratoHttp);
+  const EstadoControle& estado = retratoHttp;
+  escreverMetrica(saida, "compressor_ciclos_parciais_total", "counter", "Partidas do compressor (ciclosParciaisOperacao).");
+  for (int i = 0; i < NUM_CANAIS; i++) {
+    escreverSaida(saida, "compressor_ciclos_parciais_total{canal=\"%d\"} %lu\n", i, estado.dados.canais[i].ciclosParciaisOperacao);
+  }
+  escreverMetrica(saida, "compressor_enchimentos_completos_total", "counter", "Enchimentos completos da caixa (ciclosEnchimentoCompletos).");
+  for (int i = 0; i < NUM_CANAIS; i++) {
+    escreverSaida(saida, "compressor_enchimentos_completos_total{canal=\"%d\"} %lu\n", i, estado.dados.canais[i].ciclosEnchimentoCompletos);
   }
+  escreverMetrica(saida, "compressor_rele_ligado_segundos_total", "counter", "Tempo com o rele do compressor fechado desde o boot.");
+  for (int i = 0; i < NUM_CANAIS; i++) {
+    escreverSaida(saida, "compressor_rele_ligado_segundos_total{canal=\"%d\"} %.3f\n", i, estado.canais[i].tempoLigadoTotalMs / 1000.0);
+  }
+  escreverMetrica(saida, "compressor_ligado", "gauge", "1 com o compressor ligado.");
+  for (int i = 0; i < NUM_CANAIS; i++) {
+    escreverSaida(saida, "compressor_ligado{canal=\"%d\"} %d\n", i, estado.canais[i].compressorLigado() ? 1 : 0);
+  }
+  escreverMetrica(saida, "compressor_paradas_termicas_preditivas_total", "counter", "Paradas antes do limite previstas pelo estimador termico.");
+  for (int i = 0; i < NUM_CANAIS; i++) {
+    escreverSaida(saida, "compressor_paradas_termicas_preditivas_total{canal=\"%d\"} %lu\n", i, estado.canais[i].paradasTermicasPreditivas);
+  }
+  escreverMetrica(saida, "compressor_desligamentos_emergencia_total", "counter", "Desligamentos por atingir a temperatura maxima.");
+  for (int i = 0; i < NUM_CANAIS; i++) {
+    escreverSaida(saida, "compressor_desligamentos_emergencia_total{canal=\"%d\"} %lu\n", i, estado.canais[i].desligamentosEmergencia);
+  }
+  escreverMetrica(saida, "compressor_temperatura_celsius", "gauge", "Temperatura atual do compressor.");
+  for (int i = 0; i < NUM_CANAIS; i++) {
+    escreverSaida(saida, "compressor_temperatura_celsius{canal=\"%d\"} %.2f\n", i, estado.canais[i].temperaturaAtual);
+  }
+  escreverMetrica(saida, "compressor_corrente_amperes", "gauge", "Corrente eficaz do compressor (0 sem TC).");
+  for (int i = 0; i < NUM_CANAIS; i++) {
+    escreverSaida(saida, "compressor_corrente_amperes{canal=\"%d\"} %.2f\n", i, estado.canais[i].correnteA);
+  }
+  escreverMetrica(saida, "compressor_energia_wh_total", "counter", "Energia estimada desde o boot (tensao nominal e fator de potencia fixo).");
+  for (int i = 0; i < NUM_CANAIS; i++) {
+    escreverSaida(saida, "compressor_energia_wh_total{canal=\"%d\"} %.3f\n", i, estado.canais[i].energiaTotalWh);
+  }
+  escreverMetrica(saida, "compressor_desligamentos_corrente_total", "counter", "Desligamentos por falha de corrente (sem corrente, rotor bloqueado, a seco).");
+  for (int i = 0; i < NUM_CANAIS; i++) {
+    escreverSaida(saida, "compressor_desligamentos_corrente_total{canal=\"%d\"} %lu\n", i, estado.canais[i].desligamentosCorrente);
+  }
+  escreverMetrica(saida, "compressor_boia_bordas_total", "counter", "Bordas da boia recebidas pela interrupcao.");
+  for (int i = 0; i < NUM_CANAIS; i++) {
+    escreverSaida(saida, "compressor_boia_bordas_total{canal=\"%d\"} %lu\n", i, (unsigned long)estado.canais[i].boia.bordas);
+  }
+  escreverMetrica(saida, "compressor_boia_descartes_total", "counter", "Pulsos da boia descartados pelo filtro.");
+  for (int i = 0; i < NUM_CANAIS; i++) {
+    escreverSaida(saida, "compressor_boia_descartes_total{canal=\"%d\",motivo=\"glitch\"} %lu\n", i, (unsigned long)estado.canais[i].boia.glitches);
+    escreverSaida(saida, "compressor_boia_descartes_total{canal=\"%d\",motivo=\"trepidacao\"} %lu\n", i, (unsigned long)estado.canais[i].boia.trepidacoes);
+  }
+  escreverMetrica(saida, "compressor_boia_bordas_perdidas_total", "counter", "Bordas da boia perdidas e recuperadas pelo nivel lido.");
+  for (int i = 0; i < NUM_CANAIS; i++) {
+    escreverSaida(saida, "compressor_boia_bordas_perdidas_total{canal=\"%d\"} %lu\n", i, (unsigned long)estado.canais[i].boia.perdidas);
+  }
+
+  escreverMetrica(saida, "compressor_log_registros_total", "counter", "Eventos registrados no log diferido.");
+  escreverSaida(saida, "compressor_log_registros_total %lu\n", (unsigned long)registroEventos.registrados());
+  escreverMetrica(saida, "compressor_log_descartados_total", "counter", "Eventos perdidos com a fila do log cheia.");
+  escreverSaida(saida, "compressor_log_descartados_total %lu\n", (unsigned long)registroEventos.descartados());
+  escreverMetrica(saida, "compressor_rastro_registros_total", "counter", "Eventos da maquina de estados gravados no rastro.");
+  escreverSaida(saida, "compressor_rastro_registros_total %lu\n", (unsigned long)rastroCompressor.registrados());
+  escreverMetrica(saida, "compressor_rastro_descartados_total", "counter", "Eventos perdidos com a fila do rastro cheia.");
+  escreverSaida(saida, "compressor_rastro_descartados_total %lu\n", (unsigned long)rastroCompressor.descartados());
+  escreverMetrica(saida, "compressor_sessoes_emitidas_total", "counter", "Cookies de sessao emitidos (login ou Basic).");
+  escreverSaida(saida, "compressor_sessoes_emitidas_total %lu\n", sessoes.sessoesEmitidas());
+  escreverMetrica(saida, "compressor_senhas_recusadas_total", "counter", "Conferencias de usuario e senha recusadas.");
+  escreverSaida(saida, "compressor_senhas_recusadas_total %lu\n", sessoes.senhasRecusadas());
+  escreverMetrica(saida, "compressor_senhas_derivadas_total", "counter", "Conferencias de senha pelo PBKDF2 (as lentas).");
+  escreverSaida(saida, "compressor_senhas_derivadas_total %lu\n", sessoes.conferenciasLentas());
+  escreverMetrica(saida, "compressor_http_aceitas_total", "counter", "Requisicoes dentro do limite por cliente.");
+  escreverSaida(saida, "compressor_http_aceitas_total %lu\n", limitadorClientes.aceitas());
+  escreverMetrica(saida, "compressor_http_limitadas_total", "counter", "Requisicoes recusadas com 429 pelo limite por cliente.");
+  escreverSaida(saida, "compressor_http_limitadas_total %lu\n", limitadorClientes.recusadas());
+  escreverMetrica(saida, "compressor_http_clientes_acompanhados", "gauge", "Enderecos na tabela do limite por cliente.");
+  escreverSaida(saida, "compressor_http_clientes_acompanhados %d\n", limitadorClientes.acompanhados());
+  const TriagemHttp& triagem = server.triagem();
+  escreverMetrica(saida, "compressor_http_triagem_vencidas_total", "counter", "Conexoes fechadas sem completar a requisicao no prazo.");
+  escreverSaida(saida, "compressor_http_triagem_vencidas_total %lu\n", triagem.vencidas());
+  escreverMetrica(saida, "compressor_http_triagem_despejadas_total", "counter", "Conexoes incompletas fechadas para dar vaga a uma nova.");
+  escreverSaida(saida, "compressor_http_triagem_despejadas_total %lu\n", triagem.despejadas());
+  escreverMetrica(saida, "compressor_http_triagem_pendentes", "gauge", "Conexoes esperando a requisicao inteira.");
+  escreverSaida(saida, "compressor_http_triagem_pendentes %d\n", triagem.pendentes());
+  escreverMetrica(saida, "compressor_sse_clientes", "gauge", "Paineis conectados em /eventos.");
+  escreverSaida(saida, "compressor_sse_clientes %d\n", canalEventos.clientes());
+  escreverMetrica(saida, "compressor_sse_recusados_total", "counter", "Conexoes em /eventos recusadas sem vaga.");
+  escreverSaida(saida, "compressor_sse_recusados_total %lu\n", canalEventos.recusados());
+  escreverMetrica(saida, "compressor_sse_descartados_total", "counter", "Paineis descartados por nao receberem o evento no prazo.");
+  escreverSaida(saida, "compressor_sse_descartados_total %lu\n", canalEventos.descartados());
+
+  escreverMetrica(saida, "compressor_mqtt_conectado", "gauge", "1 com o cliente MQTT conectado ao broker.");
+  escreverSaida(saida, "compressor_mqtt_conectado %d\n", clienteMqtt.conectado() ? 1 : 0);
+  escreverMetrica(saida, "compressor_mqtt_conexoes_total", "counter", "Conexoes ao broker MQTT desde o boot.");
+  escreverSaida(saida, "compressor_mqtt_conexoes_total %lu\n", clienteMqtt.conexoes());
+  escreverMetrica(saida, "compressor_mqtt_mensagens_total", "counter", "Mensagens MQTT publicadas.");
+  escreverSaida(saida, "compressor_mqtt_mensagens_total %lu\n", clienteMqtt.mensagensEnviadas());
+  escreverMetrica(saida, "compressor_mqtt_bytes_total", "counter", "Bytes MQTT publicados (sem TCP/IP).");
+  escreverSaida(saida, "compressor_mqtt_bytes_total %lu\n", clienteMqtt.bytesEnviados());
+  escreverMetrica(saida, "compressor_mqtt_comandos_total", "counter", "Comandos recebidos por MQTT.");
+  escreverSaida(saida, "compressor_mqtt_comandos_total %lu\n", clienteMqtt.comandosRecebidos());
+  escreverMetrica(saida, "compressor_mqtt_amostras_total", "counter", "Amostras de telemetria geradas para o MQTT.");
+  escreverSaida(saida, "compressor_mqtt_amostras_total %lu\n", publicadorMqtt.amostras());
+  escreverMetrica(saida, "compressor_mqtt_amostras_descartadas_total", "counter", "Amostras perdidas com a fila offline cheia.");
+  escreverSaida(saida, "compressor_mqtt_amostras_descartadas_total %lu\n", publicadorMqtt.amostrasDescartadas());
+  escreverMetrica(saida, "compressor_mqtt_lotes_na_fila", "gauge", "Lotes de telemetria esperando conexao.");
+  escreverSaida(saida, "compressor_mqtt_lotes_na_fila %d\n", publicadorMqtt.lotesNaFila());
+
+  EstatisticasPersistencia nvs = lerEstatisticasPersistencia();
+  escreverMetrica(saida, "compressor_nvs_gravacoes_total", "counter", "Gravacoes do retrato no NVS.");
+  escreverSaida(saida, "compressor_nvs_gravacoes_total %lu\n", (unsigned long)nvs.gravacoes);
+  escreverMetrica(saida, "compressor_nvs_bytes_gravados_total", "counter", "Bytes gravados no NVS.");
+  escreverSaida(saida, "compressor_nvs_bytes_gravados_total %lu\n", (unsigned long)nvs.bytesGravados);
+  escreverMetrica(saida, "compressor_uptime_segundos", "gauge", "Tempo desde o boot.");
+  escreverSaida(saida, "compressor_uptime_segundos %.3f\n", esp_timer_get_time() / 1e6);
+  encerrarSaida(saida);
 }
 
 // ==================== LÓGICA DO GRÁFICO ====================
-void registrarTemperatura() {
+void registrarTemperatura(float temperaturaAtual) {
   unsigned long agora = millis();
   if (agora - ultimaLeituraGrafico >= INTERVALO_GRAFICO) {
     ultimaLeituraGrafico = agora;
-    historicoTemp[indiceHistorico] = temperaturaAtual;
-    indiceHistorico = (indiceHistorico + 1) % 24;
-    Serial.println("📊 Temperatura registrada para o gráfico.");
+    serieTemperatura.registrar(temperaturaAtual, agora);
   }
 }
+
+static void enviarPedacoJson(const char* dados, size_t tamanho, void*) { server.sendContent(dados, tamanho); }
+
+// GET /tempdata?range=<segundos>&resolution=<segundos>
+// Sem parâmetros: últimas 24 h na resolução de 1 h, como o gráfico original.
 void handleTempData() {
-  String labels = "[";
-  String dados = "[";
-  int leiturasValidas = 0;
-  for (int i = 0; i < 24; i++) {
-    int index = (indiceHistorico + i) % 24;
-    if (historicoTemp[index] > -999) {
-      if (leiturasValidas > 0) { labels += ","; dados += ","; }
-      labels += "\"-" + String(23 - i) + "h\"";
-      dados += String(historicoTemp[index], 1);
-      leiturasValidas++;
-    }
-  }
-  labels += "]";
-  dados += "]";
-  String json = "{\"labels\":" + labels + ",\"dados\":" + dados + "}";
-  server.send(200, "application/json", json);
+  uint32_t intervalo = server.hasArg("range") ? strtoul(server.arg("range").c_str(), nullptr, 10) : 86400UL;
+  uint32_t resolucao = server.hasArg("resolution") ? strtoul(server.arg("resolution").c_str(), nullptr, 10) : 0;
+  int nivel = SerieTemporal::escolherNivel(resolucao, intervalo, MAX_PONTOS_GRAFICO);
+
+  // Até MAX_PONTOS_GRAFICO baldes em quatro listas: passa do bufferJson, que vai em pedaços.
+  EscritorJson json(bufferJson, sizeof(bufferJson), enviarPedacoJson, nullptr);
+  iniciarSaida("application/json");
+  escreverSerieTemperatura(json, serieTemperatura, nivel, intervalo);
+  json.esvaziar();
+  server.sendContent("");
 }
 
-// ==================== LÓGICA DE REDE ====================
-void gerenciarConexaoWiFi() {
-  if (millis() - ultimoCheckWiFi > intervaloCheckWiFi) {
-    ultimoCheckWiFi = millis();
-    if (WiFi.status() != WL_CONNECTED) {
-      Serial.println("❌ Conexão WiFi perdida. Tentando reconectar...");
-      tentativasReconexao++;
-      if (tentativasReconexao > maxTentativasReconexao) {
-        Serial.println("‼️ Falha ao reconectar. Reiniciando o sistema...");
-        delay(1000);
-        ESP.restart();
-      }
-      WiFi.disconnect();
-      WiFi.reconnect();
-    } else {
-      if (tentativasReconexao > 0) {
-        Serial.println("✅ Conexão WiFi restabelecida!");
-        tentativasReconexao = 0;
-      }
-    }
-  }
+// ==================== TELEMETRIA ====================
+// Epoch se o NTP já sincronizou, senão segundos desde o boot.
+static uint32_t instanteAmostra(unsigned long agora, bool& sincronizado) {
+  time_t epoch = time(nullptr);
+  sincronizado = epoch >= EPOCH_MINIMO_VALIDO;
+  return sincronizado ? (uint32_t)epoch : agora / 1000UL;
 }
-bool conectarWiFi() {
-  String ssid = preferences.getString("wifi_ssid", "");
-  if (ssid.length() == 0) return false;
-  WiFi.mode(WIFI_STA);
-  WiFi.begin(ssid.c_str(), preferences.getString("wifi_pass", "").c_str());
-  Serial.print(F("📡 Conectando à rede do cliente: "));
-  Serial.print(ssid);
-  int tentativas = 0;
-  while (WiFi.status() != WL_CONNECTED && tentativas < 20) {
-    Serial.print(".");
-    delay(500);
-    tentativas++;
-  }
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.println(F("\n✅ Conectado!"));
-    Serial.print(F("   Endereço IP (DHCP): "));
-    Serial.println(WiFi.localIP());
-    return true;
-  } else {
-    Serial.println(F("\n❌ Falha ao conectar. Ativando modo autônomo."));
-    WiFi.disconnect();
-    return false;
-  }
+
+void registrarTelemetria(const EstadoControle& estado) {
+  unsigned long agora = millis();
+  bool sincronizado;
+  uint32_t instante = instanteAmostra(agora, sincronizado);
+  registroTelemetria.amostrar(estado, agora, instante, sincronizado);
+  registroTelemetria.descarregar(agora);
 }
-void iniciarModoAutonomo() {
-  Serial.println(F("🔧 Iniciando Modo Autônomo (Ponto de Acesso)."));
-  WiFi.softAP(apSsid, apPassword);
-  IPAddress apIP(192, 168, 4, 1);
-  WiFi.softAPConfig(apIP, apIP, IPAddress(255, 255, 255, 0));
-  dnsServer.start(53, "*", apIP);
-  server.on("/", HTTP_GET, handleConfigWiFi);
-  server.on("/configwifi", HTTP_GET, handleConfigWiFi);
-  server.on("/salvarwifi", HTTP_POST, handleSalvarWiFi);
-  server.onNotFound(handleConfigWiFi);
-  server.begin();
-  Serial.print(F("   Rede criada: "));
-  Serial.println(apSsid);
-  Serial.print(F("   Acesse http://"));
-  Serial.print(apIP);
-  Serial.println(F(" para configurar a rede WiFi."));
-}
-
-// ==================== PREFERENCES E SENSORES ====================
-void carregarConfiguracoesOperacao() {
-  tempoLigado = preferences.getULong("tempoLigado", tempoLigado);
-  tempoDescanso = preferences.getULong("tempoDescanso", tempoDescanso);
-  temperaturaMaxima = preferences.getFloat("tempMaxima", temperaturaMaxima);
-  ciclosParciaisOperacao = preferences.getULong("ciclosParc", 0);
-  ciclosEnchimentoCompletos = preferences.getULong("ciclosEnch", 0);
-  indiceHistoricoEnchimento = preferences.getInt("idxHEnch", 0);
-  size_t loaded = preferences.getBytes("hEnchimento", historicoEnchimento, sizeof(historicoEnchimento));
-  Serial.println(F("--- Carregando Histórico de Enchimento ---"));
-  if (loaded > 0) {
-    for (int i = 0; i < TAMANHO_HISTORICO_ENCHIMENTO; i++) {
-      Serial.printf("  Índice %d: Tempo=%lu s, Ciclos=%u\n", i, historicoEnchimento[i].tempo, historicoEnchimento[i].ciclosParciais);
-    }
+
+struct SaidaTelemetria {
+  SaidaFragmentada saida;
+  bool csv;
+};
+
+static bool escreverAmostra(const AmostraTelemetria& a, void* contexto) {
+  SaidaTelemetria& t = *static_cast<SaidaTelemetria*>(contexto);
+  if (!t.csv) {
+    if (sizeof(t.saida.buffer) - t.saida.usado < sizeof(a)) esvaziarSaida(t.saida);
+    memcpy(t.saida.buffer + t.saida.usado, &a, sizeof(a));
+    t.saida.usado += sizeof(a);
   } else {
-    Serial.println(F("  Nenhum histórico encontrado."));
-  }
-  Serial.println(F("------------------------------------------"));
-  Serial.println(F("🔁 Configurações de operação carregadas."));
-}
-void salvarConfiguracoesOperacao() {
-  unsigned long now = millis();
-  if (now - ultimoSaveMillis < SAVE_INTERVAL && ultimoSaveMillis != 0) return;
-  preferences.putULong("tempoLigado", tempoLigado);
-  preferences.putULong("tempoDescanso", tempoDescanso);
-  preferences.putFloat("tempMaxima", temperaturaMaxima);
-  preferences.putULong("ciclosParc", ciclosParciaisOperacao);
-  preferences.putULong("ciclosEnch", ciclosEnchimentoCompletos);
-  preferences.putInt("idxHEnch", indiceHistoricoEnchimento);
-  preferences.putBytes("hEnchimento", historicoEnchimento, sizeof(historicoEnchimento));
-  Serial.println(F("--- Salvando Histórico de Enchimento ---"));
-  for (int i = 0; i < TAMANHO_HISTORICO_ENCHIMENTO; i++) {
-    Serial.printf("  Índice %d: Tempo=%lu s, Ciclos=%u\n", i, historicoEnchimento[i].tempo, historicoEnchimento[i].ciclosParciais);
-  }
-  Serial.println(F("----------------------------------------"));
-  ultimoSaveMillis = now;
-  Serial.println(F("💾 Configurações de operação salvas."));
-}
-
-void atualizarSensores() {
-  if (sensorEnabled) {
-    sensors.requestTemperatures();
-    float t = sensors.getTempCByIndex(0);
-    if (t != DEVICE_DISCONNECTED_C) { temperaturaAtual = t; }
-    else {
-      desligarCompressor();
-      Serial.println(F("⚠️ ERRO DE SENSOR! Compressor desligado por segurança."));
-    }
-  }
-  bool caixaEstavaCheia = caixaCheia;
-  caixaCheia = !digitalRead(ENTRADA_CAIXA_CHEIA);
-  if (caixaEstavaCheia && !caixaCheia) {
-    inicioCicloEnchimentoMillis = millis();
-    ciclosParciaisNesteEnchimento = 0;
-    Serial.println(F("💧 Caixa vazia detectada. Cronômetro de enchimento INICIADO."));
-  }
-  if (!caixaEstavaCheia && caixaCheia && inicioCicloEnchimentoMillis > 0) {
-    unsigned long tempoTotalSecs = (millis() - inicioCicloEnchimentoMillis) / 1000UL;
-    historicoEnchimento[indiceHistoricoEnchimento].tempo = tempoTotalSecs;
-    historicoEnchimento[indiceHistoricoEnchimento].ciclosParciais = ciclosParciaisNesteEnchimento;
-    indiceHistoricoEnchimento = (indiceHistoricoEnchimento + 1) % TAMANHO_HISTORICO_ENCHIMENTO;
-    ciclosEnchimentoCompletos++;
-    Serial.printf("✅ Caixa Cheia! Tempo total: %lu s, em %u ciclos parciais.\n", tempoTotalSecs, ciclosParciaisNesteEnchimento);
-    Serial.println(F("⏰ Cronômetro de enchimento PARADO."));
-    salvarConfiguracoesOperacao();
-    inicioCicloEnchimentoMillis = 0;
-    if(!modoManual){
-      desligarCompressor();
-      ultimoTempoControle = millis();
-      Serial.println("⏰ Forçando ciclo de descanso completo.");
-    }
+    int centesimos = a.temperaturaCentesimos;
+    escreverSaida(t.saida, "%lu,%s%d.%02d,%d,%d,%d,%d,%lu,%lu,%d\n",
+                  (unsigned long)a.instante, centesimos < 0 ? "-" : "", abs(centesimos) / 100, abs(centesimos) % 100,
+                  (a.flags & AmostraTelemetria::FLAG_COMPRESSOR) != 0,
+                  (a.flags & AmostraTelemetria::FLAG_CAIXA_CHEIA) != 0,
+                  (a.flags & AmostraTelemetria::FLAG_MODO_MANUAL) != 0,
+                  (a.flags & AmostraTelemetria::FLAG_DESLIGADO_TEMPERATURA) != 0,
+                  (unsigned long)a.ciclosParciaisOperacao, (unsigned long)a.ciclosEnchimentoCompletos,
+                  (a.flags & AmostraTelemetria::FLAG_RELOGIO_SINCRONIZADO)!= 0);
   }
-  if (temperaturaAtual >= temperaturaMaxima && compressorLigado) {
-    Serial.printf("‼️ DESLIGAMENTO DE EMERGÊNCIA! Temp (%.1fC) >= Limite (%.1fC).\n", temperaturaAtual, temperaturaMaxima);
-    desligadoPorTemperaturaAlta = true;
-    desligarCompressor();
+  return server.client().connected();
+}
+
+// GET /telemetria?de=<instante>&ate=<instante>&formato=csv|bin
+// O formato bin é a sequência crua de AmostraTelemetria (16 bytes, little-endian).
+// Só o canal 0 é gravado (ver registro_telemetria.h); o X-Canal diz isso a quem consome.
+void handleTelemetria() {
+  uint32_t de = server.hasArg("de") ? strtoul(server.arg("de").c_str(), nullptr, 10) : 0;
+  uint32_t ate = server.hasArg("ate") ? strtoul(server.arg("ate").c_str(), nullptr, 10) : UINT32_MAX;
+  SaidaTelemetria t;
+  t.csv = server.arg("formato") != "bin";
+  server.sendHeader("X-Canal", "0");
+  iniciarSaida(t.csv ? "text/csv" : "application/octet-stream");
+  if (t.csv) {
+    escreverSaida(t.saida, "instante,temperatura,compressor,caixaCheia,modoManual,desligadoTemperatura,"
+                           "ciclosParciais,ciclosEnchimento,relogioSincronizado\n");
   }
-  if (caixaCheia && compressorLigado) { 
-    desligarCompressor(); 
+  registroTelemetria.percorrer(de, ate, escreverAmostra, &t);
+  encerrarSaida(t.saida);
+}
+
+// ==================== EXPORTAÇÃO ====================
+static bool enviarPedacoExportacao(const uint8_t* dados, size_t tamanho, void* contexto) {
+  SaidaFragmentada& saida = *static_cast<SaidaFragmentada*>(contexto);
+  while (tamanho > 0) {
+    if (saida.usado == sizeof(saida.buffer)) esvaziarSaida(saida);
+    size_t n = min(tamanho, sizeof(saida.buffer) - saida.usado);
+    memcpy(saida.buffer + saida.usado, dados, n);
+    saida.usado += n;
+    dados += n;
+    tamanho -= n;
   }
+  return server.client().connected();
 }
 
-void controleAutomatico() {
+// GET /exportar: parâmetros, contadores, telemetria e gráfico num arquivo binário
+// (formato_exportacao.h), para o tools/analisador_frota.cpp.
+void handleExportar() {
   unsigned long agora = millis();
-  bool condicoesSeguras = false;
-  if(desligadoPorTemperaturaAlta) {
-      if(temperaturaAtual < (temperaturaMaxima - 5.0)){
-          condicoesSeguras = true;
-          desligadoPorTemperaturaAlta = false;
-          Serial.println("🌡️ Temperatura baixou o suficiente. Sistema liberado para religar.");
-      }
-  } else { condicoesSeguras = (temperaturaAtual < temperaturaMaxima); }
-  if (caixaCheia) { condicoesSeguras = false; }
-  if (compressorLigado) {
-    if (agora - ultimoTempoControle >= tempoLigado) {
-      desligarCompressor();
-      ultimoTempoControle = agora;
-      salvarConfiguracoesOperacao();
+  InfoExportacao info;
+  info.identificador = identificadorDispositivo;
+  info.instante = instanteAmostra(agora, info.relogioSincronizado);
+  info.uptimeS = agora / 1000UL;
+  char disposicao[64];
+  snprintf(disposicao, sizeof(disposicao), "attachment; filename=\"%s.cpex\"", identificadorDispositivo);
+  server.sendHeader("Content-Disposition", disposicao);
+  SaidaFragmentada saida;
+  iniciarSaida("application/octet-stream");
+  lerEstadoControle(retratoHttp);
+  exportarHistorico(info, retratoHttp, registroTelemetria, serieTemperatura, enviarPedacoExportacao, &saida);
+  encerrarSaida(saida);
+}
+
+// ==================== MQTT ====================
+static bool estadoMqttAlterado(const EstadoControle& anterior, const EstadoControle& atual) {
+  for (int i = 0; i < NUM_CANAIS; i++) {
+    const EstadoCanal& a = anterior.canais[i];
+    const EstadoCanal& b = atual.canais[i];
+    const DadosCanal& da = anterior.dados.canais[i];
+    const DadosCanal& db = atual.dados.canais[i];
+    if (a.compressorLigado() != b.compressorLigado() || a.pausaTermica() != b.pausaTermica() || a.modoManual() != b.modoManual() ||
+        a.caixaCheia != b.caixaCheia || a.desligadoPorTemperaturaAlta() != b.desligadoPorTemperaturaAlta() ||
+        a.falhaCorrente() != b.falhaCorrente() || a.correnteSemRele != b.correnteSemRele ||
+        da.ciclosParciaisOperacao != db.ciclosParciaisOperacao || da.ciclosEnchimentoCompletos != db.ciclosEnchimentoCompletos) {
+      return true;
     }
+  }
+  return memcmp(&anterior.dados.parametros, &atual.dados.parametros, sizeof(ParametrosOperacao)) != 0;
+}
+
+// Sem servidor configurado nada é amostrado; com ele, a telemetria se acumula na
+// fila do publicador mesmo sem conexão e sai em ordem quando o broker volta.
+void publicarMqtt(const EstadoControle& estado) {
+  if (!clienteMqtt.configurado()) return;
+  unsigned long agora = millis();
+  bool sincronizado;
+  uint32_t instante = instanteAmostra(agora, sincronizado);
+  publicadorMqtt.amostrar(estado, agora, instante, sincronizado);
+  if (clienteMqtt.atualizar(agora, gerenciadorWiFi.conectado())) estadoMqttPendente = true;
+  publicadorMqtt.descarregar(ClienteMqtt::publicarLote, &clienteMqtt, agora);
+
+  if (estadoMqttAlterado(ultimoEstadoMqtt, estado)) {
+    ultimoEstadoMqtt = estado;
+    estadoMqttPendente = true;
+  }
+  if (!estadoMqttPendente || !clienteMqtt.conectado() || agora - ultimoEstadoMqttMillis < INTERVALO_MINIMO_ESTADO_MQTT) return;
+  EscritorJson json(bufferJson, sizeof(bufferJson));
+  escreverStatus(json, estado, CAMPOS_TODOS & ~CAMPO_DIAGNOSTICO, diagnosticoLoop());
+  if (json.estourou() || !clienteMqtt.publicarEstado(json.texto(), json.tamanho())) return;
+  estadoMqttPendente = false;
+  ultimoEstadoMqttMillis = agora;
+}
+
+// POST /configmqtt: servidor, porta, usuario, senha, prefixo. Servidor vazio desliga o MQTT.
+void handleConfigMqtt() {
+  long porta = server.hasArg("porta") ? server.arg("porta").toInt() : ClienteMqtt::PORTA_PADRAO;
+  if (porta <= 0 || porta > 65535) { server.send(400, "text/plain", "❌ Porta inválida."); return; }
+  clienteMqtt.configurar(server.arg("servidor"), (uint16_t)porta, server.arg("usuario"), server.arg("senha"), server.arg("prefixo"));
+  if (!clienteMqtt.configurado()) { server.send(200, "text/plain", "✅ MQTT desligado."); return; }
+  server.send(200, "text/plain", "✅ MQTT configurado. Tópicos em " + clienteMqtt.prefixo() + "/");
+}
+
+// ==================== REGISTRO DE EVENTOS ====================
+// GET /log: os últimos eventos já formatados, um por linha, com o instante (s desde o boot).
+void handleLog() {
+  SaidaFragmentada saida;
+  iniciarSaida("text/plain");
+  registroEventos.percorrerHistorico([&saida](const RegistroLog& registro) {
+    char linha[192];
+    RegistroEventos::formatar(registro, linha, sizeof(linha));
+    escreverSaida(saida, "%lu.%03lu %s\n", (unsigned long)(registro.instanteMs / 1000UL),
+                  (unsigned long)(registro.instanteMs % 1000UL), linha);
+  });
+  encerrarSaida(saida);
+}
+
+// GET /rastro: as últimas transições da máquina de estados (rastro_compressor.h),
+// para reproduzir um incidente no simulador.
+void handleRastro() {
+  char disposicao[64];
+  snprintf(disposicao, sizeof(disposicao), "attachment; filename=\"%s.rastro\"", identificadorDispositivo);
+  server.sendHeader("Content-Disposition", disposicao);
+  SaidaFragmentada saida;
+  iniciarSaida("application/octet-stream");
+  rastroCompressor.exportar(enviarPedacoExportacao, &saida);
+  encerrarSaida(saida);
+}
+
+// ==================== LÓGICA DE REDE ====================
+void tratarEventoWiFi(GerenciadorWiFi::Evento evento) {
+  if (evento != GerenciadorWiFi::CONECTOU) return;
+  if (!relogioConfigurado) {
+    configTime(FUSO_HORARIO_SEGUNDOS, 0, "pool.ntp.org");
+    relogioConfigurado = true;
+  }
+  MDNS.end();
+  if (MDNS.begin("compressor")) {
+    Serial.println(F("✅ Servidor mDNS iniciado. Acesse em http://compressor.local"));
   } else {
-    if ((agora - ultimoTempoControle >= tempoDescanso) && condicoesSeguras) {
-      ligarCompressor();
-      ultimoTempoControle = agora;
-    }
+    Serial.println(F("❌ Erro ao iniciar mDNS."));
   }
 }
 
 // ==================== WEB SERVER - ROTAS E HANDLERS ====================
+// Antes de qualquer trabalho, inclusive autenticar: 429 para o endereço que passou do limite.
+bool barrarCliente(uint32_t custo) {
+  uint32_t esperaS = 0;
+  if (limitadorClientes.admitir((uint32_t)server.client().remoteIP(), millis(), custo, esperaS)) return false;
+  char espera[12];
+  snprintf(espera, sizeof(espera), "%lu", (unsigned long)esperaS);
+  server.sendHeader("Retry-After", espera);
+  server.send(429, "text/plain", "❌ Requisições demais; tente de novo em instantes.");
+  return true;
+}
+
+// O cookie de sessão vem primeiro: é o caminho do painel, que consulta o
+// tempo todo. O Basic fica para scripts, para o Prometheus e para o primeiro
+// acesso do navegador, que recebe o cookie junto com a resposta.
 bool autenticar() {
-  if (!server.authenticate(httpUser, httpPass)) {
-    server.requestAuthentication();
-    return true;
+  if (barrarCliente()) return true;
+  uint32_t marca = lerCiclos();
+  uint64_t agora = (uint64_t)esp_timer_get_time() / 1000ULL;
+  bool aceito = sessoes.conferirCookie(server.header("Cookie").c_str(), agora);
+  if (!aceito && sessoes.conferirBasic(server.header("Authorization").c_str())) {
+    aceito = true;
+    enviarCookieSessao(agora);
+  }
+  perfilador.registrar(ETAPA_AUTENTICACAO, marca);
+  if (!aceito) server.requestAuthentication();
+  return !aceito;
+}
+
+void enviarCookieSessao(uint64_t agoraMs) {
+  char token[GerenciadorSessoes::TAMANHO_TOKEN + 1];
+  sessoes.emitir(agoraMs, token);
+  char cookie[128];
+  snprintf(cookie, sizeof(cookie), "sessao=%s; Path=/; Max-Age=%lu; HttpOnly; SameSite=Strict", token,
+           (unsigned long)GerenciadorSessoes::VALIDADE_S);
+  server.sendHeader("Set-Cookie", cookie);
+}
+
+// POST /login (usuario, senha): a única conferência lenta; depois disso vale o cookie.
+void handleLogin() {
+  if (barrarCliente(limitadorClientes.custoLogin())) return;
+  if (!sessoes.conferirSenha(server.arg("usuario").c_str(), server.arg("senha").c_str())) {
+    server.send(401, "text/plain", "❌ Usuário ou senha incorretos.");
+    return;
+  }
+  enviarCookieSessao((uint64_t)esp_timer_get_time() / 1000ULL);
+  server.send(200, "text/plain", "✅ Sessão iniciada.");
+}
+
+void handleSair() {
+  server.sendHeader("Set-Cookie", "sessao=; Path=/; Max-Age=0; HttpOnly; SameSite=Strict");
+  server.send(200, "text/plain", "✅ Sessão encerrada.");
+}
+
+// POST /configacesso (usuario, senha, senhaatual): troca as credenciais e derruba as outras sessões.
+// A senha atual passa pela mesma conferência lenta do login e custa o mesmo ao limitador.
+void handleConfigAcesso() {
+  if (barrarCliente(limitadorClientes.custoLogin())) return;
+  if (!sessoes.conferirSenha(sessoes.usuario(), server.arg("senhaatual").c_str())) {
+    server.send(403, "text/plain", "❌ Senha atual incorreta.");
+    return;
   }
-  return false;
+  uint8_t aleatorio[GerenciadorSessoes::TAMANHO_CHAVE + GerenciadorSessoes::TAMANHO_SAL];
+  esp_fill_random(aleatorio, sizeof(aleatorio));
+  if (!sessoes.alterarCredenciais(server.arg("usuario").c_str(), server.arg("senha").c_str(), aleatorio)) {
+    server.send(400, "text/plain", "❌ Usuário (até 31 caracteres) ou senha (1 a 63) inválidos.");
+    return;
+  }
+  LOG_EVENTO(CREDENCIAIS_ALTERADAS, SEM_CANAL);
+  enviarCookieSessao((uint64_t)esp_timer_get_time() / 1000ULL);
+  server.send(200, "text/plain", "✅ Credenciais alteradas. As outras sessões foram encerradas.");
 }
 
-void configurarRotasWebNormais() {
-  server.on("/", HTTP_GET, []() { if (autenticar()) return; handleRoot(); });
+void carregarLimiteClientes() {
+  limitadorClientes.configurar(preferences.getULong("lim_taxa", LimitadorClientes::TAXA_PADRAO_POR_S),
+                               preferences.getULong("lim_rajada", LimitadorClientes::RAJADA_PADRAO),
+                               preferences.getULong("lim_login", LimitadorClientes::CUSTO_LOGIN_PADRAO));
+}
+
+// POST /configlimite (taxa, rajada, login): requisições por segundo e rajada por endereço e o custo do login.
+void handleConfigLimite() {
+  uint32_t taxa = server.hasArg("taxa") ? strtoul(server.arg("taxa").c_str(), nullptr, 10) : limitadorClientes.taxaPorS();
+  uint32_t rajada = server.hasArg("rajada") ? strtoul(server.arg("rajada").c_str(), nullptr, 10) : limitadorClientes.rajada();
+  uint32_t login = server.hasArg("login") ? strtoul(server.arg("login").c_str(), nullptr, 10) : limitadorClientes.custoLogin();
+  if (!limitadorClientes.configurar(taxa, rajada, login)) {
+    server.send(400, "text/plain", "❌ Taxa (1 a 1000/s), rajada (1 a 1000) ou custo do login (1 até a rajada) inválidos.");
+    return;
+  }
+  preferences.putULong("lim_taxa", taxa);
+  preferences.putULong("lim_rajada", rajada);
+  preferences.putULong("lim_login", login);
+  LOG_EVENTO(LIMITE_CLIENTES_ALTERADO, SEM_CANAL, taxa, rajada, login);
+  server.send(200, "text/plain", "✅ Limite por cliente alterado.");
+}
+
+// As rotas valem para os dois modos; com o ponto de acesso no ar, "/" e as
+// URLs desconhecidas levam à página de configuração (portal cativo).
+void configurarRotas() {
+  static const char* cabecalhosColetados[] = { "If-None-Match", "Cookie" };
+  server.collectHeaders(cabecalhosColetados, 2);
+  server.on("/", HTTP_GET, []() {
+    if (gerenciadorWiFi.apAtivo()) { handleConfigWiFi(); return; }
+    if (autenticar()) return;
+    handleRoot();
+  });
+  server.on("/login", HTTP_POST, handleLogin);
+  server.on("/sair", HTTP_POST, handleSair);
+  server.on("/configacesso", HTTP_POST, []() { if (autenticar()) return; handleConfigAcesso(); });
   server.on("/ligar", HTTP_GET, []() { if (autenticar()) return; handleLigar(); });
   server.on("/desligar", HTTP_GET, []() { if (autenticar()) return; handleDesligar(); });
   server.on("/automatico", HTTP_GET, []() { if (autenticar()) return; handleAutomatico(); });
   server.on("/status", HTTP_GET, []() { if (autenticar()) return; handleStatus(); });
+  server.on("/eventos", HTTP_GET, []() { if (autenticar()) return; handleEventos(); });
   server.on("/config", HTTP_POST, []() { if (autenticar()) return; handleConfig(); });
   server.on("/zerarciclos", HTTP_GET, []() { if (autenticar()) return; handleZerarCiclos(); });
   server.on("/configwifi", HTTP_GET, handleConfigWiFi);
+  server.on("/salvarwifi", HTTP_POST, []() {
+    if (!gerenciadorWiFi.apAtivo() && autenticar()) return;
+    handleSalvarWiFi();
+  });
   server.on("/tempdata", HTTP_GET, []() { if (autenticar()) return; handleTempData(); });
+  server.on("/telemetria", HTTP_GET, []() { if (autenticar()) return; handleTelemetria(); });
+  server.on("/metrics", HTTP_GET, []() { if (autenticar()) return; handleMetrics(); });
+  server.on("/log", HTTP_GET, []() { if (autenticar()) return; handleLog(); });
+  server.on("/rastro", HTTP_GET, []() { if (autenticar()) return; handleRastro(); });
+  server.on("/exportar", HTTP_GET, []() { if (autenticar()) return; handleExportar(); });
+  server.on("/configmqtt", HTTP_POST, []() { if (autenticar()) return; handleConfigMqtt(); });
+  server.on("/configlimite", HTTP_POST, []() { if (autenticar()) return; handleConfigLimite(); });
   server.onNotFound([]() { 
+    if (gerenciadorWiFi.apAtivo()) { handleConfigWiFi(); return; }
+    if (barrarCliente()) return;
+    if (servidorArquivos.servir(server, server.uri())) return;
+    if (servidorArquivos.servir(server, "/index.html")) return;
     File file = SPIFFS.open("/index.html", "r");
     if (file) {
       server.streamFile(file, "text/html");
@@ -422,6 +807,7 @@ void configurarRotasWebNormais() {
 }
 
 void handleRoot() {
+  if (servidorArquivos.servir(server, "/index.html")) return;
   File file = SPIFFS.open("/index.html", "r");
   if (!file) {
     server.send(404, "text/plain", "ERRO: index.html não encontrado no SPIFFS");
@@ -431,114 +817,115 @@ void handleRoot() {
   file.close();
 }
 
-void handleLigar() {
-  if (caixaCheia) { server.send(200, "text/plain", "❌ Ação bloqueada: A caixa de água já está cheia."); return; }
-  if (desligadoPorTemperaturaAlta) {
-    if (temperaturaAtual >= (temperaturaMaxima - 5.0)) { server.send(200, "text/plain", "❌ Ação bloqueada: Aguardando temperatura baixar para religar (cooldown)."); return; }
-  } else {
-    if (temperaturaAtual >= temperaturaMaxima) { server.send(200, "text/plain", "❌ Ação bloqueada: A temperatura está acima do limite permitido."); return; }
+// Envia o JSON direto do buffer, sem copiá-lo para uma String.
+void enviarJson(const EscritorJson& json) {
+  if (json.estourou()) {
+    server.send(500, "text/plain", "ERRO: resposta maior que o buffer JSON.");
+    return;
+  }
+  server.send_P(200, "application/json", json.texto(), json.tamanho());
+}
+
+// Canal do argumento "canal" (0 se ausente); -1, já respondido com 400, se inválido.
+int canalRequisitado() {
+  if (!server.hasArg("canal")) return 0;
+  int canal = interpretarCanal(server.arg("canal").c_str());
+  if (canal < 0) server.send(400, "text/plain", "❌ Canal inválido.");
+  return canal;
+}
+
+// Envia um comando à tarefa de controle; responde 503 se a fila estiver cheia.
+bool encaminharComando(TipoComando tipo, uint8_t canal) {
+  Comando comando;
+  comando.tipo = tipo;
+  comando.canal = canal;
+  if (!enviarComando(comando)) {
+    server.send(503, "text/plain", "❌ Controle ocupado, tente novamente.");
+    return false;
   }
-  modoManual = true;
-  ligarCompressor();
+  return true;
+}
+
+void handleLigar() {
+  int canal = canalRequisitado();
+  if (canal < 0) return;
+  lerEstadoControle(retratoHttp);
+  const char* bloqueio = bloqueioLigar(retratoHttp.canais[canal], retratoHttp.dados.parametros);
+  if (bloqueio) { server.send(200, "text/plain", bloqueio); return; }
+  if (!encaminharComando(COMANDO_LIGAR, canal)) return;
   server.send(200, "text/plain", "✅ Compressor ligado manualmente.");
 }
 
 void handleDesligar() { 
-  modoManual = true; 
-  desligarCompressor(); 
+  int canal = canalRequisitado();
+  if (canal < 0 || !encaminharComando(COMANDO_DESLIGAR, canal)) return;
   server.send(200, "text/plain", "OK"); 
 }
 
 void handleAutomatico() { 
-  modoManual = false; 
-  ultimoTempoControle = millis(); 
-  desligadoPorTemperaturaAlta = false; 
+  int canal = canalRequisitado();
+  if (canal < 0 || !encaminharComando(COMANDO_AUTOMATICO, canal)) return;
   server.send(200, "text/plain", "OK"); 
 }
 
+DiagnosticoLoop diagnosticoLoop() {
+  return { latenciaLoopUs, latenciaMaximaLoopUs, (unsigned long)pilhaLoopLivreMinima,
+           gerenciadorWiFi.duracaoUltimaConexaoMs(), gerenciadorWiFi.reconexoes() };
+}
+
 void handleStatus() {
-  unsigned long tempoRestante = 0;
-  String proximoEstado = "N/A";
-  if (!modoManual) {
-    unsigned long agora = millis();
-    unsigned long tempoDecorrido = agora - ultimoTempoControle;
-    if (compressorLigado) {
-      proximoEstado = "Desligar";
-      if (tempoDecorrido < tempoLigado) { tempoRestante = (tempoLigado - tempoDecorrido) / 1000UL; }
-    } else {
-      proximoEstado = "Ligar";
-      if (tempoDecorrido < tempoDescanso) { tempoRestante = (tempoDescanso - tempoDecorrido) / 1000UL; }
-    }
-  }
-  unsigned long somaTempos = 0;
-  int temposValidos = 0;
-  for (int i = 0; i < TAMANHO_HISTORICO_ENCHIMENTO; i++) {
-    if (historicoEnchimento[i].tempo > 0) {
-      somaTempos += historicoEnchimento[i].tempo;
-      temposValidos++;
-    }
-  }
-  unsigned long mediaEnchimento = (temposValidos > 0) ? (somaTempos / temposValidos) : 0;
-  String json = "{";
-  json += "\"compressorLigado\":" + String(compressorLigado ? "true" : "false") + ",";
-  json += "\"temperatura\":" + String(temperaturaAtual, 1) + ",";
-  json += "\"caixaCheia\":" + String(caixaCheia ? "true" : "false") + ",";
-  json += "\"modoManual\":" + String(modoManual ? "true" : "false") + ",";
-  json += "\"alertaTemperatura\":" + String((temperaturaAtual >= temperaturaMaxima) ? "true" : "false") + ",";
-  json += "\"alertaCaixaCheia\":" + String(caixaCheia ? "true" : "false") + ",";
-  json += "\"ciclosParciaisOperacao\":" + String(ciclosParciaisOperacao) + ",";
-  json += "\"ciclosEnchimentoCompletos\":" + String(ciclosEnchimentoCompletos) + ",";
-  json += "\"tempoLigado\":" + String(tempoLigado / 60000UL) + ",";
-  json += "\"tempoDescanso\":" + String(tempoDescanso / 60000UL) + ",";
-  json += "\"temperaturaMaxima\":" + String(temperaturaMaxima, 1) + ",";
-  json += "\"tempoRestante\":" + String(tempoRestante) + ",";
-  json += "\"proximoEstado\":\"" + proximoEstado + "\",";
-  json += "\"historicoEnchimento\":[";
-  for (int i = 0; i < TAMANHO_HISTORICO_ENCHIMENTO; i++) {
-    int index = (indiceHistoricoEnchimento - 1 - i + TAMANHO_HISTORICO_ENCHIMENTO) % TAMANHO_HISTORICO_ENCHIMENTO;
-    json += "{";
-    json += "\"tempo\":" + String(historicoEnchimento[index].tempo) + ",";
-    json += "\"ciclos\":" + String(historicoEnchimento[index].ciclosParciais);
-    json += "}";
-    if (i < TAMANHO_HISTORICO_ENCHIMENTO - 1) json += ",";
-  }
-  json += "],";
-  json += "\"mediaEnchimento\":" + String(mediaEnchimento);
-  json += "}";
-  server.send(200, "application/json", json);
+  EscritorJson json(bufferJson, sizeof(bufferJson));
+  lerEstadoControle(retratoHttp);
+  escreverStatus(json, retratoHttp, CAMPOS_TODOS, diagnosticoLoop());
+  enviarJson(json);
+}
+
+void handleEventos() {
+  lerEstadoControle(retratoHttp);
+  EscritorJson json(bufferJson, sizeof(bufferJson));
+  escreverStatus(json, retratoHttp, CAMPOS_TODOS & ~CAMPO_DIAGNOSTICO, diagnosticoLoop());
+  if (json.estourou()) { server.send(500, "text/plain", "ERRO: resposta maior que o buffer JSON."); return; }
+  canalEventos.aceitar(server, json.texto(), json.tamanho());
+}
+
+// Publica aos painéis conectados só o que mudou desde o último evento.
+void publicarEventos(const EstadoControle& estado) {
+  unsigned long agora = millis();
+  canalEventos.manter(agora);
+  if (agora - ultimoEventoMillis < INTERVALO_MINIMO_EVENTOS) return;
+  uint32_t campos = camposAlterados(ultimoEstadoPublicado, estado);
+  if (campos == 0) return;
+  ultimoEstadoPublicado = estado;
+  ultimoEventoMillis = agora;
+  if (canalEventos.clientes() == 0) return;
+  EscritorJson json(bufferJson, sizeof(bufferJson));
+  escreverStatus(json, estado, campos, diagnosticoLoop());
+  if (!json.estourou()) canalEventos.publicar(json.texto(), json.tamanho());
 }
 
 void handleConfig() {
+  Comando comando;
+  comando.tipo = COMANDO_CONFIGURAR;
+  lerEstadoControle(retratoHttp);
+  comando.parametros = retratoHttp.dados.parametros;
   bool changed = false;
-  if (server.hasArg("tempoligado")) {
-    unsigned long v = server.arg("tempoligado").toInt() * 60000UL;
-    if (v >= 60000UL) { tempoLigado = v; changed = true; }
-  }
-  if (server.hasArg("tempodescanso")) {
-    unsigned long v = server.arg("tempodescanso").toInt() * 60000UL;
-    if (v >= 1000UL) { tempoDescanso = v; changed = true; }
-  }
-  if (server.hasArg("temperaturamax")) {
-    float v = server.arg("temperaturamax").toFloat();
-    if (v > 0.0) { temperaturaMaxima = v; changed = true; }
+  for (int i = 0; i < server.args(); i++) {
+    changed |= aplicarParametro(comando.parametros, server.argName(i).c_str(), server.arg(i).c_str());
   }
-  if (changed) { salvarConfiguracoesOperacao(); server.send(200, "text/plain", "✅ Configurações salvas!"); }
-  else { server.send(200, "text/plain", "ℹ️ Nenhuma alteração válida."); }
+  if (!changed) { server.send(200, "text/plain", "ℹ️ Nenhuma alteração válida."); return; }
+  if (!enviarComando(comando)) { server.send(503, "text/plain", "❌ Controle ocupado, tente novamente."); return; }
+  server.send(200, "text/plain", "✅ Configurações salvas!");
 }
 
 void handleZerarCiclos() {
-  ciclosParciaisOperacao = 0;
-  ciclosEnchimentoCompletos = 0;
-  memset(historicoEnchimento, 0, sizeof(historicoEnchimento));
-  indiceHistoricoEnchimento = 0;
-  salvarConfiguracoesOperacao();
-  Serial.println("🔄 Contadores e histórico de enchimento zerados pelo usuário.");
+  int canal = canalRequisitado();
+  if (canal < 0 || !encaminharComando(COMANDO_ZERAR_CICLOS, canal)) return;
   server.send(200, "text/plain", "Todos os contadores e o histórico foram zerados!");
 }
 
 String paginaConfigWiFi() {
   String html = R"rawliteral(
-<!DOCTYPE html><html><head><title>Configurar WiFi</title><meta name="viewport" content="width=device-width, initial-scale=1.0"><style>body{font-family: Arial, sans-serif; background: #f4f4f4; margin: 0; padding: 20px;} .container{max-width: 500px; margin: auto; background: #fff; padding: 20px; border-radius: 8px; box-shadow: 0 0 10px rgba(0,0,0,0.1);} h1{text-align: center; color: #333;} label{display: block; margin-top: 15px; font-weight: bold;} input[type=text], input[type=password]{width: calc(100% - 22px); padding: 10px; border: 1px solid #ddd; border-radius: 4px;} button{background: #007bff; color: #fff; padding: 12px 20px; border: none; border-radius: 4px; cursor: pointer; width: 100%; font-size: 16px; margin-top: 20px;} button:hover{background: #0056b3;}</style></head><body><div class="container"><h1>Configurar Conexão WiFi</h1><p style="text-align:center;color:#666;">Use esta página para conectar o compressor à sua rede WiFi.</p><form action="/salvarwifi" method="POST"><label for="ssid">Nome da Rede (SSID):</label><input type="text" id="ssid" name="ssid" required><label for="pass">Senha da Rede:</label><input type="password" id="pass" name="pass"><button type="submit">Salvar e Reiniciar</button></form></div></body></html>)rawliteral";
+<!DOCTYPE html><html><head><title>Configurar WiFi</title><meta name="viewport" content="width=device-width, initial-scale=1.0"><style>body{font-family: Arial, sans-serif; background: #f4f4f4; margin: 0; padding: 20px;} .container{max-width: 500px; margin: auto; background: #fff; padding: 20px; border-radius: 8px; box-shadow: 0 0 10px rgba(0,0,0,0.1);} h1{text-align: center; color: #333;} label{display: block; margin-top: 15px; font-weight: bold;} input[type=text], input[type=password]{width: calc(100% - 22px); padding: 10px; border: 1px solid #ddd; border-radius: 4px;} button{background: #007bff; color: #fff; padding: 12px 20px; border: none; border-radius: 4px; cursor: pointer; width: 100%; font-size: 16px; margin-top: 20px;} button:hover{background: #0056b3;}</style></head><body><div class="container"><h1>Configurar Conexão WiFi</h1><p style="text-align:center;color:#666;">Use esta página para conectar o compressor à sua rede WiFi.</p><form action="/salvarwifi" method="POST"><label for="ssid">Nome da Rede (SSID):</label><input type="text" id="ssid" name="ssid" required><label for="pass">Senha da Rede:</label><input type="password" id="pass" name="pass"><button type="submit">Salvar e Conectar</button></form></div></body></html>)rawliteral";
   return html;
 }
 
@@ -551,8 +938,7 @@ void handleSalvarWiFi() {
   preferences.putString("wifi_ssid", server.arg("ssid"));
   preferences.putString("wifi_pass", server.arg("pass"));
   String html = R"rawliteral(
-<!DOCTYPE html><html><head><title>Configuração Salva</title><meta name="viewport" content="width=device-width, initial-scale=1.0"><style>body{font-family: Arial, sans-serif; text-align: center; padding: 50px;} .msg{font-size: 1.2em; color: #155724; background: #d4edda; padding: 20px; border-radius: 8px;}</style></head><body><div class="msg"><h1>Configurações Salvas!</h1><p>O dispositivo irá reiniciar em 5 segundos para tentar se conectar à nova rede.</p></div></body></html>)rawliteral";
+<!DOCTYPE html><html><head><title>Configuração Salva</title><meta name="viewport" content="width=device-width, initial-scale=1.0"><style>body{font-family: Arial, sans-serif; text-align: center; padding: 50px;} .msg{font-size: 1.2em; color: #155724; background: #d4edda; padding: 20px; border-radius: 8px;}</style></head><body><div class="msg"><h1>Configurações Salvas!</h1><p>O dispositivo está se conectando à nova rede, sem reiniciar. Se não conseguir, esta rede de configuração continua disponível.</p></div></body></html>)rawliteral";
   server.send(200, "text/html", html);
-  delay(5000);
-  ESP.restart();
+  gerenciadorWiFi.reconfigurar(millis());
 }
\ No newline at end of file
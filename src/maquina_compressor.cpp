@@ -0,0 +1,226 @@
+#include "maquina_compressor.h"
+
+// ==================== GUARDAS ====================
+static bool caixaCheia(const MaquinaCompressor&, const EventoCompressor& e) { return e.caixaCheia; }
+
+static bool descansoVencido(const MaquinaCompressor& m, const EventoCompressor& e) {
+  return e.instante - m.inicioTemporizador >= e.tempoDescansoMs;
+}
+
+// Religamento automático: descanso cumprido, abaixo do limite e caixa esperando água.
+static bool podeLigar(const MaquinaCompressor& m, const EventoCompressor& e) {
+  return descansoVencido(m, e) && e.temperatura < e.temperaturaMaxima && !e.caixaCheia;
+}
+
+// Comando de ligar: as mesmas recusas do bloqueioLigar(), caso a camada web tenha visto um retrato antigo.
+static bool podeLigarManual(const MaquinaCompressor& m, const EventoCompressor& e) {
+  return !e.caixaCheia && e.temperatura < e.temperaturaMaxima && m.falha != FALHA_ROTOR_BLOQUEADO;
+}
+
+static bool tempoLigadoVencido(const MaquinaCompressor& m, const EventoCompressor& e) {
+  return e.instante - m.inicioTemporizador >= e.tempoLigadoMs;
+}
+
+// Só para antes se o temporizador não fosse desligar antes do limite de qualquer forma.
+static bool limitePrevisto(const MaquinaCompressor& m, const EventoCompressor& e) {
+  float restanteCiclo = (e.tempoLigadoMs - (e.instante - m.inicioTemporizador)) / 1000.0f;
+  return e.segundosAteLimite >= 0.0f && e.segundosAteLimite <= ANTECIPACAO_TERMICA_S && e.segundosAteLimite < restanteCiclo;
+}
+
+static bool esfriou(const MaquinaCompressor&, const EventoCompressor& e) { return e.temperatura < e.temperaturaReligamento; }
+
+static bool esfriouEPodeLigar(const MaquinaCompressor& m, const EventoCompressor& e) { return esfriou(m, e) && podeLigar(m, e); }
+
+static bool esfriouEPodeLigarManual(const MaquinaCompressor& m, const EventoCompressor& e) {
+  return esfriou(m, e) && podeLigarManual(m, e);
+}
+
+// Sem corrente e rotor bloqueado esperam alguém liberar; o poço seco se recupera sozinho, com espera
+// crescente, até o MAX_DESARMES_SECO seguido, que também espera alguém liberar.
+static bool secoRecuperado(const MaquinaCompressor& m, const EventoCompressor& e) {
+  return m.falha == FALHA_FUNCIONAMENTO_SECO && !secoBloqueado(m) &&
+         e.instante - m.instanteFalha >= esperaAposSeco(m.desarmesSeco);
+}
+
+static bool secoRecuperadoEPodeLigar(const MaquinaCompressor& m, const EventoCompressor& e) {
+  return secoRecuperado(m, e) && podeLigar(m, e);
+}
+
+// ==================== TABELA ====================
+// As linhas de um mesmo (origem, sinal) ficam juntas e valem na ordem: a primeira guarda que passa.
+constexpr uint16_t DESLIGA_E_DESCANSA = EFEITO_DESLIGAR_RELE | EFEITO_REINICIAR_TEMPO;
+constexpr uint16_t LIGA_E_CONTA = EFEITO_LIGAR_RELE | EFEITO_REINICIAR_TEMPO;
+constexpr uint16_t PARA_POR_FALHA = EFEITO_DESLIGAR_RELE | EFEITO_REINICIAR_TEMPO | EFEITO_REGISTRAR_FALHA;
+constexpr uint16_t VOLTA_AO_AUTOMATICO = EFEITO_REINICIAR_TEMPO | EFEITO_LIBERAR_FALHA | EFEITO_ZERAR_DESARMES;
+constexpr uint16_t SEM_MEDICAO = EFEITO_LIBERAR_FALHA | EFEITO_ZERAR_DESARMES;
+
+constexpr TransicaoCompressor TRANSICOES[] = {
+  { MODO_DESCANSO, SINAL_CICLO, podeLigar, MODO_LIGADO, LIGA_E_CONTA },
+  { MODO_DESCANSO, SINAL_CAIXA_CHEIA, nullptr, MODO_DESCANSO, EFEITO_REINICIAR_TEMPO | EFEITO_DESCANSO_FORCADO },
+  { MODO_DESCANSO, SINAL_LIGAR, podeLigarManual, MODO_MANUAL_LIGADO, EFEITO_LIGAR_RELE },
+  { MODO_DESCANSO, SINAL_LIGAR, nullptr, MODO_MANUAL_DESLIGADO, 0 },
+  { MODO_DESCANSO, SINAL_DESLIGAR, nullptr, MODO_MANUAL_DESLIGADO, 0 },
+  { MODO_DESCANSO, SINAL_AUTOMATICO, nullptr, MODO_DESCANSO, VOLTA_AO_AUTOMATICO },
+
+  { MODO_LIGADO, SINAL_CICLO, caixaCheia, MODO_DESCANSO, EFEITO_DESLIGAR_RELE },
+  { MODO_LIGADO, SINAL_CICLO, tempoLigadoVencido, MODO_DESCANSO, DESLIGA_E_DESCANSA | EFEITO_FIM_CICLO | EFEITO_ZERAR_DESARMES },
+  { MODO_LIGADO, SINAL_CICLO, limitePrevisto, MODO_PAUSA_PREDITIVA, EFEITO_DESLIGAR_RELE | EFEITO_PARADA_PREDITIVA },
+  { MODO_LIGADO, SINAL_CAIXA_CHEIA, nullptr, MODO_DESCANSO, DESLIGA_E_DESCANSA | EFEITO_DESCANSO_FORCADO },
+  { MODO_LIGADO, SINAL_TEMPERATURA_ALTA, nullptr, MODO_PARADA_TERMICA, EFEITO_DESLIGAR_RELE | EFEITO_EMERGENCIA },
+  { MODO_LIGADO, SINAL_ERRO_SENSOR, nullptr, MODO_DESCANSO, DESLIGA_E_DESCANSA },
+  { MODO_LIGADO, SINAL_FALHA_CORRENTE, nullptr, MODO_FALHA_CORRENTE, PARA_POR_FALHA },
+  { MODO_LIGADO, SINAL_LIGAR, nullptr, MODO_MANUAL_LIGADO, 0 },
+  { MODO_LIGADO, SINAL_DESLIGAR, nullptr, MODO_MANUAL_DESLIGADO, EFEITO_DESLIGAR_RELE },
+  { MODO_LIGADO, SINAL_AUTOMATICO, nullptr, MODO_LIGADO, VOLTA_AO_AUTOMATICO },
+
+  { MODO_PAUSA_PREDITIVA, SINAL_CICLO, esfriouEPodeLigar, MODO_LIGADO, EFEITO_TEMPERATURA_LIBERADA | LIGA_E_CONTA },
+  { MODO_PAUSA_PREDITIVA, SINAL_CICLO, esfriou, MODO_DESCANSO, EFEITO_TEMPERATURA_LIBERADA },
+  { MODO_PAUSA_PREDITIVA, SINAL_CAIXA_CHEIA, nullptr, MODO_PAUSA_PREDITIVA, EFEITO_REINICIAR_TEMPO | EFEITO_DESCANSO_FORCADO },
+  { MODO_PAUSA_PREDITIVA, SINAL_LIGAR, podeLigarManual, MODO_MANUAL_LIGADO, EFEITO_LIGAR_RELE },
+  { MODO_PAUSA_PREDITIVA, SINAL_LIGAR, nullptr, MODO_MANUAL_DESLIGADO, 0 },
+  { MODO_PAUSA_PREDITIVA, SINAL_DESLIGAR, nullptr, MODO_MANUAL_DESLIGADO, 0 },
+  { MODO_PAUSA_PREDITIVA, SINAL_AUTOMATICO, nullptr, MODO_DESCANSO, VOLTA_AO_AUTOMATICO },
+
+  { MODO_PARADA_TERMICA, SINAL_CICLO, esfriouEPodeLigar, MODO_LIGADO, EFEITO_TEMPERATURA_LIBERADA | LIGA_E_CONTA },
+  { MODO_PARADA_TERMICA, SINAL_CICLO, esfriou, MODO_DESCANSO, EFEITO_TEMPERATURA_LIBERADA },
+  { MODO_PARADA_TERMICA, SINAL_CAIXA_CHEIA, nullptr, MODO_PARADA_TERMICA, EFEITO_REINICIAR_TEMPO | EFEITO_DESCANSO_FORCADO },
+  { MODO_PARADA_TERMICA, SINAL_LIGAR, esfriouEPodeLigarManual, MODO_MANUAL_LIGADO, EFEITO_LIGAR_RELE },
+  { MODO_PARADA_TERMICA, SINAL_LIGAR, nullptr, MODO_MANUAL_PARADA_TERMICA, 0 },
+  { MODO_PARADA_TERMICA, SINAL_DESLIGAR, nullptr, MODO_MANUAL_PARADA_TERMICA, 0 },
+  { MODO_PARADA_TERMICA, SINAL_AUTOMATICO, nullptr, MODO_DESCANSO, VOLTA_AO_AUTOMATICO },
+
+  { MODO_FALHA_CORRENTE, SINAL_CICLO, secoRecuperadoEPodeLigar, MODO_LIGADO, EFEITO_LIBERAR_FALHA | LIGA_E_CONTA },
+  { MODO_FALHA_CORRENTE, SINAL_CICLO, secoRecuperado, MODO_DESCANSO, EFEITO_LIBERAR_FALHA },
+  { MODO_FALHA_CORRENTE, SINAL_CAIXA_CHEIA, nullptr, MODO_FALHA_CORRENTE, EFEITO_REINICIAR_TEMPO | EFEITO_DESCANSO_FORCADO },
+  { MODO_FALHA_CORRENTE, SINAL_MEDICAO_DESLIGADA, nullptr, MODO_DESCANSO, SEM_MEDICAO },
+  { MODO_FALHA_CORRENTE, SINAL_LIGAR, podeLigarManual, MODO_MANUAL_LIGADO, EFEITO_LIGAR_RELE },
+  { MODO_FALHA_CORRENTE, SINAL_LIGAR, nullptr, MODO_MANUAL_DESLIGADO, 0 },
+  { MODO_FALHA_CORRENTE, SINAL_DESLIGAR, nullptr, MODO_MANUAL_DESLIGADO, 0 },
+  { MODO_FALHA_CORRENTE, SINAL_AUTOMATICO, nullptr, MODO_DESCANSO, VOLTA_AO_AUTOMATICO },
+
+  { MODO_MANUAL_LIGADO, SINAL_CICLO, caixaCheia, MODO_MANUAL_DESLIGADO, EFEITO_DESLIGAR_RELE },
+  { MODO_MANUAL_LIGADO, SINAL_CAIXA_CHEIA, nullptr, MODO_MANUAL_DESLIGADO, EFEITO_DESLIGAR_RELE },
+  { MODO_MANUAL_LIGADO, SINAL_TEMPERATURA_ALTA, nullptr, MODO_MANUAL_PARADA_TERMICA, EFEITO_DESLIGAR_RELE | EFEITO_EMERGENCIA },
+  { MODO_MANUAL_LIGADO, SINAL_ERRO_SENSOR, nullptr, MODO_MANUAL_DESLIGADO, EFEITO_DESLIGAR_RELE },
+  { MODO_MANUAL_LIGADO, SINAL_FALHA_CORRENTE, nullptr, MODO_MANUAL_DESLIGADO, PARA_POR_FALHA },
+  { MODO_MANUAL_LIGADO, SINAL_MEDICAO_DESLIGADA, nullptr, MODO_MANUAL_LIGADO, SEM_MEDICAO },
+  { MODO_MANUAL_LIGADO, SINAL_DESLIGAR, nullptr, MODO_MANUAL_DESLIGADO, EFEITO_DESLIGAR_RELE },
+  { MODO_MANUAL_LIGADO, SINAL_AUTOMATICO, nullptr, MODO_LIGADO, VOLTA_AO_AUTOMATICO },
+
+  { MODO_MANUAL_DESLIGADO, SINAL_MEDICAO_DESLIGADA, nullptr, MODO_MANUAL_DESLIGADO, SEM_MEDICAO },
+  { MODO_MANUAL_DESLIGADO, SINAL_LIGAR, podeLigarManual, MODO_MANUAL_LIGADO, EFEITO_LIGAR_RELE },
+  { MODO_MANUAL_DESLIGADO, SINAL_AUTOMATICO, nullptr, MODO_DESCANSO, VOLTA_AO_AUTOMATICO },
+
+  { MODO_MANUAL_PARADA_TERMICA, SINAL_MEDICAO_DESLIGADA, nullptr, MODO_MANUAL_PARADA_TERMICA, SEM_MEDICAO },
+  { MODO_MANUAL_PARADA_TERMICA, SINAL_LIGAR, esfriouEPodeLigarManual, MODO_MANUAL_LIGADO, EFEITO_LIGAR_RELE },
+  { MODO_MANUAL_PARADA_TERMICA, SINAL_AUTOMATICO, nullptr, MODO_DESCANSO, VOLTA_AO_AUTOMATICO },
+};
+constexpr size_t NUM_TRANSICOES = sizeof(TRANSICOES) / sizeof(TRANSICOES[0]);
+static_assert(NUM_TRANSICOES < 255, "o índice guarda posições de 8 bits");
+
+// ==================== CONFERÊNCIAS DA TABELA ====================
+constexpr bool linhaCoerente(const TransicaoCompressor& t) {
+  bool liga = !releLigado(t.origem) && releLigado(t.destino);
+  bool desliga = releLigado(t.origem) && !releLigado(t.destino);
+  // O efeito no relé acompanha a mudança de modo, e nada fecha o relé sem uma guarda.
+  if (liga != ((t.efeitos & EFEITO_LIGAR_RELE) != 0) || desliga != ((t.efeitos & EFEITO_DESLIGAR_RELE) != 0)) return false;
+  if (liga && t.guarda == nullptr) return false;
+  // Do manual só se sai pelo comando de automático; no manual só se entra por comando.
+  if (modoManual(t.origem) && !modoManual(t.destino) && t.sinal != SINAL_AUTOMATICO) return false;
+  if (!modoManual(t.origem) && modoManual(t.destino) && t.sinal != SINAL_LIGAR && t.sinal != SINAL_DESLIGAR) return false;
+  // A falha só é registrada parando o compressor, e o modo de falha só existe com ela.
+  if ((t.efeitos & EFEITO_REGISTRAR_FALHA) && !(t.efeitos & EFEITO_DESLIGAR_RELE)) return false;
+  if (t.destino == MODO_FALHA_CORRENTE && t.origem != MODO_FALHA_CORRENTE && !(t.efeitos & EFEITO_REGISTRAR_FALHA)) return false;
+  if (t.origem == MODO_FALHA_CORRENTE && t.destino != MODO_FALHA_CORRENTE && !modoManual(t.destino) &&
+      !(t.efeitos & EFEITO_LIBERAR_FALHA)) return false;
+  return t.origem < NUM_MODOS_COMPRESSOR && t.destino < NUM_MODOS_COMPRESSOR && t.sinal < NUM_SINAIS_COMPRESSOR;
+}
+
+constexpr bool tabelaCoerente() {
+  for (size_t i = 0; i < NUM_TRANSICOES; i++) {
+    if (!linhaCoerente(TRANSICOES[i])) return false;
+    // Uma linha sem guarda encerra seu grupo: outra depois dela nunca seria escolhida.
+    bool mesmoGrupo = i + 1 < NUM_TRANSICOES && TRANSICOES[i + 1].origem == TRANSICOES[i].origem &&
+                      TRANSICOES[i + 1].sinal == TRANSICOES[i].sinal;
+    if (mesmoGrupo && TRANSICOES[i].guarda == nullptr) return false;
+    // Grupos contíguos: (origem, sinal) não reaparece depois de outro grupo.
+    for (size_t j = i + 2; j < NUM_TRANSICOES; j++) {
+      if (TRANSICOES[j].origem == TRANSICOES[i].origem && TRANSICOES[j].sinal == TRANSICOES[i].sinal &&
+          !(TRANSICOES[j - 1].origem == TRANSICOES[i].origem && TRANSICOES[j - 1].sinal == TRANSICOES[i].sinal)) return false;
+    }
+  }
+  return true;
+}
+static_assert(tabelaCoerente(), "tabela de transições do compressor incoerente");
+
+// ==================== ÍNDICE ====================
+struct IndiceTransicoes {
+  uint8_t inicio[NUM_MODOS_COMPRESSOR][NUM_SINAIS_COMPRESSOR];
+  uint8_t fim[NUM_MODOS_COMPRESSOR][NUM_SINAIS_COMPRESSOR];
+};
+
+constexpr IndiceTransicoes indexarTransicoes() {
+  IndiceTransicoes indice = {};
+  for (size_t i = NUM_TRANSICOES; i-- > 0;) {
+    indice.inicio[TRANSICOES[i].origem][TRANSICOES[i].sinal] = (uint8_t)i;
+    if (indice.fim[TRANSICOES[i].origem][TRANSICOES[i].sinal] == 0) indice.fim[TRANSICOES[i].origem][TRANSICOES[i].sinal] = (uint8_t)(i + 1);
+  }
+  return indice;
+}
+constexpr IndiceTransicoes INDICE_TRANSICOES = indexarTransicoes();
+
+// ==================== DESPACHO ====================
+const TransicaoCompressor* despachar(MaquinaCompressor& maquina, const EventoCompressor& evento) {
+  if (maquina.modo >= NUM_MODOS_COMPRESSOR || evento.sinal >= NUM_SINAIS_COMPRESSOR) return nullptr;
+  uint8_t inicio = INDICE_TRANSICOES.inicio[maquina.modo][evento.sinal];
+  uint8_t fim = INDICE_TRANSICOES.fim[maquina.modo][evento.sinal];
+  for (uint8_t i = inicio; i < fim; i++) {
+    const TransicaoCompressor& t = TRANSICOES[i];
+    if (t.guarda && !t.guarda(maquina, evento)) continue;
+    maquina.modo = t.destino;
+    if (t.efeitos & EFEITO_REINICIAR_TEMPO) maquina.inicioTemporizador = evento.instante;
+    if (t.efeitos & EFEITO_LIBERAR_FALHA) maquina.falha = FALHA_NENHUMA;
+    if (t.efeitos & EFEITO_ZERAR_DESARMES) maquina.desarmesSeco = 0;
+    if (t.efeitos & EFEITO_REGISTRAR_FALHA) {
+      maquina.falha = evento.falha;
+      maquina.instanteFalha = evento.instante;
+      if (evento.falha == FALHA_FUNCIONAMENTO_SECO && maquina.desarmesSeco < MAX_DESARMES_SECO) maquina.desarmesSeco++;
+    }
+    return &t;
+  }
+  return nullptr;
+}
+
+const TransicaoCompressor* tabelaTransicoes(size_t& quantidade) {
+  quantidade = NUM_TRANSICOES;
+  return TRANSICOES;
+}
+
+const char* nomeModoCompressor(ModoCompressor modo) {
+  switch (modo) {
+    case MODO_DESCANSO: return "descanso";
+    case MODO_LIGADO: return "ligado";
+    case MODO_PAUSA_PREDITIVA: return "pausa_preditiva";
+    case MODO_PARADA_TERMICA: return "parada_termica";
+    case MODO_FALHA_CORRENTE: return "falha_corrente";
+    case MODO_MANUAL_LIGADO: return "manual_ligado";
+    case MODO_MANUAL_DESLIGADO: return "manual_desligado";
+    case MODO_MANUAL_PARADA_TERMICA: return "manual_parada_termica";
+    default: return "desconhecido";
+  }
+}
+
+const char* nomeSinalCompressor(SinalCompressor sinal) {
+  switch (sinal) {
+    case SINAL_CICLO: return "ciclo";
+    case SINAL_CAIXA_CHEIA: return "caixa_cheia";
+    case SINAL_TEMPERATURA_ALTA: return "temperatura_alta";
+    case SINAL_ERRO_SENSOR: return "erro_sensor";
+    case SINAL_FALHA_CORRENTE: return "falha_corrente";
+    case SINAL_MEDICAO_DESLIGADA: return "medicao_desligada";
+    case SINAL_LIGAR: return "ligar";
+    case SINAL_DESLIGAR: return "desligar";
+    case SINAL_AUTOMATICO: return "automatico";
+    default: return "desconhecido";
+  }
+}
@@ -0,0 +1,143 @@
+#include "medidor_corrente.h"
+#include <math.h>
+#include <string.h>
+
+// ==================== ADC CONTÍNUO ====================
+bool MedidorCorrente::iniciar(const uint8_t* pinos, uint8_t canais) {
+  if (_ativo) parar();
+  if (canais == 0 || canais > 8) return false;
+  memset(_canalDoAdc, -1, sizeof(_canalDoAdc));
+  memset(_janelas, 0, sizeof(_janelas));
+  memset(_leituras, 0, sizeof(_leituras));
+  adc_digi_pattern_config_t padroes[8];
+  uint32_t mascara = 0;
+  for (uint8_t i = 0; i < canais; i++) {
+    uint8_t canalAdc = (uint8_t)(pinos[i] - 1);
+    if (canalAdc >= 10) return false;
+    padroes[i].atten = ADC_ATTEN_DB_11;
+    padroes[i].channel = canalAdc;
+    padroes[i].unit = 0;  // ADC1: o ADC2 disputa o rádio com o WiFi
+    padroes[i].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+    mascara |= 1UL << canalAdc;
+    _canalDoAdc[canalAdc] = (int8_t)i;
+  }
+
+  adc_digi_init_config_t inicializacao = {};
+  inicializacao.max_store_buf_size = BUFFER_DRIVER_BYTES;
+  inicializacao.conv_num_each_intr = CONVERSOES_POR_LEITURA * SOC_ADC_DIGI_RESULT_BYTES;
+  inicializacao.adc1_chan_mask = mascara;
+  if (adc_digi_initialize(&inicializacao) != ESP_OK) return false;
+
+  adc_digi_configuration_t configuracao = {};
+  configuracao.conv_limit_en = false;
+  configuracao.conv_limit_num = 250;
+  configuracao.pattern_num = canais;
+  configuracao.adc_pattern = padroes;
+  configuracao.sample_freq_hz = FREQUENCIA_CORRENTE_HZ * canais;
+  configuracao.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+  configuracao.format = ADC_DIGI_OUTPUT_FORMAT_TYPE2;
+  if (adc_digi_controller_configure(&configuracao) != ESP_OK || adc_digi_start() != ESP_OK) {
+    adc_digi_deinitialize();
+    return false;
+  }
+  _canais = canais;
+  _ativo = true;
+  return true;
+}
+
+void MedidorCorrente::parar() {
+  if (!_ativo) return;
+  adc_digi_stop();
+  adc_digi_deinitialize();
+  _ativo = false;
+}
+
+void MedidorCorrente::atualizar() {
+  if (!_ativo) return;
+  // Limitado ao que cabe no buffer do driver: mesmo atrasada, uma passada não vira um laço longo.
+  for (uint32_t i = 0; i <= BUFFER_DRIVER_BYTES / sizeof(_buffer); i++) {
+    uint32_t bytes = 0;
+    esp_err_t resultado = adc_digi_read_bytes(reinterpret_cast<uint8_t*>(_buffer), sizeof(_buffer), &bytes, 0);
+    if (resultado != ESP_OK && resultado != ESP_ERR_INVALID_STATE) break;  // INVALID_STATE: transbordou, mas leu
+    processar(_buffer, bytes / SOC_ADC_DIGI_RESULT_BYTES);
+    if (bytes < sizeof(_buffer)) break;
+  }
+}
+
+// ==================== NÚCLEO ====================
+void MedidorCorrente::processar(const adc_digi_output_data_t* conversoes, size_t quantidade) {
+  _conversoes += quantidade;
+  for (size_t i = 0; i < quantidade; i++) {
+    const adc_digi_output_data_t& c = conversoes[i];
+    int8_t canal = _canalDoAdc[c.type2.channel];
+    if (canal < 0 || c.type2.unit != 0) continue;
+    int32_t x = (int32_t)c.type2.data - MEIO_ESCALA_ADC;
+    Janela& j = _janelas[canal];
+    j.soma += x;
+    j.somaQuadrados += (uint32_t)(x * x);
+    if (++j.amostras == AMOSTRAS_POR_JANELA) fecharJanela((uint8_t)canal);
+  }
+}
+
+void MedidorCorrente::fecharJanela(uint8_t canal) {
+  Janela& j = _janelas[canal];
+  float n = (float)j.amostras;
+  float media = j.soma / n;
+  float variancia = j.somaQuadrados / n - media * media;
+  float correnteA = variancia > 0.0f ? sqrtf(variancia) * AMPERES_POR_CONTAGEM : 0.0f;
+  if (correnteA < CORRENTE_MINIMA_A) correnteA = 0.0f;
+  LeituraCorrente& l = _leituras[canal];
+  if (l.janelas < UINT16_MAX) l.janelas++;
+  l.correnteA = correnteA;
+  l.somaCorrentesA += correnteA;
+  j = Janela();
+}
+
+LeituraCorrente MedidorCorrente::ler(uint8_t canal) {
+  LeituraCorrente leitura = {};
+  if (canal >= _canais) return leitura;
+  leitura = _leituras[canal];
+  _leituras[canal].janelas = 0;
+  _leituras[canal].somaCorrentesA = 0.0f;
+  return leitura;
+}
+
+// ==================== DETECÇÃO DE FALHAS ====================
+const char* nomeFalhaCorrente(FalhaCorrente falha) {
+  switch (falha) {
+    case FALHA_SEM_CORRENTE: return "sem_corrente";
+    case FALHA_ROTOR_BLOQUEADO: return "rotor_bloqueado";
+    case FALHA_FUNCIONAMENTO_SECO: return "funcionamento_seco";
+    case FALHA_CORRENTE_SEM_RELE: return "corrente_sem_rele";
+    default: return "nenhuma";
+  }
+}
+
+void DetectorFalhaCorrente::reiniciar() {
+  memset(this, 0, sizeof(*this));
+}
+
+// Soma a duração enquanto a condição vale e zera quando ela cai; true ao passar do limite.
+static bool persistiu(bool condicao, unsigned long& acumuladoMs, unsigned long duracaoMs, unsigned long limiteMs) {
+  acumuladoMs = condicao ? acumuladoMs + duracaoMs : 0;
+  return acumuladoMs >= limiteMs;
+}
+
+FalhaCorrente DetectorFalhaCorrente::avaliar(float correnteA, bool ligado, unsigned long ligadoHaMs, unsigned long duracaoMs,
+                                             float nominalA) {
+  if (nominalA <= 0.0f) return FALHA_NENHUMA;
+  float relativa = correnteA / nominalA;
+  if (!ligado) {
+    semCorrenteMs = acimaPartidaMs = abaixoRegimeMs = 0;
+    return persistiu(relativa >= FRACAO_SEM_CORRENTE, comReleAbertoMs, duracaoMs, CONFIRMACAO_MS) ? FALHA_CORRENTE_SEM_RELE
+                                                                                                   : FALHA_NENHUMA;
+  }
+  comReleAbertoMs = 0;
+  if (persistiu(ligadoHaMs >= ATRASO_CONTATOR_MS && relativa < FRACAO_SEM_CORRENTE, semCorrenteMs, duracaoMs, CONFIRMACAO_MS)) {
+    return FALHA_SEM_CORRENTE;
+  }
+  if (persistiu(relativa >= FRACAO_ROTOR_BLOQUEADO, acimaPartidaMs, duracaoMs, PARTIDA_MAXIMA_MS)) return FALHA_ROTOR_BLOQUEADO;
+  bool abaixo = ligadoHaMs >= ESTABILIZACAO_MS && relativa >= FRACAO_SEM_CORRENTE && relativa < FRACAO_SECO;
+  if (persistiu(abaixo, abaixoRegimeMs, duracaoMs, CONFIRMACAO_SECO_MS)) return FALHA_FUNCIONAMENTO_SECO;
+  return FALHA_NENHUMA;
+}
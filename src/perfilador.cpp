@@ -0,0 +1,16 @@
+#include "perfilador.h"
+
+const uint32_t Perfilador::LIMITES_US[Perfilador::NUM_FAIXAS] = {
+  10, 50, 100, 500, 1000, 5000, 10000, 50000, 100000
+};
+
+const char* const Perfilador::NOMES_ETAPAS[NUM_ETAPAS] = {
+  "wifi", "http", "persistencia", "grafico", "telemetria", "eventos", "mqtt", "log", "autenticacao", "loop", "sensores", "controle"
+};
+
+Perfilador perfilador;
+
+void Perfilador::iniciar(uint32_t ciclosPorUs) {
+  _ciclosPorUs = ciclosPorUs;
+  for (int i = 0; i < NUM_FAIXAS; i++) _limitesCiclos[i] = LIMITES_US[i] * ciclosPorUs;
+}
@@ -0,0 +1,323 @@
+#include "persistencia.h"
+#include "crc.h"
+#include "registro_eventos.h"
+#include <stddef.h>
+
+const ParametrosOperacao PARAMETROS_PADRAO = { 600000UL, 100000UL, 60.0, 12, 1000UL, 1800000UL, 60000UL, false, false, 50UL, 5UL, 0.0f, 220.0f };
+
+static unsigned long ultimoSaveMillis = 0UL;
+static const unsigned long SAVE_INTERVAL = 60000UL;
+static unsigned long versaoDadosGravada = 0UL;
+
+// ==================== FORMATO NO NVS ====================
+// Só tipos de largura fixa: o blob não pode depender do tamanho de unsigned long.
+// Campos novos entram sempre no fim e sobem VERSAO_RETRATO; um retrato antigo
+// (mais curto) é lido pelo prefixo e o restante fica com os valores padrão.
+static const uint16_t VERSAO_RETRATO = 6;
+
+// Contadores, histórico e modelo dos canais 1 em diante (o canal 0 usa os
+// campos originais do retrato, de antes de haver canais).
+struct RetratoCanal {
+  uint32_t ciclosParciaisOperacao;
+  uint32_t ciclosEnchimentoCompletos;
+  uint32_t tempoEnchimento[TAMANHO_HISTORICO_ENCHIMENTO];
+  uint32_t ciclosEnchimento[TAMANHO_HISTORICO_ENCHIMENTO];
+  uint8_t indiceHistoricoEnchimento;
+  uint8_t reservado[3];
+  ModeloEnchimento modelo;
+};
+
+struct RetratoPersistente {
+  uint32_t tempoLigado;
+  uint32_t tempoDescanso;
+  float temperaturaMaxima;
+  uint32_t intervaloLeitura;
+  uint8_t resolucaoSensor;
+  uint8_t indiceHistoricoEnchimento;
+  uint16_t correnteNominalCentiA;   // v6, nos bytes que eram reservados
+  uint32_t ciclosParciaisOperacao;
+  uint32_t ciclosEnchimentoCompletos;
+  uint32_t tempoEnchimento[TAMANHO_HISTORICO_ENCHIMENTO];
+  uint32_t ciclosEnchimento[TAMANHO_HISTORICO_ENCHIMENTO];
+  // v2: modo adaptativo
+  uint32_t tempoLigadoMaximo;
+  uint32_t tempoDescansoMinimo;
+  uint8_t adaptativo;
+  uint8_t reservado2;
+  uint16_t tensaoNominalV;          // v6, idem
+  ModeloEnchimento modelo;
+  // v3: proteção térmica preditiva
+  uint8_t protecaoPreditiva;
+  uint8_t reservado3[3];
+  // v4: canais; só os NUM_CANAIS - 1 primeiros são gravados (ver tamanhoGravado())
+  uint8_t numCanais;
+  // v5: filtro da boia, nos bytes que eram reservados na v4
+  uint8_t glitchBoiaMs;
+  uint16_t debounceBoiaMs;
+  RetratoCanal canais[MAX_CANAIS - 1];
+};
+
+// O retrato gravado termina no último canal em uso: com um canal só, o blob
+// cresce apenas os 4 bytes de numCanais.
+static size_t tamanhoGravado() {
+  return offsetof(RetratoPersistente, canais) + (NUM_CANAIS - 1) * sizeof(RetratoCanal);
+}
+
+struct CabecalhoRetrato {
+  uint16_t versao;
+  uint16_t tamanho;     // bytes do RetratoPersistente que seguem o cabeçalho
+  uint32_t sequencia;   // cresce a cada gravação; a maior válida é a atual
+  uint32_t crc;         // CRC-32 do cabeçalho (com crc = 0) e do retrato
+};
+
+// Duas chaves alternadas: uma queda de energia no meio da gravação corrompe
+// no máximo a cópia sendo escrita, e a anterior continua válida.
+static const char* const CHAVES_RETRATO[2] = { "estadoA", "estadoB" };
+
+static RetratoPersistente retratoGravado;
+static uint32_t sequenciaGravada = 0;
+static int chaveGravada = -1;
+static EstatisticasPersistencia estatisticas;
+
+static void paraRetratoCanal(const DadosCanal& d, RetratoCanal& r) {
+  r.indiceHistoricoEnchimento = (uint8_t)d.indiceHistoricoEnchimento;
+  r.ciclosParciaisOperacao = d.ciclosParciaisOperacao;
+  r.ciclosEnchimentoCompletos = d.ciclosEnchimentoCompletos;
+  for (int i = 0; i < TAMANHO_HISTORICO_ENCHIMENTO; i++) {
+    r.tempoEnchimento[i] = d.historicoEnchimento[i].tempo;
+    r.ciclosEnchimento[i] = d.historicoEnchimento[i].ciclosParciais;
+  }
+  r.modelo = d.modelo;
+}
+
+static void deRetratoCanal(const RetratoCanal& r, DadosCanal& d) {
+  d.indiceHistoricoEnchimento = r.indiceHistoricoEnchimento % TAMANHO_HISTORICO_ENCHIMENTO;
+  d.ciclosParciaisOperacao = r.ciclosParciaisOperacao;
+  d.ciclosEnchimentoCompletos = r.ciclosEnchimentoCompletos;
+  for (int i = 0; i < TAMANHO_HISTORICO_ENCHIMENTO; i++) {
+    d.historicoEnchimento[i].tempo = r.tempoEnchimento[i];
+    d.historicoEnchimento[i].ciclosParciais = r.ciclosEnchimento[i];
+  }
+  d.modelo = r.modelo;
+}
+
+static void paraRetrato(const DadosPersistentes& dados, RetratoPersistente& r) {
+  memset(&r, 0, sizeof(r));
+  r.tempoLigado = dados.parametros.tempoLigado;
+  r.tempoDescanso = dados.parametros.tempoDescanso;
+  r.temperaturaMaxima = dados.parametros.temperaturaMaxima;
+  r.intervaloLeitura = dados.parametros.intervaloLeitura;
+  r.resolucaoSensor = dados.parametros.resolucaoSensor;
+  // Canal 0 nos campos anteriores aos canais.
+  RetratoCanal canal0;
+  paraRetratoCanal(dados.canais[0], canal0);
+  r.indiceHistoricoEnchimento = canal0.indiceHistoricoEnchimento;
+  r.ciclosParciaisOperacao = canal0.ciclosParciaisOperacao;
+  r.ciclosEnchimentoCompletos = canal0.ciclosEnchimentoCompletos;
+  memcpy(r.tempoEnchimento, canal0.tempoEnchimento, sizeof(r.tempoEnchimento));
+  memcpy(r.ciclosEnchimento, canal0.ciclosEnchimento, sizeof(r.ciclosEnchimento));
+  r.modelo = canal0.modelo;
+  r.tempoLigadoMaximo = dados.parametros.tempoLigadoMaximo;
+  r.tempoDescansoMinimo = dados.parametros.tempoDescansoMinimo;
+  r.adaptativo = dados.parametros.adaptativo ? 1 : 0;
+  r.protecaoPreditiva = dados.parametros.protecaoPreditiva ? 1 : 0;
+  r.numCanais = NUM_CANAIS;
+  r.glitchBoiaMs = (uint8_t)(dados.parametros.glitchBoiaMs > 255UL ? 255UL : dados.parametros.glitchBoiaMs);
+  r.debounceBoiaMs = (uint16_t)(dados.parametros.debounceBoiaMs > 65535UL ? 65535UL : dados.parametros.debounceBoiaMs);
+  r.correnteNominalCentiA = (uint16_t)lroundf(dados.parametros.correnteNominalA * 100.0f);
+  r.tensaoNominalV = (uint16_t)lroundf(dados.parametros.tensaoNominalV);
+  for (int i = 1; i < NUM_CANAIS; i++) paraRetratoCanal(dados.canais[i], r.canais[i - 1]);
+}
+
+static void deRetrato(const RetratoPersistente& r, DadosPersistentes& dados) {
+  memset(&dados, 0, sizeof(dados));
+  dados.parametros.tempoLigado = r.tempoLigado;
+  dados.parametros.tempoDescanso = r.tempoDescanso;
+  dados.parametros.temperaturaMaxima = r.temperaturaMaxima;
+  dados.parametros.intervaloLeitura = r.intervaloLeitura;
+  dados.parametros.resolucaoSensor = r.resolucaoSensor;
+  RetratoCanal canal0;
+  memset(&canal0, 0, sizeof(canal0));
+  canal0.indiceHistoricoEnchimento = r.indiceHistoricoEnchimento;
+  canal0.ciclosParciaisOperacao = r.ciclosParciaisOperacao;
+  canal0.ciclosEnchimentoCompletos = r.ciclosEnchimentoCompletos;
+  memcpy(canal0.tempoEnchimento, r.tempoEnchimento, sizeof(canal0.tempoEnchimento));
+  memcpy(canal0.ciclosEnchimento, r.ciclosEnchimento, sizeof(canal0.ciclosEnchimento));
+  canal0.modelo = r.modelo;
+  deRetratoCanal(canal0, dados.canais[0]);
+  dados.parametros.tempoLigadoMaximo = r.tempoLigadoMaximo;
+  dados.parametros.tempoDescansoMinimo = r.tempoDescansoMinimo;
+  dados.parametros.adaptativo = r.adaptativo != 0;
+  dados.parametros.protecaoPreditiva = r.protecaoPreditiva != 0;
+  dados.parametros.glitchBoiaMs = r.glitchBoiaMs;
+  dados.parametros.debounceBoiaMs = r.debounceBoiaMs;
+  dados.parametros.correnteNominalA = r.correnteNominalCentiA / 100.0f;
+  dados.parametros.tensaoNominalV = r.tensaoNominalV;
+  // Canais que o retrato não tem (gravado com menos canais) começam zerados.
+  for (int i = 1; i < NUM_CANAIS && i < r.numCanais; i++) deRetratoCanal(r.canais[i - 1], dados.canais[i]);
+}
+
+static uint32_t crcRetrato(CabecalhoRetrato cabecalho, const void* retrato) {
+  cabecalho.crc = 0;
+  return crc32(retrato, cabecalho.tamanho, crc32(&cabecalho, sizeof(cabecalho)));
+}
+
+// Lê uma das cópias; retorna false se ausente, truncada, de versão futura ou com CRC inválido.
+static bool lerRetrato(Preferences& preferences, int chave, CabecalhoRetrato& cabecalho, RetratoPersistente& r) {
+  uint8_t bruto[sizeof(CabecalhoRetrato) + sizeof(RetratoPersistente)];
+  size_t lidos = preferences.getBytes(CHAVES_RETRATO[chave], bruto, sizeof(bruto));
+  if (lidos < sizeof(CabecalhoRetrato)) return false;
+  memcpy(&cabecalho, bruto, sizeof(cabecalho));
+  if (cabecalho.versao == 0 || cabecalho.versao > VERSAO_RETRATO) return false;
+  if (cabecalho.tamanho > sizeof(RetratoPersistente) || lidos != sizeof(cabecalho) + cabecalho.tamanho) return false;
+  if (crcRetrato(cabecalho, bruto + sizeof(cabecalho)) != cabecalho.crc) return false;
+  // Migração de versões anteriores: prefixo gravado + padrões no que faltar.
+  DadosPersistentes padrao;
+  memset(&padrao, 0, sizeof(padrao));
+  padrao.parametros = PARAMETROS_PADRAO;
+  paraRetrato(padrao, r);
+  memcpy(&r, bruto + sizeof(cabecalho), cabecalho.tamanho);
+  // Campos que ocupam bytes antes reservados não vêm do prefixo: uma v4 os grava zerados.
+  if (cabecalho.versao < 5) {
+    r.glitchBoiaMs = (uint8_t)PARAMETROS_PADRAO.glitchBoiaMs;
+    r.debounceBoiaMs = (uint16_t)PARAMETROS_PADRAO.debounceBoiaMs;
+  }
+  if (cabecalho.versao < 6) {
+    r.correnteNominalCentiA = 0;
+    r.tensaoNominalV = (uint16_t)PARAMETROS_PADRAO.tensaoNominalV;
+  }
+  return true;
+}
+
+static bool gravarRetrato(Preferences& preferences, const RetratoPersistente& r) {
+  int chave = chaveGravada < 0 ? 0 : 1 - chaveGravada;
+  uint8_t bruto[sizeof(CabecalhoRetrato) + sizeof(RetratoPersistente)];
+  CabecalhoRetrato cabecalho = { VERSAO_RETRATO, (uint16_t)tamanhoGravado(), sequenciaGravada + 1, 0 };
+  cabecalho.crc = crcRetrato(cabecalho, &r);
+  memcpy(bruto, &cabecalho, sizeof(cabecalho));
+  memcpy(bruto + sizeof(cabecalho), &r, cabecalho.tamanho);
+
+  size_t total = sizeof(cabecalho) + cabecalho.tamanho;
+  unsigned long inicio = micros();
+  size_t escritos = preferences.putBytes(CHAVES_RETRATO[chave], bruto, total);
+  unsigned long latencia = micros() - inicio;
+  estatisticas.latenciaUltimaUs = latencia;
+  if (latencia > estatisticas.latenciaMaximaUs) estatisticas.latenciaMaximaUs = latencia;
+  if (escritos != total) {
+    estatisticas.falhas++;
+    return false;
+  }
+  estatisticas.gravacoes++;
+  estatisticas.bytesGravados += escritos;
+  retratoGravado = r;
+  sequenciaGravada = cabecalho.sequencia;
+  chaveGravada = chave;
+  return true;
+}
+
+// ==================== CHAVES ANTIGAS (ATÉ v5.1) ====================
+static const char* const CHAVES_LEGADAS[] = {
+  "tempoLigado", "tempoDescanso", "tempMaxima", "resSensor", "intLeitura",
+  "ciclosParc", "ciclosEnch", "idxHEnch", "hEnchimento"
+};
+
+static bool carregarLegado(Preferences& preferences, DadosPersistentes& dados) {
+  if (!preferences.isKey("tempoLigado") && !preferences.isKey("ciclosEnch")) return false;
+  memset(&dados, 0, sizeof(dados));
+  ParametrosOperacao& p = dados.parametros;
+  DadosCanal& canal0 = dados.canais[0];
+  p = PARAMETROS_PADRAO;
+  p.tempoLigado = preferences.getULong("tempoLigado", PARAMETROS_PADRAO.tempoLigado);
+  p.tempoDescanso = preferences.getULong("tempoDescanso", PARAMETROS_PADRAO.tempoDescanso);
+  p.temperaturaMaxima = preferences.getFloat("tempMaxima", PARAMETROS_PADRAO.temperaturaMaxima);
+  p.resolucaoSensor = preferences.getUChar("resSensor", PARAMETROS_PADRAO.resolucaoSensor);
+  p.intervaloLeitura = preferences.getULong("intLeitura", PARAMETROS_PADRAO.intervaloLeitura);
+  canal0.ciclosParciaisOperacao = preferences.getULong("ciclosParc", 0);
+  canal0.ciclosEnchimentoCompletos = preferences.getULong("ciclosEnch", 0);
+  canal0.indiceHistoricoEnchimento = preferences.getInt("idxHEnch", 0) % TAMANHO_HISTORICO_ENCHIMENTO;
+  // O blob antigo é o array de EnchimentoInfo do ESP32 (dois campos de 32 bits).
+  uint32_t historico[TAMANHO_HISTORICO_ENCHIMENTO * 2];
+  if (preferences.getBytes("hEnchimento", historico, sizeof(historico)) == sizeof(historico)) {
+    for (int i = 0; i < TAMANHO_HISTORICO_ENCHIMENTO; i++) {
+      canal0.historicoEnchimento[i].tempo = historico[2 * i];
+      canal0.historicoEnchimento[i].ciclosParciais = historico[2 * i + 1];
+    }
+  }
+  return true;
+}
+
+// ==================== INTERFACE PÚBLICA ====================
+void carregarConfiguracoesOperacao(Preferences& preferences, DadosPersistentes& dados) {
+  CabecalhoRetrato cabecalhos[2];
+  RetratoPersistente retratos[2];
+  bool validos[2];
+  for (int i = 0; i < 2; i++) validos[i] = lerRetrato(preferences, i, cabecalhos[i], retratos[i]);
+  int atual = -1;
+  if (validos[0] && validos[1]) atual = (int32_t)(cabecalhos[1].sequencia - cabecalhos[0].sequencia) > 0 ? 1 : 0;
+  else if (validos[0] || validos[1]) atual = validos[0] ? 0 : 1;
+
+  if (atual >= 0) {
+    deRetrato(retratos[atual], dados);
+    retratoGravado = retratos[atual];
+    sequenciaGravada = cabecalhos[atual].sequencia;
+    chaveGravada = atual;
+    if (!validos[1 - atual] && preferences.isKey(CHAVES_RETRATO[1 - atual])) {
+      Serial.println(F("⚠️ Cópia do estado corrompida (gravação interrompida?); usando a anterior."));
+    }
+    // Retrato de versão anterior: regrava já no formato atual.
+    if (cabecalhos[atual].versao != VERSAO_RETRATO) gravarRetrato(preferences, retratos[atual]);
+  } else if (carregarLegado(preferences, dados)) {
+    RetratoPersistente r;
+    paraRetrato(dados, r);
+    if (gravarRetrato(preferences, r)) {
+      for (size_t i = 0; i < sizeof(CHAVES_LEGADAS) / sizeof(CHAVES_LEGADAS[0]); i++) preferences.remove(CHAVES_LEGADAS[i]);
+      Serial.println(F("🔄 Configurações migradas das chaves antigas para o retrato único."));
+    }
+  } else {
+    memset(&dados, 0, sizeof(dados));
+    dados.parametros = PARAMETROS_PADRAO;
+    paraRetrato(dados, retratoGravado);
+  }
+
+  Serial.println(F("--- Carregando Histórico de Enchimento ---"));
+  for (int c = 0; c < NUM_CANAIS; c++) {
+    const DadosCanal& d = dados.canais[c];
+    if (NUM_CANAIS > 1) Serial.printf(" Canal %d:\n", c);
+    if (d.ciclosEnchimentoCompletos > 0) {
+      for (int i = 0; i < TAMANHO_HISTORICO_ENCHIMENTO; i++) {
+        Serial.printf("  Índice %d: Tempo=%lu s, Ciclos=%u\n", i, d.historicoEnchimento[i].tempo, d.historicoEnchimento[i].ciclosParciais);
+      }
+    } else {
+      Serial.println(F("  Nenhum histórico encontrado."));
+    }
+  }
+  Serial.println(F("------------------------------------------"));
+  Serial.println(F("🔁 Configurações de operação carregadas."));
+}
+
+bool salvarConfiguracoesOperacao(Preferences& preferences, const EstadoControle& estado, unsigned long now) {
+  if (estado.versaoDados == versaoDadosGravada) return false;
+  if (now - ultimoSaveMillis < SAVE_INTERVAL && ultimoSaveMillis != 0) return false;
+  // A versão só diz que algo foi marcado; grava apenas se algum campo mudou de fato.
+  RetratoPersistente r;
+  paraRetrato(estado.dados, r);
+  if (memcmp(&r, &retratoGravado, sizeof(r)) == 0) {
+    versaoDadosGravada = estado.versaoDados;
+    estatisticas.gravacoesEvitadas++;
+    return false;
+  }
+  ultimoSaveMillis = now;
+  if (!gravarRetrato(preferences, r)) {
+    LOG_EVENTO(ERRO_GRAVACAO_NVS, SEM_CANAL);
+    return false;
+  }
+  versaoDadosGravada = estado.versaoDados;
+  LOG_EVENTO(CONFIGURACOES_SALVAS, SEM_CANAL);
+  return true;
+}
+
+EstatisticasPersistencia lerEstatisticasPersistencia() {
+  EstatisticasPersistencia e = estatisticas;
+  e.sequencia = sequenciaGravada;
+  return e;
+}
@@ -0,0 +1,70 @@
+#include "publicador_mqtt.h"
+#include "registro_telemetria.h"
+
+void PublicadorMqtt::amostrar(const EstadoControle& estado, unsigned long agoraMs, uint32_t instante, bool relogioSincronizado) {
+  for (int i = 0; i < NUM_CANAIS; i++) {
+    const EstadoCanal& canal = estado.canais[i];
+    uint8_t flags = 0;
+    if (canal.compressorLigado()) flags |= AmostraTelemetria::FLAG_COMPRESSOR;
+    if (canal.caixaCheia) flags |= AmostraTelemetria::FLAG_CAIXA_CHEIA;
+    if (canal.modoManual()) flags |= AmostraTelemetria::FLAG_MODO_MANUAL;
+    if (canal.desligadoPorTemperaturaAlta()) flags |= AmostraTelemetria::FLAG_DESLIGADO_TEMPERATURA;
+
+    unsigned long decorrido = agoraMs - _ultimaAmostra[i];
+    bool vencido = !_temAmostra || decorrido >= INTERVALO_AMOSTRAGEM_MS;
+    bool mudou = flags != _ultimasFlags[i] && decorrido >= INTERVALO_MINIMO_MS;
+    if (!vencido && !mudou) continue;
+
+    if (_atual.cabecalho.amostras == 0) _inicioLote = agoraMs;
+    AmostraMqtt& amostra = _atual.amostras[_atual.cabecalho.amostras++];
+    amostra.instante = instante;
+    float centesimos = canal.temperaturaAtual * 100.0f;
+    if (centesimos > 32767.0f) centesimos = 32767.0f;
+    if (centesimos < -32768.0f) centesimos = -32768.0f;
+    amostra.temperaturaCentesimos = (int16_t)lroundf(centesimos);
+    amostra.canal = (uint8_t)i;
+    amostra.flags = flags | (relogioSincronizado ? AmostraTelemetria::FLAG_RELOGIO_SINCRONIZADO : 0);
+    amostra.ciclosParciaisOperacao = estado.dados.canais[i].ciclosParciaisOperacao;
+    amostra.ciclosEnchimentoCompletos = estado.dados.canais[i].ciclosEnchimentoCompletos;
+    _ultimaAmostra[i] = agoraMs;
+    _ultimasFlags[i] = flags;
+    _amostras++;
+    if (_atual.cabecalho.amostras >= AMOSTRAS_POR_LOTE) fecharLote();
+  }
+  _temAmostra = true;
+}
+
+void PublicadorMqtt::fecharLote() {
+  if (_atual.cabecalho.amostras == 0) return;
+  // Fila cheia: o lote mais antigo dá lugar ao novo.
+  if (_naFila == CAPACIDADE_FILA) {
+    _lotesDescartados++;
+    _amostrasDescartadas += _fila[_primeiro].cabecalho.amostras;
+    _primeiro = (_primeiro + 1) % CAPACIDADE_FILA;
+    _naFila--;
+  }
+  _atual.cabecalho.versao = VERSAO_LOTE;
+  _atual.cabecalho.sequencia = _sequencia++;
+  _fila[(_primeiro + _naFila) % CAPACIDADE_FILA] = _atual;
+  _naFila++;
+  _atual.cabecalho.amostras = 0;
+}
+
+int PublicadorMqtt::descarregar(PublicarLoteMqtt publicar, void* contexto, unsigned long agoraMs, bool forcar) {
+  // Com lotes esperando (sem conexão) o atual só fecha cheio: a fila guarda mais tempo de queda.
+  bool vencido = _naFila == 0 && agoraMs - _inicioLote >= INTERVALO_LOTE_MS;
+  if (_atual.cabecalho.amostras > 0 && (forcar || vencido)) fecharLote();
+  int publicados = 0;
+  while (_naFila > 0 && (forcar || publicados < LOTES_POR_DESCARGA)) {
+    const Lote& lote = _fila[_primeiro];
+    size_t tamanho = sizeof(CabecalhoLoteMqtt) + lote.cabecalho.amostras * sizeof(AmostraMqtt);
+    if (!publicar(reinterpret_cast<const uint8_t*>(&lote), tamanho, contexto)) break;
+    _lotesPublicados++;
+    _amostrasPublicadas += lote.cabecalho.amostras;
+    _bytesPublicados += tamanho;
+    _primeiro = (_primeiro + 1) % CAPACIDADE_FILA;
+    _naFila--;
+    publicados++;
+  }
+  return publicados;
+}
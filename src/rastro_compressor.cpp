@@ -0,0 +1,68 @@
+#include "rastro_compressor.h"
+
+RastroCompressor rastroCompressor;
+
+// ==================== GRAVAÇÃO ====================
+void RastroCompressor::registrar(uint8_t canal, const MaquinaCompressor& antes, const EventoCompressor& evento,
+                                 const TransicaoCompressor* transicao) {
+  RegistroRastro registro;
+  registro.sequencia = _sequencia.fetch_add(1, std::memory_order_relaxed);
+  registro.canal = canal;
+  registro.destino = transicao ? transicao->destino : antes.modo;
+  registro.efeitos = transicao ? transicao->efeitos : 0;
+  registro.antes = antes;
+  registro.evento = evento;
+  if (!_fila.enviar(registro)) _descartados.fetch_add(1, std::memory_order_relaxed);
+}
+
+size_t RastroCompressor::descarregar() {
+  size_t recebidos = 0;
+  RegistroRastro registro;
+  while (_fila.receber(registro)) {
+    _historico[_noHistorico % TAMANHO_HISTORICO] = registro;
+    _noHistorico++;
+    recebidos++;
+  }
+  return recebidos;
+}
+
+size_t RastroCompressor::exportar(SaidaExportacao saida, void* contexto) const {
+  CabecalhoRastro cabecalho = {};
+  cabecalho.magica = MAGICA_RASTRO;
+  cabecalho.versao = VERSAO_RASTRO;
+  cabecalho.tamanhoRegistro = sizeof(RegistroRastro);
+  cabecalho.canais = NUM_CANAIS;
+  cabecalho.registros = (uint32_t)(_noHistorico < TAMANHO_HISTORICO ? _noHistorico : TAMANHO_HISTORICO);
+  cabecalho.descartados = descartados();
+  if (!saida(reinterpret_cast<const uint8_t*>(&cabecalho), sizeof(cabecalho), contexto)) return 0;
+  size_t bytes = sizeof(cabecalho);
+  bool interrompido = false;
+  percorrerHistorico([&](const RegistroRastro& registro) {
+    if (interrompido) return;
+    interrompido = !saida(reinterpret_cast<const uint8_t*>(&registro), sizeof(registro), contexto);
+    if (!interrompido) bytes += sizeof(registro);
+  });
+  return bytes;
+}
+
+// ==================== REPRODUÇÃO ====================
+bool ReprodutorRastro::reproduzir(const RegistroRastro& registro) {
+  if (registro.canal >= MAX_CANAIS) return false;
+  // Um registro perdido pode ser de qualquer canal: todos recomeçam do que foi gravado.
+  if (_iniciado && registro.sequencia != _proximaSequencia) {
+    _lacunas++;
+    memset(_sincronizada, 0, sizeof(_sincronizada));
+  }
+  _iniciado = true;
+  _proximaSequencia = registro.sequencia + 1;
+  _reproduzidos++;
+
+  MaquinaCompressor& maquina = _maquinas[registro.canal];
+  bool confere = !_sincronizada[registro.canal] || memcmp(&maquina, &registro.antes, sizeof(maquina)) == 0;
+  maquina = registro.antes;
+  _sincronizada[registro.canal] = true;
+  const TransicaoCompressor* transicao = despachar(maquina, registro.evento);
+  confere = confere && maquina.modo == registro.destino && (transicao ? transicao->efeitos : 0) == registro.efeitos;
+  if (!confere) _divergencias++;
+  return confere;
+}
@@ -0,0 +1,99 @@
+#include "registro_eventos.h"
+#include "controle.h"
+
+RegistroEventos registroEventos;
+
+#define EVENTO_LOG_TEXTO(nome, nivel, texto) texto,
+static const char* const TEXTOS_EVENTOS[NUM_EVENTOS_LOG] = { EVENTOS_LOG(EVENTO_LOG_TEXTO) };
+#undef EVENTO_LOG_TEXTO
+
+// Se um registro não cabe na Serial por tanto tempo (ninguém lendo a USB), ela
+// é deixada de lado, para não travar a fila nem o histórico do /log.
+static const unsigned long ESPERA_MAXIMA_SERIAL_MS = 1000UL;
+
+void RegistroEventos::registrar(EventoLog evento, uint8_t canal, ArgumentoLog a, ArgumentoLog b, ArgumentoLog c) {
+  RegistroLog registro;
+  registro.instanteMs = millis();
+  registro.evento = evento;
+  registro.canal = canal;
+  registro.tipos = (uint8_t)(a.tipo | (b.tipo << 2) | (c.tipo << 4));
+  registro.argumentos[0] = a.palavra;
+  registro.argumentos[1] = b.palavra;
+  registro.argumentos[2] = c.palavra;
+  if (_fila.enviar(registro)) _registrados.fetch_add(1, std::memory_order_relaxed);
+  else _descartados.fetch_add(1, std::memory_order_relaxed);
+}
+
+size_t RegistroEventos::formatar(const RegistroLog& registro, char* destino, size_t tamanho) {
+  if (tamanho == 0) return 0;
+  size_t usado = 0;
+  if (NUM_CANAIS > 1 && registro.canal != SEM_CANAL) {
+    int n = snprintf(destino, tamanho, "[canal %u] ", registro.canal);
+    if (n > 0) usado = (size_t)n < tamanho ? (size_t)n : tamanho - 1;
+  }
+  const char* texto = registro.evento < NUM_EVENTOS_LOG ? TEXTOS_EVENTOS[registro.evento] : "evento desconhecido";
+  int argumento = 0;
+  for (const char* p = texto; *p && usado + 1 < tamanho; p++) {
+    if (p[0] != '{' || p[1] != '}' || argumento >= 3) {
+      destino[usado++] = *p;
+      continue;
+    }
+    uint32_t palavra = registro.argumentos[argumento];
+    int n = 0;
+    switch ((registro.tipos >> (2 * argumento)) & 0x3) {
+      case ArgumentoLog::SEM_SINAL: n = snprintf(destino + usado, tamanho - usado, "%lu", (unsigned long)palavra); break;
+      case ArgumentoLog::COM_SINAL: n = snprintf(destino + usado, tamanho - usado, "%ld", (long)(int32_t)palavra); break;
+      case ArgumentoLog::REAL: {
+        float v;
+        memcpy(&v, &palavra, sizeof(v));
+        n = snprintf(destino + usado, tamanho - usado, "%.1f", v);
+        break;
+      }
+      default: n = snprintf(destino + usado, tamanho - usado, "?"); break;
+    }
+    if (n > 0) usado += (size_t)n < tamanho - usado ? (size_t)n : tamanho - usado - 1;
+    argumento++;
+    p++;
+  }
+  destino[usado] = '\0';
+  return usado;
+}
+
+size_t RegistroEventos::descarregar() {
+  size_t escritos = 0;
+  unsigned long agora = millis();
+  char linha[192];
+  for (;;) {
+    if (!_temPendente) {
+      uint32_t descartados = _descartados.load(std::memory_order_relaxed);
+      if (descartados != _descartadosAvisados) {
+        // O aviso entra na frente do que ainda está na fila.
+        _pendente = RegistroLog();
+        _pendente.instanteMs = agora;
+        _pendente.evento = EVENTO_LOG_DESCARTADOS;
+        _pendente.canal = SEM_CANAL;
+        _pendente.tipos = ArgumentoLog::SEM_SINAL;
+        _pendente.argumentos[0] = descartados - _descartadosAvisados;
+        _descartadosAvisados = descartados;
+      } else if (!_fila.receber(_pendente)) {
+        break;
+      }
+      _temPendente = true;
+      _pendenteDesdeMs = agora;
+      _historico[_noHistorico % TAMANHO_HISTORICO] = _pendente;
+      _noHistorico++;
+    }
+    size_t n = formatar(_pendente, linha, sizeof(linha));
+    if ((size_t)Serial.availableForWrite() >= n + 2) {
+      Serial.println(linha);
+      _serialTravada = false;
+    } else if (!_serialTravada && agora - _pendenteDesdeMs < ESPERA_MAXIMA_SERIAL_MS) {
+      break;  // tenta de novo na próxima passada do loop()
+    } else {
+      _serialTravada = true;  // segue só com o histórico até a Serial voltar a ter espaço
+    }
+    _temPendente = false;
+    escritos++;
+  }
+  return escritos;
+}
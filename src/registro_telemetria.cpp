@@ -0,0 +1,207 @@
+#include "registro_telemetria.h"
+#include "crc.h"
+
+static const uint32_t MAGICO_TELEMETRIA = 0x314D4C54UL;  // "TLM1"
+// Versão 2: CRC-32 no cabeçalho. A 1 guardava um CRC-8 no mesmo campo e continua legível.
+static const uint16_t VERSAO_TELEMETRIA = 2;
+static const uint16_t VERSAO_TELEMETRIA_CRC8 = 1;
+static const int AMOSTRAS_POR_BLOCO_LEITURA = 16;
+
+static void selarAmostra(AmostraTelemetria& amostra) {
+  amostra.crc = 0;
+  amostra.crc = crc8(&amostra, sizeof(amostra));
+}
+
+static bool amostraValida(const AmostraTelemetria& amostra) {
+  AmostraTelemetria copia = amostra;
+  copia.crc = 0;
+  return crc8(&copia, sizeof(copia)) == amostra.crc;
+}
+
+void RegistroTelemetria::nomeSegmento(int indice, char* nome, size_t tamanho) {
+  snprintf(nome, tamanho, "/tlm_%02d.bin", indice);
+}
+
+bool RegistroTelemetria::lerCabecalho(int indice, Cabecalho& cabecalho) {
+  char nome[24];
+  nomeSegmento(indice, nome, sizeof(nome));
+  if (!_fs->exists(nome)) return false;
+  File arquivo = _fs->open(nome, "r");
+  if (!arquivo) return false;
+  size_t lidos = arquivo.read((uint8_t*)&cabecalho, sizeof(cabecalho));
+  arquivo.close();
+  if (lidos != sizeof(cabecalho) || cabecalho.magico != MAGICO_TELEMETRIA) return false;
+  if (cabecalho.tamanhoAmostra != sizeof(AmostraTelemetria)) return false;
+  uint32_t crc = cabecalho.crc;
+  cabecalho.crc = 0;
+  if (cabecalho.versao == VERSAO_TELEMETRIA_CRC8) return crc8(&cabecalho, sizeof(cabecalho)) == crc;
+  return cabecalho.versao == VERSAO_TELEMETRIA && crc32(&cabecalho, sizeof(cabecalho)) == crc;
+}
+
+bool RegistroTelemetria::abrirNovoSegmento() {
+  int indice = (_segmentoAtual + 1) % NUM_SEGMENTOS;
+  char nome[24];
+  nomeSegmento(indice, nome, sizeof(nome));
+  _fs->remove(nome);
+  Cabecalho cabecalho = { MAGICO_TELEMETRIA, _geracaoAtual + 1, VERSAO_TELEMETRIA, sizeof(AmostraTelemetria), 0 };
+  cabecalho.crc = crc32(&cabecalho, sizeof(cabecalho));
+  File arquivo = _fs->open(nome, "w");
+  if (!arquivo) return false;
+  size_t escritos = arquivo.write((const uint8_t*)&cabecalho, sizeof(cabecalho));
+  arquivo.close();
+  if (escritos != sizeof(cabecalho)) return false;
+  _segmentoAtual = indice;
+  _geracaoAtual = cabecalho.geracao;
+  _amostrasNoSegmento = 0;
+  _bytesGravados += escritos;
+  return true;
+}
+
+bool RegistroTelemetria::iniciar(fs::FS& fs) {
+  _fs = &fs;
+  _segmentoAtual = -1;
+  _geracaoAtual = 0;
+  for (int i = 0; i < NUM_SEGMENTOS; i++) {
+    Cabecalho cabecalho;
+    if (lerCabecalho(i, cabecalho) && cabecalho.geracao > _geracaoAtual) {
+      _geracaoAtual = cabecalho.geracao;
+      _segmentoAtual = i;
+    }
+  }
+  if (_segmentoAtual < 0) return abrirNovoSegmento();
+
+  char nome[24];
+  nomeSegmento(_segmentoAtual, nome, sizeof(nome));
+  File arquivo = _fs->open(nome, "r");
+  size_t tamanho = arquivo ? arquivo.size() : 0;
+  arquivo.close();
+  size_t dados = tamanho - sizeof(Cabecalho);
+  // Gravação interrompida no meio de uma amostra: começa um segmento novo em vez de desalinhar este.
+  if (tamanho < sizeof(Cabecalho) || dados % sizeof(AmostraTelemetria) != 0) return abrirNovoSegmento();
+  _amostrasNoSegmento = dados / sizeof(AmostraTelemetria);
+  if (_amostrasNoSegmento >= AMOSTRAS_POR_SEGMENTO) return abrirNovoSegmento();
+  return true;
+}
+
+void RegistroTelemetria::amostrar(const EstadoControle& estado, unsigned long agoraMs, uint32_t instante, bool relogioSincronizado) {
+  if (!_fs) return;
+  const EstadoCanal& canal = estado.canais[0];
+  uint8_t flags = 0;
+  if (canal.compressorLigado()) flags |= AmostraTelemetria::FLAG_COMPRESSOR;
+  if (canal.caixaCheia) flags |= AmostraTelemetria::FLAG_CAIXA_CHEIA;
+  if (canal.modoManual()) flags |= AmostraTelemetria::FLAG_MODO_MANUAL;
+  if (canal.desligadoPorTemperaturaAlta()) flags |= AmostraTelemetria::FLAG_DESLIGADO_TEMPERATURA;
+
+  unsigned long decorrido = agoraMs - _ultimaAmostra;
+  bool vencido = !_temAmostra || decorrido >= INTERVALO_AMOSTRAGEM_MS;
+  bool mudou = flags != _ultimasFlags && decorrido >= INTERVALO_MINIMO_MS;
+  if (!vencido && !mudou) return;
+
+  AmostraTelemetria amostra;
+  amostra.instante = instante;
+  float centesimos = canal.temperaturaAtual * 100.0f;
+  if (centesimos > 32767.0f) centesimos = 32767.0f;
+  if (centesimos < -32768.0f) centesimos = -32768.0f;
+  amostra.temperaturaCentesimos = (int16_t)lroundf(centesimos);
+  amostra.flags = flags | (relogioSincronizado ? AmostraTelemetria::FLAG_RELOGIO_SINCRONIZADO : 0);
+  amostra.ciclosParciaisOperacao = estado.dados.canais[0].ciclosParciaisOperacao;
+  amostra.ciclosEnchimentoCompletos = estado.dados.canais[0].ciclosEnchimentoCompletos;
+  selarAmostra(amostra);
+
+  _ultimaAmostra = agoraMs;
+  _temAmostra = true;
+  _ultimasFlags = flags;
+  anexar(amostra);
+  descarregar(agoraMs, _noLote >= AMOSTRAS_POR_LOTE);
+}
+
+void RegistroTelemetria::anexar(const AmostraTelemetria& amostra) {
+  // Lote cheio sem conseguir gravar: descarta a mais antiga para manter a RAM limitada.
+  if (_noLote >= AMOSTRAS_POR_LOTE) {
+    memmove(_lote, _lote + 1, sizeof(AmostraTelemetria) * (AMOSTRAS_POR_LOTE - 1));
+    _noLote = AMOSTRAS_POR_LOTE - 1;
+  }
+  _lote[_noLote++] = amostra;
+}
+
+void RegistroTelemetria::descarregar(unsigned long agoraMs, bool forcar) {
+  if (!_fs || _noLote == 0) return;
+  if (!forcar && agoraMs - _ultimaDescarga < INTERVALO_DESCARGA_MS) return;
+  _ultimaDescarga = agoraMs;
+
+  int gravadas = 0;
+  while (gravadas < _noLote) {
+    if (_amostrasNoSegmento >= AMOSTRAS_POR_SEGMENTO && !abrirNovoSegmento()) break;
+    uint32_t espaco = AMOSTRAS_POR_SEGMENTO - _amostrasNoSegmento;
+    int n = _noLote - gravadas;
+    if ((uint32_t)n > espaco) n = (int)espaco;
+    char nome[24];
+    nomeSegmento(_segmentoAtual, nome, sizeof(nome));
+    File arquivo = _fs->open(nome, "a");
+    if (!arquivo) break;
+    size_t esperado = n * sizeof(AmostraTelemetria);
+    size_t escritos = arquivo.write((const uint8_t*)(_lote + gravadas), esperado);
+    arquivo.close();
+    _bytesGravados += escritos;
+    if (escritos != esperado) {
+      // Segmento com fim desalinhado: abandona-o para não corromper as próximas amostras.
+      abrirNovoSegmento();
+      break;
+    }
+    _amostrasNoSegmento += n;
+    _amostrasGravadas += n;
+    gravadas += n;
+  }
+  if (gravadas < _noLote) {
+    _falhasGravacao++;
+    memmove(_lote, _lote + gravadas, sizeof(AmostraTelemetria) * (_noLote - gravadas));
+  }
+  _noLote -= gravadas;
+}
+
+void RegistroTelemetria::percorrer(uint32_t de, uint32_t ate, VisitanteTelemetria visitante, void* contexto) {
+  if (!_fs) return;
+  // Segmentos válidos em ordem crescente de geração.
+  int ordem[NUM_SEGMENTOS];
+  uint32_t geracoes[NUM_SEGMENTOS];
+  int validos = 0;
+  for (int i = 0; i < NUM_SEGMENTOS; i++) {
+    Cabecalho cabecalho;
+    if (!lerCabecalho(i, cabecalho)) continue;
+    int j = validos++;
+    while (j > 0 && geracoes[j - 1] > cabecalho.geracao) {
+      ordem[j] = ordem[j - 1];
+      geracoes[j] = geracoes[j - 1];
+      j--;
+    }
+    ordem[j] = i;
+    geracoes[j] = cabecalho.geracao;
+  }
+
+  AmostraTelemetria bloco[AMOSTRAS_POR_BLOCO_LEITURA];
+  for (int s = 0; s < validos; s++) {
+    char nome[24];
+    nomeSegmento(ordem[s], nome, sizeof(nome));
+    File arquivo = _fs->open(nome, "r");
+    if (!arquivo) continue;
+    arquivo.seek(sizeof(Cabecalho));
+    for (;;) {
+      size_t lidos = arquivo.read((uint8_t*)bloco, sizeof(bloco)) / sizeof(AmostraTelemetria);
+      for (size_t k = 0; k < lidos; k++) {
+        const AmostraTelemetria& a = bloco[k];
+        if (!amostraValida(a) || a.instante < de || a.instante > ate) continue;
+        if (!visitante(a, contexto)) {
+          arquivo.close();
+          return;
+        }
+      }
+      if (lidos < AMOSTRAS_POR_BLOCO_LEITURA) break;
+    }
+    arquivo.close();
+  }
+  for (int k = 0; k < _noLote; k++) {
+    const AmostraTelemetria& a = _lote[k];
+    if (a.instante < de || a.instante > ate) continue;
+    if (!visitante(a, contexto)) return;
+  }
+}
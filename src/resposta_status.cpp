@@ -0,0 +1,269 @@
+#include "resposta_status.h"
+
+#include <math.h>
+#include <string.h>
+#include "persistencia.h"
+#include "tarefa_controle.h"
+
+// ==================== /status ====================
+void calcularTemporizador(const EstadoCanal& estado, unsigned long& tempoRestante, const char*& proximoEstado) {
+  tempoRestante = 0;
+  proximoEstado = "N/A";
+  if (estado.modoManual()) return;
+  unsigned long tempoDecorrido = millis() - estado.maquina.inicioTemporizador;
+  if (estado.compressorLigado()) {
+    proximoEstado = "Desligar";
+    if (tempoDecorrido < estado.tempoLigadoAtual) { tempoRestante = (estado.tempoLigadoAtual - tempoDecorrido) / 1000UL; }
+  } else {
+    proximoEstado = "Ligar";
+    if (tempoDecorrido < estado.tempoDescansoAtual) { tempoRestante = (estado.tempoDescansoAtual - tempoDecorrido) / 1000UL; }
+  }
+}
+
+unsigned long mediaEnchimento(const DadosCanal& dados) {
+  unsigned long somaTempos = 0;
+  int temposValidos = 0;
+  for (int i = 0; i < TAMANHO_HISTORICO_ENCHIMENTO; i++) {
+    if (dados.historicoEnchimento[i].tempo > 0) {
+      somaTempos += dados.historicoEnchimento[i].tempo;
+      temposValidos++;
+    }
+  }
+  return (temposValidos > 0) ? (somaTempos / temposValidos) : 0UL;
+}
+
+static void escreverFalhaCorrente(EscritorJson& json, const EstadoCanal& estado) {
+  if (estado.falhaCorrente() != FALHA_NENHUMA) json.campo("falhaCorrente", nomeFalhaCorrente(estado.falhaCorrente()));
+  else json.campoNulo("falhaCorrente");
+  json.campo("desarmesSeco", (unsigned int)estado.maquina.desarmesSeco);
+}
+
+static void escreverCanal(EscritorJson& json, const EstadoCanal& estado, const DadosCanal& dados, const ParametrosOperacao& p) {
+  json.campo("compressorLigado", estado.compressorLigado());
+  json.campo("pausaTermica", estado.pausaTermica());
+  json.campo("modoManual", estado.modoManual());
+  json.campo("estadoControle", nomeModoCompressor(estado.maquina.modo));
+  json.campo("caixaCheia", estado.caixaCheia);
+  json.campo("temperatura", estado.temperaturaAtual, 1);
+  json.campo("alertaTemperatura", estado.temperaturaAtual >= p.temperaturaMaxima);
+  if (estado.sensorPresente) {
+    char rom[17];
+    for (int i = 0; i < 8; i++) snprintf(rom + 2 * i, 3, "%02X", estado.enderecoSensor[i]);
+    json.campo("sensor", (const char*)rom);
+  } else {
+    json.campoNulo("sensor");
+  }
+  json.campo("ciclosParciaisOperacao", dados.ciclosParciaisOperacao);
+  json.campo("ciclosEnchimentoCompletos", dados.ciclosEnchimentoCompletos);
+  json.campo("mediaEnchimento", mediaEnchimento(dados));
+  unsigned long tempoRestante;
+  const char* proximoEstado;
+  calcularTemporizador(estado, tempoRestante, proximoEstado);
+  json.campo("tempoRestante", tempoRestante);
+  json.campo("proximoEstado", proximoEstado);
+  if (p.correnteNominalA > 0.0f) {
+    json.campo("corrente", estado.correnteA, 2);
+    json.campo("energiaUltimoEnchimento", estado.energiaUltimoEnchimentoWh, 1);
+    escreverFalhaCorrente(json, estado);
+  }
+}
+
+// Escreve no JSON apenas os grupos de campos pedidos em `campos`. Os campos
+// avulsos são os do canal 0 (o painel de um canal só); "canais" traz todos.
+void escreverStatus(EscritorJson& json, const EstadoControle& retrato, uint32_t campos, const DiagnosticoLoop& diagnostico) {
+  const EstadoCanal& estado = retrato.canais[0];
+  const DadosCanal& dados = retrato.dados.canais[0];
+  const ParametrosOperacao& p = retrato.dados.parametros;
+  json.abrirObjeto();
+  if (campos & CAMPO_COMPRESSOR) {
+    json.campo("compressorLigado", estado.compressorLigado());
+    json.campo("pausaTermica", estado.pausaTermica());
+  }
+  if (campos & CAMPO_TEMPERATURA) {
+    json.campo("temperatura", estado.temperaturaAtual, 1);
+    json.campo("alertaTemperatura", estado.temperaturaAtual >= p.temperaturaMaxima);
+    // Previsões do estimador térmico (-1 = sem estimativa ou não se aplica agora).
+    float ateLimite = estado.compressorLigado() ? estado.termico.segundosAteLimite(estado.temperaturaAtual, p.temperaturaMaxima) : -1.0f;
+    bool emParadaTermica = estado.desligadoPorTemperaturaAlta() || estado.pausaTermica();
+    float ateReligar = emParadaTermica ? estado.termico.segundosAteEsfriar(estado.temperaturaAtual, estado.temperaturaReligamento) : -1.0f;
+    json.campo("segundosAteLimite", (long)ateLimite);
+    json.campo("segundosAteReligamento", (long)ateReligar);
+    json.campo("temperaturaReligamento", estado.temperaturaReligamento, 1);
+  }
+  if (campos & CAMPO_CAIXA) {
+    json.campo("caixaCheia", estado.caixaCheia);
+    json.campo("alertaCaixaCheia", estado.caixaCheia);
+  }
+  if (campos & CAMPO_MODO) {
+    json.campo("modoManual", estado.modoManual());
+    json.campo("estadoControle", nomeModoCompressor(estado.maquina.modo));
+  }
+  if (campos & CAMPO_CONTADORES) {
+    json.campo("ciclosParciaisOperacao", dados.ciclosParciaisOperacao);
+    json.campo("ciclosEnchimentoCompletos", dados.ciclosEnchimentoCompletos);
+  }
+  if (campos & CAMPO_PARAMETROS) {
+    json.campo("tempoLigado", p.tempoLigado / 60000UL);
+    json.campo("tempoDescanso", p.tempoDescanso / 60000UL);
+    json.campo("temperaturaMaxima", p.temperaturaMaxima, 1);
+    json.campo("resolucaoSensor", p.resolucaoSensor);
+    json.campo("intervaloLeitura", p.intervaloLeitura);
+    json.campo("adaptativo", p.adaptativo);
+    json.campo("tempoLigadoMaximo", p.tempoLigadoMaximo / 60000UL);
+    json.campo("tempoDescansoMinimo", p.tempoDescansoMinimo / 1000UL);
+    json.campo("protecaoPreditiva", p.protecaoPreditiva);
+    json.campo("debounceBoia", p.debounceBoiaMs);
+    json.campo("glitchBoia", p.glitchBoiaMs);
+    json.campo("correnteNominal", p.correnteNominalA, 1);
+    json.campo("tensaoNominal", p.tensaoNominalV, 0);
+  }
+  if (campos & CAMPO_CORRENTE) {
+    // Sem TC (corrente nominal 0) tudo fica zerado e falhaCorrente nulo.
+    json.campo("corrente", estado.correnteA, 2);
+    json.campo("potencia", estado.potenciaW, 0);
+    json.campo("energiaTotal", (float)estado.energiaTotalWh, 1);
+    json.campo("energiaEnchimento", estado.energiaEnchimentoWh, 1);
+    json.campo("energiaUltimoEnchimento", estado.energiaUltimoEnchimentoWh, 1);
+    escreverFalhaCorrente(json, estado);
+    json.campo("correnteSemRele", estado.correnteSemRele);
+    json.campo("desligamentosCorrente", estado.desligamentosCorrente);
+  }
+  if (campos & CAMPO_TEMPORIZADOR) {
+    unsigned long tempoRestante;
+    const char* proximoEstado;
+    calcularTemporizador(estado, tempoRestante, proximoEstado);
+    json.campo("tempoRestante", tempoRestante);
+    json.campo("proximoEstado", proximoEstado);
+  }
+  if (campos & CAMPO_HISTORICO) {
+    json.abrirLista("historicoEnchimento");
+    for (int i = 0; i < TAMANHO_HISTORICO_ENCHIMENTO; i++) {
+      int index = (dados.indiceHistoricoEnchimento - 1 - i + TAMANHO_HISTORICO_ENCHIMENTO) % TAMANHO_HISTORICO_ENCHIMENTO;
+      json.abrirObjeto();
+      json.campo("tempo", dados.historicoEnchimento[index].tempo);
+      json.campo("ciclos", dados.historicoEnchimento[index].ciclosParciais);
+      json.fecharObjeto();
+    }
+    json.fecharLista();
+    json.campo("mediaEnchimento", mediaEnchimento(dados));
+  }
+  if (campos & CAMPO_MODELO) {
+    // Estimativas aprendidas dos enchimentos (atualizadas também no modo fixo).
+    const ModeloEnchimento& m = dados.modelo;
+    json.campo("tempoLigadoAtual", estado.tempoLigadoAtual / 1000UL);
+    json.campo("tempoDescansoAtual", estado.tempoDescansoAtual / 1000UL);
+    json.abrirObjeto("modelo");
+    json.campo("enchimentos", (unsigned long)m.enchimentos);
+    json.campo("ligadoPorEnchimento", (unsigned long)m.ligadoPorEnchimentoS);
+    json.campo("partidasPorEnchimento", m.partidasPorEnchimento, 2);
+    json.campo("ligadoAteLimiteTermico", (unsigned long)m.ligadoAteLimiteS);
+    json.campo("recuperacaoPoco", m.recuperacaoPoco, 2);
+    json.campo("tempoLigadoSugerido", (unsigned long)(m.tempoLigadoMs / 1000UL));
+    json.campo("tempoDescansoBase", (unsigned long)(m.tempoDescansoMs / 1000UL));
+    json.fecharObjeto();
+  }
+  if (campos & CAMPO_DIAGNOSTICO) {
+    EstatisticasTarefa tarefa = lerEstatisticasTarefa();
+    json.campo("latenciaLoopUs", diagnostico.latenciaLoopUs);
+    json.campo("latenciaMaximaLoopUs", diagnostico.latenciaMaximaLoopUs);
+    json.campo("jitterControleMaxUs", tarefa.jitterMaximoUs);
+    json.campo("jitterControleMedioUs", tarefa.jitterMedioUs);
+    json.campo("duracaoControleMaxUs", tarefa.duracaoMaximaUs);
+    json.campo("ciclosControleAtrasados", tarefa.ciclosAtrasados);
+    json.campo("pilhaLoopLivreMinima", diagnostico.pilhaLoopLivreMinima);
+    json.campo("bootAteControleUs", tarefa.primeiroCicloUs);
+    json.campo("wifiConexaoMs", diagnostico.wifiConexaoMs);
+    json.campo("wifiReconexoes", diagnostico.wifiReconexoes);
+    EstatisticasPersistencia nvs = lerEstatisticasPersistencia();
+    json.campo("nvsGravacoes", nvs.gravacoes);
+    json.campo("nvsBytesGravados", nvs.bytesGravados);
+    json.campo("nvsLatenciaMaxUs", nvs.latenciaMaximaUs);
+  }
+  if (campos & CAMPO_CANAIS) {
+    json.abrirLista("canais");
+    for (int i = 0; i < NUM_CANAIS; i++) {
+      json.abrirObjeto();
+      json.campo("canal", i);
+      escreverCanal(json, retrato.canais[i], retrato.dados.canais[i], p);
+      json.fecharObjeto();
+    }
+    json.fecharLista();
+  }
+  json.fecharObjeto();
+}
+
+// Resumo de um canal mudou na resolução exibida em "canais"?
+static bool canalAlterado(const EstadoControle& anterior, const EstadoControle& atual, int i) {
+  const EstadoCanal& a = anterior.canais[i];
+  const EstadoCanal& b = atual.canais[i];
+  const DadosCanal& da = anterior.dados.canais[i];
+  const DadosCanal& db = atual.dados.canais[i];
+  return a.maquina.modo != b.maquina.modo || a.caixaCheia != b.caixaCheia || a.maquina.inicioTemporizador != b.maquina.inicioTemporizador ||
+         lroundf(a.temperaturaAtual * 10.0f) != lroundf(b.temperaturaAtual * 10.0f) ||
+         lroundf(a.correnteA * 100.0f) != lroundf(b.correnteA * 100.0f) || a.falhaCorrente() != b.falhaCorrente() ||
+         a.maquina.desarmesSeco != b.maquina.desarmesSeco || a.energiaUltimoEnchimentoWh != b.energiaUltimoEnchimentoWh ||
+         da.ciclosParciaisOperacao != db.ciclosParciaisOperacao || da.ciclosEnchimentoCompletos != db.ciclosEnchimentoCompletos;
+}
+
+uint32_t camposAlterados(const EstadoControle& retratoAnterior, const EstadoControle& retratoAtual) {
+  const EstadoCanal& anterior = retratoAnterior.canais[0];
+  const EstadoCanal& atual = retratoAtual.canais[0];
+  const DadosCanal& a = retratoAnterior.dados.canais[0];
+  const DadosCanal& b = retratoAtual.dados.canais[0];
+  uint32_t campos = 0;
+  if (anterior.maquina.modo != atual.maquina.modo) campos |= CAMPO_COMPRESSOR | CAMPO_MODO | CAMPO_TEMPORIZADOR;
+  // A temperatura só conta como mudança na resolução exibida (0,1 °C).
+  if (lroundf(anterior.temperaturaAtual * 10.0f) != lroundf(atual.temperaturaAtual * 10.0f)) campos |= CAMPO_TEMPERATURA;
+  if (anterior.caixaCheia != atual.caixaCheia) campos |= CAMPO_CAIXA;
+  if (a.ciclosParciaisOperacao != b.ciclosParciaisOperacao || a.ciclosEnchimentoCompletos != b.ciclosEnchimentoCompletos) campos |= CAMPO_CONTADORES;
+  if (memcmp(&retratoAnterior.dados.parametros, &retratoAtual.dados.parametros, sizeof(ParametrosOperacao)) != 0) campos |= CAMPO_PARAMETROS | CAMPO_TEMPERATURA | CAMPO_TEMPORIZADOR;
+  if (anterior.maquina.inicioTemporizador != atual.maquina.inicioTemporizador) campos |= CAMPO_TEMPORIZADOR;
+  // A corrente muda a cada janela de 100 ms: conta na resolução exibida (0,01 A), a energia em 0,1 Wh.
+  if (lroundf(anterior.correnteA * 100.0f) != lroundf(atual.correnteA * 100.0f) ||
+      lround(anterior.energiaTotalWh * 10.0) != lround(atual.energiaTotalWh * 10.0) ||
+      anterior.falhaCorrente() != atual.falhaCorrente() || anterior.correnteSemRele != atual.correnteSemRele ||
+      anterior.desligamentosCorrente != atual.desligamentosCorrente || anterior.maquina.desarmesSeco != atual.maquina.desarmesSeco ||
+      anterior.energiaUltimoEnchimentoWh != atual.energiaUltimoEnchimentoWh) campos |= CAMPO_CORRENTE;
+  if (a.indiceHistoricoEnchimento != b.indiceHistoricoEnchimento ||
+      memcmp(a.historicoEnchimento, b.historicoEnchimento, sizeof(a.historicoEnchimento)) != 0) campos |= CAMPO_HISTORICO;
+  if (memcmp(&a.modelo, &b.modelo, sizeof(a.modelo)) != 0 || anterior.tempoLigadoAtual != atual.tempoLigadoAtual ||
+      anterior.tempoDescansoAtual != atual.tempoDescansoAtual) campos |= CAMPO_MODELO | CAMPO_TEMPORIZADOR;
+  for (int i = 0; i < NUM_CANAIS; i++) {
+    if (canalAlterado(retratoAnterior, retratoAtual, i)) { campos |= CAMPO_CANAIS; break; }
+  }
+  if (campos & CAMPO_PARAMETROS) campos |= CAMPO_CANAIS | CAMPO_CORRENTE;
+  return campos;
+}
+
+// ==================== /tempdata ====================
+struct SaidaSerie {
+  EscritorJson* json;
+  int campo;  // 0 = rótulos, 1 = média, 2 = mínimo, 3 = máximo
+};
+
+static void escreverBalde(uint32_t idadeS, float minimo, float maximo, float media, void* contexto) {
+  SaidaSerie& s = *static_cast<SaidaSerie*>(contexto);
+  if (s.campo == 0) {
+    unsigned long idade = idadeS;
+    char rotulo[16];
+    if (idade < 3600UL) snprintf(rotulo, sizeof(rotulo), "-%lum%02lus", idade / 60, idade % 60);
+    else if (idade < 86400UL) snprintf(rotulo, sizeof(rotulo), "-%luh%02lum", idade / 3600, idade % 3600 / 60);
+    else snprintf(rotulo, sizeof(rotulo), "-%lud%02luh", idade / 86400, idade % 86400 / 3600);
+    s.json->valor(rotulo);
+    return;
+  }
+  s.json->valor(s.campo == 1 ? media : (s.campo == 2 ? minimo : maximo), 1);
+}
+
+void escreverSerieTemperatura(EscritorJson& json, const SerieTemporal& serie, int nivel, uint32_t intervaloS) {
+  static const char* const NOMES[] = { "labels", "dados", "minimos", "maximos" };
+  SaidaSerie s = { &json, 0 };
+  json.abrirObjeto();
+  json.campo("resolucao", (unsigned long)SerieTemporal::NIVEIS[nivel].resolucaoS);
+  for (s.campo = 0; s.campo < 4; s.campo++) {
+    json.abrirLista(NOMES[s.campo]);
+    serie.percorrer(nivel, intervaloS, escreverBalde, &s);
+    json.fecharLista();
+  }
+  json.fecharObjeto();
+}
@@ -0,0 +1,121 @@
+#include "serie_temporal.h"
+
+const SerieTemporal::Nivel SerieTemporal::NIVEIS[SerieTemporal::NUM_NIVEIS] = {
+  { 10UL, 360 },
+  { 60UL, 1440 },
+  { 3600UL, 720 },
+};
+
+static int16_t paraCentesimos(float valor) {
+  float centesimos = valor * 100.0f;
+  if (centesimos > 32767.0f) centesimos = 32767.0f;
+  if (centesimos < -32767.0f) centesimos = -32767.0f;
+  return (int16_t)lroundf(centesimos);
+}
+
+SerieTemporal::SerieTemporal() {
+  for (int i = 0; i < NUM_BALDES; i++) {
+    _baldes[i].minimo = VAZIO;
+    _baldes[i].maximo = VAZIO;
+    _baldes[i].media = VAZIO;
+  }
+}
+
+int SerieTemporal::deslocamento(int nivel) {
+  int inicio = 0;
+  for (int i = 0; i < nivel; i++) inicio += NIVEIS[i].capacidade;
+  return inicio;
+}
+
+void SerieTemporal::registrar(float valor, unsigned long agoraMs) {
+  // Relógio próprio de 64 bits: o nível de 30 dias atravessa o estouro do millis().
+  if (!_iniciada) {
+    _iniciada = true;
+    _ultimoMs = agoraMs;
+  }
+  _relogioMs += (uint32_t)(agoraMs - _ultimoMs);
+  _ultimoMs = agoraMs;
+  uint32_t indice = (uint32_t)(_relogioMs / 1000ULL / NIVEIS[0].resolucaoS);
+  agregar(0, indice, valor, valor, valor, 1);
+}
+
+void SerieTemporal::agregar(int nivel, uint32_t indice, float minimo, float maximo, float soma, uint32_t amostras) {
+  Acumulador& a = _acumuladores[nivel];
+  if (a.amostras > 0 && a.indice != indice) fechar(nivel);
+  if (a.amostras == 0) {
+    a.indice = indice;
+    a.minimo = minimo;
+    a.maximo = maximo;
+    a.soma = 0.0f;
+  } else {
+    if (minimo < a.minimo) a.minimo = minimo;
+    if (maximo > a.maximo) a.maximo = maximo;
+  }
+  a.soma += soma;
+  a.amostras += amostras;
+}
+
+void SerieTemporal::fechar(int nivel) {
+  Acumulador& a = _acumuladores[nivel];
+  const Nivel& n = NIVEIS[nivel];
+  Balde* anel = _baldes + deslocamento(nivel);
+
+  // Intervalos sem nenhuma amostra entre o último balde e este ficam vazios.
+  if (_temFechado[nivel]) {
+    uint32_t lacuna = a.indice - _ultimoFechado[nivel] - 1;
+    if (lacuna > n.capacidade) lacuna = n.capacidade;
+    for (uint32_t i = 1; i <= lacuna; i++) {
+      Balde& b = anel[(_ultimoFechado[nivel] + i) % n.capacidade];
+      b.minimo = b.maximo = b.media = VAZIO;
+    }
+  }
+  Balde& balde = anel[a.indice % n.capacidade];
+  balde.minimo = paraCentesimos(a.minimo);
+  balde.maximo = paraCentesimos(a.maximo);
+  balde.media = paraCentesimos(a.soma / a.amostras);
+  _ultimoFechado[nivel] = a.indice;
+  _temFechado[nivel] = true;
+
+  uint32_t amostras = a.amostras;
+  a.amostras = 0;
+  if (nivel + 1 < NUM_NIVEIS) {
+    uint32_t indiceSuperior = (uint32_t)((uint64_t)a.indice * n.resolucaoS / NIVEIS[nivel + 1].resolucaoS);
+    agregar(nivel + 1, indiceSuperior, a.minimo, a.maximo, a.soma, amostras);
+  }
+}
+
+int SerieTemporal::escolherNivel(uint32_t resolucaoS, uint32_t intervaloS, uint32_t maxPontos) {
+  for (int i = 0; i < NUM_NIVEIS; i++) {
+    const Nivel& n = NIVEIS[i];
+    if (resolucaoS > 0) {
+      if (n.resolucaoS >= resolucaoS) return i;
+    } else if (n.resolucaoS * n.capacidade >= intervaloS && intervaloS / n.resolucaoS <= maxPontos) {
+      return i;
+    }
+  }
+  return NUM_NIVEIS - 1;
+}
+
+void SerieTemporal::percorrer(int nivel, uint32_t intervaloS, VisitanteSerie visitante, void* contexto) const {
+  if (!_iniciada || nivel < 0 || nivel >= NUM_NIVEIS) return;
+  const Nivel& n = NIVEIS[nivel];
+  const Balde* anel = _baldes + deslocamento(nivel);
+  const Acumulador& a = _acumuladores[nivel];
+
+  uint64_t agoraS = _relogioMs / 1000ULL;
+  uint32_t atual = (uint32_t)(agoraS / n.resolucaoS);
+  uint32_t quantidade = intervaloS == 0 ? n.capacidade : (intervaloS + n.resolucaoS - 1) / n.resolucaoS;
+  if (quantidade > n.capacidade) quantidade = n.capacidade;
+  uint32_t primeiro = atual + 1 >= quantidade ? atual + 1 - quantidade : 0;
+
+  for (uint32_t indice = primeiro; indice <= atual; indice++) {
+    uint32_t idadeS = (uint32_t)(agoraS - (uint64_t)indice * n.resolucaoS);
+    if (a.amostras > 0 && indice == a.indice) {
+      visitante(idadeS, a.minimo, a.maximo, a.soma / a.amostras, contexto);
+    } else if (_temFechado[nivel] && indice <= _ultimoFechado[nivel]) {
+      const Balde& b = anel[indice % n.capacidade];
+      if (b.media == VAZIO) continue;
+      visitante(idadeS, b.minimo / 100.0f, b.maximo / 100.0f, b.media / 100.0f, contexto);
+    }
+  }
+}
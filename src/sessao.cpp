@@ -0,0 +1,180 @@
+#include "sessao.h"
+
+#include <string.h>
+
+static const char* const USUARIO_FABRICA = "admin";
+static const char* const SENHA_FABRICA = "1234";
+static const char* const CHAVE_NVS = "acesso";
+
+// Copia para um campo de tamanho fixo zerado; false se não couber.
+static bool copiarCampo(char* destino, size_t tamanho, const char* origem) {
+  memset(destino, 0, tamanho);
+  size_t comprimento = strlen(origem);
+  if (comprimento >= tamanho) return false;
+  memcpy(destino, origem, comprimento);
+  return true;
+}
+
+static int valorHex(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  return -1;
+}
+
+// Base64 padrão (RFC 4648), sem quebras de linha; retorna os bytes ou -1.
+static int decodificarBase64(const char* texto, size_t comprimento, uint8_t* saida, size_t tamanho) {
+  uint32_t acumulado = 0;
+  int bits = 0;
+  size_t escritos = 0;
+  for (size_t i = 0; i < comprimento && texto[i] != '='; i++) {
+    char c = texto[i];
+    int valor = c >= 'A' && c <= 'Z' ? c - 'A' : c >= 'a' && c <= 'z' ? c - 'a' + 26 : c >= '0' && c <= '9' ? c - '0' + 52
+              : c == '+' ? 62 : c == '/' ? 63 : -1;
+    if (valor < 0) return -1;
+    acumulado = (acumulado << 6) | (uint32_t)valor;
+    bits += 6;
+    if (bits >= 8) {
+      bits -= 8;
+      if (escritos >= tamanho) return -1;
+      saida[escritos++] = (uint8_t)(acumulado >> bits);
+    }
+  }
+  return (int)escritos;
+}
+
+// ==================== CREDENCIAIS ====================
+void GerenciadorSessoes::iniciar(Preferences& preferences, const uint8_t* aleatorio) {
+  _preferences = &preferences;
+  _hmac.definirChave(aleatorio, TAMANHO_CHAVE);
+  if (_preferences->getBytesLength(CHAVE_NVS) != sizeof(_credenciais) ||
+      _preferences->getBytes(CHAVE_NVS, &_credenciais, sizeof(_credenciais)) != sizeof(_credenciais) ||
+      _credenciais.iteracoes == 0 || _credenciais.usuario[TAMANHO_USUARIO - 1] != '\0') {
+    memset(&_credenciais, 0, sizeof(_credenciais));
+    copiarCampo(_credenciais.usuario, sizeof(_credenciais.usuario), USUARIO_FABRICA);
+  }
+}
+
+bool GerenciadorSessoes::conferirSenha(const char* usuario, const char* senha) {
+  char informado[TAMANHO_USUARIO];
+  bool usuarioCabe = copiarCampo(informado, sizeof(informado), usuario);
+  bool usuarioConfere = iguaisTempoConstante(informado, _credenciais.usuario, sizeof(informado)) && usuarioCabe;
+  bool senhaConfere;
+  if (credenciaisDeFabrica()) {
+    // As de fábrica são públicas: não há o que derivar.
+    char esperada[TAMANHO_SENHA], recebida[TAMANHO_SENHA];
+    copiarCampo(esperada, sizeof(esperada), SENHA_FABRICA);
+    bool senhaCabe = copiarCampo(recebida, sizeof(recebida), senha);
+    senhaConfere = iguaisTempoConstante(esperada, recebida, sizeof(esperada)) && senhaCabe;
+  } else {
+    uint8_t resumo[Sha256::TAMANHO_RESUMO];
+    pbkdf2Sha256(senha, strlen(senha), _credenciais.sal, sizeof(_credenciais.sal), _credenciais.iteracoes, resumo);
+    senhaConfere = iguaisTempoConstante(resumo, _credenciais.resumo, sizeof(resumo));
+    _lentas++;
+  }
+  if (!(usuarioConfere && senhaConfere)) _recusadas++;
+  return usuarioConfere && senhaConfere;
+}
+
+bool GerenciadorSessoes::alterarCredenciais(const char* usuario, const char* senha, const uint8_t* aleatorio) {
+  size_t comprimentoSenha = strlen(senha);
+  if (usuario[0] == '\0' || comprimentoSenha == 0 || comprimentoSenha >= TAMANHO_SENHA) return false;
+  Credenciais novas = {};
+  if (!copiarCampo(novas.usuario, sizeof(novas.usuario), usuario)) return false;
+  memcpy(novas.sal, aleatorio + TAMANHO_CHAVE, sizeof(novas.sal));
+  novas.iteracoes = ITERACOES_SENHA;
+  pbkdf2Sha256(senha, comprimentoSenha, novas.sal, sizeof(novas.sal), novas.iteracoes, novas.resumo);
+  if (_preferences->putBytes(CHAVE_NVS, &novas, sizeof(novas)) != sizeof(novas)) return false;
+  _credenciais = novas;
+  // Chave nova: os tokens e o cache do Basic das credenciais antigas deixam de valer.
+  _hmac.definirChave(aleatorio, TAMANHO_CHAVE);
+  memset(_cacheBasic, 0, sizeof(_cacheBasic));
+  memset(_tamanhoBasic, 0, sizeof(_tamanhoBasic));
+  memset(_tokenOcupado, 0, sizeof(_tokenOcupado));
+  return true;
+}
+
+// ==================== BASIC ====================
+bool GerenciadorSessoes::conferirBasic(const char* cabecalho) {
+  if (strncmp(cabecalho, "Basic ", 6) != 0) return false;
+  size_t comprimento = strlen(cabecalho);
+  // Maior que o maior Basic possível: nem cabe no cache, nem decodifica.
+  if (comprimento > TAMANHO_BASIC) return false;
+  bool emCache = false;
+  for (int i = 0; i < CACHE_BASIC; i++) {
+    emCache |= _tamanhoBasic[i] == comprimento && iguaisTempoConstante(_cacheBasic[i], cabecalho, comprimento);
+  }
+  if (emCache) return true;
+
+  char decodificado[TAMANHO_USUARIO + TAMANHO_SENHA];
+  int tamanho = decodificarBase64(cabecalho + 6, strlen(cabecalho + 6), reinterpret_cast<uint8_t*>(decodificado),
+                                  sizeof(decodificado) - 1);
+  if (tamanho < 0) return false;
+  decodificado[tamanho] = '\0';
+  char* separador = strchr(decodificado, ':');
+  if (!separador) return false;
+  *separador = '\0';
+  bool confere = conferirSenha(decodificado, separador + 1);
+  memset(decodificado, 0, sizeof(decodificado));
+  if (!confere) return false;
+  memcpy(_cacheBasic[_proximoCache], cabecalho, comprimento);
+  _tamanhoBasic[_proximoCache] = (uint8_t)comprimento;
+  _proximoCache = (_proximoCache + 1) % CACHE_BASIC;
+  return true;
+}
+
+// ==================== TOKENS ====================
+void GerenciadorSessoes::assinar(const uint8_t carga[8], uint8_t assinatura[16]) const {
+  uint8_t resumo[Sha256::TAMANHO_RESUMO];
+  _hmac.calcular(carga, 8, resumo);
+  memcpy(assinatura, resumo, 16);
+}
+
+void GerenciadorSessoes::emitir(uint64_t agoraMs, char* token) {
+  static const char DIGITOS[] = "0123456789abcdef";
+  uint32_t expira = (uint32_t)(agoraMs / 1000ULL) + VALIDADE_S;
+  uint32_t serie = ++_serie;
+  uint8_t bruto[24];
+  for (int i = 0; i < 4; i++) {
+    bruto[i] = (uint8_t)(expira >> (8 * i));
+    bruto[4 + i] = (uint8_t)(serie >> (8 * i));
+  }
+  assinar(bruto, bruto + 8);
+  for (size_t i = 0; i < sizeof(bruto); i++) {
+    token[2 * i] = DIGITOS[bruto[i] >> 4];
+    token[2 * i + 1] = DIGITOS[bruto[i] & 0x0F];
+  }
+  token[TAMANHO_TOKEN] = '\0';
+  _emitidas++;
+}
+
+bool GerenciadorSessoes::conferirToken(const char* token, size_t tamanho, uint64_t agoraMs) {
+  if (tamanho != TAMANHO_TOKEN) return false;
+  uint8_t bruto[24];
+  for (size_t i = 0; i < sizeof(bruto); i++) {
+    int alto = valorHex(token[2 * i]), baixo = valorHex(token[2 * i + 1]);
+    if (alto < 0 || baixo < 0) return false;
+    bruto[i] = (uint8_t)(alto << 4 | baixo);
+  }
+  bool emCache = false;
+  for (int i = 0; i < CACHE_TOKENS; i++) emCache |= _tokenOcupado[i] && iguaisTempoConstante(_cacheTokens[i], bruto, sizeof(bruto));
+  if (!emCache) {
+    uint8_t esperada[16];
+    assinar(bruto, esperada);
+    if (!iguaisTempoConstante(esperada, bruto + 8, sizeof(esperada))) return false;
+    memcpy(_cacheTokens[_proximoToken], bruto, sizeof(bruto));
+    _tokenOcupado[_proximoToken] = true;
+    _proximoToken = (_proximoToken + 1) % CACHE_TOKENS;
+  }
+  uint32_t expira = (uint32_t)bruto[0] | (uint32_t)bruto[1] << 8 | (uint32_t)bruto[2] << 16 | (uint32_t)bruto[3] << 24;
+  return (uint64_t)expira > agoraMs / 1000ULL;
+}
+
+bool GerenciadorSessoes::conferirCookie(const char* cabecalho, uint64_t agoraMs) {
+  for (const char* p = cabecalho; (p = strstr(p, "sessao=")) != nullptr; p += 7) {
+    if (p != cabecalho && p[-1] != ' ' && p[-1] != ';') continue;
+    const char* valor = p + 7;
+    size_t tamanho = strcspn(valor, "; ");
+    if (conferirToken(valor, tamanho, agoraMs)) return true;
+  }
+  return false;
+}
@@ -0,0 +1,153 @@
+#include "sha256.h"
+
+#include <string.h>
+
+static const uint32_t K[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static inline uint32_t rotacionar(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+// ==================== SHA-256 ====================
+void Sha256::reiniciar() {
+  static const uint32_t INICIAL[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                       0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+  memcpy(_estado, INICIAL, sizeof(_estado));
+  _bytes = 0;
+}
+
+void Sha256::comprimir(const uint8_t bloco[TAMANHO_BLOCO]) {
+  uint32_t w[64];
+  for (int i = 0; i < 16; i++) {
+    w[i] = (uint32_t)bloco[4 * i] << 24 | (uint32_t)bloco[4 * i + 1] << 16 | (uint32_t)bloco[4 * i + 2] << 8 | bloco[4 * i + 3];
+  }
+  for (int i = 16; i < 64; i++) {
+    uint32_t s0 = rotacionar(w[i - 15], 7) ^ rotacionar(w[i - 15], 18) ^ (w[i - 15] >> 3);
+    uint32_t s1 = rotacionar(w[i - 2], 17) ^ rotacionar(w[i - 2], 19) ^ (w[i - 2] >> 10);
+    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+  }
+  uint32_t a = _estado[0], b = _estado[1], c = _estado[2], d = _estado[3];
+  uint32_t e = _estado[4], f = _estado[5], g = _estado[6], h = _estado[7];
+  for (int i = 0; i < 64; i++) {
+    uint32_t t1 = h + (rotacionar(e, 6) ^ rotacionar(e, 11) ^ rotacionar(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+    uint32_t t2 = (rotacionar(a, 2) ^ rotacionar(a, 13) ^ rotacionar(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+    h = g;
+    g = f;
+    f = e;
+    e = d + t1;
+    d = c;
+    c = b;
+    b = a;
+    a = t1 + t2;
+  }
+  _estado[0] += a;
+  _estado[1] += b;
+  _estado[2] += c;
+  _estado[3] += d;
+  _estado[4] += e;
+  _estado[5] += f;
+  _estado[6] += g;
+  _estado[7] += h;
+}
+
+void Sha256::atualizar(const void* dados, size_t tamanho) {
+  const uint8_t* p = static_cast<const uint8_t*>(dados);
+  size_t usado = (size_t)(_bytes % TAMANHO_BLOCO);
+  _bytes += tamanho;
+  if (usado > 0) {
+    size_t falta = TAMANHO_BLOCO - usado;
+    if (tamanho < falta) {
+      memcpy(_bloco + usado, p, tamanho);
+      return;
+    }
+    memcpy(_bloco + usado, p, falta);
+    comprimir(_bloco);
+    p += falta;
+    tamanho -= falta;
+  }
+  for (; tamanho >= TAMANHO_BLOCO; p += TAMANHO_BLOCO, tamanho -= TAMANHO_BLOCO) comprimir(p);
+  memcpy(_bloco, p, tamanho);
+}
+
+void Sha256::finalizar(uint8_t resumo[TAMANHO_RESUMO]) {
+  uint64_t bits = _bytes * 8;
+  size_t usado = (size_t)(_bytes % TAMANHO_BLOCO);
+  _bloco[usado++] = 0x80;
+  if (usado > TAMANHO_BLOCO - 8) {
+    memset(_bloco + usado, 0, TAMANHO_BLOCO - usado);
+    comprimir(_bloco);
+    usado = 0;
+  }
+  memset(_bloco + usado, 0, TAMANHO_BLOCO - 8 - usado);
+  for (int i = 0; i < 8; i++) _bloco[TAMANHO_BLOCO - 1 - i] = (uint8_t)(bits >> (8 * i));
+  comprimir(_bloco);
+  for (int i = 0; i < 8; i++) {
+    resumo[4 * i] = (uint8_t)(_estado[i] >> 24);
+    resumo[4 * i + 1] = (uint8_t)(_estado[i] >> 16);
+    resumo[4 * i + 2] = (uint8_t)(_estado[i] >> 8);
+    resumo[4 * i + 3] = (uint8_t)_estado[i];
+  }
+}
+
+// ==================== HMAC ====================
+void HmacSha256::definirChave(const void* chave, size_t tamanho) {
+  uint8_t bloco[Sha256::TAMANHO_BLOCO] = {};
+  if (tamanho > Sha256::TAMANHO_BLOCO) {
+    Sha256 resumo;
+    resumo.atualizar(chave, tamanho);
+    resumo.finalizar(bloco);
+  } else {
+    memcpy(bloco, chave, tamanho);
+  }
+  for (size_t i = 0; i < sizeof(bloco); i++) bloco[i] ^= 0x36;
+  _interno.reiniciar();
+  _interno.atualizar(bloco, sizeof(bloco));
+  for (size_t i = 0; i < sizeof(bloco); i++) bloco[i] ^= 0x36 ^ 0x5c;
+  _externo.reiniciar();
+  _externo.atualizar(bloco, sizeof(bloco));
+  memset(bloco, 0, sizeof(bloco));
+}
+
+void HmacSha256::calcular(const void* dados, size_t tamanho, uint8_t resumo[Sha256::TAMANHO_RESUMO]) const {
+  Sha256 interno = _interno;
+  interno.atualizar(dados, tamanho);
+  interno.finalizar(resumo);
+  Sha256 externo = _externo;
+  externo.atualizar(resumo, Sha256::TAMANHO_RESUMO);
+  externo.finalizar(resumo);
+}
+
+// ==================== PBKDF2 ====================
+void pbkdf2Sha256(const void* senha, size_t tamanhoSenha, const void* sal, size_t tamanhoSal, uint32_t iteracoes,
+                  uint8_t saida[Sha256::TAMANHO_RESUMO]) {
+  HmacSha256 hmac;
+  hmac.definirChave(senha, tamanhoSenha);
+  // U1 = HMAC(senha, sal || INT(1)); o sal das credenciais cabe folgado.
+  uint8_t primeiro[64 + 4];
+  if (tamanhoSal > sizeof(primeiro) - 4) tamanhoSal = sizeof(primeiro) - 4;
+  memcpy(primeiro, sal, tamanhoSal);
+  const uint8_t bloco[4] = { 0, 0, 0, 1 };
+  memcpy(primeiro + tamanhoSal, bloco, sizeof(bloco));
+  uint8_t u[Sha256::TAMANHO_RESUMO];
+  hmac.calcular(primeiro, tamanhoSal + sizeof(bloco), u);
+  memcpy(saida, u, sizeof(u));
+  for (uint32_t i = 1; i < iteracoes; i++) {
+    hmac.calcular(u, sizeof(u), u);
+    for (size_t j = 0; j < sizeof(u); j++) saida[j] ^= u[j];
+  }
+}
+
+bool iguaisTempoConstante(const void* a, const void* b, size_t tamanho) {
+  const volatile uint8_t* x = static_cast<const volatile uint8_t*>(a);
+  const volatile uint8_t* y = static_cast<const volatile uint8_t*>(b);
+  uint8_t diferenca = 0;
+  for (size_t i = 0; i < tamanho; i++) diferenca |= x[i] ^ y[i];
+  return diferenca == 0;
+}
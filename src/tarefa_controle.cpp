@@ -0,0 +1,127 @@
+#include "tarefa_controle.h"
+#include "estado_compartilhado.h"
+
+static FuncaoCicloControle funcaoCiclo = nullptr;
+static unsigned long periodoTarefaMs = 10;
+static EstatisticasTarefa estatisticas;
+static EstadoCompartilhado<EstatisticasTarefa> estatisticasPublicadas;
+static uint64_t somaJitterUs = 0;
+
+// Jitter = desvio entre o intervalo medido desde o despertar anterior e o período nominal.
+static void registrarAmostra(int64_t intervaloUs, int64_t duracaoUs) {
+  int64_t desvio = intervaloUs - (int64_t)estatisticas.periodoUs;
+  unsigned long jitter = (unsigned long)(desvio < 0 ? -desvio : desvio);
+  estatisticas.amostras++;
+  somaJitterUs += jitter;
+  if (jitter > estatisticas.jitterMaximoUs) estatisticas.jitterMaximoUs = jitter;
+  estatisticas.jitterMedioUs = (unsigned long)(somaJitterUs / estatisticas.amostras);
+  if ((unsigned long)duracaoUs > estatisticas.duracaoMaximaUs) estatisticas.duracaoMaximaUs = (unsigned long)duracaoUs;
+  if ((unsigned long)duracaoUs > estatisticas.periodoUs) estatisticas.ciclosAtrasados++;
+  estatisticasPublicadas.publicar(estatisticas);
+}
+
+EstatisticasTarefa lerEstatisticasTarefa() { return estatisticasPublicadas.ler(); }
+
+#ifdef ARDUINO
+// ==================== ESP32 / FreeRTOS ====================
+#include <Arduino.h>
+
+static void tarefaControle(void*) {
+  const TickType_t periodoTicks = pdMS_TO_TICKS(periodoTarefaMs);
+  TickType_t ultimoDespertar = xTaskGetTickCount();
+  int64_t inicioAnterior = -1;
+  // O primeiro ciclo roda logo ao criar a tarefa, sem esperar um período.
+  for (;;) {
+    int64_t inicio = esp_timer_get_time();
+    funcaoCiclo(millis());
+    int64_t fim = esp_timer_get_time();
+    if (inicioAnterior >= 0) {
+      // uxTaskGetStackHighWaterMark percorre a pilha: basta a cada 100 ciclos.
+      if (estatisticas.amostras % 100 == 0) estatisticas.pilhaLivreMinimaBytes = uxTaskGetStackHighWaterMark(nullptr);
+      registrarAmostra(inicio - inicioAnterior, fim - inicio);
+    } else {
+      // esp_timer conta desde o início da aplicação: é o tempo do boot até a primeira verificação de segurança.
+      estatisticas.primeiroCicloUs = (unsigned long)inicio;
+      estatisticasPublicadas.publicar(estatisticas);
+    }
+    inicioAnterior = inicio;
+    vTaskDelayUntil(&ultimoDespertar, periodoTicks);
+  }
+}
+
+bool iniciarTarefaControle(FuncaoCicloControle ciclo, unsigned long periodoMs, int prioridade, int nucleo) {
+  funcaoCiclo = ciclo;
+  periodoTarefaMs = periodoMs;
+  estatisticas.periodoUs = periodoMs * 1000UL;
+  estatisticasPublicadas.publicar(estatisticas);
+  return xTaskCreatePinnedToCore(tarefaControle, "controle", 4096, nullptr, prioridade, nullptr, nucleo) == pdPASS;
+}
+
+#else
+// ==================== HOST / std::thread ====================
+#include <atomic>
+#include <chrono>
+#include <thread>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+static const std::chrono::steady_clock::time_point inicioProcesso = std::chrono::steady_clock::now();
+static std::thread threadTarefa;
+static std::atomic<bool> threadAtiva{false};
+
+static void threadControle() {
+  using namespace std::chrono;
+  const steady_clock::time_point origem = steady_clock::now();
+  estatisticas.primeiroCicloUs = (unsigned long)duration_cast<microseconds>(origem - inicioProcesso).count();
+  const microseconds periodo(estatisticas.periodoUs);
+  steady_clock::time_point proximo = origem + periodo;
+  steady_clock::time_point inicioAnterior = origem;
+  bool primeiro = true;
+  while (threadAtiva.load(std::memory_order_relaxed)) {
+    std::this_thread::sleep_until(proximo);
+    steady_clock::time_point inicio = steady_clock::now();
+    funcaoCiclo((unsigned long)duration_cast<milliseconds>(inicio - origem).count());
+    steady_clock::time_point fim = steady_clock::now();
+    if (!primeiro) {
+      registrarAmostra(duration_cast<microseconds>(inicio - inicioAnterior).count(),
+                       duration_cast<microseconds>(fim - inicio).count());
+    }
+    primeiro = false;
+    inicioAnterior = inicio;
+    proximo += periodo;
+  }
+}
+
+bool iniciarTarefaControle(FuncaoCicloControle ciclo, unsigned long periodoMs, int prioridade, int nucleo) {
+  funcaoCiclo = ciclo;
+  periodoTarefaMs = periodoMs;
+  estatisticas.periodoUs = periodoMs * 1000UL;
+  estatisticasPublicadas.publicar(estatisticas);
+  threadAtiva.store(true);
+  std::thread t(threadControle);
+#ifdef __linux__
+  // Melhor esforço: SCHED_FIFO exige privilégios; sem eles a thread segue com prioridade normal.
+  sched_param parametro;
+  parametro.sched_priority = prioridade;
+  pthread_setschedparam(t.native_handle(), SCHED_FIFO, &parametro);
+  if (nucleo >= 0) {
+    cpu_set_t nucleos;
+    CPU_ZERO(&nucleos);
+    CPU_SET(nucleo, &nucleos);
+    pthread_setaffinity_np(t.native_handle(), sizeof(nucleos), &nucleos);
+  }
+#else
+  (void)prioridade;
+  (void)nucleo;
+#endif
+  threadTarefa = std::move(t);
+  return true;
+}
+
+void pararTarefaControle() {
+  threadAtiva.store(false);
+  if (threadTarefa.joinable()) threadTarefa.join();
+}
+#endif
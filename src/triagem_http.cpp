@@ -0,0 +1,77 @@
+#include "triagem_http.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+
+// Uma só espiada por vez, de dentro do loop(): fora da pilha.
+static char espiada[TriagemHttp::LIMITE_ESPIADA];
+
+static bool comecaCom(const char* linha, const char* fim, const char* prefixo) {
+  for (; *prefixo; linha++, prefixo++) {
+    if (linha >= fim) return false;
+    char c = *linha;
+    if (c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+    if (c != *prefixo) return false;
+  }
+  return true;
+}
+
+bool TriagemHttp::requisicaoCompleta(const char* dados, size_t tamanho) {
+  const char* fimCabecalho = nullptr;
+  for (size_t i = 0; i + 3 < tamanho && !fimCabecalho; i++) {
+    if (memcmp(dados + i, "\r\n\r\n", 4) == 0) fimCabecalho = dados + i;
+  }
+  if (!fimCabecalho) return false;
+  unsigned long corpo = 0;
+  for (const char* linha = dados; linha < fimCabecalho;) {
+    if (comecaCom(linha, fimCabecalho, "content-length:")) {
+      const char* c = linha + strlen("content-length:");
+      while (c < fimCabecalho && *c == ' ') c++;
+      for (; c < fimCabecalho && *c >= '0' && *c <= '9'; c++) {
+        corpo = corpo * 10 + (unsigned long)(*c - '0');
+        if (corpo > LIMITE_ESPIADA) return false;  // nunca caberia na espiada
+      }
+    }
+    const char* proxima = (const char*)memchr(linha, '\n', (size_t)(fimCabecalho - linha));
+    if (!proxima) break;
+    linha = proxima + 1;
+  }
+  return (size_t)(fimCabecalho + 4 - dados) + corpo <= tamanho;
+}
+
+int TriagemHttp::guardar(int fd, unsigned long agora, bool& despejou) {
+  int vaga = 0;
+  for (int i = 0; i < MAX_PENDENTES; i++) {
+    if (!_pendentes[i].ocupada) { vaga = i; break; }
+    if ((uint32_t)(agora - _pendentes[i].chegada) > (uint32_t)(agora - _pendentes[vaga].chegada)) vaga = i;
+  }
+  despejou = _pendentes[vaga].ocupada;
+  if (despejou) _despejadas++;
+  _pendentes[vaga] = { fd, (uint32_t)agora, true };
+  return vaga;
+}
+
+TriagemHttp::Situacao TriagemHttp::examinar(int vaga, unsigned long agora) {
+  const Pendente& p = _pendentes[vaga];
+  if (!p.ocupada) return TRIAGEM_LIVRE;
+  int lidos = (int)recv(p.fd, espiada, sizeof(espiada), MSG_PEEK | MSG_DONTWAIT);
+  if (lidos == 0 || (lidos < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) return TRIAGEM_DESCARTAR;
+  if (lidos > 0 && requisicaoCompleta(espiada, (size_t)lidos)) {
+    _entregues++;
+    return TRIAGEM_PRONTA;
+  }
+  if ((size_t)lidos == sizeof(espiada) || (uint32_t)(agora - p.chegada) >= PRAZO_CABECALHO_MS) {
+    _vencidas++;
+    return TRIAGEM_DESCARTAR;
+  }
+  return TRIAGEM_AGUARDANDO;
+}
+
+void TriagemHttp::liberar(int vaga) { _pendentes[vaga].ocupada = false; }
+
+int TriagemHttp::pendentes() const {
+  int n = 0;
+  for (int i = 0; i < MAX_PENDENTES; i++) n += _pendentes[i].ocupada ? 1 : 0;
+  return n;
+}
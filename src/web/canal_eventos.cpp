@@ -0,0 +1,84 @@
+#include "canal_eventos.h"
+
+#include <lwip/sockets.h>
+
+static const char CABECALHOS_SSE[] =
+  "HTTP/1.1 200 OK\r\n"
+  "Content-Type: text/event-stream\r\n"
+  "Cache-Control: no-cache\r\n"
+  "Connection: keep-alive\r\n"
+  "\r\n"
+  "retry: 3000\n\n";
+
+// Tudo ou nada dentro do prazo do socket (SO_SNDTIMEO): um envio parcial já estragou o fluxo do cliente.
+static bool escreverComPrazo(WiFiClient& cliente, const void* dados, size_t tamanho) {
+  int socket = cliente.fd();
+  return socket >= 0 && send(socket, dados, tamanho, 0) == (ssize_t)tamanho;
+}
+
+bool CanalEventos::enviar(WiFiClient& cliente, const char* dados, size_t tamanho) {
+  if (!cliente.connected()) return false;
+  if (!escreverComPrazo(cliente, "data: ", 6) || !escreverComPrazo(cliente, dados, tamanho) ||
+      !escreverComPrazo(cliente, "\n\n", 2)) {
+    cliente.stop();
+    _descartados++;
+    return false;
+  }
+  return true;
+}
+
+bool CanalEventos::aceitar(WebServer& server, const char* dadosIniciais, size_t tamanho) {
+  WiFiClient cliente = server.client();
+  IPAddress endereco = cliente.remoteIP();
+  int vaga = -1;
+  int doEndereco = 0;
+  for (int i = 0; i < MAX_CLIENTES; i++) {
+    if (!_clientes[i] || !_clientes[i].connected()) {
+      if (vaga < 0) vaga = i;
+    } else if (_clientes[i].remoteIP() == endereco) {
+      doEndereco++;
+    }
+  }
+  if (vaga < 0 || doEndereco >= MAX_POR_ENDERECO) {
+    _recusados++;
+    server.send(503, "text/plain", "Limite de painéis conectados atingido.");
+    return false;
+  }
+  cliente.setNoDelay(true);
+  struct timeval prazo = { 0, (long)(ESPERA_MAXIMA_ENVIO_MS * 1000UL) };
+  setsockopt(cliente.fd(), SOL_SOCKET, SO_SNDTIMEO, &prazo, sizeof(prazo));
+  if (!escreverComPrazo(cliente, CABECALHOS_SSE, sizeof(CABECALHOS_SSE) - 1)) {
+    cliente.stop();
+    return false;
+  }
+  if (!enviar(cliente, dadosIniciais, tamanho)) return false;
+  _clientes[vaga] = cliente;
+  return true;
+}
+
+void CanalEventos::publicar(const char* dados, size_t tamanho) {
+  for (int i = 0; i < MAX_CLIENTES; i++) {
+    if (_clientes[i]) enviar(_clientes[i], dados, tamanho);
+  }
+}
+
+void CanalEventos::manter(unsigned long agora) {
+  if (agora - _ultimoKeepalive < INTERVALO_KEEPALIVE_MS) return;
+  _ultimoKeepalive = agora;
+  for (int i = 0; i < MAX_CLIENTES; i++) {
+    if (!_clientes[i]) continue;
+    if (!_clientes[i].connected()) _clientes[i].stop();
+    else if (!escreverComPrazo(_clientes[i], ":\n\n", 3)) {
+      _clientes[i].stop();
+      _descartados++;
+    }
+  }
+}
+
+int CanalEventos::clientes() {
+  int n = 0;
+  for (int i = 0; i < MAX_CLIENTES; i++) {
+    if (_clientes[i].connected()) n++;
+  }
+  return n;
+}
@@ -0,0 +1,176 @@
+#include "cliente_mqtt.h"
+
+#include <lwip/dns.h>
+#include <lwip/tcpip.h>
+#include "comandos.h"
+#include "publicador_mqtt.h"
+#include "registro_eventos.h"
+
+// ==================== DNS SEM BLOQUEAR ====================
+// Na tarefa tcpip: o nome em cache responde na hora; senão a resposta vem depois, pelo callback.
+static void dnsRespondeu(const char*, const ip_addr_t* endereco, void* contexto) {
+  ConsultaDns& consulta = *static_cast<ConsultaDns*>(contexto);
+  if (endereco && IP_IS_V4(endereco)) {
+    consulta.endereco = ip_2_ip4(endereco)->addr;
+    consulta.estado = ConsultaDns::RESOLVIDA;
+  } else {
+    consulta.estado = ConsultaDns::FALHOU;
+  }
+}
+
+static void consultarDns(void* contexto) {
+  ConsultaDns& consulta = *static_cast<ConsultaDns*>(contexto);
+  ip_addr_t endereco;
+  err_t erro = dns_gethostbyname(consulta.nome, &endereco, dnsRespondeu, contexto);
+  if (erro == ERR_OK) dnsRespondeu(consulta.nome, &endereco, contexto);
+  else if (erro != ERR_INPROGRESS) dnsRespondeu(consulta.nome, nullptr, contexto);
+}
+
+// ==================== CONEXÃO ====================
+
+void ClienteMqtt::iniciar(Preferences& preferences, const char* identificador, uint16_t tamanhoMensagem) {
+  _preferences = &preferences;
+  // Maior mensagem mais o cabeçalho e o tópico mais longo.
+  _mqtt.setBufferSize(tamanhoMensagem + 128);
+  _mqtt.setClient(_rede);
+  _mqtt.setSocketTimeout(PRAZO_RESPOSTA_S);
+  _mqtt.setCallback([this](char* topico, uint8_t* dados, unsigned int tamanho) { tratarMensagem(topico, dados, tamanho); });
+  _identificador = identificador;
+  carregar();
+}
+
+void ClienteMqtt::carregar() {
+  _servidor = _preferences->getString("mqtt_servidor", "");
+  _porta = _preferences->getUShort("mqtt_porta", PORTA_PADRAO);
+  _usuario = _preferences->getString("mqtt_usuario", "");
+  _senha = _preferences->getString("mqtt_senha", "");
+  _prefixo = _preferences->getString("mqtt_prefixo", "");
+  if (_prefixo.length() == 0) _prefixo = "compressor/" + _identificador.substring(_identificador.indexOf('-') + 1);
+  _mqtt.setServer(_servidor.c_str(), _porta);
+  _espera = 0;
+}
+
+void ClienteMqtt::configurar(const String& servidor, uint16_t porta, const String& usuario, const String& senha,
+                             const String& prefixo) {
+  _preferences->putString("mqtt_servidor", servidor);
+  _preferences->putUShort("mqtt_porta", porta ? porta : PORTA_PADRAO);
+  _preferences->putString("mqtt_usuario", usuario);
+  _preferences->putString("mqtt_senha", senha);
+  _preferences->putString("mqtt_prefixo", prefixo);
+  if (_mqtt.connected()) _mqtt.disconnect();
+  carregar();
+}
+
+bool ClienteMqtt::atualizar(unsigned long agora, bool redeConectada) {
+  if (!configurado() || !redeConectada) return false;
+  if (_mqtt.connected()) {
+    _mqtt.loop();
+    return false;
+  }
+  if (_espera != 0 && agora - _ultimaTentativa < _espera) return false;
+  IPAddress ip;
+  bool falhou = false;
+  if (!resolver(ip, falhou)) {
+    if (falhou) {
+      _ultimaTentativa = agora;
+      adiarTentativa();
+      LOG_EVENTO(MQTT_SEM_DNS, SEM_CANAL, _espera / 1000UL);
+    }
+    return false;
+  }
+  _ultimaTentativa = agora;
+  if (!conectar(ip)) {
+    adiarTentativa();
+    LOG_EVENTO(MQTT_FALHA_CONEXAO, SEM_CANAL, _mqtt.state(), _espera / 1000UL);
+    return false;
+  }
+  _espera = 0;
+  _conexoes++;
+  LOG_EVENTO(MQTT_CONECTADO, SEM_CANAL, (unsigned int)_porta);
+  return true;
+}
+
+void ClienteMqtt::adiarTentativa() {
+  _espera = _espera == 0 ? ESPERA_MINIMA_MS : min(_espera * 2, ESPERA_MAXIMA_MS);
+}
+
+bool ClienteMqtt::resolver(IPAddress& ip, bool& falhou) {
+  if (ip.fromString(_servidor)) return true;
+  switch (_dns.estado.load()) {
+    case ConsultaDns::OCIOSA:
+      if (_servidor.length() >= sizeof(_dns.nome)) {
+        falhou = true;
+        return false;
+      }
+      memcpy(_dns.nome, _servidor.c_str(), _servidor.length() + 1);
+      _dns.estado = ConsultaDns::PENDENTE;
+      if (tcpip_callback(consultarDns, &_dns) != ERR_OK) {
+        _dns.estado = ConsultaDns::OCIOSA;
+        falhou = true;
+      }
+      return false;
+    case ConsultaDns::RESOLVIDA:
+      ip = IPAddress(_dns.endereco.load());
+      _dns.estado = ConsultaDns::OCIOSA;  // a próxima tentativa pergunta de novo (o lwIP guarda em cache)
+      return true;
+    case ConsultaDns::FALHOU:
+      _dns.estado = ConsultaDns::OCIOSA;
+      falhou = true;
+      return false;
+    default:
+      return false;  // pendente
+  }
+}
+
+// O TCP com prazo aqui; com o socket já conectado o PubSubClient só troca o CONNECT/CONNACK.
+bool ClienteMqtt::conectar(const IPAddress& ip) {
+  if (!_rede.connect(ip, _porta, PRAZO_CONEXAO_MS)) return false;
+  String online = _prefixo + "/online";
+  bool ok = _usuario.length() > 0
+                ? _mqtt.connect(_identificador.c_str(), _usuario.c_str(), _senha.c_str(), online.c_str(), 0, true, "0")
+                : _mqtt.connect(_identificador.c_str(), nullptr, nullptr, online.c_str(), 0, true, "0");
+  if (!ok) return false;
+  String comandos = _prefixo + "/comando/+";
+  _mqtt.subscribe(comandos.c_str());
+  publicar(online, reinterpret_cast<const uint8_t*>("1"), 1, true);
+  return true;
+}
+
+bool ClienteMqtt::publicar(const String& topico, const uint8_t* dados, size_t tamanho, bool reter) {
+  if (!_mqtt.connected() || !_mqtt.publish(topico.c_str(), dados, tamanho, reter)) return false;
+  _mensagensEnviadas++;
+  _bytesEnviados += tamanhoPublishMqtt(topico.length(), tamanho);
+  return true;
+}
+
+bool ClienteMqtt::publicarEstado(const char* json, size_t tamanho) {
+  return publicar(_prefixo + "/estado", reinterpret_cast<const uint8_t*>(json), tamanho, true);
+}
+
+bool ClienteMqtt::publicarLote(const uint8_t* dados, size_t tamanho, void* contexto) {
+  ClienteMqtt& cliente = *static_cast<ClienteMqtt*>(contexto);
+  return cliente.publicar(cliente._prefixo + "/telemetria", dados, tamanho, false);
+}
+
+// <prefixo>/comando/<ação>: monta o mesmo Comando da rota HTTP e responde em <prefixo>/resposta/<ação>.
+void ClienteMqtt::tratarMensagem(char* topico, uint8_t* dados, unsigned int tamanho) {
+  String base = _prefixo + "/comando/";
+  if (strncmp(topico, base.c_str(), base.length()) != 0) return;
+  const char* acao = topico + base.length();
+  _comandosRecebidos++;
+
+  char argumentos[128];
+  size_t n = tamanho < sizeof(argumentos) - 1 ? tamanho : sizeof(argumentos) - 1;
+  memcpy(argumentos, dados, n);
+  argumentos[n] = '\0';
+
+  // Estático: o retrato não cabe folgado na pilha da tarefa do loop(), de onde o PubSubClient chama.
+  static EstadoControle retrato;
+  lerEstadoControle(retrato);
+  Comando comando;
+  const char* resposta = nullptr;
+  if (montarComando(acao, argumentos, retrato, comando, resposta) && !enviarComando(comando)) {
+    resposta = "❌ Controle ocupado, tente novamente.";
+  }
+  publicar(_prefixo + "/resposta/" + acao, reinterpret_cast<const uint8_t*>(resposta), strlen(resposta), false);
+}
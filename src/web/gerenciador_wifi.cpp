@@ -0,0 +1,131 @@
+#include "gerenciador_wifi.h"
+
+void GerenciadorWiFi::iniciar(Preferences& preferences, unsigned long agora) {
+  _preferences = &preferences;
+  // A reconexão é feita aqui; o driver não deve gravar nada na flash nem reconectar por conta própria.
+  WiFi.persistent(false);
+  WiFi.setAutoReconnect(false);
+  carregarCredenciais();
+  if (_ssid.length() == 0) {
+    WiFi.mode(WIFI_AP);
+    iniciarAp();
+    _estado = SEM_REDE;
+    return;
+  }
+  WiFi.mode(WIFI_STA);
+  comecarTentativa(agora);
+}
+
+void GerenciadorWiFi::carregarCredenciais() {
+  _ssid = _preferences->getString("wifi_ssid", "");
+  _senha = _preferences->getString("wifi_pass", "");
+  _canal = _preferences->getUChar("wifi_canal", 0);
+  _usarCache = _canal != 0 && _preferences->getBytes("wifi_bssid", _bssid, sizeof(_bssid)) == sizeof(_bssid);
+}
+
+void GerenciadorWiFi::comecarTentativa(unsigned long agora) {
+  if (_usarCache) {
+    Serial.printf("📡 Conectando a %s (canal %u em cache)...\n", _ssid.c_str(), _canal);
+    WiFi.begin(_ssid.c_str(), _senha.c_str(), _canal, _bssid);
+  } else {
+    Serial.printf("📡 Conectando a %s...\n", _ssid.c_str());
+    WiFi.begin(_ssid.c_str(), _senha.c_str());
+  }
+  _estado = CONECTANDO;
+  _inicioEstado = agora;
+}
+
+void GerenciadorWiFi::guardarCanal() {
+  uint8_t canal = (uint8_t)WiFi.channel();
+  const uint8_t* bssid = WiFi.BSSID();
+  if (!bssid) return;
+  if (canal == _canal && memcmp(bssid, _bssid, sizeof(_bssid)) == 0) return;
+  _canal = canal;
+  memcpy(_bssid, bssid, sizeof(_bssid));
+  _preferences->putUChar("wifi_canal", _canal);
+  _preferences->putBytes("wifi_bssid", _bssid, sizeof(_bssid));
+}
+
+void GerenciadorWiFi::iniciarAp() {
+  if (_apAtivo) return;
+  if (_ssid.length() > 0) WiFi.mode(WIFI_AP_STA);
+  WiFi.softAP(_apSsid, _apSenha);
+  WiFi.softAPConfig(ipAp(), ipAp(), IPAddress(255, 255, 255, 0));
+  _dns.start(53, "*", ipAp());
+  _apAtivo = true;
+  Serial.printf("🔧 Ponto de acesso %s ativo: acesse http://192.168.4.1 para configurar a rede WiFi.\n", _apSsid);
+}
+
+void GerenciadorWiFi::encerrarAp() {
+  if (!_apAtivo) return;
+  _dns.stop();
+  WiFi.softAPdisconnect(true);
+  WiFi.mode(WIFI_STA);
+  _apAtivo = false;
+  Serial.println(F("✅ Ponto de acesso desligado."));
+}
+
+GerenciadorWiFi::Evento GerenciadorWiFi::atualizar(unsigned long agora) {
+  if (_apAtivo) _dns.processNextRequest();
+  bool temConexao = WiFi.status() == WL_CONNECTED;
+
+  switch (_estado) {
+    case SEM_REDE:
+      return NENHUM;
+
+    case CONECTANDO:
+      if (temConexao) {
+        _estado = CONECTADO;
+        _duracaoUltimaConexao = agora - _inicioEstado;
+        _falhas = 0;
+        guardarCanal();
+        Serial.printf("✅ Conectado em %lu ms. IP: %s\n", _duracaoUltimaConexao, WiFi.localIP().toString().c_str());
+        encerrarAp();
+        return CONECTOU;
+      }
+      if (agora - _inicioEstado < TEMPO_TENTATIVA_MS) return NENHUM;
+      WiFi.disconnect();
+      _falhas++;
+      if (_usarCache) {
+        // O AP pode ter mudado de canal: a próxima tentativa faz a varredura completa, já.
+        _usarCache = false;
+        comecarTentativa(agora);
+        return NENHUM;
+      }
+      Serial.printf("❌ Falha ao conectar (%d).\n", _falhas);
+      _estado = AGUARDANDO;
+      _inicioEstado = agora;
+      if (_falhas >= FALHAS_ANTES_AP && !_apAtivo) {
+        iniciarAp();
+        return AP_INICIADO;
+      }
+      return NENHUM;
+
+    case CONECTADO:
+      if (temConexao) return NENHUM;
+      Serial.println(F("❌ Conexão WiFi perdida. Tentando reconectar..."));
+      _reconexoes++;
+      _usarCache = _canal != 0;
+      comecarTentativa(agora);
+      return DESCONECTOU;
+
+    case AGUARDANDO:
+      if (agora - _inicioEstado >= (_apAtivo ? ESPERA_RECONEXAO_AP_MS : ESPERA_RECONEXAO_MS)) {
+        _usarCache = _canal != 0;
+        comecarTentativa(agora);
+      }
+      return NENHUM;
+  }
+  return NENHUM;
+}
+
+void GerenciadorWiFi::reconfigurar(unsigned long agora) {
+  _preferences->remove("wifi_canal");
+  _preferences->remove("wifi_bssid");
+  carregarCredenciais();
+  _falhas = 0;
+  if (_ssid.length() == 0) return;
+  if (_apAtivo) WiFi.mode(WIFI_AP_STA);
+  WiFi.disconnect();
+  comecarTentativa(agora);
+}
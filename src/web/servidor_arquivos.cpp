@@ -0,0 +1,73 @@
+#include "servidor_arquivos.h"
+
+static const char MANIFESTO[] = "/assets.txt";
+
+bool ServidorArquivos::iniciar(fs::FS& fs) {
+  _fs = &fs;
+  _numArquivos = 0;
+  File manifesto = fs.open(MANIFESTO, "r");
+  if (!manifesto) return false;
+
+  char linha[160];
+  while (manifesto.available() && _numArquivos < MAX_ARQUIVOS) {
+    size_t n = manifesto.readBytesUntil('\n', linha, sizeof(linha) - 1);
+    linha[n] = '\0';
+    Arquivo& a = _arquivos[_numArquivos];
+    char etag[17];
+    int imutavel = 0;
+    if (sscanf(linha, "%47s %23s %16s %31s %d", a.url, a.nome, etag, a.tipo, &imutavel) != 5) continue;
+    snprintf(a.etag, sizeof(a.etag), "\"%s\"", etag);
+    a.imutavel = imutavel != 0;
+    a.cache = nullptr;
+    a.tamanho = 0;
+
+    File arquivo = fs.open(a.nome, "r");
+    if (!arquivo) continue;
+    a.tamanho = arquivo.size();
+    if (a.tamanho <= MAX_ARQUIVO_CACHE && _bytesEmCache + a.tamanho <= ORCAMENTO_CACHE) {
+      a.cache = (uint8_t*)malloc(a.tamanho);
+      if (a.cache && arquivo.read(a.cache, a.tamanho) == a.tamanho) {
+        _bytesEmCache += a.tamanho;
+      } else {
+        free(a.cache);
+        a.cache = nullptr;
+      }
+    }
+    arquivo.close();
+    _numArquivos++;
+  }
+  manifesto.close();
+  return _numArquivos > 0;
+}
+
+bool ServidorArquivos::servir(WebServer& server, const String& url) {
+  const Arquivo* a = nullptr;
+  for (int i = 0; i < _numArquivos; i++) {
+    if (url == _arquivos[i].url) { a = &_arquivos[i]; break; }
+  }
+  if (!a) return false;
+
+  server.sendHeader("ETag", a->etag);
+  server.sendHeader("Cache-Control", a->imutavel ? "public, max-age=31536000, immutable" : "no-cache");
+  if (server.header("If-None-Match") == a->etag) {
+    _respostas304++;
+    server.send(304);
+    return true;
+  }
+  if (a->cache) {
+    _respostasRam++;
+    server.sendHeader("Content-Encoding", "gzip");
+    server.send_P(200, a->tipo, (PGM_P)a->cache, a->tamanho);
+    return true;
+  }
+  File arquivo = _fs->open(a->nome, "r");
+  if (!arquivo) {
+    server.send(500, "text/plain", "ERRO: arquivo do manifesto ausente no SPIFFS.");
+    return true;
+  }
+  // streamFile acrescenta o Content-Encoding: gzip sozinho para nomes terminados em .gz.
+  _respostasFlash++;
+  server.streamFile(arquivo, a->tipo);
+  arquivo.close();
+  return true;
+}
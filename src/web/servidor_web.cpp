@@ -0,0 +1,29 @@
+#include "servidor_web.h"
+
+void ServidorWeb::handleClient() {
+  if (_currentStatus == HC_NONE) {
+    unsigned long agora = millis();
+    for (WiFiClient nova = _server.available(); nova; nova = _server.available()) {
+      bool despejou = false;
+      int vaga = _triagem.guardar(nova.fd(), agora, despejou);
+      if (despejou) _pendentes[vaga].stop();
+      _pendentes[vaga] = nova;
+    }
+    for (int vaga = 0; vaga < TriagemHttp::MAX_PENDENTES && _currentStatus == HC_NONE; vaga++) {
+      TriagemHttp::Situacao situacao = _triagem.examinar(vaga, agora);
+      if (situacao == TriagemHttp::TRIAGEM_PRONTA) {
+        // O mesmo que o WebServer faz ao aceitar, mas com a requisição já no buffer.
+        _currentClient = _pendentes[vaga];
+        _currentStatus = HC_WAIT_READ;
+        _statusChange = agora;
+        _pendentes[vaga] = WiFiClient();
+        _triagem.liberar(vaga);
+      } else if (situacao == TriagemHttp::TRIAGEM_DESCARTAR) {
+        _pendentes[vaga].stop();
+        _triagem.liberar(vaga);
+      }
+    }
+    if (_currentStatus == HC_NONE) return;
+  }
+  WebServer::handleClient();
+}
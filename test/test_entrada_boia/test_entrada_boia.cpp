@@ -0,0 +1,109 @@
+/*
+  Filtro da boia (EntradaBoia): glitch, trepidação, debounce com o instante
+  da primeira borda, fila cheia e o estouro do micros(). As bordas vêm da
+  tabela de pinos simulada, pela mesma interrupção do firmware.
+*/
+#include <unity.h>
+#include "entrada_boia.h"
+
+void setUp() {}
+void tearDown() {}
+
+const unsigned long DEBOUNCE_MS = 50;
+const unsigned long GLITCH_MS = 5;
+
+// Um pino por teste: a interrupção de cada EntradaBoia fica presa ao dela.
+static void iniciarEm(EntradaBoia& boia, uint8_t pino, uint64_t inicioMs) {
+  sim::definirRelogio(inicioMs);
+  sim::forcarPino(pino, HIGH);
+  boia.iniciar(pino, DEBOUNCE_MS, GLITCH_MS, micros());
+}
+
+static void bordas(uint8_t pino, const uint32_t* atrasosUs, size_t quantidade, int primeiroNivel) {
+  uint64_t base = sim::relogioTotalUs();
+  int nivel = primeiroNivel;
+  for (size_t i = 0; i < quantidade; i++) {
+    sim::agendarPino(pino, nivel, base + atrasosUs[i]);
+    nivel = nivel == LOW ? HIGH : LOW;
+  }
+}
+
+static void test_pulso_curto_e_glitch() {
+  static EntradaBoia boia;
+  iniciarEm(boia, 30, 1000);
+  const uint32_t pulso[] = { 1000, 3000 };  // 2 ms em LOW
+  bordas(30, pulso, 2, LOW);
+  sim::avancarRelogio(100);
+  TEST_ASSERT_FALSE(boia.atualizar(micros()));
+  TEST_ASSERT_EQUAL_INT(HIGH, boia.nivel());
+  EstatisticasBoia e = boia.estatisticas();
+  TEST_ASSERT_EQUAL_UINT32(2, e.bordas);
+  TEST_ASSERT_EQUAL_UINT32(1, e.glitches);
+  TEST_ASSERT_EQUAL_UINT32(0, e.mudancas);
+}
+
+static void test_trepidacao_que_volta_nao_muda_o_nivel() {
+  static EntradaBoia boia;
+  iniciarEm(boia, 31, 1000);
+  const uint32_t ida_e_volta[] = { 1000, 10000, 20000, 30000 };
+  bordas(31, ida_e_volta, 4, LOW);
+  sim::avancarRelogio(100);
+  TEST_ASSERT_FALSE(boia.atualizar(micros()));
+  TEST_ASSERT_EQUAL_INT(HIGH, boia.nivel());
+  TEST_ASSERT_EQUAL_UINT32(1, boia.estatisticas().trepidacoes);
+}
+
+static void test_debounce_guarda_o_instante_da_primeira_borda() {
+  static EntradaBoia boia;
+  iniciarEm(boia, 32, 1000);
+  uint32_t inicioUs = micros();
+  const uint32_t trepidando[] = { 1000, 8000, 15000 };  // termina em LOW
+  bordas(32, trepidando, 3, LOW);
+  sim::avancarRelogio(30);  // 15 ms depois da última borda: ainda no debounce
+  TEST_ASSERT_FALSE(boia.atualizar(micros()));
+  sim::avancarRelogio(70);
+  TEST_ASSERT_TRUE(boia.atualizar(micros()));
+  TEST_ASSERT_EQUAL_INT(LOW, boia.nivel());
+  TEST_ASSERT_EQUAL_UINT32(inicioUs + 1000, boia.instanteMudancaUs());
+  TEST_ASSERT_EQUAL_UINT32(1, boia.estatisticas().mudancas);
+}
+
+static void test_fila_cheia_ressincroniza_pelo_pino() {
+  static EntradaBoia boia;
+  iniciarEm(boia, 33, 1000);
+  const size_t BORDAS = 3 * EntradaBoia::CAPACIDADE_FILA + 1;  // ímpar: termina em LOW
+  uint32_t atrasos[BORDAS];
+  for (size_t i = 0; i < BORDAS; i++) atrasos[i] = 1000 + 10000 * i;
+  bordas(33, atrasos, BORDAS, LOW);
+  sim::avancarRelogio(1000);
+  // Sem ciclo no meio, a fila transborda; o nível lido corrige, contando o debounce a partir daqui.
+  TEST_ASSERT_FALSE(boia.atualizar(micros()));
+  TEST_ASSERT_GREATER_OR_EQUAL(BORDAS - EntradaBoia::CAPACIDADE_FILA, boia.estatisticas().perdidas);
+  sim::avancarRelogio(DEBOUNCE_MS + 1);
+  TEST_ASSERT_TRUE(boia.atualizar(micros()));
+  TEST_ASSERT_EQUAL_INT(LOW, boia.nivel());
+}
+
+static void test_atravessa_o_estouro_do_micros() {
+  static EntradaBoia boia;
+  // 20 ms antes de o micros() de 32 bits dar a volta.
+  iniciarEm(boia, 34, 0xFFFFFFFFULL / 1000ULL - 20);
+  uint32_t inicioUs = micros();
+  const uint32_t descida[] = { 10000 };
+  bordas(34, descida, 1, LOW);
+  sim::avancarRelogio(40);  // a borda antes do estouro, o ciclo depois
+  TEST_ASSERT_FALSE(boia.atualizar(micros()));
+  sim::avancarRelogio(40);
+  TEST_ASSERT_TRUE(boia.atualizar(micros()));
+  TEST_ASSERT_EQUAL_UINT32((uint32_t)(inicioUs + 10000), boia.instanteMudancaUs());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_pulso_curto_e_glitch);
+  RUN_TEST(test_trepidacao_que_volta_nao_muda_o_nivel);
+  RUN_TEST(test_debounce_guarda_o_instante_da_primeira_borda);
+  RUN_TEST(test_fila_cheia_ressincroniza_pelo_pino);
+  RUN_TEST(test_atravessa_o_estouro_do_micros);
+  return UNITY_END();
+}
@@ -0,0 +1,72 @@
+/*
+  EscritorJson: vírgulas e aninhamento, números formatados à mão, estouro
+  sem truncar em silêncio e o envio em pedaços por um buffer pequeno.
+*/
+#include <unity.h>
+#include <string>
+#include "escritor_json.h"
+
+void setUp() {}
+void tearDown() {}
+
+static void escreverDocumento(EscritorJson& json) {
+  json.abrirObjeto();
+  json.campo("resolucao", 60UL);
+  json.abrirLista("dados");
+  for (int i = 0; i < 40; i++) json.valor(20.0f + i * 0.25f, 1);
+  json.fecharLista();
+  json.campo("texto", "aspas \" e barra \\");
+  json.campo("negativo", -0.04f, 1);
+  json.fecharObjeto();
+}
+
+static void juntar(const char* dados, size_t tamanho, void* contexto) {
+  static_cast<std::string*>(contexto)->append(dados, tamanho);
+}
+
+static void test_numeros_e_separadores() {
+  char buffer[128];
+  EscritorJson json(buffer, sizeof(buffer));
+  json.abrirObjeto();
+  json.campo("ligado", true);
+  json.campo("temperatura", 25.04f, 1);
+  json.campo("media", 47.25f, 1);
+  json.abrirLista("historico");
+  json.valor(12UL);
+  json.valor(-3L);
+  json.fecharLista();
+  json.fecharObjeto();
+  TEST_ASSERT_FALSE(json.estourou());
+  TEST_ASSERT_EQUAL_STRING("{\"ligado\":true,\"temperatura\":25.0,\"media\":47.3,\"historico\":[12,-3]}", buffer);
+}
+
+static void test_estouro_sem_esvaziar_nao_trunca_em_silencio() {
+  char buffer[32];
+  EscritorJson json(buffer, sizeof(buffer));
+  escreverDocumento(json);
+  TEST_ASSERT_TRUE(json.estourou());
+  TEST_ASSERT_EQUAL_UINT32(sizeof(buffer) - 1, json.tamanho());
+}
+
+static void test_em_pedacos_sai_igual_ao_buffer_grande() {
+  static char grande[1024];
+  EscritorJson inteiro(grande, sizeof(grande));
+  escreverDocumento(inteiro);
+  TEST_ASSERT_FALSE(inteiro.estourou());
+
+  std::string enviado;
+  char pequeno[16];
+  EscritorJson json(pequeno, sizeof(pequeno), juntar, &enviado);
+  escreverDocumento(json);
+  json.esvaziar();
+  TEST_ASSERT_FALSE(json.estourou());
+  TEST_ASSERT_EQUAL_STRING(grande, enviado.c_str());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_numeros_e_separadores);
+  RUN_TEST(test_estouro_sem_esvaziar_nao_trunca_em_silencio);
+  RUN_TEST(test_em_pedacos_sai_igual_ao_buffer_grande);
+  return UNITY_END();
+}
@@ -0,0 +1,145 @@
+/*
+  Primitivas sem trava (estado_compartilhado.h): o seqlock nunca entrega uma
+  cópia pela metade e as filas entregam tudo, uma vez e em ordem, também
+  com produtores e consumidor em threads de verdade.
+*/
+#include <unity.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "estado_compartilhado.h"
+
+void setUp() {}
+void tearDown() {}
+
+// Grande o bastante para a cópia não ser atômica por acaso.
+struct Bloco {
+  uint32_t valores[64];
+};
+
+static void test_seqlock_nunca_entrega_copia_rasgada() {
+  static EstadoCompartilhado<Bloco> estado;
+  const uint32_t PUBLICACOES = 200000;
+  std::atomic<bool> fim{false};
+  std::thread escritor([&]() {
+    Bloco bloco;
+    for (uint32_t k = 1; k <= PUBLICACOES; k++) {
+      for (uint32_t& v : bloco.valores) v = k;
+      estado.publicar(bloco);
+      if (k % 64 == 0) std::this_thread::yield();
+    }
+    fim = true;
+  });
+  uint32_t rasgadas = 0, ultima = 0, regressoes = 0;
+  while (!fim) {
+    Bloco copia = estado.ler();
+    for (uint32_t v : copia.valores) rasgadas += v != copia.valores[0];
+    regressoes += copia.valores[0] < ultima;
+    ultima = copia.valores[0];
+  }
+  escritor.join();
+  TEST_ASSERT_EQUAL_UINT32(0, rasgadas);
+  TEST_ASSERT_EQUAL_UINT32(0, regressoes);
+  TEST_ASSERT_EQUAL_UINT32(PUBLICACOES, estado.ler().valores[63]);
+}
+
+static void test_fila_spsc_capacidade_e_ordem() {
+  FilaSpsc<int, 8> fila;
+  for (int i = 0; i < 8; i++) TEST_ASSERT_TRUE(fila.enviar(i));
+  TEST_ASSERT_FALSE(fila.enviar(8));
+  int item = -1;
+  TEST_ASSERT_TRUE(fila.receber(item));
+  TEST_ASSERT_EQUAL_INT(0, item);
+  TEST_ASSERT_TRUE(fila.enviar(8));
+  for (int i = 1; i <= 8; i++) {
+    TEST_ASSERT_TRUE(fila.receber(item));
+    TEST_ASSERT_EQUAL_INT(i, item);
+  }
+  TEST_ASSERT_FALSE(fila.receber(item));
+}
+
+static void test_fila_spsc_entre_threads() {
+  static FilaSpsc<uint32_t, 16> fila;
+  const uint32_t ITENS = 1000000;
+  std::thread produtor([&]() {
+    for (uint32_t i = 0; i < ITENS;) {
+      if (fila.enviar(i)) i++;
+      else std::this_thread::yield();
+    }
+  });
+  uint32_t esperado = 0, foraDeOrdem = 0, item;
+  while (esperado < ITENS) {
+    if (!fila.receber(item)) {
+      std::this_thread::yield();
+      continue;
+    }
+    foraDeOrdem += item != esperado;
+    esperado++;
+  }
+  produtor.join();
+  TEST_ASSERT_EQUAL_UINT32(0, foraDeOrdem);
+  TEST_ASSERT_FALSE(fila.receber(item));
+}
+
+static void test_fila_mpsc_cheia_recusa_sem_esperar() {
+  FilaMpsc<int, 4> fila;
+  for (int i = 0; i < 4; i++) TEST_ASSERT_TRUE(fila.enviar(i));
+  TEST_ASSERT_FALSE(fila.enviar(4));
+  int item = -1;
+  for (int i = 0; i < 4; i++) {
+    TEST_ASSERT_TRUE(fila.receber(item));
+    TEST_ASSERT_EQUAL_INT(i, item);
+  }
+  TEST_ASSERT_FALSE(fila.receber(item));
+  // Dá a volta no anel: as sequências das posições continuam valendo.
+  for (int volta = 0; volta < 10; volta++) {
+    TEST_ASSERT_TRUE(fila.enviar(volta));
+    TEST_ASSERT_TRUE(fila.receber(item));
+    TEST_ASSERT_EQUAL_INT(volta, item);
+  }
+}
+
+static void test_fila_mpsc_varios_produtores() {
+  struct Item {
+    uint32_t produtor;
+    uint32_t sequencia;
+  };
+  static FilaMpsc<Item, 64> fila;
+  const int PRODUTORES = 4;
+  const uint32_t POR_PRODUTOR = 200000;
+  std::vector<std::thread> produtores;
+  for (int p = 0; p < PRODUTORES; p++) {
+    produtores.emplace_back([p]() {
+      for (uint32_t i = 0; i < POR_PRODUTOR;) {
+        if (fila.enviar(Item{ (uint32_t)p, i })) i++;
+        else std::this_thread::yield();
+      }
+    });
+  }
+  uint32_t proximo[PRODUTORES] = {};
+  uint32_t recebidos = 0, foraDeOrdem = 0;
+  Item item;
+  while (recebidos < PRODUTORES * POR_PRODUTOR) {
+    if (!fila.receber(item)) {
+      std::this_thread::yield();
+      continue;
+    }
+    foraDeOrdem += item.sequencia != proximo[item.produtor];
+    proximo[item.produtor] = item.sequencia + 1;
+    recebidos++;
+  }
+  for (std::thread& t : produtores) t.join();
+  TEST_ASSERT_EQUAL_UINT32(0, foraDeOrdem);
+  for (int p = 0; p < PRODUTORES; p++) TEST_ASSERT_EQUAL_UINT32(POR_PRODUTOR, proximo[p]);
+  TEST_ASSERT_FALSE(fila.receber(item));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_seqlock_nunca_entrega_copia_rasgada);
+  RUN_TEST(test_fila_spsc_capacidade_e_ordem);
+  RUN_TEST(test_fila_spsc_entre_threads);
+  RUN_TEST(test_fila_mpsc_cheia_recusa_sem_esperar);
+  RUN_TEST(test_fila_mpsc_varios_produtores);
+  return UNITY_END();
+}
@@ -0,0 +1,84 @@
+/*
+  Leitor dos DS18B20 (LeitorTemperatura): o 85 °C do scratchpad de um sensor
+  que acabou de ligar é descartado, e só vale quando a conversão seguinte o
+  repete. Os sensores são os simulados (sim/DallasTemperature.h), que devolvem
+  85 °C quando lidos antes do fim da primeira conversão.
+*/
+#include <unity.h>
+#include "leitor_temperatura.h"
+
+static OneWire barramento(4);
+static DallasTemperature sensores(&barramento);
+
+void setUp() {
+  sim::definirRelogio(1000);
+  sim::sensoresNoBarramento = 1;
+  sim::sensorConectado = true;
+  sim::atrasoConversaoMs = 0;
+  sim::temperaturaSensores[0] = 40.0f;
+}
+void tearDown() {}
+
+// Avança o relógio e faz uma passada do leitor, como o ciclo de controle.
+static LeitorTemperatura::Resultado passada(LeitorTemperatura& leitor, unsigned long ms) {
+  sim::avancarRelogio(ms);
+  return leitor.atualizar(millis());
+}
+
+// Uma conversão inteira (12 bits, 750 ms, a cada 1 s): dispara e coleta.
+static LeitorTemperatura::Resultado conversao(LeitorTemperatura& leitor) {
+  TEST_ASSERT_EQUAL_INT(LeitorTemperatura::SEM_NOVIDADE, passada(leitor, 250));
+  return passada(leitor, 750);
+}
+
+static void test_85_ao_ligar_e_descartado() {
+  LeitorTemperatura leitor(sensores);
+  leitor.iniciar(1, 12, 1000);
+  // O sensor ainda não terminou a primeira conversão quando é lido: devolve o 85 do scratchpad.
+  sim::atrasoConversaoMs = 1200;
+  TEST_ASSERT_EQUAL_INT(LeitorTemperatura::SEM_NOVIDADE, passada(leitor, 0));
+  TEST_ASSERT_EQUAL_INT(LeitorTemperatura::SEM_NOVIDADE, passada(leitor, 750));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, DEVICE_DISCONNECTED_C, leitor.ultimaLeitura(0));
+  sim::atrasoConversaoMs = 0;
+  TEST_ASSERT_EQUAL_INT(LeitorTemperatura::LEITURA_NOVA, conversao(leitor));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 40.0f, leitor.ultimaLeitura(0));
+}
+
+static void test_85_isolado_mantem_a_leitura_anterior() {
+  LeitorTemperatura leitor(sensores);
+  leitor.iniciar(1, 12, 1000);
+  TEST_ASSERT_EQUAL_INT(LeitorTemperatura::SEM_NOVIDADE, passada(leitor, 0));
+  TEST_ASSERT_EQUAL_INT(LeitorTemperatura::LEITURA_NOVA, passada(leitor, 750));
+  // Um sensor que reiniciou no meio da operação devolve 85 uma vez.
+  sim::temperaturaSensores[0] = 85.0f;
+  TEST_ASSERT_EQUAL_INT(LeitorTemperatura::SEM_NOVIDADE, conversao(leitor));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 40.0f, leitor.ultimaLeitura(0));
+  sim::temperaturaSensores[0] = 41.0f;
+  TEST_ASSERT_EQUAL_INT(LeitorTemperatura::LEITURA_NOVA, conversao(leitor));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 41.0f, leitor.ultimaLeitura(0));
+}
+
+static void test_85_confirmado_e_aceito() {
+  LeitorTemperatura leitor(sensores);
+  leitor.iniciar(1, 12, 1000);
+  sim::temperaturaSensores[0] = 85.0f;
+  TEST_ASSERT_EQUAL_INT(LeitorTemperatura::SEM_NOVIDADE, passada(leitor, 0));
+  TEST_ASSERT_EQUAL_INT(LeitorTemperatura::SEM_NOVIDADE, passada(leitor, 750));
+  // A segunda conversão repete o valor: é uma temperatura de verdade, e a proteção precisa dela.
+  TEST_ASSERT_EQUAL_INT(LeitorTemperatura::LEITURA_NOVA, conversao(leitor));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 85.0f, leitor.ultimaLeitura(0));
+  TEST_ASSERT_EQUAL_INT(LeitorTemperatura::LEITURA_NOVA, conversao(leitor));
+  // Enquanto o 85 se repete ele segue valendo; depois de outro valor, volta a esperar confirmação.
+  sim::temperaturaSensores[0] = 60.0f;
+  TEST_ASSERT_EQUAL_INT(LeitorTemperatura::LEITURA_NOVA, conversao(leitor));
+  sim::temperaturaSensores[0] = 85.0f;
+  TEST_ASSERT_EQUAL_INT(LeitorTemperatura::SEM_NOVIDADE, conversao(leitor));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_85_ao_ligar_e_descartado);
+  RUN_TEST(test_85_isolado_mantem_a_leitura_anterior);
+  RUN_TEST(test_85_confirmado_e_aceito);
+  return UNITY_END();
+}
@@ -0,0 +1,70 @@
+/*
+  Limite por cliente (limitador_clientes.h): rajada, reposição atravessando
+  o estouro do millis(), custo do login, a troca do endereço mais parado
+  com a tabela cheia e a troca dos valores do limite.
+*/
+#include <unity.h>
+#include "limitador_clientes.h"
+
+void setUp() {}
+void tearDown() {}
+
+typedef LimitadorClientes L;
+
+static L limitador;
+static uint32_t espera = 0;
+const uint32_t PAINEL = 0x0A00A8C0, SCRIPT = 0x0B00A8C0;
+const unsigned long HORA = 3600000UL;
+
+// Começa perto do estouro: a reposição atravessa o zero do millis().
+static unsigned long em(unsigned long ms) { return (0xFFFFFE00UL + ms) & 0xFFFFFFFFUL; }
+
+static uint32_t seguidas(uint32_t ip, unsigned long agora, uint32_t custo) {
+  uint32_t n = 0;
+  while (n < 1000 && limitador.admitir(ip, agora, custo, espera)) n++;
+  return n;
+}
+
+static void test_rajada_e_reposicao() {
+  TEST_ASSERT_EQUAL_UINT32(limitador.rajada(), seguidas(PAINEL, em(0), 1));
+  TEST_ASSERT_EQUAL_UINT32(1, espera);
+  TEST_ASSERT_EQUAL_UINT32(limitador.taxaPorS(), seguidas(PAINEL, em(1000), 1));
+  TEST_ASSERT_EQUAL_UINT32(limitador.rajada(), seguidas(PAINEL, em(HORA), 1));
+}
+
+static void test_login_custa_mais() {
+  TEST_ASSERT_EQUAL_UINT32(limitador.rajada() / limitador.custoLogin(), seguidas(SCRIPT, em(HORA + 1), limitador.custoLogin()));
+  TEST_ASSERT_EQUAL_UINT32(limitador.custoLogin() / limitador.taxaPorS(), espera);
+}
+
+static void test_tabela_cheia_troca_o_mais_parado() {
+  for (int i = 0; i < L::MAX_CLIENTES - 1; i++) limitador.admitir(0x0100000A + i, em(HORA + 2 + i), 1, espera);
+  TEST_ASSERT_EQUAL_INT(L::MAX_CLIENTES, limitador.acompanhados());
+  // O endereço novo tomou o lugar do painel; o script esgotado continua esgotado
+  // e o painel, quando volta, volta com o balde cheio.
+  TEST_ASSERT_FALSE(limitador.admitir(SCRIPT, em(HORA + 100), limitador.custoLogin(), espera));
+  TEST_ASSERT_EQUAL_UINT32(limitador.rajada(), seguidas(PAINEL, em(HORA + 100), 1));
+}
+
+static void test_configurar_troca_taxa_e_rajada() {
+  TEST_ASSERT_FALSE(limitador.configurar(0, 30, 10));
+  TEST_ASSERT_FALSE(limitador.configurar(5, L::RAJADA_MAXIMA + 1, 10));
+  TEST_ASSERT_FALSE(limitador.configurar(5, 8, 9));  // login mais caro que a rajada nunca passaria
+  TEST_ASSERT_EQUAL_UINT32(L::RAJADA_PADRAO, limitador.rajada());
+  TEST_ASSERT_TRUE(limitador.configurar(2, 8, 4));
+  // O painel, com o balde cheio da rajada antiga, é aparado na rajada nova.
+  TEST_ASSERT_EQUAL_UINT32(8, seguidas(PAINEL, em(2 * HORA), 1));
+  TEST_ASSERT_EQUAL_UINT32(1, espera);
+  TEST_ASSERT_EQUAL_UINT32(2, seguidas(PAINEL, em(2 * HORA + 1000), 1));
+  TEST_ASSERT_EQUAL_UINT32(2, seguidas(SCRIPT, em(2 * HORA), 4));
+  TEST_ASSERT_EQUAL_UINT32(2, espera);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_rajada_e_reposicao);
+  RUN_TEST(test_login_custa_mais);
+  RUN_TEST(test_tabela_cheia_troca_o_mais_parado);
+  RUN_TEST(test_configurar_troca_taxa_e_rajada);
+  return UNITY_END();
+}
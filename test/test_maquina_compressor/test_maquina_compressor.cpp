@@ -0,0 +1,142 @@
+/*
+  Máquina de estados do compressor: algumas transições conferidas à mão,
+  entre elas a espera crescente e o bloqueio do poço seco, e a verificação
+  por sequências sorteadas (verificacao_maquina.h), que cobre as
+  invariantes de segurança, a reprodução pelo rastro e todas as linhas da
+  tabela.
+*/
+#include <unity.h>
+#include "maquina_compressor.h"
+#include "verificacao_maquina.h"
+
+void setUp() {}
+void tearDown() {}
+
+static EventoCompressor evento(SinalCompressor sinal, uint32_t instante) {
+  EventoCompressor e = {};
+  e.sinal = sinal;
+  e.instante = instante;
+  e.temperatura = 40.0f;
+  e.temperaturaMaxima = 60.0f;
+  e.temperaturaReligamento = 55.0f;
+  e.segundosAteLimite = -1.0f;
+  e.tempoLigadoMs = 600000UL;
+  e.tempoDescansoMs = 100000UL;
+  return e;
+}
+
+static void test_ciclo_automatico_liga_e_desliga_pelos_tempos() {
+  MaquinaCompressor m = { MODO_DESCANSO, FALHA_NENHUMA, 0, 0, 0, 0 };
+  TEST_ASSERT_NULL(despachar(m, evento(SINAL_CICLO, 99999UL)));
+  const TransicaoCompressor* t = despachar(m, evento(SINAL_CICLO, 100000UL));
+  TEST_ASSERT_NOT_NULL(t);
+  TEST_ASSERT_EQUAL_INT(MODO_LIGADO, m.modo);
+  TEST_ASSERT_TRUE(t->efeitos & EFEITO_LIGAR_RELE);
+  TEST_ASSERT_EQUAL_UINT32(100000UL, m.inicioTemporizador);
+  t = despachar(m, evento(SINAL_CICLO, 700000UL));
+  TEST_ASSERT_NOT_NULL(t);
+  TEST_ASSERT_EQUAL_INT(MODO_DESCANSO, m.modo);
+  TEST_ASSERT_TRUE(t->efeitos & EFEITO_FIM_CICLO);
+}
+
+static void test_caixa_cheia_e_temperatura_alta_abrem_o_rele() {
+  MaquinaCompressor m = { MODO_LIGADO, FALHA_NENHUMA, 0, 0, 0, 0 };
+  const TransicaoCompressor* t = despachar(m, evento(SINAL_CAIXA_CHEIA, 1000UL));
+  TEST_ASSERT_EQUAL_INT(MODO_DESCANSO, m.modo);
+  TEST_ASSERT_TRUE(t->efeitos & EFEITO_DESLIGAR_RELE);
+
+  m = { MODO_MANUAL_LIGADO, FALHA_NENHUMA, 0, 0, 0, 0 };
+  t = despachar(m, evento(SINAL_TEMPERATURA_ALTA, 1000UL));
+  TEST_ASSERT_EQUAL_INT(MODO_MANUAL_PARADA_TERMICA, m.modo);
+  TEST_ASSERT_TRUE(t->efeitos & EFEITO_EMERGENCIA);
+  // Só religa abaixo da temperatura de religamento.
+  EventoCompressor ligar = evento(SINAL_LIGAR, 2000UL);
+  ligar.temperatura = 57.0f;
+  TEST_ASSERT_NULL(despachar(m, ligar));
+  ligar.temperatura = 50.0f;
+  TEST_ASSERT_NOT_NULL(despachar(m, ligar));
+  TEST_ASSERT_EQUAL_INT(MODO_MANUAL_LIGADO, m.modo);
+}
+
+static void test_parada_preditiva_so_antes_do_fim_do_ciclo() {
+  MaquinaCompressor m = { MODO_LIGADO, FALHA_NENHUMA, 0, 0, 0, 0 };
+  EventoCompressor e = evento(SINAL_CICLO, 590000UL);
+  e.segundosAteLimite = 20.0f;  // o temporizador desliga em 10 s, antes do limite
+  TEST_ASSERT_NULL(despachar(m, e));
+  e.instante = 500000UL;
+  const TransicaoCompressor* t = despachar(m, e);
+  TEST_ASSERT_EQUAL_INT(MODO_PAUSA_PREDITIVA, m.modo);
+  TEST_ASSERT_TRUE(t->efeitos & EFEITO_PARADA_PREDITIVA);
+}
+
+static void test_falha_de_corrente_espera_liberacao() {
+  MaquinaCompressor m = { MODO_LIGADO, FALHA_NENHUMA, 0, 0, 0, 0 };
+  EventoCompressor e = evento(SINAL_FALHA_CORRENTE, 5000UL);
+  e.falha = FALHA_ROTOR_BLOQUEADO;
+  despachar(m, e);
+  TEST_ASSERT_EQUAL_INT(MODO_FALHA_CORRENTE, m.modo);
+  TEST_ASSERT_EQUAL_INT(FALHA_ROTOR_BLOQUEADO, m.falha);
+  // Rotor bloqueado não se libera com o tempo, nem por comando de ligar.
+  TEST_ASSERT_NULL(despachar(m, evento(SINAL_CICLO, 5000UL + 2 * ESPERA_APOS_SECO_MS)));
+  despachar(m, evento(SINAL_LIGAR, 5000UL + 2 * ESPERA_APOS_SECO_MS));
+  TEST_ASSERT_EQUAL_INT(MODO_MANUAL_DESLIGADO, m.modo);
+  despachar(m, evento(SINAL_AUTOMATICO, 5000UL + 2 * ESPERA_APOS_SECO_MS));
+  TEST_ASSERT_EQUAL_INT(MODO_DESCANSO, m.modo);
+  TEST_ASSERT_EQUAL_INT(FALHA_NENHUMA, m.falha);
+}
+
+static uint32_t desarmarSeco(MaquinaCompressor& m, uint32_t instante) {
+  EventoCompressor e = evento(SINAL_FALHA_CORRENTE, instante);
+  e.falha = FALHA_FUNCIONAMENTO_SECO;
+  despachar(m, e);
+  TEST_ASSERT_EQUAL_INT(MODO_FALHA_CORRENTE, m.modo);
+  return instante;
+}
+
+static void test_poco_seco_espera_dobra_e_bloqueia() {
+  MaquinaCompressor m = { MODO_LIGADO, FALHA_NENHUMA, 0, 0, 0, 0 };
+  uint32_t t = desarmarSeco(m, 1000UL);
+  TEST_ASSERT_NULL(despachar(m, evento(SINAL_CICLO, t + ESPERA_APOS_SECO_MS - 1)));
+  despachar(m, evento(SINAL_CICLO, t + ESPERA_APOS_SECO_MS));
+  TEST_ASSERT_EQUAL_INT(MODO_LIGADO, m.modo);
+  // O segundo desarme seguido espera o dobro.
+  t = desarmarSeco(m, t + ESPERA_APOS_SECO_MS + 60000UL);
+  TEST_ASSERT_EQUAL_UINT8(2, m.desarmesSeco);
+  TEST_ASSERT_NULL(despachar(m, evento(SINAL_CICLO, t + 2 * ESPERA_APOS_SECO_MS - 1)));
+  despachar(m, evento(SINAL_CICLO, t + 2 * ESPERA_APOS_SECO_MS));
+  TEST_ASSERT_EQUAL_INT(MODO_LIGADO, m.modo);
+  // O terceiro bloqueia: o tempo não libera mais, só a volta ao automático.
+  t = desarmarSeco(m, t + 2 * ESPERA_APOS_SECO_MS + 60000UL);
+  TEST_ASSERT_TRUE(secoBloqueado(m));
+  TEST_ASSERT_NULL(despachar(m, evento(SINAL_CICLO, t + 100 * ESPERA_APOS_SECO_MS)));
+  despachar(m, evento(SINAL_AUTOMATICO, t + 100 * ESPERA_APOS_SECO_MS));
+  TEST_ASSERT_EQUAL_INT(MODO_DESCANSO, m.modo);
+  TEST_ASSERT_EQUAL_INT(FALHA_NENHUMA, m.falha);
+  TEST_ASSERT_EQUAL_UINT8(0, m.desarmesSeco);
+
+  // Um ciclo inteiro sem desarme zera a contagem: o desarme seguinte volta a esperar 30 min.
+  m = { MODO_LIGADO, FALHA_NENHUMA, 0, 0, 0, 0 };
+  t = desarmarSeco(m, 1000UL);
+  despachar(m, evento(SINAL_CICLO, t + ESPERA_APOS_SECO_MS));
+  despachar(m, evento(SINAL_CICLO, t + ESPERA_APOS_SECO_MS + 600000UL));
+  TEST_ASSERT_EQUAL_INT(MODO_DESCANSO, m.modo);
+  TEST_ASSERT_EQUAL_UINT8(0, m.desarmesSeco);
+}
+
+static void test_sequencias_sorteadas_respeitam_as_invariantes() {
+  ResultadoVerificacaoMaquina r = verificarMaquina(200000, 1);
+  TEST_ASSERT_EQUAL_UINT64_MESSAGE(0, r.violacoes, r.primeiraViolacao);
+  TEST_ASSERT_EQUAL_UINT64(0, r.divergenciasReproducao);
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(r.linhasTabela, r.linhasExercitadas, "linha da tabela inalcançável");
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_ciclo_automatico_liga_e_desliga_pelos_tempos);
+  RUN_TEST(test_caixa_cheia_e_temperatura_alta_abrem_o_rele);
+  RUN_TEST(test_parada_preditiva_so_antes_do_fim_do_ciclo);
+  RUN_TEST(test_falha_de_corrente_espera_liberacao);
+  RUN_TEST(test_poco_seco_espera_dobra_e_bloqueia);
+  RUN_TEST(test_sequencias_sorteadas_respeitam_as_invariantes);
+  return UNITY_END();
+}
@@ -0,0 +1,162 @@
+/*
+  Persistência no NVS: ida e volta do retrato, gravações evitadas, intervalo
+  mínimo, cópia corrompida e migração das chaves antigas.
+*/
+#include <unity.h>
+#include "persistencia.h"
+
+void setUp() {}
+void tearDown() {}
+
+// O intervalo mínimo entre gravações é estado do módulo: cada gravação avança o relógio o bastante.
+static unsigned long agora = 1000UL;
+static unsigned long proximaGravacao() {
+  agora += 120000UL;
+  return agora;
+}
+
+static EstadoControle estado;
+
+static void carregarNovo(const char* nome, Preferences& preferences, DadosPersistentes& dados) {
+  preferences.begin(nome, false);
+  preferences.clear();
+  carregarConfiguracoesOperacao(preferences, dados);
+  estado.dados = dados;
+}
+
+static uint32_t sequenciaDaChave(Preferences& preferences, const char* chave) {
+  uint8_t bruto[4096];
+  if (preferences.getBytes(chave, bruto, sizeof(bruto)) < 8) return 0;
+  uint32_t sequencia;
+  memcpy(&sequencia, bruto + 4, sizeof(sequencia));  // depois de versão e tamanho
+  return sequencia;
+}
+
+static void test_sem_nada_gravado_vale_o_padrao() {
+  Preferences preferences;
+  static DadosPersistentes dados;
+  carregarNovo("vazio", preferences, dados);
+  TEST_ASSERT_EQUAL_UINT32(PARAMETROS_PADRAO.tempoLigado, dados.parametros.tempoLigado);
+  TEST_ASSERT_EQUAL_INT(PARAMETROS_PADRAO.protecaoPreditiva, dados.parametros.protecaoPreditiva);
+  for (int c = 0; c < NUM_CANAIS; c++) TEST_ASSERT_EQUAL_UINT32(0, dados.canais[c].ciclosEnchimentoCompletos);
+}
+
+static void test_ida_e_volta_de_todos_os_canais() {
+  Preferences preferences;
+  static DadosPersistentes dados, lidos;
+  carregarNovo("idaevolta", preferences, dados);
+  estado.dados.parametros.tempoLigado = 420000UL;
+  estado.dados.parametros.glitchBoiaMs = 7;
+  estado.dados.parametros.correnteNominalA = 8.5f;
+  for (int c = 0; c < NUM_CANAIS; c++) {
+    estado.dados.canais[c].ciclosEnchimentoCompletos = 10 + c;
+    estado.dados.canais[c].historicoEnchimento[2].tempo = 900 + c;
+    estado.dados.canais[c].indiceHistoricoEnchimento = 3;
+  }
+  estado.versaoDados++;
+  TEST_ASSERT_TRUE(salvarConfiguracoesOperacao(preferences, estado, proximaGravacao()));
+  preferences.end();
+
+  preferences.begin("idaevolta", false);
+  carregarConfiguracoesOperacao(preferences, lidos);
+  TEST_ASSERT_EQUAL_UINT32(420000UL, lidos.parametros.tempoLigado);
+  TEST_ASSERT_EQUAL_UINT32(7, lidos.parametros.glitchBoiaMs);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 8.5f, lidos.parametros.correnteNominalA);
+  for (int c = 0; c < NUM_CANAIS; c++) {
+    TEST_ASSERT_EQUAL_UINT32(10 + c, lidos.canais[c].ciclosEnchimentoCompletos);
+    TEST_ASSERT_EQUAL_UINT32(900 + c, lidos.canais[c].historicoEnchimento[2].tempo);
+    TEST_ASSERT_EQUAL_INT(3, lidos.canais[c].indiceHistoricoEnchimento);
+  }
+}
+
+static void test_grava_so_o_que_mudou_e_respeita_o_intervalo() {
+  Preferences preferences;
+  static DadosPersistentes dados;
+  carregarNovo("intervalo", preferences, dados);
+  estado.dados.canais[0].ciclosParciaisOperacao = 1;
+  estado.versaoDados++;
+  unsigned long instante = proximaGravacao();
+  TEST_ASSERT_TRUE(salvarConfiguracoesOperacao(preferences, estado, instante));
+  unsigned long gravacoes = Preferences::gravacoes;
+  EstatisticasPersistencia antes = lerEstatisticasPersistencia();
+
+  // Versão marcada sem nenhum campo diferente: nada vai para a flash.
+  estado.versaoDados++;
+  TEST_ASSERT_FALSE(salvarConfiguracoesOperacao(preferences, estado, proximaGravacao()));
+  TEST_ASSERT_EQUAL_UINT32(antes.gravacoesEvitadas + 1, lerEstatisticasPersistencia().gravacoesEvitadas);
+  TEST_ASSERT_EQUAL_UINT32(gravacoes, Preferences::gravacoes);
+
+  // Mudou, mas dentro do intervalo mínimo desde a última gravação.
+  instante = agora;
+  estado.dados.canais[0].ciclosParciaisOperacao = 2;
+  estado.versaoDados++;
+  TEST_ASSERT_FALSE(salvarConfiguracoesOperacao(preferences, estado, instante - 120000UL + 30000UL));
+  TEST_ASSERT_TRUE(salvarConfiguracoesOperacao(preferences, estado, proximaGravacao()));
+  TEST_ASSERT_EQUAL_UINT32(gravacoes + 1, Preferences::gravacoes);
+}
+
+static void test_copia_corrompida_volta_para_a_anterior() {
+  Preferences preferences;
+  static DadosPersistentes dados, lidos;
+  carregarNovo("corrompida", preferences, dados);
+  estado.dados.canais[0].ciclosEnchimentoCompletos = 100;
+  estado.versaoDados++;
+  TEST_ASSERT_TRUE(salvarConfiguracoesOperacao(preferences, estado, proximaGravacao()));
+  estado.dados.canais[0].ciclosEnchimentoCompletos = 101;
+  estado.versaoDados++;
+  TEST_ASSERT_TRUE(salvarConfiguracoesOperacao(preferences, estado, proximaGravacao()));
+
+  // Estraga um byte do retrato mais novo, como uma queda de energia no meio da gravação.
+  const char* nova = sequenciaDaChave(preferences, "estadoA") > sequenciaDaChave(preferences, "estadoB") ? "estadoA" : "estadoB";
+  uint8_t bruto[4096];
+  size_t tamanho = preferences.getBytes(nova, bruto, sizeof(bruto));
+  TEST_ASSERT_GREATER_THAN(20, tamanho);
+  bruto[20] ^= 0x40;
+  preferences.putBytes(nova, bruto, tamanho);
+
+  carregarConfiguracoesOperacao(preferences, lidos);
+  TEST_ASSERT_EQUAL_UINT32(100, lidos.canais[0].ciclosEnchimentoCompletos);
+
+  // Truncada também não vale.
+  preferences.putBytes(nova, bruto, 10);
+  carregarConfiguracoesOperacao(preferences, lidos);
+  TEST_ASSERT_EQUAL_UINT32(100, lidos.canais[0].ciclosEnchimentoCompletos);
+}
+
+static void test_migra_as_chaves_antigas() {
+  Preferences preferences;
+  static DadosPersistentes dados;
+  preferences.begin("legado", false);
+  preferences.clear();
+  preferences.putULong("tempoLigado", 480000UL);
+  preferences.putFloat("tempMaxima", 55.0f);
+  preferences.putULong("ciclosEnch", 42);
+  preferences.putInt("idxHEnch", 2);
+  uint32_t historico[TAMANHO_HISTORICO_ENCHIMENTO * 2] = {};
+  historico[2] = 1234;  // tempo do índice 1
+  historico[3] = 3;     // ciclos do índice 1
+  preferences.putBytes("hEnchimento", historico, sizeof(historico));
+
+  carregarConfiguracoesOperacao(preferences, dados);
+  TEST_ASSERT_EQUAL_UINT32(480000UL, dados.parametros.tempoLigado);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 55.0f, dados.parametros.temperaturaMaxima);
+  TEST_ASSERT_EQUAL_UINT32(PARAMETROS_PADRAO.tempoDescanso, dados.parametros.tempoDescanso);
+  TEST_ASSERT_EQUAL_UINT32(42, dados.canais[0].ciclosEnchimentoCompletos);
+  TEST_ASSERT_EQUAL_INT(2, dados.canais[0].indiceHistoricoEnchimento);
+  TEST_ASSERT_EQUAL_UINT32(1234, dados.canais[0].historicoEnchimento[1].tempo);
+  TEST_ASSERT_EQUAL_UINT32(3, dados.canais[0].historicoEnchimento[1].ciclosParciais);
+  // As chaves antigas saem; o retrato único entra.
+  TEST_ASSERT_FALSE(preferences.isKey("tempoLigado"));
+  TEST_ASSERT_FALSE(preferences.isKey("hEnchimento"));
+  TEST_ASSERT_TRUE(preferences.isKey("estadoA") || preferences.isKey("estadoB"));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_sem_nada_gravado_vale_o_padrao);
+  RUN_TEST(test_ida_e_volta_de_todos_os_canais);
+  RUN_TEST(test_grava_so_o_que_mudou_e_respeita_o_intervalo);
+  RUN_TEST(test_copia_corrompida_volta_para_a_anterior);
+  RUN_TEST(test_migra_as_chaves_antigas);
+  return UNITY_END();
+}
@@ -0,0 +1,175 @@
+/*
+  Durabilidade do registro de telemetria no SPIFFS simulado (arquivos no
+  host): queda de energia no meio de um lote, cabeçalho truncado, cabeçalho
+  e amostra corrompidos e os segmentos da versão 1 (CRC-8 no cabeçalho).
+  Cada "reinício" é um RegistroTelemetria novo sobre os mesmos arquivos.
+*/
+#include <unity.h>
+#include <SPIFFS.h>
+#include <vector>
+#include "crc.h"
+#include "registro_telemetria.h"
+
+void setUp() {}
+void tearDown() { sim::bytesAteQueda = -1; }
+
+typedef RegistroTelemetria R;
+
+static EstadoControle estado;
+static unsigned long agoraMs = 0;
+static uint32_t instante = 1000;
+
+static void nome(int indice, char* destino) { snprintf(destino, 24, "/tlm_%02d.bin", indice); }
+
+static void limpar() {
+  SPIFFS.begin(true);
+  char caminho[24];
+  for (int i = 0; i < R::NUM_SEGMENTOS; i++) {
+    nome(i, caminho);
+    SPIFFS.remove(caminho);
+  }
+}
+
+// Cada amostra leva nos ciclos parciais o próprio instante, para conferir que nada veio desalinhado.
+static void gravar(R& registro, uint32_t quantidade, bool descarregar = true) {
+  for (uint32_t i = 0; i < quantidade; i++) {
+    agoraMs += R::INTERVALO_AMOSTRAGEM_MS;
+    instante += 5;
+    estado.dados.canais[0].ciclosParciaisOperacao = instante;
+    registro.amostrar(estado, agoraMs, instante, false);
+  }
+  if (descarregar) registro.descarregar(agoraMs, true);
+}
+
+struct Lidas {
+  uint32_t quantidade = 0;
+  uint32_t ultimo = 0;
+  bool emOrdem = true;
+  bool coerentes = true;
+};
+
+static bool coletar(const AmostraTelemetria& a, void* contexto) {
+  Lidas& l = *static_cast<Lidas*>(contexto);
+  l.emOrdem &= a.instante > l.ultimo;
+  l.coerentes &= a.ciclosParciaisOperacao == a.instante;
+  l.ultimo = a.instante;
+  l.quantidade++;
+  return true;
+}
+
+static Lidas lerTudo(R& registro) {
+  Lidas l;
+  registro.percorrer(0, UINT32_MAX, coletar, &l);
+  TEST_ASSERT_TRUE_MESSAGE(l.emOrdem, "amostras fora de ordem");
+  TEST_ASSERT_TRUE_MESSAGE(l.coerentes, "amostra desalinhada");
+  return l;
+}
+
+static void estragarByte(int segmento, uint32_t posicao) {
+  char caminho[24];
+  nome(segmento, caminho);
+  File arquivo = SPIFFS.open(caminho, "r+");
+  TEST_ASSERT_TRUE(arquivo);
+  arquivo.seek(posicao);
+  int c = arquivo.read();
+  arquivo.seek(posicao);
+  uint8_t trocado = (uint8_t)(c ^ 0x10);
+  arquivo.write(&trocado, 1);
+  arquivo.close();
+}
+
+static void test_queda_no_meio_do_lote() {
+  limpar();
+  static R antes;
+  TEST_ASSERT_TRUE(antes.iniciar(SPIFFS));
+  gravar(antes, 40);
+  gravar(antes, 10, false);
+  // A energia cai depois de 3 amostras e meia do lote.
+  sim::bytesAteQueda = 3 * sizeof(AmostraTelemetria) + 5;
+  antes.descarregar(agoraMs, true);
+  TEST_ASSERT_EQUAL_UINT32(1, antes.falhasGravacao());
+  sim::bytesAteQueda = -1;
+
+  static R depois;
+  TEST_ASSERT_TRUE(depois.iniciar(SPIFFS));
+  TEST_ASSERT_EQUAL_UINT32(43, lerTudo(depois).quantidade);
+  // O segmento de fim quebrado foi abandonado: o que vem depois não desalinha.
+  gravar(depois, 5);
+  TEST_ASSERT_EQUAL_UINT32(48, lerTudo(depois).quantidade);
+}
+
+static void test_cabecalho_truncado() {
+  limpar();
+  static R antes;
+  TEST_ASSERT_TRUE(antes.iniciar(SPIFFS));
+  gravar(antes, R::AMOSTRAS_POR_SEGMENTO);
+  gravar(antes, 3, false);
+  // Cai durante o cabeçalho do segmento seguinte.
+  sim::bytesAteQueda = 7;
+  antes.descarregar(agoraMs, true);
+  sim::bytesAteQueda = -1;
+
+  static R depois;
+  TEST_ASSERT_TRUE(depois.iniciar(SPIFFS));
+  TEST_ASSERT_EQUAL_UINT32(R::AMOSTRAS_POR_SEGMENTO, lerTudo(depois).quantidade);
+  gravar(depois, 5);
+  TEST_ASSERT_EQUAL_UINT32(R::AMOSTRAS_POR_SEGMENTO + 5, lerTudo(depois).quantidade);
+}
+
+static void test_cabecalho_e_amostra_corrompidos() {
+  limpar();
+  static R antes;
+  TEST_ASSERT_TRUE(antes.iniciar(SPIFFS));
+  gravar(antes, R::AMOSTRAS_POR_SEGMENTO + 20);
+
+  // Um bit da geração no segmento mais antigo: o CRC-32 o tira do anel.
+  estragarByte(0, 4);
+  static R depois;
+  TEST_ASSERT_TRUE(depois.iniciar(SPIFFS));
+  TEST_ASSERT_EQUAL_UINT32(20, lerTudo(depois).quantidade);
+
+  // Uma amostra estragada some sozinha.
+  estragarByte(1, 16 + 3 * sizeof(AmostraTelemetria) + 1);
+  TEST_ASSERT_EQUAL_UINT32(19, lerTudo(depois).quantidade);
+
+  // O cabeçalho do segmento atual: no reinício o registro recomeça num segmento novo.
+  estragarByte(1, 12);
+  static R recomecado;
+  TEST_ASSERT_TRUE(recomecado.iniciar(SPIFFS));
+  TEST_ASSERT_EQUAL_UINT32(0, lerTudo(recomecado).quantidade);
+  gravar(recomecado, 5);
+  TEST_ASSERT_EQUAL_UINT32(5, lerTudo(recomecado).quantidade);
+}
+
+static void test_segmento_da_versao_1_continua_legivel() {
+  limpar();
+  struct { uint32_t magico, geracao; uint16_t versao, tamanhoAmostra; uint32_t crc; } cabecalho = { 0x314D4C54UL, 7, 1, 16, 0 };
+  cabecalho.crc = crc8(&cabecalho, sizeof(cabecalho));
+  AmostraTelemetria amostras[2] = {};
+  for (int i = 0; i < 2; i++) {
+    instante += 5;
+    amostras[i].instante = amostras[i].ciclosParciaisOperacao = instante;
+    amostras[i].crc = crc8(&amostras[i], sizeof(amostras[i]));
+  }
+  char caminho[24];
+  nome(3, caminho);
+  File arquivo = SPIFFS.open(caminho, "w");
+  arquivo.write((const uint8_t*)&cabecalho, sizeof(cabecalho));
+  arquivo.write((const uint8_t*)amostras, sizeof(amostras));
+  arquivo.close();
+
+  static R registro;
+  TEST_ASSERT_TRUE(registro.iniciar(SPIFFS));
+  TEST_ASSERT_EQUAL_UINT32(2, lerTudo(registro).quantidade);
+  gravar(registro, 3);
+  TEST_ASSERT_EQUAL_UINT32(5, lerTudo(registro).quantidade);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_queda_no_meio_do_lote);
+  RUN_TEST(test_cabecalho_truncado);
+  RUN_TEST(test_cabecalho_e_amostra_corrompidos);
+  RUN_TEST(test_segmento_da_versao_1_continua_legivel);
+  return UNITY_END();
+}
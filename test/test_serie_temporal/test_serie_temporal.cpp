@@ -0,0 +1,95 @@
+/*
+  SerieTemporal: agregação em cascata, picos curtos, lacunas e o estouro do
+  millis().
+*/
+#include <unity.h>
+#include "serie_temporal.h"
+
+void setUp() {}
+void tearDown() {}
+
+struct Resumo {
+  int baldes;
+  float minimo;
+  float maximo;
+  uint32_t maiorIdadeS;
+};
+
+static void resumir(uint32_t idadeS, float minimo, float maximo, float, void* contexto) {
+  Resumo& r = *static_cast<Resumo*>(contexto);
+  if (r.baldes == 0 || minimo < r.minimo) r.minimo = minimo;
+  if (r.baldes == 0 || maximo > r.maximo) r.maximo = maximo;
+  if (idadeS > r.maiorIdadeS) r.maiorIdadeS = idadeS;
+  r.baldes++;
+}
+
+static Resumo resumo(const SerieTemporal& serie, int nivel, uint32_t intervaloS) {
+  Resumo r = {};
+  serie.percorrer(nivel, intervaloS, resumir, &r);
+  return r;
+}
+
+static void test_pico_curto_sobrevive_ate_o_nivel_de_uma_hora() {
+  static SerieTemporal serie;
+  // Três dias a 25 °C, uma amostra por segundo, com 3 s a 80 °C na 10ª hora.
+  for (unsigned long s = 0; s < 3UL * 86400UL; s++) {
+    bool pico = s >= 36000UL && s < 36003UL;
+    serie.registrar(pico ? 80.0f : 25.0f, s * 1000UL);
+  }
+  for (int nivel = 1; nivel < SerieTemporal::NUM_NIVEIS; nivel++) {
+    Resumo r = resumo(serie, nivel, 0);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 25.0f, r.minimo);
+    // O nível de 1 min só guarda 24 h: o pico já saiu do anel dele.
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, nivel == 1 ? 25.0f : 80.0f, r.maximo);
+  }
+}
+
+static void test_media_ponderada_pelas_amostras() {
+  static SerieTemporal serie;
+  // Um minuto: 50 s a 20 °C e 10 s a 80 °C; a média do balde de 1 min é 30 °C.
+  for (unsigned long s = 0; s < 60UL; s++) serie.registrar(s < 50 ? 20.0f : 80.0f, s * 1000UL);
+  serie.registrar(20.0f, 60000UL);  // fecha o minuto
+  float media = 0.0f;
+  serie.percorrer(1, 120, [](uint32_t idadeS, float, float, float m, void* contexto) {
+    if (idadeS >= 60) *static_cast<float*>(contexto) = m;
+  }, &media);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 30.0f, media);
+}
+
+static void test_lacuna_sem_amostras_fica_vazia() {
+  static SerieTemporal serie;
+  for (unsigned long s = 0; s < 600UL; s += 10) serie.registrar(25.0f, s * 1000UL);
+  // Dez minutos sem nada (sensor fora), depois volta.
+  for (unsigned long s = 1200UL; s < 1800UL; s += 10) serie.registrar(25.0f, s * 1000UL);
+  Resumo r = resumo(serie, 0, 1800);
+  TEST_ASSERT_EQUAL_INT(120, r.baldes);
+}
+
+static void test_atravessa_o_estouro_do_millis() {
+  static SerieTemporal serie;
+  const unsigned long INICIO = 0xFFFFFFFFUL - 1800000UL;  // meia hora antes do estouro
+  for (unsigned long s = 0; s < 3600UL; s += 10) serie.registrar(25.0f + s / 3600.0f, (INICIO + s * 1000UL) & 0xFFFFFFFFUL);
+  Resumo r = resumo(serie, 0, 3600);
+  TEST_ASSERT_EQUAL_INT(360, r.baldes);
+  TEST_ASSERT_LESS_OR_EQUAL(3600, r.maiorIdadeS);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 25.0f, r.minimo);
+}
+
+static void test_escolha_do_nivel() {
+  TEST_ASSERT_EQUAL_INT(0, SerieTemporal::escolherNivel(10, 0, 0));
+  TEST_ASSERT_EQUAL_INT(1, SerieTemporal::escolherNivel(30, 0, 0));
+  TEST_ASSERT_EQUAL_INT(2, SerieTemporal::escolherNivel(3600, 0, 0));
+  TEST_ASSERT_EQUAL_INT(0, SerieTemporal::escolherNivel(0, 3600, 400));
+  TEST_ASSERT_EQUAL_INT(1, SerieTemporal::escolherNivel(0, 86400, 1440));
+  TEST_ASSERT_EQUAL_INT(2, SerieTemporal::escolherNivel(0, 30UL * 86400UL, 1000));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_pico_curto_sobrevive_ate_o_nivel_de_uma_hora);
+  RUN_TEST(test_media_ponderada_pelas_amostras);
+  RUN_TEST(test_lacuna_sem_amostras_fica_vazia);
+  RUN_TEST(test_atravessa_o_estouro_do_millis);
+  RUN_TEST(test_escolha_do_nivel);
+  return UNITY_END();
+}
@@ -0,0 +1,113 @@
+/*
+  Sessões (sessao.h): credenciais de fábrica, troca de senha, Basic em cache,
+  validade e adulteração do cookie e o reinício, que derruba os tokens.
+*/
+#include <unity.h>
+#include <string>
+#include "sessao.h"
+
+void setUp() {}
+void tearDown() {}
+
+static void codificarBase64(const char* texto, std::string& saida) {
+  static const char ALFABETO[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  size_t n = strlen(texto);
+  saida.clear();
+  for (size_t i = 0; i < n; i += 3) {
+    uint32_t v = (uint8_t)texto[i] << 16 | (i + 1 < n ? (uint8_t)texto[i + 1] << 8 : 0) | (i + 2 < n ? (uint8_t)texto[i + 2] : 0);
+    saida += ALFABETO[v >> 18];
+    saida += ALFABETO[(v >> 12) & 63];
+    saida += i + 1 < n ? ALFABETO[(v >> 6) & 63] : '=';
+    saida += i + 2 < n ? ALFABETO[v & 63] : '=';
+  }
+}
+
+static std::string basic(const char* credenciais) {
+  std::string codificado;
+  codificarBase64(credenciais, codificado);
+  return "Basic " + codificado;
+}
+
+static Preferences preferences;
+static uint8_t aleatorio[GerenciadorSessoes::TAMANHO_CHAVE + GerenciadorSessoes::TAMANHO_SAL];
+static GerenciadorSessoes sessoes;
+const uint64_t AGORA_MS = 5000;
+
+static void test_fabrica_e_troca_de_credenciais() {
+  preferences.begin("sessao-teste", false);
+  preferences.clear();
+  for (size_t i = 0; i < sizeof(aleatorio); i++) aleatorio[i] = (uint8_t)(i * 37 + 11);
+  sessoes.iniciar(preferences, aleatorio);
+  TEST_ASSERT_TRUE(sessoes.credenciaisDeFabrica());
+  TEST_ASSERT_TRUE(sessoes.conferirBasic(basic("admin:1234").c_str()));
+  TEST_ASSERT_FALSE(sessoes.conferirSenha("admin", "12345"));
+
+  for (size_t i = 0; i < sizeof(aleatorio); i++) aleatorio[i] ^= 0x5A;
+  TEST_ASSERT_FALSE(sessoes.alterarCredenciais("", "x", aleatorio));
+  TEST_ASSERT_TRUE(sessoes.alterarCredenciais("operador", "poco-fundo", aleatorio));
+  TEST_ASSERT_FALSE(sessoes.credenciaisDeFabrica());
+  // A troca derruba o cache: o Basic de fábrica não passa mais.
+  TEST_ASSERT_FALSE(sessoes.conferirBasic(basic("admin:1234").c_str()));
+  TEST_ASSERT_TRUE(sessoes.conferirBasic(basic("operador:poco-fundo").c_str()));
+  TEST_ASSERT_FALSE(sessoes.conferirSenha("operador", "poco-fund"));
+  TEST_ASSERT_FALSE(sessoes.conferirSenha("Operador", "poco-fundo"));
+}
+
+static void test_basic_em_cache_nao_aceita_parecido() {
+  std::string certo = basic("operador:poco-fundo");
+  TEST_ASSERT_TRUE(sessoes.conferirBasic(certo.c_str()));
+  unsigned long lentas = sessoes.conferenciasLentas();
+  TEST_ASSERT_TRUE(sessoes.conferirBasic(certo.c_str()));
+  TEST_ASSERT_EQUAL_UINT32(lentas, sessoes.conferenciasLentas());
+  // Mesmo tamanho, um caractere diferente: tem de ir à conferência lenta e falhar.
+  std::string quase = certo;
+  quase[quase.size() - 2] ^= 1;
+  TEST_ASSERT_FALSE(sessoes.conferirBasic(quase.c_str()));
+  // Maior que qualquer Basic válido: recusado sem derivar a senha.
+  lentas = sessoes.conferenciasLentas();
+  std::string longo = "Basic " + std::string(GerenciadorSessoes::TAMANHO_BASIC, 'A');
+  TEST_ASSERT_FALSE(sessoes.conferirBasic(longo.c_str()));
+  TEST_ASSERT_EQUAL_UINT32(lentas, sessoes.conferenciasLentas());
+  TEST_ASSERT_FALSE(sessoes.conferirBasic("Bearer abc"));
+  TEST_ASSERT_FALSE(sessoes.conferirBasic(""));
+}
+
+static void test_cookie_validade_e_adulteracao() {
+  char token[GerenciadorSessoes::TAMANHO_TOKEN + 1];
+  sessoes.emitir(AGORA_MS, token);
+  char cookie[128];
+  snprintf(cookie, sizeof(cookie), "tema=escuro; sessao=%s; idioma=pt", token);
+  TEST_ASSERT_TRUE(sessoes.conferirCookie(cookie, AGORA_MS));
+  TEST_ASSERT_TRUE(sessoes.conferirCookie(cookie, AGORA_MS + (GerenciadorSessoes::VALIDADE_S - 1) * 1000ULL));
+  TEST_ASSERT_FALSE(sessoes.conferirCookie(cookie, AGORA_MS + GerenciadorSessoes::VALIDADE_S * 1000ULL));
+
+  char adulterado[128];
+  strcpy(adulterado, cookie);
+  char* digito = strstr(adulterado, "sessao=") + 7 + 2;  // mexe na validade, não na assinatura
+  *digito = *digito == 'f' ? 'e' : 'f';
+  TEST_ASSERT_FALSE(sessoes.conferirCookie(adulterado, AGORA_MS));
+  TEST_ASSERT_FALSE(sessoes.conferirCookie("xsessao=0", AGORA_MS));
+  TEST_ASSERT_FALSE(sessoes.conferirCookie("", AGORA_MS));
+}
+
+static void test_reinicio_derruba_tokens_e_mantem_credenciais() {
+  char token[GerenciadorSessoes::TAMANHO_TOKEN + 1];
+  sessoes.emitir(AGORA_MS, token);
+  char cookie[80];
+  snprintf(cookie, sizeof(cookie), "sessao=%s", token);
+  static GerenciadorSessoes reiniciado;
+  for (size_t i = 0; i < sizeof(aleatorio); i++) aleatorio[i] += 1;
+  reiniciado.iniciar(preferences, aleatorio);
+  TEST_ASSERT_FALSE(reiniciado.conferirCookie(cookie, AGORA_MS));
+  TEST_ASSERT_TRUE(reiniciado.conferirSenha("operador", "poco-fundo"));
+  TEST_ASSERT_EQUAL_STRING("operador", reiniciado.usuario());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_fabrica_e_troca_de_credenciais);
+  RUN_TEST(test_basic_em_cache_nao_aceita_parecido);
+  RUN_TEST(test_cookie_validade_e_adulteracao);
+  RUN_TEST(test_reinicio_derruba_tokens_e_mantem_credenciais);
+  return UNITY_END();
+}
@@ -0,0 +1,159 @@
+/*
+  Triagem das conexões (triagem_http.h) sobre conexões locais de verdade:
+  requisição em pedaços, corpo do Content-Length, cliente lento vencido no
+  prazo, conexão fechada, cabeçalho grande demais e a vaga da mais antiga
+  com todas ocupadas.
+*/
+#include <unity.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string.h>
+#include <string>
+#include "triagem_http.h"
+
+static int escuta = -1;
+static sockaddr_in endereco;
+
+void setUp() {}
+void tearDown() {}
+
+struct Conexao {
+  int cliente;
+  int servidor;
+};
+
+static Conexao conectar() {
+  Conexao c;
+  c.cliente = socket(AF_INET, SOCK_STREAM, 0);
+  TEST_ASSERT_EQUAL_INT(0, connect(c.cliente, (sockaddr*)&endereco, sizeof(endereco)));
+  c.servidor = accept(escuta, nullptr, nullptr);
+  TEST_ASSERT_GREATER_OR_EQUAL(0, c.servidor);
+  return c;
+}
+
+static void fechar(Conexao& c) {
+  if (c.cliente >= 0) close(c.cliente);
+  close(c.servidor);
+}
+
+static void enviar(const Conexao& c, const std::string& dados) {
+  TEST_ASSERT_EQUAL_INT((int)dados.size(), (int)send(c.cliente, dados.data(), dados.size(), MSG_NOSIGNAL));
+  usleep(2000);  // o loopback entrega antes da espiada
+}
+
+static void test_requisicao_completa() {
+  const char* get = "GET /status HTTP/1.1\r\nHost: x\r\n\r\n";
+  TEST_ASSERT_TRUE(TriagemHttp::requisicaoCompleta(get, strlen(get)));
+  TEST_ASSERT_FALSE(TriagemHttp::requisicaoCompleta(get, strlen(get) - 1));
+  const char* post = "POST /config HTTP/1.1\r\nCONTENT-length:  12\r\n\r\ntempoligado=";
+  TEST_ASSERT_TRUE(TriagemHttp::requisicaoCompleta(post, strlen(post)));
+  TEST_ASSERT_FALSE(TriagemHttp::requisicaoCompleta(post, strlen(post) - 1));
+  // Um valor com "content-length:" no meio não é o cabeçalho.
+  const char* falso = "GET / HTTP/1.1\r\nX-A: content-length: 99\r\n\r\n";
+  TEST_ASSERT_TRUE(TriagemHttp::requisicaoCompleta(falso, strlen(falso)));
+  const char* enorme = "POST / HTTP/1.1\r\nContent-Length: 999999999999\r\n\r\n";
+  TEST_ASSERT_FALSE(TriagemHttp::requisicaoCompleta(enorme, strlen(enorme)));
+}
+
+static void test_entrega_so_com_a_requisicao_inteira() {
+  static TriagemHttp triagem;
+  Conexao c = conectar();
+  bool despejou = true;
+  int vaga = triagem.guardar(c.servidor, 1000, despejou);
+  TEST_ASSERT_FALSE(despejou);
+  TEST_ASSERT_EQUAL_INT(TriagemHttp::TRIAGEM_AGUARDANDO, triagem.examinar(vaga, 1000));
+  enviar(c, "POST /login HTTP/1.1\r\nContent-Length: 21\r\n\r\n");
+  TEST_ASSERT_EQUAL_INT(TriagemHttp::TRIAGEM_AGUARDANDO, triagem.examinar(vaga, 1100));
+  enviar(c, "usuario=a&senha=1234");
+  TEST_ASSERT_EQUAL_INT(TriagemHttp::TRIAGEM_AGUARDANDO, triagem.examinar(vaga, 1200));
+  enviar(c, "5");
+  TEST_ASSERT_EQUAL_INT(TriagemHttp::TRIAGEM_PRONTA, triagem.examinar(vaga, 1300));
+  // A espiada não consome: o servidor lê a requisição inteira.
+  char lido[128];
+  TEST_ASSERT_EQUAL_INT(65, (int)recv(c.servidor, lido, sizeof(lido), MSG_DONTWAIT));
+  triagem.liberar(vaga);
+  TEST_ASSERT_EQUAL_INT(0, triagem.pendentes());
+  TEST_ASSERT_EQUAL_UINT32(1, triagem.entregues());
+  fechar(c);
+}
+
+static void test_lento_vence_no_prazo_e_fechada_sai() {
+  static TriagemHttp triagem;
+  Conexao lenta = conectar(), fechada = conectar();
+  bool despejou;
+  // Perto do estouro do millis(): o prazo atravessa o zero.
+  const unsigned long inicio = 0xFFFFFF00UL;
+  int vagaLenta = triagem.guardar(lenta.servidor, inicio, despejou);
+  int vagaFechada = triagem.guardar(fechada.servidor, inicio, despejou);
+  enviar(lenta, "GET /status HTTP/1.1\r\nX-Lento: a");
+  TEST_ASSERT_EQUAL_INT(TriagemHttp::TRIAGEM_AGUARDANDO, triagem.examinar(vagaLenta, inicio + TriagemHttp::PRAZO_CABECALHO_MS - 1));
+  TEST_ASSERT_EQUAL_INT(TriagemHttp::TRIAGEM_DESCARTAR, triagem.examinar(vagaLenta, inicio + TriagemHttp::PRAZO_CABECALHO_MS));
+  TEST_ASSERT_EQUAL_UINT32(1, triagem.vencidas());
+
+  close(fechada.cliente);
+  fechada.cliente = -1;
+  usleep(2000);
+  TEST_ASSERT_EQUAL_INT(TriagemHttp::TRIAGEM_DESCARTAR, triagem.examinar(vagaFechada, inicio + 1));
+  TEST_ASSERT_EQUAL_UINT32(1, triagem.vencidas());
+  triagem.liberar(vagaLenta);
+  triagem.liberar(vagaFechada);
+  fechar(lenta);
+  fechar(fechada);
+}
+
+static void test_cabecalho_grande_demais() {
+  static TriagemHttp triagem;
+  Conexao c = conectar();
+  bool despejou;
+  int vaga = triagem.guardar(c.servidor, 0, despejou);
+  enviar(c, "GET / HTTP/1.1\r\nX-Enorme: " + std::string(TriagemHttp::LIMITE_ESPIADA, 'a'));
+  TEST_ASSERT_EQUAL_INT(TriagemHttp::TRIAGEM_DESCARTAR, triagem.examinar(vaga, 1));
+  TEST_ASSERT_EQUAL_UINT32(1, triagem.vencidas());
+  triagem.liberar(vaga);
+  fechar(c);
+}
+
+static void test_vagas_cheias_despejam_a_mais_antiga() {
+  static TriagemHttp triagem;
+  Conexao conexoes[TriagemHttp::MAX_PENDENTES + 1];
+  int vagas[TriagemHttp::MAX_PENDENTES + 1];
+  bool despejou;
+  for (int i = 0; i < TriagemHttp::MAX_PENDENTES; i++) {
+    conexoes[i] = conectar();
+    // A segunda chegou primeiro.
+    vagas[i] = triagem.guardar(conexoes[i].servidor, i == 1 ? 50 : 100 + i, despejou);
+    TEST_ASSERT_FALSE(despejou);
+  }
+  conexoes[TriagemHttp::MAX_PENDENTES] = conectar();
+  int nova = triagem.guardar(conexoes[TriagemHttp::MAX_PENDENTES].servidor, 200, despejou);
+  TEST_ASSERT_TRUE(despejou);
+  TEST_ASSERT_EQUAL_INT(vagas[1], nova);
+  TEST_ASSERT_EQUAL_UINT32(1, triagem.despejadas());
+  TEST_ASSERT_EQUAL_INT(TriagemHttp::MAX_PENDENTES, triagem.pendentes());
+  // A vaga agora espia a conexão nova.
+  enviar(conexoes[TriagemHttp::MAX_PENDENTES], "GET / HTTP/1.1\r\n\r\n");
+  TEST_ASSERT_EQUAL_INT(TriagemHttp::TRIAGEM_PRONTA, triagem.examinar(nova, 201));
+  for (Conexao& c : conexoes) fechar(c);
+}
+
+int main() {
+  escuta = socket(AF_INET, SOCK_STREAM, 0);
+  endereco = {};
+  endereco.sin_family = AF_INET;
+  endereco.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t tamanho = sizeof(endereco);
+  if (bind(escuta, (sockaddr*)&endereco, sizeof(endereco)) != 0 || listen(escuta, 16) != 0 ||
+      getsockname(escuta, (sockaddr*)&endereco, &tamanho) != 0) {
+    return 1;
+  }
+  UNITY_BEGIN();
+  RUN_TEST(test_requisicao_completa);
+  RUN_TEST(test_entrega_so_com_a_requisicao_inteira);
+  RUN_TEST(test_lento_vence_no_prazo_e_fechada_sai);
+  RUN_TEST(test_cabecalho_grande_demais);
+  RUN_TEST(test_vagas_cheias_despejam_a_mais_antiga);
+  close(escuta);
+  return UNITY_END();
+}
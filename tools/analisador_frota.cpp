@@ -0,0 +1,479 @@
+/*
+  Analisador de frota para as exportações do GET /exportar.
+  --------------------------------------------------------
+  Lê exportações (formato_exportacao.h) de muitos controladores e resume,
+  por controlador e para a frota inteira:
+
+  - enchimentos reconstituídos da telemetria (boia abre -> boia fecha):
+    duração, tempo ligado e partidas, mediana e tendência (regressão linear
+    da duração contra o tempo, em % por dia);
+  - ciclo de trabalho (fração do tempo coberto pela telemetria com o relé
+    fechado), total e por dia;
+  - anomalias: arquivo corrompido, lacunas na telemetria (queda de energia),
+    desligamentos térmicos, enchimentos mais longos que o dobro da mediana,
+    tendência de alta, ciclo de trabalho alto, temperatura perto do limite,
+    contadores zerados.
+
+  Cada arquivo é mapeado em memória (mmap) e lido no lugar, sem cópia; um
+  conjunto de threads pega os arquivos de uma fila (um índice atômico) e só
+  a junção dos resultados por dia é feita no fim, numa thread.
+
+  Compilar e usar (Linux):
+    g++ -std=c++17 -O2 -pthread -Iinclude tools/analisador_frota.cpp -o analisador_frota
+    ./analisador_frota [-j THREADS] [--csv] [--max-anomalias N] exportacoes/ outro.cpex ...
+
+  Diretórios são percorridos recursivamente atrás de *.cpex. Com --csv sai
+  só a tabela por controlador, para planilhas.
+*/
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "formato_exportacao.h"
+
+// Amostras a cada 5 s: mais que isso entre duas é falta de dados, não tempo com o relé no estado anterior.
+const uint32_t LACUNA_MAXIMA_S = 60;
+const uint32_t LACUNA_ANOMALIA_S = 600;
+const double CICLO_TRABALHO_ALTO = 0.8;
+const double TENDENCIA_ALTA_POR_DIA = 0.05;   // duração dos enchimentos crescendo 5% ao dia
+const int ENCHIMENTOS_PARA_TENDENCIA = 10;
+const float MARGEM_TEMPERATURA_C = 2.0f;
+
+// O mesmo CRC-32 de crc.h, por tabela e 8 bytes por vez (slice-by-8): o bit a bit do firmware
+// ficaria em ~100 MB/s e dominaria a análise.
+class Crc32Rapido {
+public:
+  Crc32Rapido() {
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t crc = i;
+      for (int b = 0; b < 8; b++) crc = (crc >> 1) ^ (0xEDB88320UL & (0UL - (crc & 1)));
+      _tabela[0][i] = crc;
+    }
+    for (uint32_t i = 0; i < 256; i++) {
+      for (int t = 1; t < 8; t++) _tabela[t][i] = (_tabela[t - 1][i] >> 8) ^ _tabela[0][_tabela[t - 1][i] & 0xFF];
+    }
+  }
+
+  uint32_t calcular(const uint8_t* p, size_t tamanho) const {
+    uint32_t crc = 0xFFFFFFFFUL;
+    for (; tamanho >= 8; tamanho -= 8, p += 8) {
+      uint32_t a, b;
+      memcpy(&a, p, 4);
+      memcpy(&b, p + 4, 4);
+      a ^= crc;
+      crc = _tabela[7][a & 0xFF] ^ _tabela[6][(a >> 8) & 0xFF] ^ _tabela[5][(a >> 16) & 0xFF] ^ _tabela[4][a >> 24] ^
+            _tabela[3][b & 0xFF] ^ _tabela[2][(b >> 8) & 0xFF] ^ _tabela[1][(b >> 16) & 0xFF] ^ _tabela[0][b >> 24];
+    }
+    while (tamanho--) crc = (crc >> 8) ^ _tabela[0][(crc ^ *p++) & 0xFF];
+    return ~crc;
+  }
+
+private:
+  uint32_t _tabela[8][256];
+};
+
+static const Crc32Rapido crcRapido;
+
+struct Anomalia {
+  uint32_t instante;
+  std::string descricao;
+};
+
+struct Enchimento {
+  uint32_t inicio;
+  uint32_t duracaoS;
+  uint32_t ligadoS;
+  uint32_t partidas;
+};
+
+struct Dia {
+  uint32_t cobertoS = 0;
+  uint32_t ligadoS = 0;
+  uint32_t enchimentos = 0;
+  uint64_t duracaoEnchimentosS = 0;
+};
+
+struct Controlador {
+  std::string arquivo;
+  std::string identificador;
+  std::string erro;            // vazio se a exportação é válida
+  size_t bytes = 0;
+  CabecalhoExportacao cabecalho = {};
+  ParametrosExportados parametros = {};
+  std::vector<CanalExportado> canais;
+
+  uint32_t amostras = 0;
+  uint64_t cobertoS = 0;
+  uint64_t ligadoS = 0;
+  float temperaturaMaximaC = -1000.0f;
+  std::vector<Enchimento> enchimentos;
+  double medianaEnchimentoS = 0.0;
+  double tendenciaPorDia = 0.0;
+  std::map<uint32_t, Dia> dias;  // por dias antes da exportação
+  std::vector<Anomalia> anomalias;
+
+  double cicloTrabalho() const { return cobertoS ? (double)ligadoS / cobertoS : 0.0; }
+};
+
+// Percorre a telemetria reconstituindo enchimentos, ciclo de trabalho e anomalias.
+class AcumuladorTelemetria {
+public:
+  explicit AcumuladorTelemetria(Controlador& c) : _c(c) {}
+
+  void amostra(const AmostraExportada& a) {
+    _c.amostras++;
+    bool sincronizada = (a.flags & AmostraExportada::FLAG_RELOGIO_SINCRONIZADO) != 0;
+    bool mesmaBase = sincronizada == ((_c.cabecalho.flags & CabecalhoExportacao::FLAG_RELOGIO_SINCRONIZADO) != 0);
+    float temperatura = a.temperaturaCentesimos / 100.0f;
+    if (temperatura > _c.temperaturaMaximaC) _c.temperaturaMaximaC = temperatura;
+    if (!_tem) {
+      _anterior = a;
+      _tem = true;
+      return;
+    }
+    const AmostraExportada& p = _anterior;
+    uint32_t intervalo = a.instante - p.instante;
+    if (a.instante < p.instante || intervalo > LACUNA_MAXIMA_S) {
+      if (a.instante < p.instante || intervalo >= LACUNA_ANOMALIA_S) {
+        anomalia(p.instante, "lacuna de %u min na telemetria (queda de energia ou reinício)", (unsigned)(intervalo / 60));
+      }
+      _enchendo = false;  // enchimento atravessando a lacuna não tem duração confiável
+    } else {
+      _c.cobertoS += intervalo;
+      bool ligado = (p.flags & AmostraExportada::FLAG_COMPRESSOR) != 0;
+      if (ligado) _c.ligadoS += intervalo;
+      if (_enchendo && ligado) _ligadoEnchimento += intervalo;
+      if (mesmaBase && p.instante <= _c.cabecalho.instante) {
+        Dia& dia = diaDe(p.instante);
+        dia.cobertoS += intervalo;
+        if (ligado) dia.ligadoS += intervalo;
+      }
+    }
+
+    bool cheiaAntes = (p.flags & AmostraExportada::FLAG_CAIXA_CHEIA) != 0;
+    bool cheiaAgora = (a.flags & AmostraExportada::FLAG_CAIXA_CHEIA) != 0;
+    if (cheiaAntes && !cheiaAgora) {
+      _enchendo = true;
+      _inicioEnchimento = a.instante;
+      _ligadoEnchimento = 0;
+      _partidas = 0;
+    } else if (!cheiaAntes && cheiaAgora && _enchendo) {
+      Enchimento e = { _inicioEnchimento, a.instante - _inicioEnchimento, _ligadoEnchimento, _partidas };
+      _c.enchimentos.push_back(e);
+      if (mesmaBase && a.instante <= _c.cabecalho.instante) {
+        Dia& dia = diaDe(a.instante);
+        dia.enchimentos++;
+        dia.duracaoEnchimentosS += e.duracaoS;
+      }
+      _enchendo = false;
+    }
+    if (_enchendo && !(p.flags & AmostraExportada::FLAG_COMPRESSOR) && (a.flags & AmostraExportada::FLAG_COMPRESSOR)) _partidas++;
+    if (!(p.flags & AmostraExportada::FLAG_DESLIGADO_TEMPERATURA) && (a.flags & AmostraExportada::FLAG_DESLIGADO_TEMPERATURA)) {
+      anomalia(a.instante, "desligamento térmico a %.1f °C", temperatura);
+    }
+    if (a.ciclosEnchimentoCompletos < p.ciclosEnchimentoCompletos || a.ciclosParciaisOperacao < p.ciclosParciaisOperacao) {
+      anomalia(a.instante, "contadores zerados");
+    }
+    _anterior = a;
+  }
+
+  __attribute__((format(printf, 3, 4))) void anomalia(uint32_t instante, const char* formato, ...) {
+    char texto[160];
+    va_list args;
+    va_start(args, formato);
+    vsnprintf(texto, sizeof(texto), formato, args);
+    va_end(args);
+    _c.anomalias.push_back({ instante, texto });
+  }
+
+private:
+  // As amostras vêm em ordem: o dia só muda a cada ~17 mil delas, então a busca no mapa fica fora do caminho quente.
+  Dia& diaDe(uint32_t instante) {
+    uint32_t indice = (_c.cabecalho.instante - instante) / 86400U;
+    if (_dia == nullptr || indice != _indiceDia) {
+      _dia = &_c.dias[indice];
+      _indiceDia = indice;
+    }
+    return *_dia;
+  }
+
+  Controlador& _c;
+  Dia* _dia = nullptr;
+  uint32_t _indiceDia = 0;
+  AmostraExportada _anterior = {};
+  bool _tem = false;
+  bool _enchendo = false;
+  uint32_t _inicioEnchimento = 0;
+  uint32_t _ligadoEnchimento = 0;
+  uint32_t _partidas = 0;
+};
+
+static void concluir(Controlador& c, AcumuladorTelemetria& acumulador) {
+  std::vector<uint32_t> duracoes;
+  for (const Enchimento& e : c.enchimentos) duracoes.push_back(e.duracaoS);
+  if (!duracoes.empty()) {
+    std::sort(duracoes.begin(), duracoes.end());
+    size_t meio = duracoes.size() / 2;
+    c.medianaEnchimentoS = duracoes.size() % 2 ? duracoes[meio] : (duracoes[meio - 1] + duracoes[meio]) / 2.0;
+  }
+  if (c.enchimentos.size() >= 5) {
+    for (const Enchimento& e : c.enchimentos) {
+      if (e.duracaoS > 2.0 * c.medianaEnchimentoS) {
+        acumulador.anomalia(e.inicio, "enchimento de %u min, mais que o dobro da mediana (%.0f min)", e.duracaoS / 60,
+                            c.medianaEnchimentoS / 60.0);
+      }
+    }
+  }
+  // Mínimos quadrados da duração contra o início, relativa à mediana.
+  if ((int)c.enchimentos.size() >= ENCHIMENTOS_PARA_TENDENCIA && c.medianaEnchimentoS > 0.0) {
+    double n = c.enchimentos.size(), sx = 0, sy = 0, sxx = 0, sxy = 0;
+    double x0 = c.enchimentos.front().inicio;
+    for (const Enchimento& e : c.enchimentos) {
+      double x = (e.inicio - x0) / 86400.0;
+      sx += x;
+      sy += e.duracaoS;
+      sxx += x * x;
+      sxy += x * e.duracaoS;
+    }
+    double denominador = n * sxx - sx * sx;
+    if (denominador > 1e-9) c.tendenciaPorDia = (n * sxy - sx * sy) / denominador / c.medianaEnchimentoS;
+    if (c.tendenciaPorDia > TENDENCIA_ALTA_POR_DIA) {
+      acumulador.anomalia(c.enchimentos.back().inicio, "tempo de enchimento subindo %.0f%% ao dia", c.tendenciaPorDia * 100.0);
+    }
+  }
+  if (c.cobertoS >= 86400 && c.cicloTrabalho() > CICLO_TRABALHO_ALTO) {
+    acumulador.anomalia(c.cabecalho.instante, "ciclo de trabalho de %.0f%%", c.cicloTrabalho() * 100.0);
+  }
+  float limite = c.parametros.temperaturaMaximaCentesimos / 100.0f;
+  if (c.amostras > 0 && c.temperaturaMaximaC >= limite - MARGEM_TEMPERATURA_C) {
+    acumulador.anomalia(c.cabecalho.instante, "temperatura chegou a %.1f °C (limite %.1f °C)", c.temperaturaMaximaC, limite);
+  }
+  for (const CanalExportado& canal : c.canais) {
+    if (canal.desligamentosEmergencia > 0) {
+      acumulador.anomalia(c.cabecalho.instante, "canal %u: %u desligamentos de emergência desde o boot", canal.canal,
+                          (unsigned)canal.desligamentosEmergencia);
+    }
+  }
+  std::sort(c.anomalias.begin(), c.anomalias.end(), [](const Anomalia& a, const Anomalia& b) { return a.instante < b.instante; });
+}
+
+static void interpretar(Controlador& c, const uint8_t* dados, size_t tamanho) {
+  if (tamanho < sizeof(CabecalhoExportacao) || memcmp(dados, MAGICO_EXPORTACAO, sizeof(MAGICO_EXPORTACAO)) != 0) {
+    c.erro = "não é uma exportação";
+    return;
+  }
+  memcpy(&c.cabecalho, dados, sizeof(c.cabecalho));
+  if (c.cabecalho.versao != VERSAO_EXPORTACAO) {
+    c.erro = "versão " + std::to_string(c.cabecalho.versao) + " desconhecida";
+    return;
+  }
+  c.identificador.assign(c.cabecalho.identificador, strnlen(c.cabecalho.identificador, sizeof(c.cabecalho.identificador)));
+
+  // Primeira passada: só a estrutura e o CRC, para não analisar um arquivo truncado.
+  size_t posicao = sizeof(CabecalhoExportacao);
+  bool fim = false;
+  while (!fim) {
+    CabecalhoSecao secao;
+    if (tamanho - posicao < sizeof(secao)) break;
+    memcpy(&secao, dados + posicao, sizeof(secao));
+    if (secao.tamanho > tamanho - posicao - sizeof(secao)) break;
+    if (secao.tipo == SECAO_FIM) {
+      uint32_t esperado;
+      if (secao.tamanho < sizeof(esperado)) break;
+      memcpy(&esperado, dados + posicao + sizeof(secao), sizeof(esperado));
+      if (crcRapido.calcular(dados, posicao) != esperado) {
+        c.erro = "CRC não confere";
+        return;
+      }
+      fim = true;
+    }
+    posicao += sizeof(secao) + secao.tamanho;
+  }
+  if (!fim) {
+    c.erro = "arquivo truncado";
+    return;
+  }
+
+  AcumuladorTelemetria acumulador(c);
+  for (posicao = sizeof(CabecalhoExportacao);;) {
+    CabecalhoSecao secao;
+    memcpy(&secao, dados + posicao, sizeof(secao));
+    const uint8_t* corpo = dados + posicao + sizeof(secao);
+    if (secao.tipo == SECAO_FIM) break;
+    if (secao.tipo == SECAO_PARAMETROS && secao.tamanho >= sizeof(ParametrosExportados)) {
+      memcpy(&c.parametros, corpo, sizeof(c.parametros));
+    } else if (secao.tipo == SECAO_CANAL && secao.tamanho >= sizeof(CanalExportado)) {
+      CanalExportado canal;
+      memcpy(&canal, corpo, sizeof(canal));
+      c.canais.push_back(canal);
+    } else if (secao.tipo == SECAO_TELEMETRIA) {
+      for (size_t i = 0; i + sizeof(AmostraExportada) <= secao.tamanho; i += sizeof(AmostraExportada)) {
+        AmostraExportada amostra;
+        memcpy(&amostra, corpo + i, sizeof(amostra));
+        acumulador.amostra(amostra);
+      }
+    }
+    // TEMPERATURA e tipos desconhecidos: a telemetria já traz a temperatura de cada amostra.
+    posicao += sizeof(secao) + secao.tamanho;
+  }
+  concluir(c, acumulador);
+}
+
+static Controlador analisar(const std::string& arquivo) {
+  Controlador c;
+  c.arquivo = arquivo;
+  int fd = open(arquivo.c_str(), O_RDONLY);
+  struct stat info;
+  if (fd < 0 || fstat(fd, &info) != 0) {
+    c.erro = std::string("não abriu: ") + strerror(errno);
+    if (fd >= 0) close(fd);
+    return c;
+  }
+  c.bytes = (size_t)info.st_size;
+  if (c.bytes == 0) {
+    close(fd);
+    c.erro = "arquivo vazio";
+    return c;
+  }
+  void* mapa = mmap(nullptr, c.bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapa == MAP_FAILED) {
+    c.erro = std::string("mmap falhou: ") + strerror(errno);
+    return c;
+  }
+  madvise(mapa, c.bytes, MADV_SEQUENTIAL);
+  interpretar(c, static_cast<const uint8_t*>(mapa), c.bytes);
+  munmap(mapa, c.bytes);
+  return c;
+}
+
+static void coletar(const std::string& caminho, std::vector<std::string>& arquivos) {
+  namespace fs = std::filesystem;
+  std::error_code erro;
+  if (fs::is_directory(caminho, erro)) {
+    for (const fs::directory_entry& entrada : fs::recursive_directory_iterator(caminho, erro)) {
+      if (entrada.is_regular_file() && entrada.path().extension() == ".cpex") arquivos.push_back(entrada.path().string());
+    }
+  } else {
+    arquivos.push_back(caminho);
+  }
+}
+
+static void imprimirCsv(const std::vector<Controlador>& controladores) {
+  printf("arquivo,identificador,erro,horas,amostras,enchimentos,mediana_enchimento_min,tendencia_pct_dia,ciclo_trabalho_pct,"
+         "temperatura_max_c,anomalias\n");
+  for (const Controlador& c : controladores) {
+    printf("%s,%s,%s,%.1f,%u,%zu,%.1f,%.1f,%.1f,%.1f,%zu\n", c.arquivo.c_str(), c.identificador.c_str(), c.erro.c_str(),
+           c.cobertoS / 3600.0, c.amostras, c.enchimentos.size(), c.medianaEnchimentoS / 60.0, c.tendenciaPorDia * 100.0,
+           c.cicloTrabalho() * 100.0, c.amostras ? c.temperaturaMaximaC : 0.0f, c.anomalias.size());
+  }
+}
+
+static void imprimirRelatorio(const std::vector<Controlador>& controladores, size_t maxAnomalias) {
+  // Frota por dia: junção dos mapas de cada controlador.
+  std::map<uint32_t, Dia> frota;
+  size_t invalidos = 0, anomalias = 0;
+  for (const Controlador& c : controladores) {
+    if (!c.erro.empty()) { invalidos++; continue; }
+    anomalias += c.anomalias.size();
+    for (const auto& [indice, dia] : c.dias) {
+      Dia& f = frota[indice];
+      f.cobertoS += dia.cobertoS;
+      f.ligadoS += dia.ligadoS;
+      f.enchimentos += dia.enchimentos;
+      f.duracaoEnchimentosS += dia.duracaoEnchimentosS;
+    }
+  }
+
+  printf("=== Controladores (%zu, %zu inválidos) ===\n", controladores.size(), invalidos);
+  printf("%-18s %7s %11s %10s %10s %8s %7s %9s\n", "identificador", "horas", "enchimentos", "mediana", "tendência", "trabalho",
+         "Tmax", "anomalias");
+  for (const Controlador& c : controladores) {
+    if (!c.erro.empty()) {
+      printf("%-18s %s: %s\n", c.identificador.empty() ? "?" : c.identificador.c_str(), c.arquivo.c_str(), c.erro.c_str());
+      continue;
+    }
+    printf("%-18s %7.1f %11zu %8.1f m %8.1f%%/d %7.1f%% %6.1f° %9zu\n", c.identificador.c_str(), c.cobertoS / 3600.0,
+           c.enchimentos.size(), c.medianaEnchimentoS / 60.0, c.tendenciaPorDia * 100.0, c.cicloTrabalho() * 100.0,
+           c.amostras ? c.temperaturaMaximaC : 0.0f, c.anomalias.size());
+  }
+
+  printf("\n=== Frota por dia (dias antes da exportação) ===\n");
+  printf("%5s %12s %11s %15s %9s\n", "dia", "horas dados", "enchimentos", "duração média", "trabalho");
+  for (auto it = frota.rbegin(); it != frota.rend(); ++it) {
+    const Dia& d = it->second;
+    printf("%5u %12.1f %11u %13.1f m %8.1f%%\n", it->first, d.cobertoS / 3600.0, d.enchimentos,
+           d.enchimentos ? d.duracaoEnchimentosS / 60.0 / d.enchimentos : 0.0, d.cobertoS ? 100.0 * d.ligadoS / d.cobertoS : 0.0);
+  }
+
+  printf("\n=== Anomalias (%zu) ===\n", anomalias);
+  size_t impressas = 0;
+  for (const Controlador& c : controladores) {
+    for (const Anomalia& a : c.anomalias) {
+      if (impressas++ >= maxAnomalias) break;
+      // Instante relativo à exportação: funciona também sem o relógio sincronizado.
+      double horasAtras = (double)(int64_t)(c.cabecalho.instante - a.instante) / 3600.0;
+      printf("%-18s há %7.1f h  %s\n", c.identificador.c_str(), horasAtras, a.descricao.c_str());
+    }
+  }
+  if (anomalias > maxAnomalias) printf("... mais %zu (use --max-anomalias)\n", anomalias - maxAnomalias);
+}
+
+int main(int argc, char** argv) {
+  unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+  bool csv = false;
+  size_t maxAnomalias = 50;
+  std::vector<std::string> arquivos;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) threads = std::max(1, atoi(argv[++i]));
+    else if (strcmp(argv[i], "--csv") == 0) csv = true;
+    else if (strcmp(argv[i], "--max-anomalias") == 0 && i + 1 < argc) maxAnomalias = strtoul(argv[++i], nullptr, 10);
+    else if (argv[i][0] == '-') {
+      fprintf(stderr, "uso: %s [-j THREADS] [--csv] [--max-anomalias N] ARQUIVO|DIRETÓRIO...\n", argv[0]);
+      return 2;
+    } else coletar(argv[i], arquivos);
+  }
+  if (arquivos.empty()) {
+    fprintf(stderr, "nenhuma exportação (*.cpex) encontrada\n");
+    return 2;
+  }
+  std::sort(arquivos.begin(), arquivos.end());
+
+  std::chrono::steady_clock::time_point inicio = std::chrono::steady_clock::now();
+  std::vector<Controlador> controladores(arquivos.size());
+  std::atomic<size_t> proximo{0};
+  std::vector<std::thread> trabalhadores;
+  threads = std::min<unsigned>(threads, arquivos.size());
+  for (unsigned t = 0; t < threads; t++) {
+    trabalhadores.emplace_back([&]() {
+      for (size_t i; (i = proximo.fetch_add(1)) < arquivos.size();) controladores[i] = analisar(arquivos[i]);
+    });
+  }
+  for (std::thread& t : trabalhadores) t.join();
+  double segundos = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+
+  if (csv) {
+    imprimirCsv(controladores);
+  } else {
+    imprimirRelatorio(controladores, maxAnomalias);
+  }
+  size_t bytes = 0;
+  for (const Controlador& c : controladores) bytes += c.bytes;
+  fprintf(stderr, "%zu arquivos, %.1f MB em %.3f s com %u threads (%.0f MB/s)\n", arquivos.size(), bytes / 1e6, segundos,
+          threads, bytes / 1e6 / (segundos > 0 ? segundos : 1e-9));
+  return 0;
+}
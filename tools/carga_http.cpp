@@ -0,0 +1,351 @@
+/*
+  Teste de carga do servidor web de um controlador.
+  -------------------------------------------------
+  Dispara o tráfego que o controlador vê em campo e mede o que importa.
+  Serve para dois alvos:
+
+  - o ESP32 de verdade (--alvo <ip>), com o WebServer, a autenticação e a
+    tarefa de controle do firmware;
+  - o simulador no host (program --servir PORTA [--sem-triagem]), que atende
+    em 127.0.0.1 como o loop() do firmware, uma requisição por passada, com
+    respostas fixas: mede a triagem das conexões (triagem_http.h) e, com
+    --sem-triagem, a leitura do WebServer sem ela. O jitter do controle lido
+    do /status só tem sentido no ESP32.
+
+  O tráfego:
+
+  - painéis: cada um pede /status e /tempdata a cada --intervalo-painel ms,
+    como a página aberta num celular, com o cookie do POST /login;
+  - raspadores: /metrics sem pausa, com Basic, como um Prometheus apertado;
+  - --rajada: uma thread pedindo /status sem pausa, como um script em laço;
+  - --lentos K: K conexões que mandam um byte do cabeçalho a cada meio
+    segundo, dentro da espera de 1 s do Stream que o WebServer renova a
+    cada byte, e nunca terminam a requisição, para medir quanto tempo o
+    servidor as segura e quanto elas atrasam os painéis.
+
+  Por rota: pedidas, respostas 2xx, 429 (limite por cliente), erros,
+  requisições por segundo e latências p50, p99 e máxima. Antes e depois, o
+  jitter da tarefa de controle lido do /status (jitterControleMaxUs,
+  jitterControleMedioUs, ciclosControleAtrasados): a carga no servidor web
+  não pode atrasar o controle.
+
+  Todas as threads saem do mesmo endereço e dividem o mesmo balde do limite
+  por cliente (limitador_clientes.h): acima de 5 requisições por segundo
+  somadas, os 429 aparecem, e são contados à parte dos erros.
+
+  Compilar e usar (Linux):
+    g++ -std=c++17 -O2 -pthread tools/carga_http.cpp -o carga_http
+    ./carga_http --alvo 192.168.0.50 [--usuario admin --senha 1234] [--paineis 2] [--intervalo-painel 1000]
+                 [--raspadores 0] [--segundos 60] [--lentos 0] [--rajada]
+
+  Triagem contra a leitura do WebServer, sem um ESP32 (2 painéis, 2 conexões
+  lentas, 30 s), com o servidor num terminal e a carga no outro:
+    .pio/build/native/program --servir 8080 --segundos 40 [--sem-triagem]
+    ./carga_http --alvo 127.0.0.1:8080 --paineis 2 --lentos 2 --segundos 30
+  Sem a triagem uma passada do loop() ficou presa 29992 ms e só 4 pedidos
+  dos painéis foram atendidos (2 com erro, p50 acima de 9 s); com ela a
+  passada mais longa levou 1 ms, 120/120 pedidos dos painéis, p99 de 10,7 ms,
+  e as conexões lentas caem em ~2,5 s.
+*/
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock Relogio;
+
+enum Rota { ROTA_STATUS, ROTA_TEMPDATA, ROTA_METRICS, NUM_ROTAS };
+static const char* const CAMINHOS[NUM_ROTAS] = { "/status", "/tempdata", "/metrics" };
+
+struct Opcoes {
+  std::string host = "";
+  std::string porta = "80";
+  std::string usuario = "admin";
+  std::string senha = "1234";
+  int paineis = 2;
+  int intervaloPainelMs = 1000;
+  int raspadores = 0;
+  int segundos = 60;
+  int lentos = 0;
+  bool rajada = false;
+};
+
+struct Medidas {
+  unsigned long pedidas = 0;
+  unsigned long sucesso = 0;
+  unsigned long limitadas = 0;
+  unsigned long erros = 0;
+  std::vector<double> latenciasMs;
+};
+
+struct Resposta {
+  int status = -1;
+  std::string cabecalhos;
+  std::string corpo;
+};
+
+static Opcoes opcoes;
+static addrinfo* enderecoAlvo = nullptr;
+static std::atomic<bool> parar{false};
+
+// ==================== HTTP ====================
+static int conectar(int prazoMs) {
+  int fd = socket(enderecoAlvo->ai_family, SOCK_STREAM, 0);
+  if (fd < 0) return -1;
+  timeval prazo = { prazoMs / 1000, (prazoMs % 1000) * 1000 };
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &prazo, sizeof(prazo));
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &prazo, sizeof(prazo));
+  int um = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &um, sizeof(um));
+  if (connect(fd, enderecoAlvo->ai_addr, enderecoAlvo->ai_addrlen) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static bool escreverTudo(int fd, const std::string& dados) {
+  for (size_t enviados = 0; enviados < dados.size();) {
+    ssize_t n = send(fd, dados.data() + enviados, dados.size() - enviados, MSG_NOSIGNAL);
+    if (n <= 0) return false;
+    enviados += (size_t)n;
+  }
+  return true;
+}
+
+// Uma requisição por conexão (Connection: close), como o WebServer atende.
+static Resposta requisitar(const char* metodo, const char* caminho, const std::string& extras, const std::string& corpo) {
+  Resposta resposta;
+  int fd = conectar(10000);
+  if (fd < 0) return resposta;
+  std::string pedido = std::string(metodo) + " " + caminho + " HTTP/1.1\r\nHost: " + opcoes.host +
+                       "\r\nConnection: close\r\n" + extras;
+  if (!corpo.empty()) {
+    pedido += "Content-Type: application/x-www-form-urlencoded\r\nContent-Length: " + std::to_string(corpo.size()) + "\r\n";
+  }
+  pedido += "\r\n" + corpo;
+  std::string recebido;
+  if (escreverTudo(fd, pedido)) {
+    char bloco[4096];
+    for (ssize_t n; (n = recv(fd, bloco, sizeof(bloco), 0)) > 0;) recebido.append(bloco, (size_t)n);
+  }
+  close(fd);
+  size_t fimCabecalhos = recebido.find("\r\n\r\n");
+  if (recebido.compare(0, 5, "HTTP/") != 0 || fimCabecalhos == std::string::npos) return resposta;
+  resposta.status = atoi(recebido.c_str() + recebido.find(' ') + 1);
+  resposta.cabecalhos = recebido.substr(0, fimCabecalhos);
+  resposta.corpo = recebido.substr(fimCabecalhos + 4);
+  return resposta;
+}
+
+static std::string base64(const std::string& texto) {
+  static const char ALFABETO[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::string saida;
+  for (size_t i = 0; i < texto.size(); i += 3) {
+    uint32_t bloco = (uint8_t)texto[i] << 16;
+    if (i + 1 < texto.size()) bloco |= (uint8_t)texto[i + 1] << 8;
+    if (i + 2 < texto.size()) bloco |= (uint8_t)texto[i + 2];
+    saida += ALFABETO[bloco >> 18 & 63];
+    saida += ALFABETO[bloco >> 12 & 63];
+    saida += i + 1 < texto.size() ? ALFABETO[bloco >> 6 & 63] : '=';
+    saida += i + 2 < texto.size() ? ALFABETO[bloco & 63] : '=';
+  }
+  return saida;
+}
+
+// Valor de um campo numérico do /status; -1 se não veio.
+static double campoJson(const std::string& json, const char* nome) {
+  size_t posicao = json.find("\"" + std::string(nome) + "\":");
+  return posicao == std::string::npos ? -1.0 : atof(json.c_str() + posicao + strlen(nome) + 3);
+}
+
+// ==================== CARGA ====================
+static void medir(Medidas& medidas, const char* caminho, const std::string& extras) {
+  Relogio::time_point inicio = Relogio::now();
+  Resposta resposta = requisitar("GET", caminho, extras, "");
+  medidas.pedidas++;
+  if (resposta.status >= 200 && resposta.status < 300) {
+    medidas.sucesso++;
+    medidas.latenciasMs.push_back(std::chrono::duration<double, std::milli>(Relogio::now() - inicio).count());
+  } else if (resposta.status == 429) {
+    medidas.limitadas++;
+  } else {
+    medidas.erros++;
+  }
+}
+
+static void esperarAte(Relogio::time_point instante) {
+  while (!parar && Relogio::now() < instante) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+}
+
+// Segura a conexão mandando um byte a cada meio segundo; devolve quantos segundos o servidor aguentou.
+static double conexaoLenta() {
+  int fd = conectar(1000);
+  if (fd < 0) return -1.0;
+  const std::string pedido = "GET /status HTTP/1.1\r\nHost: " + opcoes.host + "\r\nX-Lento: ";
+  Relogio::time_point inicio = Relogio::now();
+  for (size_t i = 0; !parar; i++) {
+    if (send(fd, i < pedido.size() ? &pedido[i] : "a", 1, MSG_NOSIGNAL) != 1) break;
+    char byte;
+    ssize_t n = recv(fd, &byte, 1, MSG_DONTWAIT);
+    if (n >= 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) break;
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  }
+  close(fd);
+  return std::chrono::duration<double>(Relogio::now() - inicio).count();
+}
+
+static double percentil(std::vector<double>& valores, double fracao) {
+  if (valores.empty()) return 0.0;
+  size_t indice = std::min(valores.size() - 1, (size_t)(fracao * (valores.size() - 1) + 0.5));
+  std::nth_element(valores.begin(), valores.begin() + indice, valores.end());
+  return valores[indice];
+}
+
+static void imprimirDiagnostico(const char* titulo, const std::string& status) {
+  printf("%-8s jitter do controle: máx %.0f us, médio %.0f us, %.0f ciclos atrasados\n", titulo,
+         campoJson(status, "jitterControleMaxUs"), campoJson(status, "jitterControleMedioUs"),
+         campoJson(status, "ciclosControleAtrasados"));
+}
+
+int main(int argc, char** argv) {
+  for (int i = 1; i < argc; i++) {
+    auto valor = [&]() { return i + 1 < argc ? argv[++i] : (char*)""; };
+    if (strcmp(argv[i], "--alvo") == 0) opcoes.host = valor();
+    else if (strcmp(argv[i], "--usuario") == 0) opcoes.usuario = valor();
+    else if (strcmp(argv[i], "--senha") == 0) opcoes.senha = valor();
+    else if (strcmp(argv[i], "--paineis") == 0) opcoes.paineis = std::max(0, atoi(valor()));
+    else if (strcmp(argv[i], "--intervalo-painel") == 0) opcoes.intervaloPainelMs = std::max(1, atoi(valor()));
+    else if (strcmp(argv[i], "--raspadores") == 0) opcoes.raspadores = std::max(0, atoi(valor()));
+    else if (strcmp(argv[i], "--segundos") == 0) opcoes.segundos = std::max(1, atoi(valor()));
+    else if (strcmp(argv[i], "--lentos") == 0) opcoes.lentos = std::max(0, atoi(valor()));
+    else if (strcmp(argv[i], "--rajada") == 0) opcoes.rajada = true;
+    else opcoes.host.clear(), i = argc;
+  }
+  if (opcoes.host.empty()) {
+    fprintf(stderr, "uso: %s --alvo HOST[:PORTA] [--usuario U] [--senha S] [--paineis N] [--intervalo-painel MS]\n"
+                    "          [--raspadores N] [--segundos S] [--lentos K] [--rajada]\n", argv[0]);
+    return 2;
+  }
+  size_t doisPontos = opcoes.host.rfind(':');
+  if (doisPontos != std::string::npos) {
+    opcoes.porta = opcoes.host.substr(doisPontos + 1);
+    opcoes.host.resize(doisPontos);
+  }
+  addrinfo dica = {};
+  dica.ai_socktype = SOCK_STREAM;
+  if (getaddrinfo(opcoes.host.c_str(), opcoes.porta.c_str(), &dica, &enderecoAlvo) != 0) {
+    fprintf(stderr, "não consegui resolver %s\n", opcoes.host.c_str());
+    return 2;
+  }
+
+  // O login gasta fichas do limite por cliente: é feito uma vez e o cookie vale para todos os painéis.
+  Resposta login = requisitar("POST", "/login", "", "usuario=" + opcoes.usuario + "&senha=" + opcoes.senha);
+  size_t posicaoCookie = login.cabecalhos.find("sessao=");
+  if (login.status != 200 || posicaoCookie == std::string::npos) {
+    fprintf(stderr, "login recusado (HTTP %d)\n", login.status);
+    return 1;
+  }
+  std::string cookie = "Cookie: " + login.cabecalhos.substr(posicaoCookie, login.cabecalhos.find(';', posicaoCookie) - posicaoCookie) + "\r\n";
+  std::string basic = "Authorization: Basic " + base64(opcoes.usuario + ":" + opcoes.senha) + "\r\n";
+  std::string antes = requisitar("GET", "/status", cookie, "").corpo;
+  imprimirDiagnostico("antes:", antes);
+
+  std::vector<Medidas> medidas(NUM_ROTAS);
+  std::vector<double> duracoesLentas;
+  std::mutex trava;
+  auto juntar = [&](std::vector<Medidas>& parciais) {
+    std::lock_guard<std::mutex> guarda(trava);
+    for (int r = 0; r < NUM_ROTAS; r++) {
+      medidas[r].pedidas += parciais[r].pedidas;
+      medidas[r].sucesso += parciais[r].sucesso;
+      medidas[r].limitadas += parciais[r].limitadas;
+      medidas[r].erros += parciais[r].erros;
+      medidas[r].latenciasMs.insert(medidas[r].latenciasMs.end(), parciais[r].latenciasMs.begin(), parciais[r].latenciasMs.end());
+    }
+  };
+
+  std::vector<std::thread> threads;
+  Relogio::time_point inicio = Relogio::now();
+  for (int p = 0; p < opcoes.paineis; p++) {
+    threads.emplace_back([&, p]() {
+      std::vector<Medidas> parciais(NUM_ROTAS);
+      // Painéis defasados entre si, como celulares abertos em momentos diferentes.
+      Relogio::time_point proximo = inicio + std::chrono::milliseconds(opcoes.intervaloPainelMs * p / std::max(1, opcoes.paineis));
+      for (esperarAte(proximo); !parar; esperarAte(proximo)) {
+        medir(parciais[ROTA_STATUS], CAMINHOS[ROTA_STATUS], cookie);
+        medir(parciais[ROTA_TEMPDATA], CAMINHOS[ROTA_TEMPDATA], cookie);
+        proximo += std::chrono::milliseconds(opcoes.intervaloPainelMs);
+      }
+      juntar(parciais);
+    });
+  }
+  for (int r = 0; r < opcoes.raspadores; r++) {
+    threads.emplace_back([&]() {
+      std::vector<Medidas> parciais(NUM_ROTAS);
+      while (!parar) medir(parciais[ROTA_METRICS], CAMINHOS[ROTA_METRICS], basic);
+      juntar(parciais);
+    });
+  }
+  if (opcoes.rajada) {
+    threads.emplace_back([&]() {
+      std::vector<Medidas> parciais(NUM_ROTAS);
+      while (!parar) medir(parciais[ROTA_STATUS], CAMINHOS[ROTA_STATUS], cookie);
+      juntar(parciais);
+    });
+  }
+  for (int l = 0; l < opcoes.lentos; l++) {
+    threads.emplace_back([&]() {
+      while (!parar) {
+        // Só contam as que o servidor fechou; as cortadas pelo fim do teste não dizem nada.
+        double segundos = conexaoLenta();
+        if (segundos < 0 || parar) break;
+        std::lock_guard<std::mutex> guarda(trava);
+        duracoesLentas.push_back(segundos);
+      }
+    });
+  }
+  std::this_thread::sleep_for(std::chrono::seconds(opcoes.segundos));
+  parar = true;
+  for (std::thread& t : threads) t.join();
+  double decorrido = std::chrono::duration<double>(Relogio::now() - inicio).count();
+
+  std::string depois = requisitar("GET", "/status", cookie, "").corpo;
+  printf("\n%-10s %8s %8s %8s %8s %8s %8s %8s %8s\n", "rota", "pedidas", "2xx", "429", "erros", "req/s", "p50 ms",
+         "p99 ms", "máx ms");
+  unsigned long sucessos = 0;
+  for (int r = 0; r < NUM_ROTAS; r++) {
+    Medidas& m = medidas[r];
+    if (m.pedidas == 0) continue;
+    sucessos += m.sucesso;
+    double maximo = m.latenciasMs.empty() ? 0.0 : *std::max_element(m.latenciasMs.begin(), m.latenciasMs.end());
+    double p50 = percentil(m.latenciasMs, 0.50), p99 = percentil(m.latenciasMs, 0.99);
+    printf("%-10s %8lu %8lu %8lu %8lu %8.1f %8.1f %8.1f %8.1f\n", CAMINHOS[r], m.pedidas, m.sucesso, m.limitadas,
+           m.erros, m.sucesso / decorrido, p50, p99, maximo);
+  }
+  if (opcoes.lentos > 0) {
+    double soma = 0.0;
+    for (double d : duracoesLentas) soma += d;
+    printf("lentas:    %zu fechadas pelo servidor, seguradas em média %.1f s cada\n", duracoesLentas.size(),
+           duracoesLentas.empty() ? 0.0 : soma / duracoesLentas.size());
+  }
+  printf("\n");
+  imprimirDiagnostico("antes:", antes);
+  imprimirDiagnostico("depois:", depois);
+  freeaddrinfo(enderecoAlvo);
+  return sucessos > 0 ? 0 : 1;
+}
@@ -0,0 +1,168 @@
+"""
+Gera a imagem do SPIFFS a partir de data/ (extra_script do PlatformIO).
+-----------------------------------------------------------------------
+Para cada arquivo de data/:
+  - calcula a impressão digital (SHA-256) do conteúdo;
+  - grava o conteúdo comprimido com gzip em $PROJECT_DATA_DIR/z_<hash>.gz;
+  - os arquivos que não são HTML ganham URL com a impressão digital
+    (chart.umd.min.js -> chart.umd.min.<hash>.js) e as referências a eles
+    dentro dos HTML são reescritas, então podem ser cacheados para sempre.
+
+O manifesto /assets.txt (uma linha "url arquivo etag tipo imutavel" por
+arquivo) é lido pelo firmware no boot.
+
+O Chart.js fica versionado em data/ para o painel funcionar sem internet, e
+a compilação não escreve nada em data/. Os arquivos de terceiros listados
+em tools/assets_fixados.sha256 têm de existir e bater com o SHA-256 fixado
+ali; se faltar um deles, ou o conteúdo não conferir, a compilação para. Sem
+o assets_fixados.sha256 (Chart.js ainda não vendorizado) a conferência é
+pulada com um aviso e o painel busca o Chart.js na CDN.
+Para trocar de versão (ou vendorizar pela primeira vez), ajuste
+CHART_JS_URL e rode
+
+    python tools/gerar_assets.py --vendorizar
+
+que baixa o arquivo para data/ e regrava o SHA-256 fixado; confira o hash
+impresso contra o do pacote publicado antes de versionar os dois arquivos.
+
+Também roda fora do PlatformIO: python tools/gerar_assets.py [data] [destino]
+"""
+import gzip
+import hashlib
+import os
+import shutil
+import sys
+import urllib.request
+
+CHART_JS = "chart.umd.min.js"
+CHART_JS_URL = "https://cdn.jsdelivr.net/npm/chart.js@4.4.1/dist/chart.umd.min.js"
+# Uma linha "sha256  nome" por arquivo de terceiros em data/ (formato do sha256sum).
+FIXADOS = os.path.join(os.path.dirname(os.path.abspath(__file__)), "assets_fixados.sha256")
+
+TIPOS = {
+    ".html": "text/html",
+    ".js": "application/javascript",
+    ".css": "text/css",
+    ".json": "application/json",
+    ".svg": "image/svg+xml",
+    ".png": "image/png",
+    ".ico": "image/x-icon",
+}
+
+# Nomes do SPIFFS têm no máximo 31 caracteres.
+TAMANHO_HASH_NOME = 8
+TAMANHO_ETAG = 16
+
+
+class ErroAssets(Exception):
+    pass
+
+
+def ler_fixados():
+    if not os.path.exists(FIXADOS):
+        return None
+    fixados = {}
+    with open(FIXADOS) as arquivo:
+        for linha in arquivo:
+            linha = linha.strip()
+            if linha and not linha.startswith("#"):
+                impressao, nome = linha.split(None, 1)
+                fixados[nome.lstrip("*")] = impressao.lower()
+    return fixados
+
+
+def conferir_fixados(origem):
+    fixados = ler_fixados()
+    if fixados is None:
+        print("assets: AVISO - %s não existe; arquivos de terceiros não conferidos "
+              "(rode tools/gerar_assets.py --vendorizar)" % FIXADOS)
+        return
+    for nome, esperado in fixados.items():
+        caminho = os.path.join(origem, nome)
+        if not os.path.exists(caminho):
+            raise ErroAssets("%s não existe; rode tools/gerar_assets.py --vendorizar" % caminho)
+        with open(caminho, "rb") as arquivo:
+            obtido = hashlib.sha256(arquivo.read()).hexdigest()
+        if obtido != esperado:
+            raise ErroAssets("%s tem SHA-256 %s, fixado %s" % (caminho, obtido, esperado))
+
+
+def vendorizar(origem):
+    try:
+        with urllib.request.urlopen(CHART_JS_URL, timeout=20) as resposta:
+            conteudo = resposta.read()
+    except OSError as erro:
+        raise ErroAssets("não foi possível baixar %s: %s" % (CHART_JS_URL, erro))
+    with open(os.path.join(origem, CHART_JS), "wb") as arquivo:
+        arquivo.write(conteudo)
+    impressao = hashlib.sha256(conteudo).hexdigest()
+    with open(FIXADOS, "w") as arquivo:
+        arquivo.write("# Arquivos de terceiros em data/; conferidos a cada compilação (tools/gerar_assets.py).\n")
+        arquivo.write("# %s\n" % CHART_JS_URL)
+        arquivo.write("%s  %s\n" % (impressao, CHART_JS))
+    print("assets: %s (%d bytes) vendorizado de %s" % (CHART_JS, len(conteudo), CHART_JS_URL))
+    print("assets: SHA-256 %s fixado em %s" % (impressao, FIXADOS))
+
+
+def gerar(origem, destino):
+    conferir_fixados(origem)
+    if os.path.isdir(destino):
+        shutil.rmtree(destino)
+    os.makedirs(destino)
+
+    nomes = sorted(n for n in os.listdir(origem) if not n.startswith(".") and os.path.isfile(os.path.join(origem, n)))
+    # Os HTML por último: eles precisam das URLs já com impressão digital.
+    nomes.sort(key=lambda n: n.endswith(".html"))
+
+    urls = {}
+    manifesto = []
+    total_original = 0
+    total_gzip = 0
+    for nome in nomes:
+        with open(os.path.join(origem, nome), "rb") as arquivo:
+            conteudo = arquivo.read()
+        base, extensao = os.path.splitext(nome)
+        html = extensao == ".html"
+        if html:
+            for antigo, novo in urls.items():
+                conteudo = conteudo.replace(('"%s"' % antigo).encode(), ('"%s"' % novo).encode())
+
+        impressao = hashlib.sha256(conteudo).hexdigest()
+        url = "/" + nome if html else "/%s.%s%s" % (base, impressao[:TAMANHO_HASH_NOME], extensao)
+        urls["/" + nome] = url
+        arquivo_gz = "/z_%s.gz" % impressao[:TAMANHO_HASH_NOME]
+        comprimido = gzip.compress(conteudo, compresslevel=9, mtime=0)
+        with open(os.path.join(destino, arquivo_gz[1:]), "wb") as arquivo:
+            arquivo.write(comprimido)
+
+        tipo = TIPOS.get(extensao, "application/octet-stream")
+        manifesto.append("%s %s %s %s %d" % (url, arquivo_gz, impressao[:TAMANHO_ETAG], tipo, 0 if html else 1))
+        total_original += len(conteudo)
+        total_gzip += len(comprimido)
+        print("assets: %-28s %7d -> %6d bytes  %s" % (nome, len(conteudo), len(comprimido), url))
+
+    with open(os.path.join(destino, "assets.txt"), "w") as arquivo:
+        arquivo.write("\n".join(manifesto) + "\n")
+    print("assets: total %d -> %d bytes (gzip)" % (total_original, total_gzip))
+
+
+try:
+    Import("env")  # noqa: F821 - definido pelo SCons do PlatformIO
+    try:
+        gerar(os.path.join(env.subst("$PROJECT_DIR"), "data"), env.subst("$PROJECT_DATA_DIR"))  # noqa: F821
+    except ErroAssets as erro:
+        print("assets: ERRO - %s" % erro)
+        env.Exit(1)  # noqa: F821
+except NameError:
+    if __name__ == "__main__":
+        raiz = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+        argumentos = [a for a in sys.argv[1:] if a != "--vendorizar"]
+        origem = argumentos[0] if argumentos else os.path.join(raiz, "data")
+        try:
+            if "--vendorizar" in sys.argv[1:]:
+                vendorizar(origem)
+            else:
+                gerar(origem, argumentos[1] if len(argumentos) > 1 else os.path.join(raiz, ".pio", "spiffs"))
+        except ErroAssets as erro:
+            print("assets: ERRO - %s" % erro)
+            sys.exit(1)